@@ -0,0 +1,141 @@
+/*
+ * app.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef INC_APP_H_
+#define INC_APP_H_
+
+#include "main.h"
+#include "lis3mdl.h"
+#include "lis3mdl_capture.h"
+#include "lis3mdl_odr_controller.h"
+#include "lis3mdl_stats.h"
+#include "lis3mdl_goertzel.h"
+
+#ifndef APP_MAX_LIS3MDL_DEVICES
+#define APP_MAX_LIS3MDL_DEVICES 1
+#endif
+
+#ifndef APP_CAPTURE_ENABLED
+#define APP_CAPTURE_ENABLED 0 // Hands every sample to app_capture_callback as a LIS3MDL_Capture_Record
+#endif
+
+#ifndef APP_WATCHDOG_DEADLINE_PERIODS
+#define APP_WATCHDOG_DEADLINE_PERIODS 4 // Sample periods a task may go without checking in
+#endif
+
+#ifndef APP_WATCHDOG_DEADLINE_SLACK_US
+#define APP_WATCHDOG_DEADLINE_SLACK_US 100000 // Added to the deadlines, covers the first conversion after power-up
+#endif
+
+/*
+ * Deadlines of the tasks in app.c from their release to their completion, a miss is
+ * counted by the task scheduler.
+ */
+#ifndef APP_ACQUISITION_DEADLINE_US
+#define APP_ACQUISITION_DEADLINE_US 2000
+#endif
+
+#ifndef APP_PROCESSING_DEADLINE_US
+#define APP_PROCESSING_DEADLINE_US 5000
+#endif
+
+#ifndef APP_OUTPUT_DEADLINE_US
+#define APP_OUTPUT_DEADLINE_US 250000 // One LED refresh of TIM2, which stands still in STOP until the next sample
+#endif
+
+/*
+ * Background diagnostics, the WHO_AM_I register of every device is checked once per
+ * period through the background class of the bus arbiter. 0 disables them.
+ */
+#ifndef APP_DIAGNOSTICS_PERIOD_US
+#define APP_DIAGNOSTICS_PERIOD_US 1000000
+#endif
+
+/*
+ * Period of the self-test, which runs on one device after the other without stopping
+ * acquisition, see lis3mdl_self_test.h. 0 only runs it on `app_request_self_test`.
+ */
+#ifndef APP_SELF_TEST_PERIOD_US
+#define APP_SELF_TEST_PERIOD_US 0
+#endif
+
+/*
+ * Statistics of every device over windows of its samples, see lis3mdl_stats.h. A summary
+ * goes to app_stats_callback every APP_STATS_HOP_SAMPLES samples and covers the last
+ * APP_STATS_WINDOW_HOPS hops, 1 gives tumbling windows. 0 samples disables them.
+ */
+#ifndef APP_STATS_HOP_SAMPLES
+#define APP_STATS_HOP_SAMPLES 0
+#endif
+
+#ifndef APP_STATS_WINDOW_HOPS
+#define APP_STATS_WINDOW_HOPS 1
+#endif
+
+/*
+ * AC field detector, see lis3mdl_goertzel.h. Every APP_GOERTZEL_BLOCK_SAMPLES samples of a
+ * device, amplitude and phase of the APP_GOERTZEL_HARMONICS of APP_GOERTZEL_FUNDAMENTAL_MHZ
+ * go to app_goertzel_callback. Mains frequencies need a fast ODR. 0 mHz disables it.
+ */
+#ifndef APP_GOERTZEL_FUNDAMENTAL_MHZ
+#define APP_GOERTZEL_FUNDAMENTAL_MHZ 0
+#endif
+
+#ifndef APP_GOERTZEL_HARMONICS
+#define APP_GOERTZEL_HARMONICS 0x05 // Fundamental and 3rd harmonic
+#endif
+
+#ifndef APP_GOERTZEL_BLOCK_SAMPLES
+#define APP_GOERTZEL_BLOCK_SAMPLES 200 // 0.2 s at the 1 kHz fast ODR
+#endif
+
+/*
+ * Adaptive ODR, see lis3mdl_odr_controller.h. The devices idle at the output_data_rate of
+ * the configuration and go to APP_ODR_ACTIVE_LEVEL while the field changes. At the 16 gauss
+ * full scale 1711 LSB are one gauss.
+ */
+#ifndef APP_ODR_ACTIVE_LEVEL
+#define APP_ODR_ACTIVE_LEVEL LIS3MDL_ODR_LEVEL_80
+#endif
+
+#ifndef APP_ODR_ACTIVITY_THRESHOLD
+#define APP_ODR_ACTIVITY_THRESHOLD 200 // LSB per second, summed over the axes
+#endif
+
+#ifndef APP_ODR_HOLD_OFF_US
+#define APP_ODR_HOLD_OFF_US 5000000
+#endif
+
+/*
+ * Thermal offset compensation, see lis3mdl_thermal.h. Define APP_THERMAL_LUTS as the
+ * initializers of one LIS3MDL_Thermal_Lut per device, in the order of the chip selects,
+ * from the calibration of the board. The tables take effect with temp_en set in the
+ * configuration. Without them the samples stay uncompensated.
+ */
+
+/**
+ * @brief Chip select line of one LIS3MDL on SPI2.
+ */
+
+typedef struct {
+	GPIO_TypeDef *gpio_port;
+	uint16_t pin;
+} App_Chip_Select;
+
+uint8_t app_init(const App_Chip_Select *chip_selects, uint8_t num_of_devices, LIS3MDL_Init_Params init_params);
+uint8_t app_start(void);
+void app_run_once(void);
+void app_idle(void);
+void app_magnetic_sample_callback(uint8_t dev_index, const LIS3MDL_Magnetic_Data_t *sample);
+const LIS3MDL_Device *app_get_lis3mdl_devices(uint8_t *num_of_devices);
+uint32_t app_get_identity_failures(void);
+uint8_t app_request_self_test(uint8_t dev_index);
+void app_capture_callback(const LIS3MDL_Capture_Record *record);
+void app_stats_callback(const LIS3MDL_Stats_Summary *summary);
+void app_goertzel_callback(const LIS3MDL_Goertzel_Result *result);
+
+#endif /* INC_APP_H_ */
@@ -0,0 +1,89 @@
+/*
+ * clock_governor.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef INC_CLOCK_GOVERNOR_H_
+#define INC_CLOCK_GOVERNOR_H_
+
+#include "main.h"
+#include "power_manager.h"
+
+#ifndef CLOCK_GOVERNOR_WINDOW_US
+#define CLOCK_GOVERNOR_WINDOW_US 100000 // CPU load is evaluated over windows this long
+#endif
+
+#ifndef CLOCK_GOVERNOR_UP_PERCENT
+#define CLOCK_GOVERNOR_UP_PERCENT 60 // Load at the low clock above which the PLL is switched on
+#endif
+
+#ifndef CLOCK_GOVERNOR_DOWN_PERCENT
+#define CLOCK_GOVERNOR_DOWN_PERCENT 30 // Load the low clock would see, below which the PLL is switched off
+#endif
+
+#ifndef CLOCK_GOVERNOR_MAX_TIMERS
+#define CLOCK_GOVERNOR_MAX_TIMERS 2
+#endif
+
+/*
+ * Supply current at the low clock, MSI at 2.1 MHz in range 1. Typical values of the
+ * STM32L053 datasheet, calibrate them against a measurement of the board. The high clock
+ * uses POWER_RUN_CURRENT_UA and POWER_SLEEP_CURRENT_UA.
+ */
+#ifndef CLOCK_LOW_RUN_CURRENT_UA
+#define CLOCK_LOW_RUN_CURRENT_UA 450
+#endif
+#ifndef CLOCK_LOW_SLEEP_CURRENT_UA
+#define CLOCK_LOW_SLEEP_CURRENT_UA 110
+#endif
+
+typedef enum {
+	CLOCK_PROFILE_LOW = 0x00, // MSI 2.097 MHz, APB1 undivided
+	CLOCK_PROFILE_HIGH = 0x01, // PLL 32 MHz from HSI16, APB1 divided by 16, as SystemClock_Config sets it up
+	CLOCK_PROFILE_COUNT
+} Clock_Profile;
+
+/**
+ * @brief Clock tree of a profile, the SPI and timer prescalers are rescaled from it.
+ */
+
+typedef struct {
+	uint32_t sysclk_hz;
+	uint32_t pclk1_hz;
+	uint32_t apb1_timer_hz; // Twice PCLK1 when APB1 is divided
+	uint32_t current_ua[POWER_STATE_COUNT];
+} Clock_Profile_Info;
+
+/**
+ * @brief What the governor measured per profile since `clock_governor_init`.
+ */
+
+typedef struct {
+	uint64_t residency_us[CLOCK_PROFILE_COUNT];
+	uint64_t charge_nc[CLOCK_PROFILE_COUNT]; // Estimated by the power manager while the profile was active
+	uint32_t switches[CLOCK_PROFILE_COUNT]; // Switches into the profile
+	uint64_t switch_us_sum[CLOCK_PROFILE_COUNT]; // Latency of those switches
+	uint32_t switch_us_max[CLOCK_PROFILE_COUNT];
+} Clock_Stats;
+
+void clock_governor_init(SPI_HandleTypeDef *hspi);
+uint8_t clock_governor_attach_timer(TIM_HandleTypeDef *htim);
+uint8_t clock_governor_update(void);
+void clock_governor_boost(uint8_t on);
+void clock_governor_set_enabled(uint8_t enable);
+Clock_Profile clock_governor_get_profile(void);
+const Clock_Profile_Info *clock_governor_get_profile_info(Clock_Profile profile);
+const Clock_Stats *clock_governor_get_stats(void);
+uint32_t clock_governor_get_average_current_ua(Clock_Profile profile);
+
+/*
+ * Hardware side, Core/Src/clock_port.c on target and the HAL mock on the host. Only called
+ * while no SPI transfer is in flight.
+ */
+uint32_t clock_port_switch(Clock_Profile profile);
+void clock_port_set_spi_prescaler(SPI_HandleTypeDef *hspi, uint32_t prescaler);
+void clock_port_set_timer_prescaler(TIM_HandleTypeDef *htim, uint32_t prescaler);
+
+#endif /* INC_CLOCK_GOVERNOR_H_ */
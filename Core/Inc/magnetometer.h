@@ -22,7 +22,7 @@ typedef struct{
 	uint16_t neg_y_led_gpio_pin;
 }Magnetometer_leds;
 
-void light_up_led_towards_magnetic_field(Magnetometer_leds leds, LIS3MDL_Magnetic_Data_t magnetic_data);
+void light_up_led_towards_magnetic_field(const Magnetometer_leds *leds, const LIS3MDL_Magnetic_Data_t *magnetic_data);
 
 #endif /* INC_MAGNETOMETER_H_ */
 
@@ -0,0 +1,76 @@
+/*
+ * power_manager.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef INC_POWER_MANAGER_H_
+#define INC_POWER_MANAGER_H_
+
+#include <stdint.h>
+
+#define POWER_IDLE_UNTIL_IRQ UINT32_MAX // Only an interrupt can bring new work
+
+#ifndef POWER_STOP_MIN_US
+#define POWER_STOP_MIN_US 500 // Shorter idle periods are spent in Sleep, STOP does not pay off
+#endif
+
+#ifndef POWER_STOP_WAKEUP_US
+#define POWER_STOP_WAKEUP_US 100 // Leaving STOP and relocking the PLL, STOP ends this much early
+#endif
+
+#ifndef POWER_MAX_SLEEP_US
+#define POWER_MAX_SLEEP_US 1500 // Longest STOP, has to stay below the IWDG timeout
+#endif
+
+/*
+ * Supply current of every power state, used for the charge estimate. Typical values of
+ * the STM32L053 datasheet at 32 MHz in range 1 with the LSI, IWDG and LPTIM running in
+ * STOP, calibrate them against a measurement of the board. The clock governor replaces
+ * them with the currents of its profile.
+ */
+#ifndef POWER_RUN_CURRENT_UA
+#define POWER_RUN_CURRENT_UA 6500
+#endif
+#ifndef POWER_SLEEP_CURRENT_UA
+#define POWER_SLEEP_CURRENT_UA 1700
+#endif
+#ifndef POWER_STOP_CURRENT_UA
+#define POWER_STOP_CURRENT_UA 2
+#endif
+
+typedef enum {
+	POWER_RUN = 0x00,
+	POWER_SLEEP = 0x01,
+	POWER_STOP = 0x02,
+	POWER_STATE_COUNT
+} Power_State;
+
+/**
+ * @brief Time spent in every power state since `power_manager_init`.
+ */
+
+typedef struct {
+	uint64_t residency_us[POWER_STATE_COUNT];
+	uint32_t entries[POWER_STATE_COUNT]; // Times Sleep or STOP was entered, RUN counts the idle calls that stayed awake
+} Power_Stats;
+
+void power_manager_init(void);
+void power_manager_idle(uint32_t idle_us, uint8_t dma_active, volatile uint8_t *wake_flag);
+void power_manager_set_max_sleep_us(uint32_t max_sleep_us);
+void power_manager_set_currents(const uint32_t *current_ua);
+const Power_Stats *power_manager_get_stats(void);
+uint64_t power_manager_estimate_charge_nc(void);
+
+/*
+ * Hardware side, Core/Src/power_port.c on target and the HAL mock on the host.
+ * Both return the time actually spent in the low power state.
+ */
+void power_port_init(void);
+uint32_t power_port_sleep(uint32_t max_us, volatile uint8_t *wake_flag);
+uint32_t power_port_stop(uint32_t duration_us);
+void power_port_wakeup_irq(void);
+uint32_t power_port_get_time_us(void);
+
+#endif /* INC_POWER_MANAGER_H_ */
@@ -0,0 +1,94 @@
+/*
+ * profiler.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef INC_PROFILER_H_
+#define INC_PROFILER_H_
+
+#include <stdint.h>
+#include "main.h"
+
+/*
+ * Execution time profiler of the hot paths, see profiler.c. Like the trace it is only
+ * compiled in when PROFILER_ENABLED is set to 1, otherwise every zone macro below expands
+ * to the bare code it wraps and TIM6 stays untouched.
+ */
+
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 0
+#endif
+
+#ifndef PROFILER_TICK_NS
+#define PROFILER_TICK_NS 500 // Counter resolution, TIM6 at 2 MHz on target, 1 ns on the host
+#endif
+
+#ifndef PROFILER_COUNTER_MASK
+#define PROFILER_COUNTER_MASK 0xFFFFU // TIM6 is 16 bit, zones have to end within one wrap, 32.7 ms on target
+#endif
+
+#ifndef PROFILER_HISTOGRAM_BINS
+#define PROFILER_HISTOGRAM_BINS 12 // Bin i counts zones shorter than PROFILER_HISTOGRAM_BASE_NS << i, the last one everything longer
+#endif
+
+#ifndef PROFILER_HISTOGRAM_BASE_NS
+#define PROFILER_HISTOGRAM_BASE_NS 500
+#endif
+
+typedef enum {
+	PROFILER_ZONE_PROCESS = 0x00, // lis3mdl_process
+	PROFILER_ZONE_GET_MAGNETIC_DATA = 0x01, // One lis3mdl_get_magnetic_data call
+	PROFILER_ZONE_DMA_IRQ = 0x02, // DMA1_Channel4_5_6_7_IRQHandler
+	PROFILER_ZONE_SPI_IRQ = 0x03, // SPI2_IRQHandler
+	PROFILER_ZONE_LED = 0x04, // light_up_led_towards_magnetic_field
+	PROFILER_ZONE_COUNT
+} Profiler_Zone;
+
+/**
+ * @brief Durations of one zone since `profiler_reset`, in nanoseconds.
+ */
+
+typedef struct {
+	uint32_t count;
+	uint32_t min_ns; // UINT32_MAX until the zone ran
+	uint32_t max_ns;
+	uint64_t sum_ns;
+	uint32_t histogram[PROFILER_HISTOGRAM_BINS];
+} Profiler_Zone_Stats;
+
+void profiler_init(TIM_HandleTypeDef *htim);
+void profiler_reset(void);
+void profiler_record(Profiler_Zone zone, uint32_t start);
+const Profiler_Zone_Stats *profiler_get_stats(Profiler_Zone zone);
+uint32_t profiler_get_mean_ns(Profiler_Zone zone);
+const char *profiler_get_zone_name(Profiler_Zone zone);
+
+/*
+ * Hardware side, Core/Src/profiler_port.c on target and Host/mock/profiler_port_mock.c
+ * on the host. The counter counts up in PROFILER_TICK_NS steps and wraps at PROFILER_COUNTER_MASK.
+ */
+void profiler_port_init(TIM_HandleTypeDef *htim);
+uint32_t profiler_port_now(void);
+
+#if PROFILER_ENABLED
+
+/*
+ * PROFILER_ZONE(zone) { ... } times the statement or block that follows it, which must
+ * not leave it through return, break or goto. PROFILER_ZONE_BEGIN and PROFILER_ZONE_END
+ * time code that cannot be wrapped, e.g. in between two USER CODE sections of CubeMX.
+ */
+#define PROFILER_ZONE(zone) for(uint32_t profiler_start = profiler_port_now(), profiler_once = 1; profiler_once; profiler_once = 0, profiler_record(zone, profiler_start))
+#define PROFILER_ZONE_BEGIN(zone) uint32_t profiler_start_##zone = profiler_port_now()
+#define PROFILER_ZONE_END(zone) profiler_record(zone, profiler_start_##zone)
+
+#else
+
+#define PROFILER_ZONE(zone)
+#define PROFILER_ZONE_BEGIN(zone) do {} while(0)
+#define PROFILER_ZONE_END(zone) do {} while(0)
+
+#endif
+
+#endif /* INC_PROFILER_H_ */
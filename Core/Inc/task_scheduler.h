@@ -0,0 +1,57 @@
+/*
+ * task_scheduler.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef INC_TASK_SCHEDULER_H_
+#define INC_TASK_SCHEDULER_H_
+
+#include <stdint.h>
+
+#ifndef TASK_SCHEDULER_MAX_TASKS
+#define TASK_SCHEDULER_MAX_TASKS 8
+#endif
+
+#ifndef TASK_SCHEDULER_HISTOGRAM_BINS
+#define TASK_SCHEDULER_HISTOGRAM_BINS 12 // Bin i counts runs shorter than 2^i us, the last one everything longer
+#endif
+
+#define TASK_EVERY_ROUND 0xFFFFFFFFU // period_us of a task that is released on every round
+#define TASK_ON_SIGNAL 0 // period_us of a task that only runs when signalled
+
+typedef void (*Task_Function)(void);
+
+/**
+ * @brief Entry of the static task table, see task_scheduler.c.
+ */
+
+typedef struct {
+	const char *name;
+	Task_Function run;
+	uint32_t period_us; // Release period, TASK_EVERY_ROUND or TASK_ON_SIGNAL. Any task can be signalled as well
+	uint32_t deadline_us; // Longest release to completion time, 0 for none
+	uint8_t priority; // Released tasks run lowest value first
+} Task_Descriptor;
+
+/**
+ * @brief What the scheduler measured about a task since `task_scheduler_init`.
+ */
+
+typedef struct {
+	uint32_t runs;
+	uint32_t deadline_misses;
+	uint32_t max_response_us; // Release to completion
+	uint32_t max_execution_us;
+	uint32_t execution_histogram[TASK_SCHEDULER_HISTOGRAM_BINS];
+} Task_Stats;
+
+uint8_t task_scheduler_init(const Task_Descriptor *tasks, uint8_t num_of_tasks);
+void task_scheduler_run_round(void);
+void task_scheduler_signal(uint8_t task);
+uint32_t task_scheduler_get_idle_time_us(void);
+const Task_Stats *task_scheduler_get_stats(uint8_t task);
+uint32_t task_scheduler_get_deadline_misses(void);
+
+#endif /* INC_TASK_SCHEDULER_H_ */
@@ -0,0 +1,55 @@
+/*
+ * watchdog.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef INC_WATCHDOG_H_
+#define INC_WATCHDOG_H_
+
+#include "main.h"
+
+/*
+ * IWDG timeout of every profile. The LSI of the L0 may run anywhere from 26 to 56 kHz, so
+ * the real timeout is 0.66 to 1.42 times the nominal one, the refresh and sleep rules in
+ * watchdog.c leave room for both ends.
+ */
+#ifndef WATCHDOG_ACTIVE_TIMEOUT_US
+#define WATCHDOG_ACTIVE_TIMEOUT_US 16000
+#endif
+#ifndef WATCHDOG_LOW_POWER_TIMEOUT_US
+#define WATCHDOG_LOW_POWER_TIMEOUT_US 2000000
+#endif
+
+typedef enum {
+	WATCHDOG_TASK_ACQUISITION = 0x00,
+	WATCHDOG_TASK_PROCESSING = 0x01,
+	WATCHDOG_TASK_OUTPUT = 0x02,
+	WATCHDOG_TASK_COUNT
+} Watchdog_Task;
+
+typedef enum {
+	WATCHDOG_PROFILE_ACTIVE = 0x00, // The loop hardly sleeps, a short timeout catches hangs quickly
+	WATCHDOG_PROFILE_LOW_POWER = 0x01, // The loop spends most of its time in STOP
+	WATCHDOG_PROFILE_COUNT
+} Watchdog_Profile;
+
+/**
+ * @brief Counters of the supervisor since `watchdog_init`.
+ */
+
+typedef struct {
+	uint32_t refreshes;
+	uint32_t withheld; // watchdog_service calls that refused to refresh because a task is late
+	uint8_t late_tasks; // Bit per Watchdog_Task that missed its deadline, the IWDG resets the target soon after
+} Watchdog_Stats;
+
+void watchdog_init(IWDG_HandleTypeDef *hiwdg);
+void watchdog_set_deadline_us(Watchdog_Task task, uint32_t deadline_us);
+uint8_t watchdog_set_profile(Watchdog_Profile profile);
+void watchdog_check_in(Watchdog_Task task);
+uint8_t watchdog_service(void);
+const Watchdog_Stats *watchdog_get_stats(void);
+
+#endif /* INC_WATCHDOG_H_ */
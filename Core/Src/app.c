@@ -0,0 +1,454 @@
+/*
+ * app.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Body of the super-loop and the interrupt callbacks it depends on. main.c only
+ * configures the MCU and calls app_run_once and app_idle forever, which lets the host runner in
+ * Host/sil execute exactly this code against simulated peripherals. The body is a table of
+ * tasks with priorities and deadlines run by task_scheduler.c.
+ */
+
+#include "app.h"
+#include "lis3mdl_registers.h"
+#include "lis3mdl_self_test.h"
+#include "lis3mdl_stats.h"
+#include "lis3mdl_thermal.h"
+#include "magnetometer.h"
+#include "lis3mdl_telemetry.h"
+#include "lis3mdl_trace.h"
+#include "power_manager.h"
+#include "watchdog.h"
+#include "clock_governor.h"
+#include "task_scheduler.h"
+#include "profiler.h"
+
+extern IWDG_HandleTypeDef hiwdg;
+extern SPI_HandleTypeDef hspi2;
+extern TIM_HandleTypeDef htim2;
+extern TIM_HandleTypeDef htim6;
+
+static LIS3MDL_Bus lis3mdl_bus;
+static LIS3MDL_Device lis3mdl_devices[APP_MAX_LIS3MDL_DEVICES];
+static LIS3MDL_Config_regs lis3mdl_config_image; // Shared by every device, they all run the same configuration
+static uint8_t num_of_lis3mdl_devices = 0;
+static uint32_t sample_period_us = 0; // At the quiet level, the longest the devices run at
+static uint32_t active_sample_period_us = 0;
+static LIS3MDL_Sample_Buffer magnetic_samples;
+static volatile uint8_t spi_cplt_flag = 0;
+static volatile uint8_t time_to_renew_data = 0;
+static LIS3MDL_Magnetic_Data_t latest_sample; // Shown by the LEDs
+static uint8_t latest_sample_valid = 0;
+static uint32_t next_diagnostics_us = 0;
+static uint8_t diagnostics_device = 0;
+static uint8_t diagnostics_in_flight = 0;
+static uint8_t who_am_i = 0; // Receive buffer of the diagnostics read
+static uint32_t identity_failures = 0;
+static uint32_t next_self_test_us = 0;
+static uint8_t self_test_device = 0;
+
+#ifdef APP_THERMAL_LUTS
+static const LIS3MDL_Thermal_Lut thermal_luts[] = { APP_THERMAL_LUTS }; // Calibration of the board, see app.h
+#endif
+
+_Static_assert(APP_MAX_LIS3MDL_DEVICES <= LIS3MDL_BUS_ARBITER_MAX_DEVICES, "The bus arbiter queues one bit per device");
+_Static_assert(APP_MAX_LIS3MDL_DEVICES <= LIS3MDL_ODR_CONTROLLER_MAX_DEVICES, "The ODR controller only watches the samples of the devices it has room for");
+_Static_assert(APP_MAX_LIS3MDL_DEVICES <= LIS3MDL_THERMAL_MAX_DEVICES, "Devices beyond LIS3MDL_THERMAL_MAX_DEVICES would not be thermally compensated");
+
+typedef enum {
+	APP_TASK_WATCHDOG = 0x00,
+	APP_TASK_ACQUISITION = 0x01,
+	APP_TASK_PROCESSING = 0x02,
+	APP_TASK_OUTPUT = 0x03,
+	APP_TASK_RATE_CONTROL = 0x04,
+	APP_TASK_DIAGNOSTICS = 0x05,
+	APP_TASK_COUNT
+} App_Task;
+
+static const Magnetometer_leds magnetometer_leds = {
+		.pos_y_led_gpio_port = LED1_GPIO_Port,
+		.pos_y_led_gpio_pin = LED1_Pin,
+		.pos_x_led_gpio_port = LED2_GPIO_Port,
+		.pos_x_led_gpio_pin = LED2_Pin,
+		.neg_y_led_gpio_port = LED3_GPIO_Port,
+		.neg_y_led_gpio_pin = LED3_Pin,
+		.neg_x_led_gpio_port = LED4_GPIO_Port,
+		.neg_x_led_gpio_pin = LED4_Pin,
+};
+
+static void acquisition_task(void){
+	PROFILER_ZONE(PROFILER_ZONE_PROCESS)
+		lis3mdl_process(lis3mdl_devices, num_of_lis3mdl_devices, &spi_cplt_flag);
+	for(int i=0; i<num_of_lis3mdl_devices; i++){
+		LIS3MDL_Data_Retrieval_State_t state;
+		PROFILER_ZONE(PROFILER_ZONE_GET_MAGNETIC_DATA)
+			state = lis3mdl_get_magnetic_data(lis3mdl_devices, num_of_lis3mdl_devices, i, &magnetic_samples);
+		if(state != LIS3MDL_DATA_AVAILABLE)
+			continue;
+		watchdog_check_in(WATCHDOG_TASK_ACQUISITION);
+		const LIS3MDL_Magnetic_Data_t *sample = lis3mdl_sample_buffer_peek_newest(&magnetic_samples);
+		uint32_t now_us = lis3mdl_get_tick_us();
+		uint8_t valid = lis3mdl_self_test_add_sample(i, sample);
+		if(valid){
+			lis3mdl_odr_controller_add_sample(i, sample);
+			lis3mdl_stats_add_sample(i, sample, now_us);
+			if(lis3mdl_devices[i].status & LIS3MDL_ZYXOR) // A sample was lost, the block would not be evenly sampled
+				lis3mdl_goertzel_restart_block(i);
+			lis3mdl_goertzel_add_sample(i, sample, now_us);
+		}
+		else{
+			lis3mdl_sample_buffer_flag_newest(&magnetic_samples, LIS3MDL_SAMPLE_INVALID);
+			lis3mdl_stats_skip_sample(i);
+			lis3mdl_goertzel_restart_block(i);
+		}
+#if APP_CAPTURE_ENABLED
+		LIS3MDL_Capture_Record record;
+		lis3mdl_capture_make_record(&record, &lis3mdl_devices[i], i, sample);
+		if(!valid)
+			record.flags |= LIS3MDL_CAPTURE_SELF_TEST;
+		app_capture_callback(&record);
+#endif
+		task_scheduler_signal(APP_TASK_PROCESSING);
+	}
+}
+
+/**
+  * @brief Hands the samples to `app_magnetic_sample_callback` and the LEDs, the summaries of
+  * the windows that completed to `app_stats_callback` and the results of the blocks the AC
+  * field detector completed to `app_goertzel_callback`.
+  */
+
+static void processing_task(void){
+	const LIS3MDL_Magnetic_Data_t *sample;
+	while((sample = lis3mdl_sample_buffer_peek(&magnetic_samples)) != NULL){
+		watchdog_check_in(WATCHDOG_TASK_PROCESSING);
+		if(!(lis3mdl_sample_buffer_peek_flags(&magnetic_samples) & LIS3MDL_SAMPLE_INVALID)){
+			app_magnetic_sample_callback(lis3mdl_sample_buffer_peek_dev_index(&magnetic_samples), sample);
+			latest_sample = *sample;
+			latest_sample_valid = 1;
+		}
+		lis3mdl_sample_buffer_release(&magnetic_samples);
+	}
+	LIS3MDL_Stats_Summary summary;
+	LIS3MDL_Goertzel_Result tones;
+	lis3mdl_goertzel_process(lis3mdl_devices, num_of_lis3mdl_devices);
+	for(int i=0; i<num_of_lis3mdl_devices; i++){
+		if(lis3mdl_stats_take_summary(i, &summary) == 0)
+			app_stats_callback(&summary);
+		if(lis3mdl_goertzel_take_result(i, &tones) == 0)
+			app_goertzel_callback(&tones);
+	}
+	task_scheduler_signal(APP_TASK_OUTPUT); // Checks in even when the LEDs are not due, TIM2 stands still in STOP
+}
+
+static void output_task(void){
+	if(time_to_renew_data && latest_sample_valid){
+		PROFILER_ZONE(PROFILER_ZONE_LED)
+			light_up_led_towards_magnetic_field(&magnetometer_leds, &latest_sample);
+		time_to_renew_data = 0;
+	}
+	watchdog_check_in(WATCHDOG_TASK_OUTPUT);
+}
+
+static void rate_control_task(void){
+	lis3mdl_odr_controller_process(lis3mdl_devices, num_of_lis3mdl_devices);
+}
+
+/**
+  * @brief Reads the WHO_AM_I register of one device after the other every
+  * APP_DIAGNOSTICS_PERIOD_US and runs the self-test, of one device after the other every
+  * APP_SELF_TEST_PERIOD_US and on `app_request_self_test`. Both are background work the bus
+  * arbiter only starts in the gaps between samples, so they never delay acquisition.
+  */
+
+static void diagnostics_task(void){
+	if(num_of_lis3mdl_devices == 0) // app_init failed
+		return;
+	if(APP_SELF_TEST_PERIOD_US != 0 && (int32_t)(lis3mdl_get_tick_us() - next_self_test_us) >= 0){
+		if(lis3mdl_self_test_start(lis3mdl_devices, num_of_lis3mdl_devices, self_test_device) == 0)
+			self_test_device = (self_test_device + 1) % num_of_lis3mdl_devices;
+		next_self_test_us = lis3mdl_get_tick_us() + APP_SELF_TEST_PERIOD_US;
+	}
+	lis3mdl_self_test_process(lis3mdl_devices, num_of_lis3mdl_devices);
+
+	if(APP_DIAGNOSTICS_PERIOD_US == 0)
+		return;
+
+	if(diagnostics_in_flight){
+		if(lis3mdl_devices[diagnostics_device].process_state != LIS3MDL_IDLE)
+			return;
+		diagnostics_in_flight = 0;
+		if(who_am_i != LIS3MDL_WHO_AM_I_REG_VALUE)
+			identity_failures++;
+		if(++diagnostics_device >= num_of_lis3mdl_devices){
+			diagnostics_device = 0;
+			next_diagnostics_us = lis3mdl_get_tick_us() + APP_DIAGNOSTICS_PERIOD_US;
+		}
+		return;
+	}
+	if((int32_t)(lis3mdl_get_tick_us() - next_diagnostics_us) < 0)
+		return;
+	if(lis3mdl_read_reg_to_buffer(lis3mdl_devices, num_of_lis3mdl_devices, diagnostics_device, LIS3MDL_WHO_AM_I_REG_ADDR, &who_am_i, 1, LIS3MDL_TRANSACTION_BACKGROUND) == HAL_OK)
+		diagnostics_in_flight = 1;
+}
+
+static void watchdog_task(void){
+	watchdog_service();
+}
+
+/*
+ * What the loop runs, see task_scheduler.c. Acquisition goes first on every round and only
+ * queues behind the watchdog, so a stage added below cannot delay reading the sensors.
+ */
+static const Task_Descriptor app_tasks[APP_TASK_COUNT] = {
+		[APP_TASK_WATCHDOG] = { "watchdog", watchdog_task, TASK_EVERY_ROUND, 0, 0 },
+		[APP_TASK_ACQUISITION] = { "acquisition", acquisition_task, TASK_EVERY_ROUND, APP_ACQUISITION_DEADLINE_US, 1 },
+		[APP_TASK_PROCESSING] = { "processing", processing_task, TASK_ON_SIGNAL, APP_PROCESSING_DEADLINE_US, 2 },
+		[APP_TASK_OUTPUT] = { "output", output_task, TASK_ON_SIGNAL, APP_OUTPUT_DEADLINE_US, 3 },
+		[APP_TASK_RATE_CONTROL] = { "rate control", rate_control_task, TASK_EVERY_ROUND, 0, 4 },
+		[APP_TASK_DIAGNOSTICS] = { "diagnostics", diagnostics_task, TASK_EVERY_ROUND, 0, 5 },
+};
+
+/**
+  * @brief Sets up the LIS3MDL devices on SPI2 and the buffers the loop uses.
+  * Only fills structures, so it can run before the peripherals are initialized.
+  *
+  * @param chip_selects Array of `num_of_devices` chip select lines, one per device.
+  * @param num_of_devices Number of LIS3MDL devices, at most APP_MAX_LIS3MDL_DEVICES.
+  * @param init_params Configuration every device is initialized with.
+  *
+  * @retval 0 on success, 1 on invalid input or an invalid table of APP_THERMAL_LUTS.
+  */
+
+uint8_t app_init(const App_Chip_Select *chip_selects, uint8_t num_of_devices, LIS3MDL_Init_Params init_params){
+	if(chip_selects == NULL || num_of_devices == 0 || num_of_devices > APP_MAX_LIS3MDL_DEVICES)
+		return 1;
+
+	if(lis3mdl_bus_init(&lis3mdl_bus, &hspi2) != 0 || lis3mdl_build_config_image(&lis3mdl_config_image, init_params) != 0)
+		return 1;
+
+	LIS3MDL_Odr_Controller_Params odr_params = {
+			.quiet_level = (LIS3MDL_Odr_Level)init_params.output_data_rate,
+			.active_level = APP_ODR_ACTIVE_LEVEL,
+			.activity_threshold = APP_ODR_ACTIVITY_THRESHOLD,
+			.hold_off_us = APP_ODR_HOLD_OFF_US,
+	};
+	if(init_params.fast_odr) // The operating mode selects the rate, there is nothing to adapt
+		odr_params.quiet_level = odr_params.active_level = (LIS3MDL_Odr_Level)(LIS3MDL_ODR_LEVEL_155 + LIS3MDL_ULTRA_PERFORMACE - init_params.xy_operation_mode);
+	if(odr_params.active_level < odr_params.quiet_level)
+		odr_params.active_level = odr_params.quiet_level;
+	if(lis3mdl_odr_controller_init(&lis3mdl_config_image, &odr_params) != 0) // Before the devices take over the image
+		return 1;
+	LIS3MDL_Stats_Params stats_params = {
+			.hop_samples = APP_STATS_HOP_SAMPLES,
+			.window_hops = APP_STATS_WINDOW_HOPS,
+	};
+	if(lis3mdl_stats_init(&stats_params) != 0)
+		return 1;
+	LIS3MDL_Goertzel_Params goertzel_params = {
+			.fundamental_mhz = APP_GOERTZEL_FUNDAMENTAL_MHZ,
+			.harmonics = APP_GOERTZEL_HARMONICS,
+			.block_samples = APP_GOERTZEL_BLOCK_SAMPLES,
+	};
+	if(lis3mdl_goertzel_init(&goertzel_params) != 0)
+		return 1;
+	for(int i=0; i<num_of_devices; i++){
+		if(lis3mdl_initialize_device_struct(&lis3mdl_devices[i], &lis3mdl_bus, chip_selects[i].gpio_port, chip_selects[i].pin) != 0)
+			return 1;
+		if(lis3mdl_setup_config_registers(&lis3mdl_devices[i], &lis3mdl_config_image) != 0)
+			return 1;
+	}
+	num_of_lis3mdl_devices = num_of_devices;
+	sample_period_us = lis3mdl_odr_get_level_period_us(odr_params.quiet_level);
+	active_sample_period_us = lis3mdl_odr_get_level_period_us(odr_params.active_level);
+
+	lis3mdl_sample_buffer_init(&magnetic_samples);
+	lis3mdl_telemetry_reset();
+	lis3mdl_trace_reset();
+	lis3mdl_bus_arbiter_reset();
+	lis3mdl_self_test_init();
+	lis3mdl_thermal_reset();
+#ifdef APP_THERMAL_LUTS
+	for(int i=0; i<num_of_devices && i<(int)(sizeof(thermal_luts) / sizeof(thermal_luts[0])); i++){
+		if(lis3mdl_thermal_set_lut((uint8_t)i, &thermal_luts[i]) != 0)
+			return 1;
+	}
+#endif
+	return 0;
+}
+
+/**
+  * @brief Starts power management, the clock governor, the watchdog supervisor, the
+  * task scheduler and with PROFILER_ENABLED the profiler on TIM6. Call it once the
+  * peripherals are initialized and right before the loop.
+  *
+  * Acquisition, processing and output have to check in at least every
+  * APP_WATCHDOG_DEADLINE_PERIODS sample periods of the quiet level. A loop that can STOP
+  * between samples even at the active level runs the low power watchdog profile, one that
+  * samples too fast for that the active one.
+  *
+  * @retval 0 on success, 1 if the watchdog or the scheduler cannot be configured.
+  */
+
+uint8_t app_start(void){
+#if LIS3MDL_BUS_SINGLE_IRQ
+	lis3mdl_bus_port_init(&lis3mdl_bus);
+#endif
+	power_manager_init();
+	clock_governor_init(&hspi2);
+	if(clock_governor_attach_timer(&htim2) != 0)
+		return 1;
+#if PROFILER_ENABLED
+	profiler_init(&htim6); // Before it is attached, the governor keeps the prescaler it finds
+	if(clock_governor_attach_timer(&htim6) != 0)
+		return 1;
+#endif
+	watchdog_init(&hiwdg);
+	if(task_scheduler_init(app_tasks, APP_TASK_COUNT) != 0)
+		return 1;
+	next_diagnostics_us = lis3mdl_get_tick_us() + APP_DIAGNOSTICS_PERIOD_US;
+	next_self_test_us = lis3mdl_get_tick_us() + APP_SELF_TEST_PERIOD_US;
+
+	uint32_t deadline_us = APP_WATCHDOG_DEADLINE_PERIODS * sample_period_us + APP_WATCHDOG_DEADLINE_SLACK_US;
+	for(int i=0; i<WATCHDOG_TASK_COUNT; i++)
+		watchdog_set_deadline_us((Watchdog_Task)i, deadline_us);
+
+	uint8_t sleeps_between_samples = active_sample_period_us > (WATCHDOG_ACTIVE_TIMEOUT_US >> 2) + POWER_STOP_MIN_US;
+	return watchdog_set_profile(sleeps_between_samples ? WATCHDOG_PROFILE_LOW_POWER : WATCHDOG_PROFILE_ACTIVE);
+}
+
+/**
+  * @brief One round of the task table.
+  * Acquisition is paced by the ODR aware poll schedule, TIM2 only paces the LED refresh.
+  * The adaptive ODR controller sees every sample and rewrites the rate in between samples.
+  */
+
+void app_run_once(void){
+	task_scheduler_run_round();
+}
+
+/**
+  * @brief Time until the devices or a task have work again.
+  */
+
+static uint32_t get_idle_time_us(void){
+	uint32_t idle_us = lis3mdl_get_idle_time_us(lis3mdl_devices, num_of_lis3mdl_devices, lis3mdl_get_tick_us());
+	uint32_t task_idle_us = task_scheduler_get_idle_time_us();
+	return task_idle_us < idle_us ? task_idle_us : idle_us;
+}
+
+/**
+  * @brief Lets the clock governor adapt the clock and sleeps until the devices or a task
+  * have work again, see clock_governor.c and power_manager.c. Call it after every `app_run_once`.
+  */
+
+void app_idle(void){
+	if(lis3mdl_get_idle_time_us(lis3mdl_devices, num_of_lis3mdl_devices, lis3mdl_get_tick_us()) == LIS3MDL_IDLE_UNTIL_TRANSFER_CPLT){
+		if(task_scheduler_get_idle_time_us() != 0) // Signalled tasks run first
+			power_manager_idle(POWER_IDLE_UNTIL_IRQ, 1, &spi_cplt_flag);
+		return;
+	}
+	if(get_idle_time_us() == 0)
+		return;
+	clock_governor_update();
+	power_manager_idle(get_idle_time_us(), 0, &spi_cplt_flag); // Again, a clock switch takes time
+}
+
+/**
+  * @brief Called for every sample the loop consumes, before it is released.
+  *
+  * @param dev_index Index of the device the sample was read from, in the order of the chip selects.
+  * @param sample Pointer to the sample, only valid during the call.
+  */
+
+__weak void app_magnetic_sample_callback(uint8_t dev_index, const LIS3MDL_Magnetic_Data_t *sample){
+}
+
+/**
+  * @brief Called with every sample as soon as it is committed when APP_CAPTURE_ENABLED is set,
+  * see lis3mdl_capture.h for the format.
+  *
+  * @param record Pointer to the record, only valid during the call.
+  */
+
+__weak void app_capture_callback(const LIS3MDL_Capture_Record *record){
+}
+
+/**
+  * @brief Called with the summary of every window that completed when APP_STATS_HOP_SAMPLES
+  * is set, see lis3mdl_stats.h for the format. Samples taken during a self-test are left out.
+  *
+  * @param summary Pointer to the summary, only valid during the call.
+  */
+
+__weak void app_stats_callback(const LIS3MDL_Stats_Summary *summary){
+}
+
+/**
+  * @brief Called with amplitude and phase of every block the AC field detector completed
+  * when APP_GOERTZEL_FUNDAMENTAL_MHZ is set. Blocks with an invalid or a lost sample are dropped.
+  *
+  * @param result Pointer to the result, only valid during the call.
+  */
+
+__weak void app_goertzel_callback(const LIS3MDL_Goertzel_Result *result){
+}
+
+/**
+  * @brief Gives access to the devices the loop runs, e.g. to write a capture header.
+  *
+  * @param num_of_devices Receives the number of devices.
+  *
+  * @retval Pointer to the device array.
+  */
+
+const LIS3MDL_Device *app_get_lis3mdl_devices(uint8_t *num_of_devices){
+	*num_of_devices = num_of_lis3mdl_devices;
+	return lis3mdl_devices;
+}
+
+/**
+  * @brief Diagnostics reads that found a WHO_AM_I other than LIS3MDL_WHO_AM_I_REG_VALUE,
+  * a sensor that dropped off the bus or lost its supply.
+  */
+
+uint32_t app_get_identity_failures(void){
+	return identity_failures;
+}
+
+/**
+  * @brief Starts the self-test of a device while the loop keeps sampling, the outcome is
+  * in `lis3mdl_self_test_get_report`. Samples taken while the self-test field is on do not
+  * reach `app_magnetic_sample_callback`, the LEDs or the ODR controller.
+  *
+  * @param dev_index Index of the device to test.
+  *
+  * @retval 0 if the test started, 1 if a test is running already or the index is invalid.
+  */
+
+uint8_t app_request_self_test(uint8_t dev_index){
+	return lis3mdl_self_test_start(lis3mdl_devices, num_of_lis3mdl_devices, dev_index);
+}
+
+LIS3MDL_RAM_FUNC void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi){
+	if(hspi->Instance == SPI2){
+		LIS3MDL_TRACE_DMA_COMPLETE();
+		spi_cplt_flag = 1;
+	}
+}
+
+LIS3MDL_RAM_FUNC void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi){
+	if(hspi->Instance == SPI2){
+		LIS3MDL_TRACE_DMA_COMPLETE();
+		spi_cplt_flag = 1;
+	}
+}
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim){
+	if(htim->Instance == TIM2){
+		LIS3MDL_TRACE_TIMER_TICK();
+		time_to_renew_data = 1;
+		task_scheduler_signal(APP_TASK_OUTPUT);
+	}
+}
@@ -0,0 +1,243 @@
+/*
+ * clock_governor.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Runs the core from the MSI at 2.1 MHz while it is mostly waiting for samples and
+ * switches to the 32 MHz PLL only when the load calls for it or a burst of work
+ * (calibration, filtering) asks for it through `clock_governor_boost`.
+ *
+ * The load is the RUN residency of the power manager over a window, scaled to what the
+ * low clock would see. Above CLOCK_GOVERNOR_UP_PERCENT the PLL is switched on, below
+ * CLOCK_GOVERNOR_DOWN_PERCENT off again.
+ *
+ * The low profile keeps APB1 undivided, so PCLK1 stays close to the 2 MHz of the high
+ * profile. The SPI prescaler and the prescalers of the attached timers are recomputed on
+ * every switch from the values MX_*_Init configured for the high profile, so SCK never runs
+ * more than 1/16 faster than configured and the timers keep their period. The HAL tick
+ * keeps its phase across a switch, see clock_port.c.
+ */
+
+#include <string.h>
+#include "clock_governor.h"
+#include "lis3mdl_poll_scheduler.h"
+
+#define CLOCK_GOVERNOR_SPI_TOLERANCE_SHIFT 4 // SCK may exceed the configured rate by 1/16
+#define CLOCK_GOVERNOR_MAX_TIMER_PRESCALER 0xFFFF
+
+static const Clock_Profile_Info profile_info[CLOCK_PROFILE_COUNT] = {
+		[CLOCK_PROFILE_LOW] = {
+				.sysclk_hz = 2097152,
+				.pclk1_hz = 2097152,
+				.apb1_timer_hz = 2097152,
+				.current_ua = { CLOCK_LOW_RUN_CURRENT_UA, CLOCK_LOW_SLEEP_CURRENT_UA, POWER_STOP_CURRENT_UA },
+		},
+		[CLOCK_PROFILE_HIGH] = {
+				.sysclk_hz = 32000000,
+				.pclk1_hz = 2000000,
+				.apb1_timer_hz = 4000000,
+				.current_ua = { POWER_RUN_CURRENT_UA, POWER_SLEEP_CURRENT_UA, POWER_STOP_CURRENT_UA },
+		},
+};
+
+static SPI_HandleTypeDef *governed_spi = NULL;
+static uint32_t reference_spi_prescaler = 0;
+static TIM_HandleTypeDef *governed_timers[CLOCK_GOVERNOR_MAX_TIMERS];
+static uint32_t reference_timer_prescalers[CLOCK_GOVERNOR_MAX_TIMERS];
+static uint8_t num_of_timers = 0;
+
+static Clock_Profile active_profile = CLOCK_PROFILE_HIGH;
+static uint8_t enabled = 1;
+static uint8_t boosts = 0;
+static uint32_t window_start_us = 0;
+static uint64_t window_start_run_us = 0;
+static uint32_t period_start_us = 0;
+static uint64_t period_start_charge_nc = 0;
+static Clock_Stats stats;
+
+/**
+  * @brief Books the time and charge since the last switch onto the active profile.
+  */
+
+static void close_period(void){
+	power_manager_set_currents(profile_info[active_profile].current_ua);
+	uint32_t now_us = lis3mdl_get_tick_us();
+	uint64_t charge_nc = power_manager_estimate_charge_nc();
+	stats.residency_us[active_profile] += now_us - period_start_us;
+	stats.charge_nc[active_profile] += charge_nc - period_start_charge_nc;
+	period_start_us = now_us;
+	period_start_charge_nc = charge_nc;
+}
+
+/**
+  * @brief Slowest SPI prescaler that keeps SCK within tolerance of the configured rate.
+  */
+
+static uint32_t rescale_spi_prescaler(Clock_Profile profile){
+	uint32_t reference_divider = 2U << (reference_spi_prescaler >> 3);
+	uint32_t max_bitrate_hz = profile_info[CLOCK_PROFILE_HIGH].pclk1_hz / reference_divider;
+	max_bitrate_hz += max_bitrate_hz >> CLOCK_GOVERNOR_SPI_TOLERANCE_SHIFT;
+
+	uint32_t prescaler = SPI_BAUDRATEPRESCALER_2;
+	while(profile_info[profile].pclk1_hz / (2U << (prescaler >> 3)) > max_bitrate_hz && prescaler < SPI_BAUDRATEPRESCALER_256)
+		prescaler += SPI_BAUDRATEPRESCALER_4;
+	return prescaler;
+}
+
+static uint32_t rescale_timer_prescaler(uint32_t reference_prescaler, Clock_Profile profile){
+	uint64_t divider = ((uint64_t)(reference_prescaler + 1) * profile_info[profile].apb1_timer_hz
+			+ profile_info[CLOCK_PROFILE_HIGH].apb1_timer_hz / 2) / profile_info[CLOCK_PROFILE_HIGH].apb1_timer_hz;
+	if(divider == 0)
+		divider = 1;
+	return divider > CLOCK_GOVERNOR_MAX_TIMER_PRESCALER + 1 ? CLOCK_GOVERNOR_MAX_TIMER_PRESCALER : (uint32_t)divider - 1;
+}
+
+static uint8_t switch_to(Clock_Profile profile){
+	if(profile == active_profile)
+		return 0;
+
+	close_period();
+	uint32_t latency_us = clock_port_switch(profile);
+	active_profile = profile;
+	power_manager_set_currents(profile_info[profile].current_ua);
+
+	if(governed_spi)
+		clock_port_set_spi_prescaler(governed_spi, rescale_spi_prescaler(profile));
+	for(int i=0; i<num_of_timers; i++)
+		clock_port_set_timer_prescaler(governed_timers[i], rescale_timer_prescaler(reference_timer_prescalers[i], profile));
+
+	stats.switches[profile]++;
+	stats.switch_us_sum[profile] += latency_us;
+	if(latency_us > stats.switch_us_max[profile])
+		stats.switch_us_max[profile] = latency_us;
+	return 1;
+}
+
+/**
+  * @brief Takes over the clock tree SystemClock_Config left behind, which is the high
+  * profile. Call it after `power_manager_init`.
+  *
+  * @param hspi SPI whose prescaler follows the clock, configured for the high profile. May be NULL.
+  */
+
+void clock_governor_init(SPI_HandleTypeDef *hspi){
+	governed_spi = hspi;
+	reference_spi_prescaler = hspi ? hspi->Init.BaudRatePrescaler : 0;
+	num_of_timers = 0;
+	active_profile = CLOCK_PROFILE_HIGH;
+	enabled = 1;
+	boosts = 0;
+	memset(&stats, 0, sizeof(stats));
+
+	power_manager_set_currents(profile_info[CLOCK_PROFILE_HIGH].current_ua);
+	window_start_us = period_start_us = lis3mdl_get_tick_us();
+	window_start_run_us = power_manager_get_stats()->residency_us[POWER_RUN];
+	period_start_charge_nc = power_manager_estimate_charge_nc();
+}
+
+/**
+  * @brief Makes the prescaler of an APB1 timer follow the clock, so its period stays
+  * what MX_*_Init configured for the high profile.
+  *
+  * @retval 0 on success, 1 if the handle is NULL or CLOCK_GOVERNOR_MAX_TIMERS are attached.
+  */
+
+uint8_t clock_governor_attach_timer(TIM_HandleTypeDef *htim){
+	if(htim == NULL || num_of_timers >= CLOCK_GOVERNOR_MAX_TIMERS)
+		return 1;
+	governed_timers[num_of_timers] = htim;
+	reference_timer_prescalers[num_of_timers] = htim->Init.Prescaler;
+	num_of_timers++;
+	if(active_profile != CLOCK_PROFILE_HIGH)
+		clock_port_set_timer_prescaler(htim, rescale_timer_prescaler(htim->Init.Prescaler, active_profile));
+	return 0;
+}
+
+/**
+  * @brief Picks the profile for the load of the last window. Call it from the loop while
+  * no SPI transfer is in flight, it does nothing until a window is complete.
+  *
+  * @retval 1 if the clock was switched, 0 otherwise.
+  */
+
+uint8_t clock_governor_update(void){
+	uint32_t now_us = lis3mdl_get_tick_us();
+	uint32_t window_us = now_us - window_start_us;
+	if(window_us < CLOCK_GOVERNOR_WINDOW_US)
+		return 0;
+
+	uint64_t run_us = power_manager_get_stats()->residency_us[POWER_RUN];
+	uint64_t busy_us = run_us - window_start_run_us;
+	window_start_us = now_us;
+	window_start_run_us = run_us;
+	if(!enabled || boosts)
+		return 0;
+
+	// Load the low profile would see, work scales with the core clock
+	uint64_t low_load_percent = busy_us * 100 * profile_info[active_profile].sysclk_hz / profile_info[CLOCK_PROFILE_LOW].sysclk_hz / window_us;
+	if(active_profile == CLOCK_PROFILE_LOW && low_load_percent > CLOCK_GOVERNOR_UP_PERCENT)
+		return switch_to(CLOCK_PROFILE_HIGH);
+	if(active_profile == CLOCK_PROFILE_HIGH && low_load_percent < CLOCK_GOVERNOR_DOWN_PERCENT)
+		return switch_to(CLOCK_PROFILE_LOW);
+	return 0;
+}
+
+/**
+  * @brief Runs the PLL for a burst of work, e.g. a calibration or a filter pass. Calls
+  * nest, the load decides again once every boost is released. Call it while no SPI
+  * transfer is in flight.
+  *
+  * @param on 1 to start a burst, 0 to end it.
+  */
+
+void clock_governor_boost(uint8_t on){
+	if(on){
+		boosts++;
+		if(enabled)
+			switch_to(CLOCK_PROFILE_HIGH);
+	}
+	else if(boosts)
+		boosts--;
+}
+
+/**
+  * @brief Disabling keeps the core on the PLL like before the governor existed.
+  */
+
+void clock_governor_set_enabled(uint8_t enable){
+	enabled = enable;
+	if(!enabled)
+		switch_to(CLOCK_PROFILE_HIGH);
+}
+
+Clock_Profile clock_governor_get_profile(void){
+	return active_profile;
+}
+
+const Clock_Profile_Info *clock_governor_get_profile_info(Clock_Profile profile){
+	return profile < CLOCK_PROFILE_COUNT ? &profile_info[profile] : NULL;
+}
+
+/**
+  * @brief Residency, charge and switch latency per profile, up to now.
+  */
+
+const Clock_Stats *clock_governor_get_stats(void){
+	close_period();
+	return &stats;
+}
+
+/**
+  * @brief Average supply current while a profile was active, estimated from its
+  * residency in RUN, Sleep and STOP.
+  *
+  * @retval Current in microamperes, 0 if the profile was never active.
+  */
+
+uint32_t clock_governor_get_average_current_ua(Clock_Profile profile){
+	const Clock_Stats *current = clock_governor_get_stats();
+	if(profile >= CLOCK_PROFILE_COUNT || current->residency_us[profile] == 0)
+		return 0;
+	return (uint32_t)(current->charge_nc[profile] * 1000 / current->residency_us[profile]);
+}
@@ -0,0 +1,107 @@
+/*
+ * clock_port.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Clock switching on the STM32L053 for clock_governor.c.
+ *
+ * The low profile runs from the MSI at 2.097 MHz with APB1 undivided and the PLL and HSI16
+ * off, the high one is the PLL at 32 MHz that SystemClock_Config sets up. The voltage range
+ * stays at 1 in both, so no VOS transition has to be waited for. STOP wakes up on the clock
+ * of the active profile.
+ *
+ * HAL_RCC_ClockConfig would restart SysTick and drop the part of the millisecond that had
+ * passed, which adds up with frequent switches and makes the HAL tick lag. SysTick is
+ * rescaled here instead so that the current millisecond ends on time.
+ */
+
+#include "main.h"
+#include "clock_governor.h"
+
+#define CLOCK_PORT_MSI_HZ 2097152
+#define CLOCK_PORT_PLL_HZ 32000000
+
+/**
+  * @brief Moves SysTick to a new core clock without losing the phase of the current tick.
+  */
+
+static void rescale_systick(uint32_t old_hz, uint32_t new_hz){
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq(); // A tick in between would be counted twice or not at all
+	uint32_t new_load = new_hz / 1000;
+	uint32_t remaining = (uint32_t)((uint64_t)SysTick->VAL * new_hz / old_hz);
+	if(remaining < 2)
+		remaining = 2;
+
+	SysTick->LOAD = remaining - 1;
+	SysTick->VAL = 0; // Reloads with the rest of the current tick
+	while(SysTick->VAL == 0);
+	SysTick->LOAD = new_load - 1; // Applies from the next tick on
+	SystemCoreClock = new_hz;
+	__set_PRIMASK(primask);
+}
+
+static void switch_to_msi(void){
+	MODIFY_REG(RCC->ICSCR, RCC_ICSCR_MSIRANGE, RCC_MSIRANGE_5);
+	RCC->CR |= RCC_CR_MSION;
+	while(!(RCC->CR & RCC_CR_MSIRDY));
+
+	MODIFY_REG(RCC->CFGR, RCC_CFGR_SW | RCC_CFGR_PPRE1, RCC_CFGR_SW_MSI | RCC_HCLK_DIV1);
+	while((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_MSI);
+	rescale_systick(CLOCK_PORT_PLL_HZ, CLOCK_PORT_MSI_HZ);
+
+	__HAL_FLASH_SET_LATENCY(FLASH_LATENCY_0);
+	RCC->CR &= ~(RCC_CR_PLLON | RCC_CR_HSION);
+	__HAL_RCC_WAKEUPSTOP_CLK_CONFIG(RCC_STOP_WAKEUPCLOCK_MSI);
+}
+
+static void switch_to_pll(void){
+	RCC->CR |= RCC_CR_HSION;
+	while(!(RCC->CR & RCC_CR_HSIRDY));
+	RCC->CR |= RCC_CR_PLLON; // Multiplier and divider are still the ones SystemClock_Config set
+	while(!(RCC->CR & RCC_CR_PLLRDY));
+
+	__HAL_FLASH_SET_LATENCY(FLASH_LATENCY_1);
+	while(__HAL_FLASH_GET_LATENCY() != FLASH_LATENCY_1);
+	MODIFY_REG(RCC->CFGR, RCC_CFGR_SW | RCC_CFGR_PPRE1, RCC_CFGR_SW_PLL | RCC_HCLK_DIV16);
+	while((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL);
+	rescale_systick(CLOCK_PORT_MSI_HZ, CLOCK_PORT_PLL_HZ);
+
+	__HAL_RCC_WAKEUPSTOP_CLK_CONFIG(RCC_STOP_WAKEUPCLOCK_HSI);
+}
+
+/**
+  * @brief Switches the core and APB1 clocks to a profile.
+  *
+  * @retval Time the switch took in microseconds, most of it waiting for the oscillators.
+  */
+
+uint32_t clock_port_switch(Clock_Profile profile){
+	uint32_t start_us = power_port_get_time_us();
+	if(profile == CLOCK_PROFILE_LOW)
+		switch_to_msi();
+	else
+		switch_to_pll();
+	return power_port_get_time_us() - start_us;
+}
+
+/**
+  * @brief Changes the SCK divider, BR can only be written while the SPI is disabled.
+  * HAL_SPI_*_DMA enables it again with the next transfer.
+  */
+
+void clock_port_set_spi_prescaler(SPI_HandleTypeDef *hspi, uint32_t prescaler){
+	__HAL_SPI_DISABLE(hspi);
+	MODIFY_REG(hspi->Instance->CR1, SPI_CR1_BR, prescaler);
+	hspi->Init.BaudRatePrescaler = prescaler;
+}
+
+/**
+  * @brief Changes a timer prescaler, PSC is preloaded and applies from the next update on.
+  */
+
+void clock_port_set_timer_prescaler(TIM_HandleTypeDef *htim, uint32_t prescaler){
+	__HAL_TIM_SET_PRESCALER(htim, prescaler);
+	htim->Init.Prescaler = prescaler;
+}
@@ -0,0 +1,104 @@
+/*
+ * lis3mdl_bus_port.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Single interrupt SPI engine on the STM32L053 for LIS3MDL_BUS_SINGLE_IRQ, see lis3mdl_bus.h.
+ *
+ * The HAL path takes the half and full transfer interrupts of both DMA channels, and every
+ * entry of DMA1_Channel4_5_6_7_IRQHandler runs HAL_DMA_IRQHandler for both of them, which
+ * ends in a busy wait for the SPI in the completion callback. The engine programs the two
+ * channels CubeMX set up for SPI2 directly. Only the full transfer interrupt of the RX
+ * channel is enabled, it fires after the last byte has been clocked in, so the bus is idle
+ * and CS can be released right away. SPI2_IRQn is disabled, the HAL only enabled it for
+ * error reports the engine does not use.
+ */
+
+#include "main.h"
+#include "lis3mdl_bus.h"
+
+static LIS3MDL_Bus *engine_bus = NULL;
+static DMA_TypeDef *dma = NULL;
+static DMA_Channel_TypeDef *rx_channel = NULL;
+static DMA_Channel_TypeDef *tx_channel = NULL;
+static uint32_t rx_channel_index = 0; // Bit position of the RX channel flags in ISR and IFCR
+static uint32_t rx_ccr = 0; // Channel configurations without EN
+static uint32_t tx_ccr = 0;
+
+/**
+  * @brief Takes the DMA channels of the bus over from the HAL. Call it once the
+  * peripherals are initialized, the HAL SPI DMA functions must not be used afterwards.
+  *
+  * @param bus Bus whose SPI handle is linked to its RX and TX DMA handles.
+  */
+
+void lis3mdl_bus_port_init(LIS3MDL_Bus *bus){
+	if(bus == NULL || bus->hspi == NULL || bus->hspi->hdmarx == NULL || bus->hspi->hdmatx == NULL)
+		return;
+
+	HAL_NVIC_DisableIRQ(SPI2_IRQn);
+	dma = bus->hspi->hdmarx->DmaBaseAddress;
+	rx_channel = bus->hspi->hdmarx->Instance;
+	tx_channel = bus->hspi->hdmatx->Instance;
+	rx_channel_index = bus->hspi->hdmarx->ChannelIndex;
+
+	// RX above TX, a received byte is always stored before the next one arrives
+	rx_ccr = DMA_CCR_MINC | DMA_CCR_TCIE | DMA_CCR_PL_0;
+	tx_ccr = DMA_CCR_MINC | DMA_CCR_DIR;
+	rx_channel->CCR = rx_ccr;
+	tx_channel->CCR = tx_ccr;
+	rx_channel->CPAR = (uint32_t)(uintptr_t)&bus->hspi->Instance->DR;
+	tx_channel->CPAR = (uint32_t)(uintptr_t)&bus->hspi->Instance->DR;
+	dma->IFCR = DMA_IFCR_CGIF1 << rx_channel_index;
+	engine_bus = bus;
+}
+
+/**
+  * @brief Clocks `size` bytes of the bus `tx` buffer out and into its `rx_frame`.
+  * CS has to be low already, it is released when the transfer completes.
+  *
+  * @retval HAL_OK once started, HAL_BUSY while a transfer is in flight, HAL_ERROR if the
+  * engine was not initialized for this bus or the size does not fit the buffers.
+  */
+
+LIS3MDL_RAM_FUNC HAL_StatusTypeDef lis3mdl_bus_port_transfer(LIS3MDL_Bus *bus, GPIO_TypeDef *cs_gpio_port, uint16_t cs_pin, uint8_t size){
+	if(bus != engine_bus || engine_bus == NULL || size == 0 || size > LIS3MDL_BUS_BUFFER_SIZE)
+		return HAL_ERROR;
+	if(rx_channel->CCR & DMA_CCR_EN)
+		return HAL_BUSY;
+
+	SPI_TypeDef *spi = bus->hspi->Instance;
+	bus->cs_gpio_port = cs_gpio_port;
+	bus->cs_pin = cs_pin;
+
+	// A byte left over in DR would shift the receive by one, reading DR and SR clears it and OVR
+	(void)spi->DR;
+	(void)spi->SR;
+	rx_channel->CMAR = (uint32_t)(uintptr_t)bus->rx_frame;
+	rx_channel->CNDTR = size;
+	rx_channel->CCR = rx_ccr | DMA_CCR_EN;
+	tx_channel->CMAR = (uint32_t)(uintptr_t)bus->tx;
+	tx_channel->CNDTR = size;
+	tx_channel->CCR = tx_ccr | DMA_CCR_EN;
+	spi->CR1 |= SPI_CR1_SPE; // The clock governor disables it to change the prescaler
+	spi->CR2 |= SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN;
+	return HAL_OK;
+}
+
+/**
+  * @brief The one interrupt of a transaction, call it from DMA1_Channel4_5_6_7_IRQHandler
+  * instead of the HAL handlers.
+  */
+
+LIS3MDL_RAM_FUNC void lis3mdl_bus_port_irq(void){
+	if(engine_bus == NULL || !(dma->ISR & (DMA_ISR_TCIF1 << rx_channel_index)))
+		return;
+
+	dma->IFCR = DMA_IFCR_CGIF1 << rx_channel_index;
+	rx_channel->CCR = rx_ccr;
+	tx_channel->CCR = tx_ccr;
+	engine_bus->hspi->Instance->CR2 &= ~(SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+	engine_bus->cs_gpio_port->BSRR = engine_bus->cs_pin;
+	HAL_SPI_RxCpltCallback(engine_bus->hspi);
+}
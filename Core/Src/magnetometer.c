@@ -8,26 +8,26 @@
 #include <stdlib.h>
 #include "magnetometer.h"
 
-void light_up_led_towards_magnetic_field(Magnetometer_leds leds, LIS3MDL_Magnetic_Data_t magnetic_data){
+void light_up_led_towards_magnetic_field(const Magnetometer_leds *leds, const LIS3MDL_Magnetic_Data_t *magnetic_data){
 
-	HAL_GPIO_WritePin(leds.neg_x_led_gpio_port, leds.neg_x_led_gpio_pin, 0);
-	HAL_GPIO_WritePin(leds.pos_x_led_gpio_port, leds.pos_x_led_gpio_pin, 0);
-	HAL_GPIO_WritePin(leds.neg_y_led_gpio_port, leds.neg_y_led_gpio_pin, 0);
-	HAL_GPIO_WritePin(leds.pos_y_led_gpio_port, leds.pos_y_led_gpio_pin, 0);
+	HAL_GPIO_WritePin(leds->neg_x_led_gpio_port, leds->neg_x_led_gpio_pin, 0);
+	HAL_GPIO_WritePin(leds->pos_x_led_gpio_port, leds->pos_x_led_gpio_pin, 0);
+	HAL_GPIO_WritePin(leds->neg_y_led_gpio_port, leds->neg_y_led_gpio_pin, 0);
+	HAL_GPIO_WritePin(leds->pos_y_led_gpio_port, leds->pos_y_led_gpio_pin, 0);
 
-	if(abs(magnetic_data.x) > abs(magnetic_data.y)){
-		if (magnetic_data.x < 0){
-			HAL_GPIO_WritePin(leds.neg_x_led_gpio_port, leds.neg_x_led_gpio_pin, 1);
+	if(abs(magnetic_data->x) > abs(magnetic_data->y)){
+		if (magnetic_data->x < 0){
+			HAL_GPIO_WritePin(leds->neg_x_led_gpio_port, leds->neg_x_led_gpio_pin, 1);
 			return;
 		}
-		HAL_GPIO_WritePin(leds.pos_x_led_gpio_port, leds.pos_x_led_gpio_pin, 1);
+		HAL_GPIO_WritePin(leds->pos_x_led_gpio_port, leds->pos_x_led_gpio_pin, 1);
 		return;
 	}
-	if (magnetic_data.y < 0){
-		HAL_GPIO_WritePin(leds.neg_y_led_gpio_port, leds.neg_y_led_gpio_pin, 1);
+	if (magnetic_data->y < 0){
+		HAL_GPIO_WritePin(leds->neg_y_led_gpio_port, leds->neg_y_led_gpio_pin, 1);
 		return;
 	}
-	HAL_GPIO_WritePin(leds.pos_y_led_gpio_port, leds.pos_y_led_gpio_pin, 1);
+	HAL_GPIO_WritePin(leds->pos_y_led_gpio_port, leds->pos_y_led_gpio_pin, 1);
 	return;
 }
 
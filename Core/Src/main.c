@@ -23,9 +23,7 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 
-#include "lis3mdl.h"
-#include "lis3mdl_registers.h"
-#include "magnetometer.h"
+#include "app.h"
 
 /* USER CODE END Includes */
 
@@ -55,21 +53,6 @@ TIM_HandleTypeDef htim6;
 
 /* USER CODE BEGIN PV */
 
-volatile uint8_t spi_cplt_flag = 0;
-LIS3MDL_Magnetic_Data_t magnetic_data;
-uint8_t time_to_renew_data = 0;
-
-Magnetometer_leds magnetometer_leds = {
-		.pos_y_led_gpio_port = LED1_GPIO_Port,
-		.pos_y_led_gpio_pin = LED1_Pin,
-		.pos_x_led_gpio_port = LED2_GPIO_Port,
-		.pos_x_led_gpio_pin = LED2_Pin,
-		.neg_y_led_gpio_port = LED3_GPIO_Port,
-		.neg_y_led_gpio_pin = LED3_Pin,
-		.neg_x_led_gpio_port = LED4_GPIO_Port,
-		.neg_x_led_gpio_pin = LED4_Pin,
-};
-
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -98,8 +81,9 @@ int main(void)
 
   /* USER CODE BEGIN 1 */
 
-	LIS3MDL_Device lis3mdl_devices[1];
-	lis3mdl_initialize_device_struct(&lis3mdl_devices[0], &hspi2, SS2_GPIO_Port, SS2_Pin);
+	const App_Chip_Select lis3mdl_chip_selects[] = {
+			{ .gpio_port = SS2_GPIO_Port, .pin = SS2_Pin },
+	};
 
 	LIS3MDL_Init_Params init_params;
 	lis3mdl_set_default_params(&init_params);
@@ -109,7 +93,8 @@ int main(void)
 	init_params.full_scale = LIS3MDL_FULL_SCALE_16_GAUSS;
 	init_params.xy_operation_mode = LIS3MDL_ULTRA_PERFORMACE;
 
-	lis3mdl_setup_config_registers(&lis3mdl_devices[0], init_params);
+	if(app_init(lis3mdl_chip_selects, 1, init_params) != 0)
+		Error_Handler();
 
   /* USER CODE END 1 */
 
@@ -138,6 +123,10 @@ int main(void)
   MX_TIM2_Init();
   /* USER CODE BEGIN 2 */
   HAL_TIM_Base_Start_IT(&htim2);
+  if (app_start() != 0)
+  {
+    Error_Handler();
+  }
 
   /* USER CODE END 2 */
 
@@ -145,14 +134,8 @@ int main(void)
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-	HAL_IWDG_Refresh(&hiwdg);
-	lis3mdl_process(lis3mdl_devices, 1, &spi_cplt_flag);
-	if(time_to_renew_data){
-		if(lis3mdl_get_magnetic_data(lis3mdl_devices, 1, 0, &magnetic_data) == LIS3MDL_DATA_AVAILABLE){
-			light_up_led_towards_magnetic_field(magnetometer_leds, magnetic_data);
-			time_to_renew_data = 0;
-		}
-	}
+	app_run_once();
+	app_idle();
 
     /* USER CODE END WHILE */
 
@@ -215,16 +198,17 @@ static void MX_IWDG_Init(void)
 {
 
   /* USER CODE BEGIN IWDG_Init 0 */
-
+	// The 2 s of WATCHDOG_PROFILE_LOW_POWER without a window until app_start sets the profile
+	// of the loop, so nothing between here and there can trip a reset
   /* USER CODE END IWDG_Init 0 */
 
   /* USER CODE BEGIN IWDG_Init 1 */
 
   /* USER CODE END IWDG_Init 1 */
   hiwdg.Instance = IWDG;
-  hiwdg.Init.Prescaler = IWDG_PRESCALER_4;
-  hiwdg.Init.Window = 20;
-  hiwdg.Init.Reload = 20;
+  hiwdg.Init.Prescaler = IWDG_PRESCALER_32;
+  hiwdg.Init.Window = 4095;
+  hiwdg.Init.Reload = 2311;
   if (HAL_IWDG_Init(&hiwdg) != HAL_OK)
   {
     Error_Handler();
@@ -415,24 +399,6 @@ static void MX_GPIO_Init(void)
 
 /* USER CODE BEGIN 4 */
 
-void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi){
-	if(hspi->Instance == SPI2){
-		spi_cplt_flag = 1;
-	}
-}
-
-void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi){
-	if(hspi->Instance == SPI2){
-		spi_cplt_flag = 1;
-	}
-}
-
-void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim){
-	if(htim->Instance == TIM2){
-		time_to_renew_data = 1;
-	}
-}
-
 /* USER CODE END 4 */
 
 /**
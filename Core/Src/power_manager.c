@@ -0,0 +1,135 @@
+/*
+ * power_manager.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Decides how the super-loop waits for its next piece of work. With a DMA transfer in
+ * flight, or when the next work is close, the core only stops its clock (Sleep) and any
+ * interrupt wakes it. Longer idle periods are spent in STOP, woken by the low power timer
+ * shortly before the work is due. The DMA does not run in STOP, so STOP is never entered
+ * during a transfer.
+ */
+
+#include <string.h>
+#include "power_manager.h"
+#include "lis3mdl_poll_scheduler.h"
+
+_Static_assert(POWER_STOP_MIN_US > POWER_STOP_WAKEUP_US, "STOP has to last longer than waking up from it");
+
+static Power_Stats stats;
+static uint64_t total_us = 0;
+static uint64_t charge_pc = 0;
+static uint32_t last_us = 0;
+static uint32_t stop_limit_us = POWER_MAX_SLEEP_US;
+
+static const uint32_t default_current_ua[POWER_STATE_COUNT] = {
+		[POWER_RUN] = POWER_RUN_CURRENT_UA,
+		[POWER_SLEEP] = POWER_SLEEP_CURRENT_UA,
+		[POWER_STOP] = POWER_STOP_CURRENT_UA,
+};
+static uint32_t state_current_ua[POWER_STATE_COUNT];
+
+/**
+  * @brief Accounts the time since the previous call, `slept_us` of it in `state` and the
+  * rest in RUN, with the currents that applied during that time.
+  */
+
+static void account(uint32_t now_us, Power_State state, uint32_t slept_us){
+	uint32_t elapsed_us = now_us - last_us;
+	if(slept_us > elapsed_us)
+		slept_us = elapsed_us;
+	total_us += elapsed_us;
+	charge_pc += (uint64_t)(elapsed_us - slept_us) * state_current_ua[POWER_RUN] + (uint64_t)slept_us * state_current_ua[state];
+	last_us = now_us;
+}
+
+/**
+  * @brief Prepares the wakeup timer and restarts the residency accounting.
+  * Call it once the clocks and peripherals are initialized.
+  */
+
+void power_manager_init(void){
+	memset(&stats, 0, sizeof(stats));
+	total_us = 0;
+	charge_pc = 0;
+	stop_limit_us = POWER_MAX_SLEEP_US;
+	memcpy(state_current_ua, default_current_ua, sizeof(state_current_ua));
+	power_port_init();
+	last_us = lis3mdl_get_tick_us();
+}
+
+/**
+  * @brief Waits in the cheapest power state that still wakes up in time.
+  *
+  * @param idle_us Time until the loop has work again, 0 to return at once,
+  * POWER_IDLE_UNTIL_IRQ if only an interrupt can bring new work.
+  * @param dma_active Non-zero while a DMA transfer is in flight, rules STOP out.
+  * @param wake_flag Flag set by the interrupt the loop waits for, may be NULL. A flag
+  * that is already set keeps the core awake.
+  */
+
+void power_manager_idle(uint32_t idle_us, uint8_t dma_active, volatile uint8_t *wake_flag){
+	Power_State state = POWER_RUN;
+	uint32_t slept_us = 0;
+
+	if(idle_us != 0 && (wake_flag == NULL || !*wake_flag)){
+		if(!dma_active && idle_us >= POWER_STOP_MIN_US){
+			state = POWER_STOP;
+			slept_us = power_port_stop((idle_us < stop_limit_us ? idle_us : stop_limit_us) - POWER_STOP_WAKEUP_US);
+		}
+		else{
+			state = POWER_SLEEP;
+			slept_us = power_port_sleep(idle_us, wake_flag);
+		}
+	}
+
+	account(lis3mdl_get_tick_us(), state, slept_us);
+	stats.residency_us[state] += state == POWER_RUN ? 0 : slept_us;
+	stats.entries[state]++;
+}
+
+/**
+  * @brief Limits how long a single STOP may last, e.g. to the watchdog timeout.
+  *
+  * @param max_sleep_us Longest STOP, has to be above POWER_STOP_WAKEUP_US.
+  */
+
+void power_manager_set_max_sleep_us(uint32_t max_sleep_us){
+	if(max_sleep_us > POWER_STOP_WAKEUP_US)
+		stop_limit_us = max_sleep_us;
+}
+
+/**
+  * @brief Changes the supply current of every power state, e.g. when the clock changes.
+  * The time up to now is accounted with the previous currents first.
+  *
+  * @param current_ua Current of every Power_State in microamperes.
+  */
+
+void power_manager_set_currents(const uint32_t *current_ua){
+	account(lis3mdl_get_tick_us(), POWER_RUN, 0);
+	memcpy(state_current_ua, current_ua, sizeof(state_current_ua));
+}
+
+/**
+  * @brief Residency of every power state. RUN is whatever time was not spent in
+  * Sleep or STOP, as of the last `power_manager_idle` call.
+  */
+
+const Power_Stats *power_manager_get_stats(void){
+	uint64_t asleep_us = stats.residency_us[POWER_SLEEP] + stats.residency_us[POWER_STOP];
+	stats.residency_us[POWER_RUN] = total_us > asleep_us ? total_us - asleep_us : 0;
+	return &stats;
+}
+
+/**
+  * @brief Charge drawn since `power_manager_init`, estimated from the residency and the
+  * current of every state, POWER_*_CURRENT_UA unless `power_manager_set_currents` changed it.
+  *
+  * @retval Charge in nanocoulombs, multiply with the supply voltage for nanojoules.
+  */
+
+uint64_t power_manager_estimate_charge_nc(void){
+	return charge_pc / 1000;
+}
@@ -0,0 +1,174 @@
+/*
+ * power_port.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Sleep and STOP on the STM32L053 for power_manager.c, and the microsecond time base
+ * of the lis3mdl driver.
+ *
+ * LPTIM1 runs from the LSI, which keeps running in STOP for the IWDG anyway, and ends a
+ * STOP through EXTI line 29. On the PLL the core wakes on HSI16 so only the PLL has to be
+ * brought back before the loop continues at 32 MHz, on the MSI it continues right away. SysTick does not count in STOP, the HAL tick
+ * is moved forward by the time LPTIM1 measured.
+ */
+
+#include "main.h"
+#include "power_manager.h"
+#include "lis3mdl_poll_scheduler.h"
+
+#define POWER_PORT_MAX_TICKS 0xFFFF // LPTIM1 is 16 bit
+
+static volatile uint8_t lptim_expired = 0;
+static uint32_t tick_remainder_us = 0; // Stopped time not yet added to the HAL tick
+
+/**
+  * @brief HAL tick refined with the SysTick counter.
+  *
+  * The part of the millisecond still to go is taken from the core clock rather than from
+  * LOAD, which clock_port.c shortens for the one tick during a clock switch. With the
+  * interrupts masked, e.g. in an ISR, a SysTick that reloaded but could not run its handler
+  * yet is counted here, so the time never goes backwards.
+  */
+
+uint32_t power_port_get_time_us(void){
+	uint32_t tick, count, pending;
+	do{
+		tick = uwTick;
+		count = SysTick->VAL;
+		pending = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+	}while(tick != uwTick);
+
+	uint32_t remaining_us = count * 1000 / (SystemCoreClock / 1000);
+	if(remaining_us > 1000)
+		remaining_us = 1000;
+	if(pending && remaining_us > 500) // Reloaded after the last handler ran
+		tick++;
+	return tick * 1000 + 1000 - remaining_us;
+}
+
+/**
+  * @brief Microsecond time base of the lis3mdl driver, replaces the weak default that only
+  * has the resolution of the HAL tick.
+  */
+
+uint32_t lis3mdl_get_tick_us(void){
+	return power_port_get_time_us();
+}
+
+/**
+  * @brief Switches SYSCLK back to the PLL after a wakeup on HSI16.
+  * The PLL configuration survives STOP, only PLLON is cleared. A core that ran from the
+  * MSI wakes up on it and needs nothing, see clock_port.c.
+  */
+
+static void restore_clocks(void){
+	RCC->CR |= RCC_CR_PLLON;
+	while(!(RCC->CR & RCC_CR_PLLRDY));
+	MODIFY_REG(RCC->CFGR, RCC_CFGR_SW, RCC_CFGR_SW_PLL);
+	while((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL);
+}
+
+static uint32_t read_lptim_counter(void){
+	uint32_t count;
+	do{
+		count = LPTIM1->CNT; // Asynchronous to the bus clock, two equal reads are a valid value
+	}while(count != LPTIM1->CNT);
+	return count;
+}
+
+/**
+  * @brief Wakes up from STOP on HSI16 without waiting for VREFINT and prepares LPTIM1.
+  */
+
+void power_port_init(void){
+	__HAL_RCC_WAKEUPSTOP_CLK_CONFIG(RCC_STOP_WAKEUPCLOCK_HSI);
+	HAL_PWREx_EnableUltraLowPower(); // VREFINT off in STOP
+	HAL_PWREx_EnableFastWakeUp(); // Do not wait for VREFINT when waking up
+
+	__HAL_RCC_LPTIM1_CONFIG(RCC_LPTIM1CLKSOURCE_LSI);
+	__HAL_RCC_LPTIM1_CLK_ENABLE();
+	LPTIM1->CR = 0; // CFGR and IER can only be written while disabled
+	LPTIM1->CFGR = 0;
+	LPTIM1->IER = LPTIM_IER_ARRMIE;
+	EXTI->IMR |= EXTI_IMR_IM29;
+	HAL_NVIC_SetPriority(LPTIM1_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(LPTIM1_IRQn);
+}
+
+/**
+  * @brief Starts LPTIM1 to expire once after `ticks` LSI periods.
+  */
+
+static void start_lptim(uint32_t ticks){
+	lptim_expired = 0;
+	LPTIM1->CR = LPTIM_CR_ENABLE;
+	LPTIM1->ARR = ticks;
+	while(!(LPTIM1->ISR & LPTIM_ISR_ARROK));
+	LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+	LPTIM1->CR |= LPTIM_CR_SNGSTRT;
+}
+
+static uint32_t us_to_lptim_ticks(uint32_t duration_us){
+	uint32_t ticks = (uint32_t)((uint64_t)duration_us * LSI_VALUE / 1000000);
+	return ticks > POWER_PORT_MAX_TICKS ? POWER_PORT_MAX_TICKS : ticks;
+}
+
+/**
+  * @brief Stops the core clock until the next interrupt, LPTIM1 ends it after `max_us`
+  * unless it is POWER_IDLE_UNTIL_IRQ. SysTick ends it within a millisecond anyway.
+  */
+
+uint32_t power_port_sleep(uint32_t max_us, volatile uint8_t *wake_flag){
+	uint32_t ticks = max_us == POWER_IDLE_UNTIL_IRQ ? 0 : us_to_lptim_ticks(max_us);
+	if(max_us != POWER_IDLE_UNTIL_IRQ && ticks < 2)
+		return 0; // Shorter than the LPTIM1 resolution, not worth it
+
+	uint32_t start_us = power_port_get_time_us();
+	if(ticks)
+		start_lptim(ticks);
+	__disable_irq();
+	if(wake_flag == NULL || !*wake_flag)
+		__WFI(); // A pending interrupt ends WFI even while masked, it runs once they are enabled
+	__enable_irq();
+	LPTIM1->CR = 0;
+	return power_port_get_time_us() - start_us;
+}
+
+/**
+  * @brief Enters STOP until LPTIM1 expires after `duration_us`, up to 1.77 s.
+  */
+
+uint32_t power_port_stop(uint32_t duration_us){
+	uint32_t ticks = us_to_lptim_ticks(duration_us);
+	if(ticks < 2)
+		return 0;
+
+	uint8_t pll_used = (RCC->CFGR & RCC_CFGR_SWS) == RCC_CFGR_SWS_PLL;
+	start_lptim(ticks);
+	HAL_SuspendTick();
+	HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+	if(pll_used)
+		restore_clocks();
+
+	uint32_t elapsed = lptim_expired ? ticks : read_lptim_counter(); // Another wakeup source ended it early
+	LPTIM1->CR = 0;
+	uint32_t stopped_us = (uint32_t)((uint64_t)elapsed * 1000000 / LSI_VALUE);
+
+	tick_remainder_us += stopped_us;
+	uwTick += tick_remainder_us / 1000;
+	tick_remainder_us %= 1000;
+	HAL_ResumeTick();
+	return stopped_us;
+}
+
+/**
+  * @brief LPTIM1 interrupt, called from LPTIM1_IRQHandler.
+  */
+
+void power_port_wakeup_irq(void){
+	if(LPTIM1->ISR & LPTIM_ISR_ARRM){
+		LPTIM1->ICR = LPTIM_ICR_ARRMCF;
+		lptim_expired = 1;
+	}
+}
@@ -0,0 +1,98 @@
+/*
+ * profiler.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Execution time of the hot paths. The Cortex-M0+ has no DWT cycle counter, so a zone
+ * reads a free-running timer when it starts and again when it ends, see profiler_port.c.
+ * Every zone keeps its count, minimum, maximum, the sum for the mean and a log2 histogram.
+ * Recording costs a counter read, a multiplication and a few compares, no division.
+ *
+ * Zones measure wall time, an interrupt preempting a zone is part of it. A zone may be
+ * recorded from an interrupt as long as no zone of the same kind runs in the main loop.
+ */
+
+#include <string.h>
+#include "profiler.h"
+
+static Profiler_Zone_Stats stats[PROFILER_ZONE_COUNT];
+
+static const char *const zone_names[PROFILER_ZONE_COUNT] = {
+		[PROFILER_ZONE_PROCESS] = "lis3mdl_process",
+		[PROFILER_ZONE_GET_MAGNETIC_DATA] = "lis3mdl_get_magnetic_data",
+		[PROFILER_ZONE_DMA_IRQ] = "dma_irq",
+		[PROFILER_ZONE_SPI_IRQ] = "spi_irq",
+		[PROFILER_ZONE_LED] = "light_up_led",
+};
+
+/**
+  * @brief Starts the counter and clears the statistics.
+  *
+  * @param htim Timer the counter runs on, TIM6 on target. It is reconfigured, so it
+  * cannot serve anything else.
+  */
+
+void profiler_init(TIM_HandleTypeDef *htim){
+	profiler_port_init(htim);
+	profiler_reset();
+}
+
+void profiler_reset(void){
+	memset(stats, 0, sizeof(stats));
+	for(int i=0; i<PROFILER_ZONE_COUNT; i++)
+		stats[i].min_ns = UINT32_MAX;
+}
+
+/**
+  * @brief Ends a zone, called by the zone macros.
+  *
+  * @param zone The zone that ends.
+  * @param start Counter value when it started.
+  */
+
+void profiler_record(Profiler_Zone zone, uint32_t start){
+	uint32_t duration_ns = ((profiler_port_now() - start) & PROFILER_COUNTER_MASK) * PROFILER_TICK_NS;
+	Profiler_Zone_Stats *zone_stats = &stats[zone];
+
+	zone_stats->count++;
+	zone_stats->sum_ns += duration_ns;
+	if(duration_ns < zone_stats->min_ns)
+		zone_stats->min_ns = duration_ns;
+	if(duration_ns > zone_stats->max_ns)
+		zone_stats->max_ns = duration_ns;
+
+	uint8_t bin = 0;
+	uint32_t bound_ns = PROFILER_HISTOGRAM_BASE_NS;
+	while(bin < PROFILER_HISTOGRAM_BINS - 1 && duration_ns >= bound_ns){
+		bin++;
+		bound_ns <<= 1;
+	}
+	zone_stats->histogram[bin]++;
+}
+
+/**
+  * @brief Statistics of a zone.
+  *
+  * @retval Pointer to them, NULL for an invalid zone.
+  */
+
+const Profiler_Zone_Stats *profiler_get_stats(Profiler_Zone zone){
+	return zone < PROFILER_ZONE_COUNT ? &stats[zone] : NULL;
+}
+
+/**
+  * @brief Mean duration of a zone.
+  *
+  * @retval Nanoseconds, 0 if the zone never ran or is invalid.
+  */
+
+uint32_t profiler_get_mean_ns(Profiler_Zone zone){
+	if(zone >= PROFILER_ZONE_COUNT || stats[zone].count == 0)
+		return 0;
+	return (uint32_t)(stats[zone].sum_ns / stats[zone].count);
+}
+
+const char *profiler_get_zone_name(Profiler_Zone zone){
+	return zone < PROFILER_ZONE_COUNT ? zone_names[zone] : "";
+}
@@ -0,0 +1,47 @@
+/*
+ * profiler_port.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Free-running counter on the STM32L053 for profiler.c.
+ *
+ * The basic timer TIM6 counts up at 2 MHz over its full 16 bit range without interrupts.
+ * MX_TIM6_Init leaves it at the prescaler and period CubeMX generated, they are replaced
+ * here. The prescaler is derived from the APB1 timer clock at the time of the call, the
+ * clock governor keeps the rate when it switches the clock if TIM6 is attached to it.
+ * On the MSI the counter then runs 4.9 % fast, which is the resolution the governor can keep.
+ */
+
+#include "main.h"
+#include "profiler.h"
+
+#define PROFILER_PORT_TICK_HZ (1000000000U / PROFILER_TICK_NS)
+
+static TIM_TypeDef *counter = NULL;
+
+/**
+  * @brief Kernel clock of the timers on APB1, twice PCLK1 unless APB1 is undivided.
+  */
+
+static uint32_t get_apb1_timer_hz(void){
+	uint32_t pclk1_hz = HAL_RCC_GetPCLK1Freq();
+	return (RCC->CFGR & RCC_CFGR_PPRE1) == RCC_HCLK_DIV1 ? pclk1_hz : pclk1_hz * 2;
+}
+
+void profiler_port_init(TIM_HandleTypeDef *htim){
+	uint32_t divider = get_apb1_timer_hz() / PROFILER_PORT_TICK_HZ;
+
+	HAL_TIM_Base_Stop(htim);
+	htim->Init.Prescaler = divider ? divider - 1 : 0;
+	htim->Init.Period = PROFILER_COUNTER_MASK;
+	htim->Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+	if(HAL_TIM_Base_Init(htim) != HAL_OK)
+		return;
+	HAL_TIM_Base_Start(htim);
+	counter = htim->Instance;
+}
+
+uint32_t profiler_port_now(void){
+	return counter ? counter->CNT : 0;
+}
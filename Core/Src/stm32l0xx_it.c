@@ -23,6 +23,9 @@
 #include "stm32l0xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "power_manager.h"
+#include "profiler.h"
+#include "lis3mdl_bus.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -47,7 +50,7 @@
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN PFP */
-
+LIS3MDL_RAM_FUNC void DMA1_Channel4_5_6_7_IRQHandler(void); // Acquisition interrupt, see LIS3MDL_HOT_PATH_IN_RAM
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -151,12 +154,17 @@ void SysTick_Handler(void)
 void DMA1_Channel4_5_6_7_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel4_5_6_7_IRQn 0 */
-
+  PROFILER_ZONE_BEGIN(PROFILER_ZONE_DMA_IRQ);
+#if LIS3MDL_BUS_SINGLE_IRQ
+  lis3mdl_bus_port_irq();
+  PROFILER_ZONE_END(PROFILER_ZONE_DMA_IRQ);
+  return; // The engine owns both channels, the HAL handlers would find nothing to do
+#endif
   /* USER CODE END DMA1_Channel4_5_6_7_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_spi2_rx);
   HAL_DMA_IRQHandler(&hdma_spi2_tx);
   /* USER CODE BEGIN DMA1_Channel4_5_6_7_IRQn 1 */
-
+  PROFILER_ZONE_END(PROFILER_ZONE_DMA_IRQ);
   /* USER CODE END DMA1_Channel4_5_6_7_IRQn 1 */
 }
 
@@ -194,14 +202,22 @@ void TIM6_DAC_IRQHandler(void)
 void SPI2_IRQHandler(void)
 {
   /* USER CODE BEGIN SPI2_IRQn 0 */
-
+  PROFILER_ZONE_BEGIN(PROFILER_ZONE_SPI_IRQ);
   /* USER CODE END SPI2_IRQn 0 */
   HAL_SPI_IRQHandler(&hspi2);
   /* USER CODE BEGIN SPI2_IRQn 1 */
-
+  PROFILER_ZONE_END(PROFILER_ZONE_SPI_IRQ);
   /* USER CODE END SPI2_IRQn 1 */
 }
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles LPTIM1 global interrupt / LPTIM1 wake-up interrupt through EXTI line 29.
+  */
+void LPTIM1_IRQHandler(void)
+{
+  power_port_wakeup_irq();
+}
+
 /* USER CODE END 1 */
@@ -0,0 +1,185 @@
+/*
+ * task_scheduler.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Cooperative scheduler over a static task table. A task is released by its period, on
+ * every round, or by `task_scheduler_signal` from an interrupt or another task. A round
+ * runs every released task once, lowest priority value first, so a stage added to the
+ * table queues behind acquisition instead of ahead of it. A signal for a task whose turn
+ * in the round has passed releases it for the next round.
+ *
+ * Every run is checked against the deadline of the task, measured from its release, and
+ * its execution time goes into a log2 histogram. Tasks never preempt each other, a miss
+ * tells that the tasks in front of it took too long.
+ *
+ * All times come from `lis3mdl_get_tick_us`, which power_port.c reads from SysTick with
+ * microsecond resolution. On the weak 1 ms default every run would land in the first bin.
+ */
+
+#include <string.h>
+#include "task_scheduler.h"
+#include "lis3mdl_poll_scheduler.h"
+
+static const Task_Descriptor *task_table = NULL;
+static uint8_t num_of_table_tasks = 0;
+static uint8_t run_order[TASK_SCHEDULER_MAX_TASKS]; // Table indices sorted by priority
+static uint32_t next_release_us[TASK_SCHEDULER_MAX_TASKS];
+static uint32_t release_us[TASK_SCHEDULER_MAX_TASKS];
+static volatile uint8_t signalled[TASK_SCHEDULER_MAX_TASKS];
+static volatile uint32_t signal_us[TASK_SCHEDULER_MAX_TASKS];
+static Task_Stats stats[TASK_SCHEDULER_MAX_TASKS];
+
+/**
+  * @brief Takes over a task table and releases its periodic tasks one period from now.
+  *
+  * @param tasks Table of `num_of_tasks` entries, has to outlive the scheduler, may be const in flash.
+  * @param num_of_tasks At most TASK_SCHEDULER_MAX_TASKS.
+  *
+  * @retval 0 on success, 1 on invalid input.
+  */
+
+uint8_t task_scheduler_init(const Task_Descriptor *tasks, uint8_t num_of_tasks){
+	if(tasks == NULL || num_of_tasks == 0 || num_of_tasks > TASK_SCHEDULER_MAX_TASKS)
+		return 1;
+	for(int i=0; i<num_of_tasks; i++){
+		if(tasks[i].run == NULL)
+			return 1;
+	}
+
+	task_table = tasks;
+	num_of_table_tasks = num_of_tasks;
+	memset(stats, 0, sizeof(stats));
+	uint32_t now_us = lis3mdl_get_tick_us();
+	for(int i=0; i<num_of_tasks; i++){
+		signalled[i] = 0;
+		next_release_us[i] = now_us + tasks[i].period_us;
+
+		// Insertion sort, equal priorities keep the table order
+		int j = i;
+		for(; j > 0 && tasks[run_order[j-1]].priority > tasks[i].priority; j--)
+			run_order[j] = run_order[j-1];
+		run_order[j] = (uint8_t)i;
+	}
+	return 0;
+}
+
+/**
+  * @brief Releases a task, it runs in the current round if its turn has not come yet.
+  * Safe to call from an interrupt, signals arriving before the task runs are merged into one run.
+  *
+  * @param task Index of the task in the table.
+  */
+
+void task_scheduler_signal(uint8_t task){
+	if(task >= num_of_table_tasks || signalled[task])
+		return;
+	signal_us[task] = lis3mdl_get_tick_us();
+	signalled[task] = 1;
+}
+
+static void account(uint8_t task, uint32_t start_us, uint32_t end_us){
+	const Task_Descriptor *descriptor = &task_table[task];
+	Task_Stats *task_stats = &stats[task];
+	uint32_t execution_us = end_us - start_us;
+	uint32_t response_us = end_us - release_us[task];
+
+	task_stats->runs++;
+	if(execution_us > task_stats->max_execution_us)
+		task_stats->max_execution_us = execution_us;
+	if(response_us > task_stats->max_response_us)
+		task_stats->max_response_us = response_us;
+	if(descriptor->deadline_us && response_us > descriptor->deadline_us)
+		task_stats->deadline_misses++;
+
+	uint8_t bin = 0;
+	while(bin < TASK_SCHEDULER_HISTOGRAM_BINS - 1 && execution_us >= (1U << bin))
+		bin++;
+	task_stats->execution_histogram[bin]++;
+}
+
+/**
+  * @brief Runs every released task once, in priority order. A task signalled by one that
+  * runs before it in the same round is released in this round already.
+  */
+
+void task_scheduler_run_round(void){
+	uint32_t round_us = lis3mdl_get_tick_us();
+
+	for(int i=0; i<num_of_table_tasks; i++){
+		uint8_t task = run_order[i];
+		const Task_Descriptor *descriptor = &task_table[task];
+		uint8_t released = 0;
+
+		if(signalled[task]){
+			release_us[task] = signal_us[task];
+			signalled[task] = 0; // Before running it, a signal during the run releases it again
+			released = 1;
+		}
+		if(descriptor->period_us == TASK_EVERY_ROUND){
+			if(!released)
+				release_us[task] = round_us;
+			released = 1;
+		}
+		else if(descriptor->period_us != TASK_ON_SIGNAL && (int32_t)(round_us - next_release_us[task]) >= 0){
+			if(!released)
+				release_us[task] = next_release_us[task];
+			released = 1;
+			next_release_us[task] += descriptor->period_us;
+			if((int32_t)(round_us - next_release_us[task]) >= 0) // Fell more than a period behind, skip the lost releases
+				next_release_us[task] = round_us + descriptor->period_us;
+		}
+		if(!released)
+			continue;
+
+		uint32_t start_us = lis3mdl_get_tick_us();
+		descriptor->run();
+		account(task, start_us, lis3mdl_get_tick_us());
+	}
+}
+
+/**
+  * @brief Tells how long no task needs to run, tasks released on every round do not count.
+  *
+  * @retval 0 if a task is signalled, UINT32_MAX if only a signal can release one, otherwise
+  * the microseconds until the next periodic release.
+  */
+
+uint32_t task_scheduler_get_idle_time_us(void){
+	uint32_t now_us = lis3mdl_get_tick_us();
+	uint32_t idle_us = UINT32_MAX;
+	for(int i=0; i<num_of_table_tasks; i++){
+		if(signalled[i])
+			return 0;
+		uint32_t period_us = task_table[i].period_us;
+		if(period_us == TASK_EVERY_ROUND || period_us == TASK_ON_SIGNAL)
+			continue;
+		if((int32_t)(next_release_us[i] - now_us) <= 0)
+			return 0;
+		if(next_release_us[i] - now_us < idle_us)
+			idle_us = next_release_us[i] - now_us;
+	}
+	return idle_us;
+}
+
+/**
+  * @brief Statistics of a task.
+  *
+  * @retval Pointer to them, NULL for an invalid index.
+  */
+
+const Task_Stats *task_scheduler_get_stats(uint8_t task){
+	return task < num_of_table_tasks ? &stats[task] : NULL;
+}
+
+/**
+  * @brief Deadline misses of all tasks together.
+  */
+
+uint32_t task_scheduler_get_deadline_misses(void){
+	uint32_t misses = 0;
+	for(int i=0; i<num_of_table_tasks; i++)
+		misses += stats[i].deadline_misses;
+	return misses;
+}
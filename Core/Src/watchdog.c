@@ -0,0 +1,152 @@
+/*
+ * watchdog.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Supervises the independent watchdog instead of refreshing it on every loop iteration.
+ * Acquisition, processing and output each check in when they complete a piece of work and
+ * have their own deadline. The IWDG is refreshed only while every task is within its
+ * deadline, a task that misses it stops the refreshes for good and the IWDG resets the
+ * target. A loop that merely keeps spinning no longer keeps the watchdog happy.
+ *
+ * The IWDG runs windowed: a refresh within the first eighth of the timeout resets the
+ * target as well, which catches code that runs away into the refresh. The supervisor
+ * refreshes once a quarter of the timeout has passed and limits a single STOP to another
+ * quarter, so even with the LSI at the ends of its tolerance a refresh lands inside the
+ * window. The timeout follows the power profile, a loop that spends seconds in STOP gets a
+ * long one, a loop that hardly sleeps a short one that detects a hang quickly.
+ */
+
+#include <string.h>
+#include "watchdog.h"
+#include "power_manager.h"
+#include "lis3mdl_poll_scheduler.h"
+
+#define WATCHDOG_MAX_RELOAD 0xFFF // IWDG_RLR is 12 bit
+#define WATCHDOG_WINDOW_OPEN_SHIFT 3 // The window opens after 1/8 of the timeout
+#define WATCHDOG_REFRESH_SHIFT 2 // Refresh after 1/4 of the timeout, sleep at most another 1/4
+
+static const uint32_t profile_timeout_us[WATCHDOG_PROFILE_COUNT] = {
+		[WATCHDOG_PROFILE_ACTIVE] = WATCHDOG_ACTIVE_TIMEOUT_US,
+		[WATCHDOG_PROFILE_LOW_POWER] = WATCHDOG_LOW_POWER_TIMEOUT_US,
+};
+
+static const uint32_t iwdg_prescalers[] = {
+		IWDG_PRESCALER_4, IWDG_PRESCALER_8, IWDG_PRESCALER_16, IWDG_PRESCALER_32,
+		IWDG_PRESCALER_64, IWDG_PRESCALER_128, IWDG_PRESCALER_256,
+};
+
+static IWDG_HandleTypeDef *watchdog_hiwdg = NULL;
+static uint32_t task_deadline_us[WATCHDOG_TASK_COUNT];
+static uint32_t last_check_in_us[WATCHDOG_TASK_COUNT];
+static uint32_t last_refresh_us = 0;
+static uint32_t refresh_after_us = 0;
+static Watchdog_Stats stats;
+
+/**
+  * @brief Takes over the IWDG that MX_IWDG_Init started. Every task counts as checked in
+  * and none has a deadline until `watchdog_set_deadline_us`, call `watchdog_set_profile`
+  * before the loop starts.
+  *
+  * @param hiwdg Handle of the running IWDG.
+  */
+
+void watchdog_init(IWDG_HandleTypeDef *hiwdg){
+	watchdog_hiwdg = hiwdg;
+	memset(&stats, 0, sizeof(stats));
+	uint32_t now_us = lis3mdl_get_tick_us();
+	for(int i=0; i<WATCHDOG_TASK_COUNT; i++){
+		task_deadline_us[i] = 0;
+		last_check_in_us[i] = now_us;
+	}
+	last_refresh_us = now_us;
+}
+
+/**
+  * @brief Sets the longest time a task may go without checking in.
+  *
+  * @param task Task to supervise.
+  * @param deadline_us Deadline in microseconds, 0 stops supervising the task.
+  */
+
+void watchdog_set_deadline_us(Watchdog_Task task, uint32_t deadline_us){
+	if(task >= WATCHDOG_TASK_COUNT)
+		return;
+	task_deadline_us[task] = deadline_us;
+	last_check_in_us[task] = lis3mdl_get_tick_us();
+}
+
+/**
+  * @brief Reprograms the IWDG for the timeout of a power profile and limits STOP so the
+  * loop is back in time to refresh it.
+  *
+  * @param profile Profile the loop runs in from now on.
+  *
+  * @retval 0 on success, 1 on invalid input or if the IWDG does not accept the setting.
+  */
+
+uint8_t watchdog_set_profile(Watchdog_Profile profile){
+	if(watchdog_hiwdg == NULL || profile >= WATCHDOG_PROFILE_COUNT)
+		return 1;
+
+	uint32_t timeout_us = profile_timeout_us[profile];
+	for(uint32_t i=0; i<sizeof(iwdg_prescalers)/sizeof(iwdg_prescalers[0]); i++){
+		uint64_t ticks = (uint64_t)timeout_us * LSI_VALUE / (1000000ULL * (4U << i));
+		if(ticks == 0 || ticks > WATCHDOG_MAX_RELOAD + 1)
+			continue;
+
+		watchdog_hiwdg->Init.Prescaler = iwdg_prescalers[i];
+		watchdog_hiwdg->Init.Reload = (uint32_t)ticks - 1;
+		watchdog_hiwdg->Init.Window = watchdog_hiwdg->Init.Reload - (watchdog_hiwdg->Init.Reload >> WATCHDOG_WINDOW_OPEN_SHIFT);
+		if(HAL_IWDG_Init(watchdog_hiwdg) != HAL_OK) // Reloads the counter as well
+			return 1;
+		last_refresh_us = lis3mdl_get_tick_us();
+		refresh_after_us = timeout_us >> WATCHDOG_REFRESH_SHIFT;
+		power_manager_set_max_sleep_us(timeout_us >> WATCHDOG_REFRESH_SHIFT);
+		return 0;
+	}
+	return 1;
+}
+
+/**
+  * @brief Reports that a task completed a piece of work.
+  */
+
+void watchdog_check_in(Watchdog_Task task){
+	if(task < WATCHDOG_TASK_COUNT)
+		last_check_in_us[task] = lis3mdl_get_tick_us();
+}
+
+/**
+  * @brief Refreshes the IWDG if every task is within its deadline and the refresh window
+  * is open. Call it on every loop iteration, it does nothing most of the time.
+  *
+  * @retval 1 if the IWDG was refreshed, 0 otherwise.
+  */
+
+uint8_t watchdog_service(void){
+	if(watchdog_hiwdg == NULL)
+		return 0;
+
+	uint32_t now_us = lis3mdl_get_tick_us();
+	for(int i=0; i<WATCHDOG_TASK_COUNT; i++){
+		if(task_deadline_us[i] && now_us - last_check_in_us[i] > task_deadline_us[i])
+			stats.late_tasks |= 1 << i; // Stays set, a task that recovers late does not avert the reset
+	}
+	if(stats.late_tasks){
+		stats.withheld++;
+		return 0;
+	}
+	if(now_us - last_refresh_us < refresh_after_us)
+		return 0;
+
+	HAL_IWDG_Refresh(watchdog_hiwdg);
+	last_refresh_us = now_us;
+	stats.refreshes++;
+	return 1;
+}
+
+const Watchdog_Stats *watchdog_get_stats(void){
+	return &stats;
+}
@@ -9,6 +9,107 @@
 #include <string.h>
 #include "lis3mdl.h"
 #include "lis3mdl_registers.h"
+#include "lis3mdl_init_planner.h"
+#include "lis3mdl_telemetry.h"
+#include "lis3mdl_trace.h"
+#include "lis3mdl_thermal.h"
+
+static uint8_t spi_transaction_started = 0; // A DMA transfer of lis3mdl_process is in flight
+
+_Static_assert(LIS3MDL_THERMAL_BURST_SIZE <= LIS3MDL_BUS_MAX_BURST, "The temperature burst has to fit the bus buffers");
+_Static_assert(LIS3MDL_THERMAL_BURST_SIZE == sizeof(LIS3MDL_Magnetic_Data_t) + sizeof(int16_t), "The temperature burst has to end with `temperature` of the slot");
+
+/**
+  * @brief Decodes TEMP_OUT received into a slot in place, in the byte order BLE selects like the axes.
+  */
+
+static void decode_temperature_in_place(const LIS3MDL_Device *device, LIS3MDL_Sample_Slot *slot){
+	const uint8_t *raw = (const uint8_t *)&slot->temperature;
+	if(device->config_regs->ctrls[3] & LIS3MDL_BLE)
+		slot->temperature = (int16_t)((raw[0] << 8) | raw[1]);
+	else
+		slot->temperature = (int16_t)(raw[0] | (raw[1] << 8));
+}
+
+/**
+  * @brief Hands the result of a completed read over to the device, the bus buffers are
+  * reused by the next transaction. Reads into a caller provided buffer need nothing, on the
+  * single interrupt engine only those received in place, i.e. sample reads, see lis3mdl_bus.h.
+  */
+
+LIS3MDL_RAM_FUNC static void hand_off_read(LIS3MDL_Device *device){
+	LIS3MDL_Bus *bus = device->bus;
+#if LIS3MDL_BUS_SINGLE_IRQ
+	if(!(bus->tx[0] & LIS3MDL_READ_BIT))
+		return;
+	if(bus->rx_frame == bus->rx) // The byte clocked in with the address is void
+		memmove(bus->rx_destination, bus->rx + 1, bus->data_size);
+	bus->rx_frame = bus->rx; // A sample read went straight into its slot
+#endif
+	if(bus->rx_destination != bus->rx || !(bus->tx[0] & LIS3MDL_READ_BIT))
+		return;
+
+	if((bus->tx[0] & ~(LIS3MDL_READ_BIT | LIS3MDL_MD_BIT)) == LIS3MDL_STATUS_REG_ADDR)
+		device->status = bus->rx[0];
+}
+
+/**
+  * @brief Puts the register block the init sequence writes in a state into the transmit buffer.
+  *
+  * @retval Bytes to transfer including the address, 0 if the state writes no register block.
+  */
+
+LIS3MDL_RAM_FUNC static uint8_t fill_init_transfer(LIS3MDL_Device *device){
+	LIS3MDL_Bus *bus = device->bus;
+	switch(device->process_state){
+	case LIS3MDL_RESETTING_REGISTERS:
+		bus->tx[0] = LIS3MDL_CTRL_REG2_ADDR;
+		bus->tx[1] = LIS3MDL_REBOOT;
+		return 2;
+	case LIS3MDL_INITIALIZING_OFFSET_REGS:
+		bus->tx[0] = LIS3MDL_OFFSET_X_REG_L_M_ADDR | LIS3MDL_MD_BIT;
+		memcpy(bus->tx + 1, device->config_regs->offsets, 6);
+		return 7;
+	case LIS3MDL_INITIALIZING_CTRL_REGS:
+		bus->tx[0] = LIS3MDL_CTRL_REG1_ADDR | LIS3MDL_MD_BIT;
+		memcpy(bus->tx + 1, device->config_regs->ctrls, 5);
+		return 6;
+	case LIS3MDL_INITIALIZING_INT_REGS:
+		bus->tx[0] = LIS3MDL_INT_CFG_REG_ADDR | LIS3MDL_MD_BIT;
+		memcpy(bus->tx + 1, device->config_regs->ints, 4);
+		return 5;
+	default:
+		return 0;
+	}
+}
+
+#if LIS3MDL_BUS_SINGLE_IRQ
+
+/**
+  * @brief Starts the next transaction of a device as one full-duplex transfer, see lis3mdl_bus.h.
+  * Reads and writes skip the address state, their completion makes the device idle again.
+  */
+
+LIS3MDL_RAM_FUNC static LIS3MDL_Process_Status_t start_single_transfer(LIS3MDL_Device *device, int dev_index){
+	LIS3MDL_Bus *bus = device->bus;
+	uint8_t size = fill_init_transfer(device);
+
+	if(device->process_state == LIS3MDL_SENDING_ADDRESS_TO_READ_FROM || device->process_state == LIS3MDL_SENDING_ADDRESS_TO_WRITE_TO){
+		device->process_state = device->process_state == LIS3MDL_SENDING_ADDRESS_TO_READ_FROM ? LIS3MDL_READING_DATA : LIS3MDL_WRITING_DATA;
+		LIS3MDL_TRACE_PROCESS_STATE(dev_index, device->process_state);
+		size = 1 + bus->data_size;
+	}
+	if(size == 0)
+		return LIS3MDL_PROCESS_ERROR;
+
+	LIS3MDL_TRACE_DMA_START(dev_index, size);
+	if(lis3mdl_bus_port_transfer(bus, device->cs_gpio_port_handle, device->cs_pin, size) != HAL_OK)
+		return LIS3MDL_PROCESS_ERROR;
+	LIS3MDL_TELEMETRY_TRANSFER_STARTED(size);
+	return LIS3MDL_PROCESS_OK;
+}
+
+#endif
 
 /**
   * @brief Manages the state-driven communication and processing for LIS3MDL devices via SPI DMA.
@@ -30,29 +131,23 @@
   * a failed HAL SPI DMA call, or an invalid state transition.
   * @retval LIS3MDL_PROCESS_ALL_DEVICES_IDLING If all managed LIS3MDL devices are currently in an
   * idle state, meaning no processing is pending.
+  * @retval LIS3MDL_PROCESS_WAITING_FOR_REBOOT If the only pending work is the configuration of devices
+  * whose REBOOT has not settled yet (see lis3mdl_init_planner.h).
   * @retval LIS3MDL_PROCESS_WAITING_FOR_SPI_CPLT If an SPI DMA transaction was initiated and is still
   * in progress, requiring further calls to this function
   * once the `spi_cplt_flag` is set by the ISR.
   * @retval LIS3MDL_PROCESS_OK If a processing step was successfully initiated (e.g., a DMA transfer started)
-  * or successfully completed, and the state machine can progress.
+  * or successfully completed, and the state machine can progress. A completed transfer is immediately
+  * followed by the next pending one so consecutive bursts are not separated by a main loop iteration.
   */
 
-LIS3MDL_Process_Status_t lis3mdl_process(LIS3MDL_Device *devices, uint8_t num_of_devices, volatile uint8_t *spi_cplt_flag){
+LIS3MDL_RAM_FUNC LIS3MDL_Process_Status_t lis3mdl_process(LIS3MDL_Device *devices, uint8_t num_of_devices, volatile uint8_t *spi_cplt_flag){
 	if(devices == NULL)
 		return LIS3MDL_PROCESS_ERROR;
 
 	static int dev_index = 0;
-	if(dev_index == 0){
-		dev_index = get_first_non_idling_device_index(devices, num_of_devices);
-	}
-
-	if(dev_index < 0){
-		dev_index = 0;
-		return LIS3MDL_PROCESS_ALL_DEVICES_IDLING;
-	}
-
-	static uint8_t spi_transaction_started = 0;
 
+	lis3mdl_bus_arbiter_new_round();
 	if(spi_transaction_started){
 		if(!*spi_cplt_flag)
 			return LIS3MDL_PROCESS_WAITING_FOR_SPI_CPLT;
@@ -60,70 +155,99 @@ LIS3MDL_Process_Status_t lis3mdl_process(LIS3MDL_Device *devices, uint8_t num_of
 
 		if(lis3mdl_change_state_due_to_spi_cplt(&devices[dev_index].process_state) == LIS3MDL_STATE_CHANGE_INVALID_CHANGE)
 			return LIS3MDL_PROCESS_ERROR;
+		LIS3MDL_TRACE_PROCESS_STATE(dev_index, devices[dev_index].process_state);
+
+		if(devices[dev_index].process_state == LIS3MDL_WAITING_FOR_REBOOT)
+			lis3mdl_init_planner_reboot_issued();
+		else if(devices[dev_index].process_state == LIS3MDL_IDLE)
+			hand_off_read(&devices[dev_index]);
+
+		LIS3MDL_TELEMETRY_TRANSFER_COMPLETED(devices[dev_index].process_state != LIS3MDL_WRITING_DATA && devices[dev_index].process_state != LIS3MDL_READING_DATA);
+		spi_transaction_started = 0;
 
 		if(devices[dev_index].process_state != LIS3MDL_WRITING_DATA && devices[dev_index].process_state != LIS3MDL_READING_DATA){
+#if !LIS3MDL_BUS_SINGLE_IRQ // The port already released CS in the completion interrupt
 			devices[dev_index].cs_gpio_port_handle->BSRR = devices[dev_index].cs_pin; // Pulling CS High
+#endif
+			LIS3MDL_TRACE_CS_HIGH(dev_index);
+			lis3mdl_bus_arbiter_transaction_done(lis3mdl_get_tick_us());
+			dev_index = lis3mdl_init_planner_next_device_index(devices, num_of_devices);
+			if(dev_index < 0){
+				dev_index = 0;
+				return LIS3MDL_PROCESS_OK;
+			}
+		}
+		// Falling through so that the next transfer is kicked off without an idle gap
+	}
+	else{
+		dev_index = lis3mdl_init_planner_next_device_index(devices, num_of_devices);
+		if(dev_index == LIS3MDL_INIT_PLANNER_SETTLING){
+			dev_index = 0;
+			return LIS3MDL_PROCESS_WAITING_FOR_REBOOT;
+		}
+		if(dev_index < 0){
+			dev_index = 0;
+			return LIS3MDL_PROCESS_ALL_DEVICES_IDLING;
 		}
-
-		spi_transaction_started = 0;
-		dev_index = 0;
-		return LIS3MDL_PROCESS_OK;
 	}
 
-	// If spi_transaction was not started
-	devices[dev_index].cs_gpio_port_handle->BSRR = (devices[dev_index].cs_pin) << 16; // Pulling CS Low
+	// Starting the next transaction of the selected device
+	if(devices[dev_index].config_regs == NULL || devices[dev_index].bus == NULL) // lis3mdl_setup_config_registers was never called
+		return LIS3MDL_PROCESS_ERROR;
+	if(devices[dev_index].process_state != LIS3MDL_WRITING_DATA && devices[dev_index].process_state != LIS3MDL_READING_DATA){
+		devices[dev_index].cs_gpio_port_handle->BSRR = (devices[dev_index].cs_pin) << 16; // Pulling CS Low
+		LIS3MDL_TRACE_CS_LOW(dev_index);
+	}
 	spi_transaction_started = 1;
+#if LIS3MDL_BUS_SINGLE_IRQ
+	return start_single_transfer(&devices[dev_index], dev_index);
+#else
+	LIS3MDL_Bus *bus = devices[dev_index].bus;
+	uint8_t size;
 	switch(devices[dev_index].process_state){
 	case LIS3MDL_RESETTING_REGISTERS:
-		devices[dev_index].tx[0] = LIS3MDL_CTRL_REG2_ADDR;
-		devices[dev_index].tx[1] = LIS3MDL_REBOOT;
-		if(HAL_SPI_Transmit_DMA(devices[dev_index].hspi, devices[dev_index].tx, 2) != HAL_OK)
-			return LIS3MDL_PROCESS_ERROR;
-		return LIS3MDL_PROCESS_OK;
 	case LIS3MDL_INITIALIZING_OFFSET_REGS:
-		devices[dev_index].tx[0] = LIS3MDL_OFFSET_X_REG_L_M_ADDR | LIS3MDL_MD_BIT;
-		memcpy(devices[dev_index].tx + 1, devices[dev_index].config_regs.offsets, 6);
-		if(HAL_SPI_Transmit_DMA(devices[dev_index].hspi, devices[dev_index].tx, 7) != HAL_OK)
-			return LIS3MDL_PROCESS_ERROR;
-		return LIS3MDL_PROCESS_OK;
-
 	case LIS3MDL_INITIALIZING_CTRL_REGS:
-		devices[dev_index].tx[0] = LIS3MDL_CTRL_REG1_ADDR | LIS3MDL_MD_BIT;
-		memcpy(devices[dev_index].tx + 1, devices[dev_index].config_regs.ctrls, 5);
-		if(HAL_SPI_Transmit_DMA(devices[dev_index].hspi, devices[dev_index].tx, 6) != HAL_OK)
-			return LIS3MDL_PROCESS_ERROR;
-		return LIS3MDL_PROCESS_OK;
-
 	case LIS3MDL_INITIALIZING_INT_REGS:
-		devices[dev_index].tx[0] = LIS3MDL_INT_CFG_REG_ADDR| LIS3MDL_MD_BIT;
-		memcpy(devices[dev_index].tx + 1, devices[dev_index].config_regs.ints, 4);
-		if(HAL_SPI_Transmit_DMA(devices[dev_index].hspi, devices[dev_index].tx, 5) != HAL_OK)
+		size = fill_init_transfer(&devices[dev_index]);
+		LIS3MDL_TRACE_DMA_START(dev_index, size);
+		if(HAL_SPI_Transmit_DMA(bus->hspi, bus->tx, size) != HAL_OK)
 			return LIS3MDL_PROCESS_ERROR;
+		LIS3MDL_TELEMETRY_TRANSFER_STARTED(size);
 		return LIS3MDL_PROCESS_OK;
 
 	case LIS3MDL_SENDING_ADDRESS_TO_WRITE_TO:
-		if(HAL_SPI_Transmit_DMA(devices[dev_index].hspi,&devices[dev_index].reg_addr, 1) != HAL_OK)
+		LIS3MDL_TRACE_DMA_START(dev_index, 1);
+		if(HAL_SPI_Transmit_DMA(bus->hspi, bus->tx, 1) != HAL_OK)
 					return LIS3MDL_PROCESS_ERROR;
+		LIS3MDL_TELEMETRY_TRANSFER_STARTED(1);
 		return LIS3MDL_PROCESS_OK;
 
 	case LIS3MDL_SENDING_ADDRESS_TO_READ_FROM:
-		if(HAL_SPI_Transmit_DMA(devices[dev_index].hspi,&devices[dev_index].reg_addr, 1) != HAL_OK)
+		LIS3MDL_TRACE_DMA_START(dev_index, 1);
+		if(HAL_SPI_Transmit_DMA(bus->hspi, bus->tx, 1) != HAL_OK)
 			return LIS3MDL_PROCESS_ERROR;
+		LIS3MDL_TELEMETRY_TRANSFER_STARTED(1);
 		return LIS3MDL_PROCESS_OK;
 
 	case LIS3MDL_WRITING_DATA:
-		if(HAL_SPI_Transmit_DMA(devices[dev_index].hspi,devices[dev_index].tx, devices[dev_index].data_size) != HAL_OK)
+		LIS3MDL_TRACE_DMA_START(dev_index, bus->data_size);
+		if(HAL_SPI_Transmit_DMA(bus->hspi, bus->tx + 1, bus->data_size) != HAL_OK)
 					return LIS3MDL_PROCESS_ERROR;
+		LIS3MDL_TELEMETRY_TRANSFER_STARTED(bus->data_size);
 		return LIS3MDL_PROCESS_OK;
 
 	case LIS3MDL_READING_DATA:
-		if(HAL_SPI_Receive_DMA(devices[dev_index].hspi,devices[dev_index].rx, devices[dev_index].data_size) != HAL_OK)
+		LIS3MDL_TRACE_DMA_START(dev_index, bus->data_size);
+		if(HAL_SPI_Receive_DMA(bus->hspi, bus->rx_destination, bus->data_size) != HAL_OK)
 			return LIS3MDL_PROCESS_ERROR;
+		LIS3MDL_TELEMETRY_TRANSFER_STARTED(bus->data_size);
 		return LIS3MDL_PROCESS_OK;
 
 	default:
 		return LIS3MDL_PROCESS_ERROR;
 	}
+#endif
 
 	return LIS3MDL_PROCESS_ERROR;
 }
@@ -133,70 +257,122 @@ LIS3MDL_Process_Status_t lis3mdl_process(LIS3MDL_Device *devices, uint8_t num_of
   *
   * This function should be called repeatedly in a non-blocking loop. It progresses through
   * a sequence of states:
+  * 0. Waiting until the device's poll schedule expects a new sample (see lis3mdl_poll_scheduler.h).
   * 1. Initiating a read of the status register to check for new data.
   * 2. Waiting for the status register read to complete and checking the data-ready flag.
-  * 3. Initiating the read of the actual X, Y, Z magnetic data.
-  * 4. Waiting for the magnetic data read to complete and parsing the results.
+  * 3. Initiating the read of the actual X, Y, Z magnetic data straight into the next free
+  *    slot of `samples`, which the device claims. When the temperature is due (see
+  *    lis3mdl_thermal.h) the same burst continues to TEMP_OUT_H, which the slot has room for.
+  * 4. Waiting for the magnetic data read to complete, decoding the slot in place, correcting
+  *    its thermal offset and committing it to `samples`.
+  *
+  * Every device reads into a slot of its own, so a device can start its read while the
+  * sample of another one waits to be committed.
   *
   * @param devices Pointer to the array of LIS3MDL_Device structures.
   * @param num_of_devices The total number of devices in the `devices` array.
   * @param dev_index The index of the specific LIS3MDL device within the `devices` array
   * for which data is to be retrieved.
-  * @param results Pointer to a `LIS3MDL_Magnetic_Data_t` structure where the
-  * retrieved X, Y, Z magnetic field values will be stored upon successful completion.
+  * @param samples Pointer to the `LIS3MDL_Sample_Buffer` the receive DMA writes into.
+  * Committed samples are read with `lis3mdl_sample_buffer_peek` and handed back with
+  * `lis3mdl_sample_buffer_release`.
   *
-  * @retval LIS3MDL_DATA_RETRIEVAL_ERROR If `devices` or `results` are NULL, or if an
+  * @retval LIS3MDL_DATA_RETRIEVAL_ERROR If `devices` or `samples` are NULL, or if an
   * unexpected state is encountered.
-  * @retval LIS3MDL_STARTING_STATUS_CHECK If the function successfully initiated a status
-  * register read or needs to restart the status check because data wasn't ready.
+  * @retval LIS3MDL_WAITING_FOR_DATA_READY If the next sample is not expected yet, either after a
+  * sample was delivered or after a status read found no new data.
+  * @retval LIS3MDL_STARTING_STATUS_CHECK If a status register read is due but the bus is busy.
   * @retval LIS3MDL_STATUS_CHECK_IN_PROGRESS If the status register read is ongoing (waiting
   * for the `lis3mdl_process` to complete the underlying SPI transaction).
-  * @retval LIS3MDL_STARTING_DATA_RETRIEVAL If the function successfully initiated a magnetic
-  * data read after determining data is available.
+  * @retval LIS3MDL_STARTING_DATA_RETRIEVAL If data is available but the read could not be started
+  * yet, either because the bus is busy or because `samples` has no free slot.
   * @retval LIS3MDL_DATA_RETRIEVAL_IN_PROGRESS If the magnetic data read is ongoing (waiting
   * for the `lis3mdl_process` to complete the underlying SPI transaction).
   * @retval LIS3MDL_DATA_AVAILABLE If magnetic data has been successfully retrieved and
-  * parsed into the `results` structure. The process then resets to start a new status check.
+  * committed to `samples`. The process then waits for the next predicted sample.
   */
 
-LIS3MDL_Data_Retrieval_State_t lis3mdl_get_magnetic_data(LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t dev_index, LIS3MDL_Magnetic_Data_t *results){
-	if(devices == NULL || results == NULL){
+LIS3MDL_Data_Retrieval_State_t lis3mdl_get_magnetic_data(LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t dev_index, LIS3MDL_Sample_Buffer *samples){
+	if(devices == NULL || samples == NULL){
 		return LIS3MDL_DATA_RETRIEVAL_ERROR;
 	}
 
+	LIS3MDL_Sample_Slot *slot;
+	uint8_t flags;
+
 	switch(devices[dev_index].data_retrieval_state){
+	case LIS3MDL_WAITING_FOR_DATA_READY:
+		if(!lis3mdl_poll_scheduler_is_due(&devices[dev_index].poll_schedule, lis3mdl_get_tick_us()))
+			return LIS3MDL_WAITING_FOR_DATA_READY;
+		devices[dev_index].data_retrieval_state = LIS3MDL_STARTING_STATUS_CHECK;
+		LIS3MDL_TRACE_RETRIEVAL_STATE(dev_index, LIS3MDL_STARTING_STATUS_CHECK);
+		// fall through
 	case LIS3MDL_STARTING_STATUS_CHECK:
-		if(lis3mdl_read_reg(devices, num_of_devices, dev_index, LIS3MDL_STATUS_REG_ADDR, 1) == HAL_OK){
+		if(lis3mdl_read_reg(devices, num_of_devices, dev_index, LIS3MDL_STATUS_REG_ADDR, 1, LIS3MDL_TRANSACTION_SAMPLE) == HAL_OK){
+			LIS3MDL_TELEMETRY_STATUS_POLL(dev_index);
 			devices[dev_index].data_retrieval_state = LIS3MDL_STATUS_CHECK_IN_PROGRESS;
+			LIS3MDL_TRACE_RETRIEVAL_STATE(dev_index, LIS3MDL_STATUS_CHECK_IN_PROGRESS);
 			return LIS3MDL_STATUS_CHECK_IN_PROGRESS;
 		}
+		LIS3MDL_TELEMETRY_RETRY(dev_index);
 		return LIS3MDL_STARTING_STATUS_CHECK;
 
 	case LIS3MDL_STATUS_CHECK_IN_PROGRESS:
-		if(get_first_non_idling_device_index(devices, num_of_devices) < 0){ // Every device is idling including this one
-			if(devices[dev_index].rx[0] & LIS3MDL_ZYXDA){ // Data available bit from status register
+		if(devices[dev_index].process_state == LIS3MDL_IDLE){ // The read completed and handed the status off to the device
+			if(devices[dev_index].status & LIS3MDL_ZYXDA){ // Data available bit from status register
+				if(devices[dev_index].status & LIS3MDL_ZYXOR)
+					LIS3MDL_TELEMETRY_OVERRUN(dev_index);
+				lis3mdl_poll_scheduler_data_ready(&devices[dev_index].poll_schedule, lis3mdl_get_tick_us(), devices[dev_index].status & LIS3MDL_ZYXOR);
 				devices[dev_index].data_retrieval_state = LIS3MDL_STARTING_DATA_RETRIEVAL;
+				LIS3MDL_TRACE_RETRIEVAL_STATE(dev_index, LIS3MDL_STARTING_DATA_RETRIEVAL);
 				return LIS3MDL_STARTING_DATA_RETRIEVAL;
 			}
-			devices[dev_index].data_retrieval_state = LIS3MDL_STARTING_STATUS_CHECK; // Data is not yet available reread the status reg until it is available
-			return LIS3MDL_STARTING_STATUS_CHECK;
+			// Data is not yet available, the schedule decides when to reread the status reg
+			LIS3MDL_TELEMETRY_STATUS_MISS(dev_index);
+			lis3mdl_poll_scheduler_data_not_ready(&devices[dev_index].poll_schedule, lis3mdl_get_tick_us());
+			devices[dev_index].data_retrieval_state = LIS3MDL_WAITING_FOR_DATA_READY;
+			LIS3MDL_TRACE_RETRIEVAL_STATE(dev_index, LIS3MDL_WAITING_FOR_DATA_READY);
+			return LIS3MDL_WAITING_FOR_DATA_READY;
 		}
 		return LIS3MDL_STATUS_CHECK_IN_PROGRESS;
 
 	case LIS3MDL_STARTING_DATA_RETRIEVAL:
-		if(lis3mdl_read_reg(devices, num_of_devices, dev_index, LIS3MDL_OUT_X_L_ADDR, 6) == HAL_OK){
+		slot = lis3mdl_sample_buffer_acquire_slot(samples);
+		if(slot == NULL){ // Consumer and the reads of other devices hold every slot
+			LIS3MDL_TELEMETRY_RETRY(dev_index);
+			return LIS3MDL_STARTING_DATA_RETRIEVAL;
+		}
+		// With the temperature due the burst continues to TEMP_OUT_H, which lands in `temperature` of the slot
+		flags = lis3mdl_thermal_is_burst_due(&devices[dev_index], dev_index) ? LIS3MDL_SAMPLE_TEMPERATURE : 0;
+		if(lis3mdl_read_reg_to_buffer(devices, num_of_devices, dev_index, LIS3MDL_OUT_X_L_ADDR, (uint8_t *)&slot->data,
+				flags ? LIS3MDL_THERMAL_BURST_SIZE : sizeof(slot->data), LIS3MDL_TRANSACTION_SAMPLE) == HAL_OK){
+			lis3mdl_sample_buffer_claim(samples, dev_index, flags);
+#if LIS3MDL_BUS_SINGLE_IRQ
+			devices[dev_index].bus->rx_frame = &slot->address_byte;
+#endif
 			devices[dev_index].data_retrieval_state = LIS3MDL_DATA_RETRIEVAL_IN_PROGRESS;
+			LIS3MDL_TRACE_RETRIEVAL_STATE(dev_index, LIS3MDL_DATA_RETRIEVAL_IN_PROGRESS);
 			return LIS3MDL_DATA_RETRIEVAL_IN_PROGRESS;
 		}
+		LIS3MDL_TELEMETRY_RETRY(dev_index);
 		return LIS3MDL_STARTING_DATA_RETRIEVAL;
 
 	case LIS3MDL_DATA_RETRIEVAL_IN_PROGRESS:
-		if(get_first_non_idling_device_index(devices, num_of_devices) < 0){ // Every device is idling including this one
-			results->x = (devices[dev_index].rx[1]) | (devices[dev_index].rx[0] << 8);
-			results->y = (devices[dev_index].rx[3]) | (devices[dev_index].rx[2] << 8);
-			results->z = (devices[dev_index].rx[5]) | (devices[dev_index].rx[4] << 8);
+		if(devices[dev_index].process_state == LIS3MDL_IDLE){ // The read into the claimed slot completed
+			slot = lis3mdl_sample_buffer_get_claimed_slot(samples, dev_index);
+			if(slot == NULL)
+				return LIS3MDL_DATA_RETRIEVAL_ERROR;
+			if(slot->flags & LIS3MDL_SAMPLE_TEMPERATURE){
+				decode_temperature_in_place(&devices[dev_index], slot);
+				lis3mdl_thermal_set_temperature(dev_index, slot->temperature);
+			}
+			lis3mdl_decode_sample_in_place(&devices[dev_index], &slot->data);
+			lis3mdl_thermal_compensate(dev_index, &slot->data);
+			lis3mdl_sample_buffer_commit(samples, slot);
+			LIS3MDL_TELEMETRY_SAMPLE(dev_index);
 
-			devices[dev_index].data_retrieval_state = LIS3MDL_STARTING_STATUS_CHECK;
+			devices[dev_index].data_retrieval_state = LIS3MDL_WAITING_FOR_DATA_READY;
+			LIS3MDL_TRACE_RETRIEVAL_STATE(dev_index, LIS3MDL_WAITING_FOR_DATA_READY);
 			return LIS3MDL_DATA_AVAILABLE;
 		}
 		return LIS3MDL_DATA_RETRIEVAL_IN_PROGRESS;
@@ -206,6 +382,58 @@ LIS3MDL_Data_Retrieval_State_t lis3mdl_get_magnetic_data(LIS3MDL_Device *devices
 
 }
 
+/**
+  * @brief Tells how long the devices need no attention, so the caller can sleep meanwhile.
+  *
+  * @param devices Pointer to the array of LIS3MDL_Device structures.
+  * @param num_of_devices The total number of devices in the `devices` array.
+  * @param now_us Current time from `lis3mdl_get_tick_us`.
+  *
+  * @retval LIS3MDL_IDLE_UNTIL_TRANSFER_CPLT If a DMA transfer is in flight, nothing happens
+  * until its completion interrupt.
+  * @retval 0 If a transaction or a step of `lis3mdl_get_magnetic_data` is pending.
+  * @retval Otherwise the microseconds until the first device's status read is due.
+  */
+
+uint32_t lis3mdl_get_idle_time_us(const LIS3MDL_Device *devices, uint8_t num_of_devices, uint32_t now_us){
+	if(devices == NULL)
+		return 0;
+
+	if(spi_transaction_started)
+		return LIS3MDL_IDLE_UNTIL_TRANSFER_CPLT;
+
+	uint32_t idle_us = LIS3MDL_IDLE_UNTIL_TRANSFER_CPLT - 1;
+	for(int i=0; i<num_of_devices; i++){
+		if(devices[i].process_state != LIS3MDL_IDLE || devices[i].data_retrieval_state != LIS3MDL_WAITING_FOR_DATA_READY)
+			return 0;
+		uint32_t until_due_us = lis3mdl_poll_scheduler_time_until_due_us(&devices[i].poll_schedule, now_us);
+		if(until_due_us < idle_us)
+			idle_us = until_due_us;
+	}
+	return idle_us;
+}
+
+/**
+  * @brief Turns the raw bytes the receive DMA left in a sample slot into axis values.
+  *
+  * When the device was configured with `LIS3MDL_NATIVE_ENDIANNESS` (the default) the
+  * OUT_X_L..OUT_Z_H burst already is an int16_t[3] in MCU byte order and nothing is done.
+  * Otherwise the two bytes of every axis are swapped.
+  *
+  * @param device Pointer to the LIS3MDL_Device the sample was read from.
+  * @param sample Pointer to the slot holding the raw OUT_X..OUT_Z burst.
+  */
+
+LIS3MDL_RAM_FUNC void lis3mdl_decode_sample_in_place(const LIS3MDL_Device *device, LIS3MDL_Magnetic_Data_t *sample){
+	LIS3MDL_Endianness endianness = (device->config_regs->ctrls[3] & LIS3MDL_BLE) ? LIS3MDL_BIG_ENDIAN : LIS3MDL_LITTLE_ENDIAN;
+	if(endianness == LIS3MDL_NATIVE_ENDIANNESS)
+		return;
+
+	sample->x = (int16_t)(((uint16_t)sample->x << 8) | ((uint16_t)sample->x >> 8));
+	sample->y = (int16_t)(((uint16_t)sample->y << 8) | ((uint16_t)sample->y >> 8));
+	sample->z = (int16_t)(((uint16_t)sample->z << 8) | ((uint16_t)sample->z >> 8));
+}
+
 /**
   * @brief Finds the index of the first LIS3MDL device in the array that is not in an idle state.
   *
@@ -234,14 +462,60 @@ int get_first_non_idling_device_index(LIS3MDL_Device *devices, uint8_t num_of_de
 	return -1;
 }
 
+/**
+  * @brief Asks the bus arbiter for the bus on behalf of a transaction, see lis3mdl_bus_arbiter.h.
+  * The arbiter is asked even while the bus is busy so the transaction keeps its place.
+  *
+  * @retval 1 if the transaction may be prepared now, 0 if it has to be retried later.
+  */
+
+static uint8_t request_bus(LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t device_index, LIS3MDL_Transaction_Class transaction_class){
+	uint32_t now_us = lis3mdl_get_tick_us();
+	uint8_t bus_free = get_first_non_idling_device_index(devices, num_of_devices) < 0;
+	uint32_t sample_slack_us = 0;
+	if(transaction_class == LIS3MDL_TRANSACTION_BACKGROUND && bus_free)
+		sample_slack_us = lis3mdl_get_idle_time_us(devices, num_of_devices, now_us);
+
+	uint8_t allowed = lis3mdl_bus_arbiter_request(transaction_class, device_index, now_us, sample_slack_us);
+	return allowed && bus_free;
+}
+
 /**
   * @brief Prepares a LIS3MDL device for a register read operation.
   *
   * This function sets up the necessary parameters within the LIS3MDL_Device structure
-  * to prepare for reading one or more registers from the sensor. It does not
-  * initiate the SPI communication directly; instead, it configures the device's
-  * state and parameters so that a subsequent call to `lis3mdl_process()` can
-  * execute the actual SPI read transaction via DMA.
+  * to prepare for reading one or more registers from the sensor into the `rx` buffer of
+  * its bus. It does not initiate the SPI communication directly; instead, it configures
+  * the device's state and parameters so that a subsequent call to `lis3mdl_process()` can
+  * execute the actual SPI read transaction via DMA. When the read completes a STATUS_REG
+  * value is handed off to the device's `status`, the rest of the burst stays in the bus
+  * `rx` buffer until the next transaction starts.
+  *
+  * @param devices Pointer to an array of LIS3MDL_Device structures.
+  * @param num_of_devices The total number of LIS3MDL devices in the `devices` array.
+  * @param device_index The index of the specific LIS3MDL device within the `devices` array
+  * for which the read operation is being prepared.
+  * @param reg The starting address of the register(s) to be read from the LIS3MDL sensor.
+  * This should be the raw register address without the read/multi-byte bits.
+  * @param size The number of bytes (registers) to read starting from the `reg` address.
+  * @param transaction_class Priority class of the read, see lis3mdl_bus_arbiter.h.
+  *
+  * @retval The return value of `lis3mdl_read_reg_to_buffer`.
+  */
+
+HAL_StatusTypeDef lis3mdl_read_reg(LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t device_index, uint8_t reg, uint8_t size, LIS3MDL_Transaction_Class transaction_class){
+	if(devices == NULL || devices[device_index].bus == NULL)
+		return HAL_ERROR;
+
+	return lis3mdl_read_reg_to_buffer(devices, num_of_devices, device_index, reg, devices[device_index].bus->rx, size, transaction_class);
+}
+
+/**
+  * @brief Prepares a LIS3MDL device for a register read operation into a caller provided buffer.
+  *
+  * Same as `lis3mdl_read_reg` except that the receive DMA writes straight into `destination`,
+  * which has to stay valid until the read completes. Nothing is cleared beforehand, so
+  * `destination` only holds valid data once the device is back to `LIS3MDL_IDLE`.
   *
   * @param devices Pointer to an array of LIS3MDL_Device structures.
   * @param num_of_devices The total number of LIS3MDL devices in the `devices` array.
@@ -249,37 +523,42 @@ int get_first_non_idling_device_index(LIS3MDL_Device *devices, uint8_t num_of_de
   * for which the read operation is being prepared.
   * @param reg The starting address of the register(s) to be read from the LIS3MDL sensor.
   * This should be the raw register address without the read/multi-byte bits.
+  * @param destination Buffer of at least `size` bytes the register contents are received into.
   * @param size The number of bytes (registers) to read starting from the `reg` address.
+  * @param transaction_class Priority class of the read, see lis3mdl_bus_arbiter.h.
   *
   * @retval HAL_OK If the device is successfully prepared for the read operation.
-  * @retval HAL_ERROR If any input parameter is invalid (e.g., NULL `devices` pointer,
-  * invalid `reg` flags, or `size` out of bounds), or if `lis3mdl_clear_data` fails.
+  * @retval HAL_ERROR If any input parameter is invalid (e.g., NULL `devices`, `destination`
+  * or bus pointer, invalid `reg` flags, or `size` out of bounds).
   * @retval HAL_BUSY If any LIS3MDL device (including the target `device_index`) is
-  * currently busy with another ongoing SPI transaction (i.e., not in `LIS3MDL_IDLE` state).
+  * currently busy with another ongoing SPI transaction (i.e., not in `LIS3MDL_IDLE` state),
+  * or if the bus arbiter lets a transaction of another class go first.
   */
 
-HAL_StatusTypeDef lis3mdl_read_reg(LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t device_index, uint8_t reg, uint8_t size){
-	if(devices == NULL)
+HAL_StatusTypeDef lis3mdl_read_reg_to_buffer(LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t device_index, uint8_t reg, uint8_t *destination, uint8_t size, LIS3MDL_Transaction_Class transaction_class){
+	if(devices == NULL || destination == NULL || devices[device_index].bus == NULL)
 		return HAL_ERROR;
 
-	if(get_first_non_idling_device_index(devices, num_of_devices) >= 0)
-		return HAL_BUSY;
-
 	if((reg & LIS3MDL_READ_BIT) == LIS3MDL_READ_BIT || (reg & LIS3MDL_MD_BIT) == LIS3MDL_MD_BIT)
 		return HAL_ERROR;
 
-	if(size < 1 || size > LIS3MDL_BUFFER_SIZE)
+	if(size < 1 || size > LIS3MDL_BUS_MAX_BURST)
 		return HAL_ERROR;
 
-	if(lis3mdl_clear_data(&devices[device_index])!=0)
-		return HAL_ERROR;
+	if(!request_bus(devices, num_of_devices, device_index, transaction_class))
+		return HAL_BUSY;
 
-	devices[device_index].reg_addr = reg | LIS3MDL_READ_BIT;
+	LIS3MDL_Bus *bus = devices[device_index].bus;
+	bus->tx[0] = reg | LIS3MDL_READ_BIT;
 	if(size > 1)
-		devices[device_index].reg_addr |= LIS3MDL_MD_BIT;
-	devices[device_index].data_size = size;
+		bus->tx[0] |= LIS3MDL_MD_BIT;
+	bus->data_size = size;
+	bus->rx_destination = destination;
+	bus->rx_frame = bus->rx;
 
 	devices[device_index].process_state = LIS3MDL_SENDING_ADDRESS_TO_READ_FROM;
+	LIS3MDL_TRACE_PROCESS_STATE(device_index, LIS3MDL_SENDING_ADDRESS_TO_READ_FROM);
+	lis3mdl_bus_arbiter_granted(transaction_class, device_index, lis3mdl_get_tick_us());
 
 	return HAL_OK;
 
@@ -302,66 +581,73 @@ HAL_StatusTypeDef lis3mdl_read_reg(LIS3MDL_Device *devices, uint8_t num_of_devic
   * This should be the raw register address without the read/multi-byte bits.
   * @param data Pointer to the buffer containing the data bytes to be written.
   * @param size The number of bytes (registers) to write starting from the `reg` address.
+  * @param transaction_class Priority class of the write, see lis3mdl_bus_arbiter.h.
   *
   * @retval HAL_OK If the device is successfully prepared for the write operation.
-  * @retval HAL_ERROR If any input parameter is invalid (e.g., NULL `devices` or `data` pointer,
-  * invalid `reg` flags, or `size` out of bounds), or if `lis3mdl_clear_data` fails.
+  * @retval HAL_ERROR If any input parameter is invalid (e.g., NULL `devices`, `data` or bus
+  * pointer, invalid `reg` flags, or `size` out of bounds), or if `lis3mdl_clear_data` fails.
   * @retval HAL_BUSY If any LIS3MDL device (including the target `device_index`) is
-  * currently busy with another ongoing SPI transaction (i.e., not in `LIS3MDL_IDLE` state).
+  * currently busy with another ongoing SPI transaction (i.e., not in `LIS3MDL_IDLE` state),
+  * or if the bus arbiter lets a transaction of another class go first.
   */
 
-HAL_StatusTypeDef lis3mdl_write_reg(LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t device_index, uint8_t reg, uint8_t *data, uint8_t size){
-	if(devices == NULL || data == NULL)
+HAL_StatusTypeDef lis3mdl_write_reg(LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t device_index, uint8_t reg, uint8_t *data, uint8_t size, LIS3MDL_Transaction_Class transaction_class){
+	if(devices == NULL || devices[device_index].bus == NULL || data == NULL)
 		return HAL_ERROR;
 
-	if(get_first_non_idling_device_index(devices, num_of_devices) >= 0)
-		return HAL_BUSY;
-
 	if((reg & LIS3MDL_READ_BIT) == LIS3MDL_READ_BIT || (reg & LIS3MDL_MD_BIT) == LIS3MDL_MD_BIT)
 		return HAL_ERROR;
 
-	if(size < 1 || size > LIS3MDL_BUFFER_SIZE)
+	if(size < 1 || size > LIS3MDL_BUS_MAX_BURST)
 		return HAL_ERROR;
 
+	if(!request_bus(devices, num_of_devices, device_index, transaction_class))
+		return HAL_BUSY;
+
 	if(lis3mdl_clear_data(&devices[device_index])!=0)
 		return HAL_ERROR;
 
-	devices[device_index].reg_addr = reg;
+	LIS3MDL_Bus *bus = devices[device_index].bus;
+	bus->tx[0] = reg;
 	if(size > 1)
-		devices[device_index].reg_addr |= LIS3MDL_MD_BIT;
-	devices[device_index].data_size = size;
+		bus->tx[0] |= LIS3MDL_MD_BIT;
+	bus->data_size = size;
 
 	for(int i=0; i<size; i++){
-		devices[device_index].tx[i] = data[i];
+		bus->tx[1 + i] = data[i];
 	}
 
 	devices[device_index].process_state = LIS3MDL_SENDING_ADDRESS_TO_WRITE_TO;
+	LIS3MDL_TRACE_PROCESS_STATE(device_index, LIS3MDL_SENDING_ADDRESS_TO_WRITE_TO);
+	lis3mdl_bus_arbiter_granted(transaction_class, device_index, lis3mdl_get_tick_us());
 
 	return HAL_OK;
 
 }
 
 /**
-  * @brief Clears the data buffers and resets transfer-related parameters within a LIS3MDL_Device structure.
+  * @brief Clears the data buffers and resets transfer-related parameters of the bus a LIS3MDL_Device is attached to.
   *
-  * This function zeroes out the transmit (tx) and receive (rx) buffers,
-  * and resets the register address, data size, and data available flag
-  * for a specific LIS3MDL device. It's typically called before initiating
-  * a new SPI transaction to ensure no residual data or flags interfere.
+  * This function zeroes out the receive (rx) buffer,
+  * and resets the register address and data size
+  * of the device's bus. It's typically called before initiating
+  * a new register write to ensure no residual data or flags interfere.
+  * Sample reads skip it, their destination is fully overwritten by the DMA.
   *
   * @param device Pointer to the LIS3MDL_Device structure whose data needs to be cleared.
   *
   * @retval 0 if the data was successfully cleared.
-  * @retval 1 if the `device` pointer is NULL.
+  * @retval 1 if the `device` or its bus pointer is NULL.
   */
 
 uint8_t lis3mdl_clear_data(LIS3MDL_Device *device){
-	if(device == NULL)
+	if(device == NULL || device->bus == NULL)
 		return 1;
 
-	//memset(device->tx, 0, LIS3MDL_BUFFER_SIZE);
-	memset(device->rx, 0, LIS3MDL_BUFFER_SIZE);
-	device->reg_addr = 0;
-	device->data_size = 0;
+	memset(device->bus->rx, 0, sizeof(device->bus->rx));
+	device->bus->rx_destination = device->bus->rx;
+	device->bus->rx_frame = device->bus->rx;
+	device->bus->tx[0] = 0;
+	device->bus->data_size = 0;
 	return 0;
 }
@@ -9,8 +9,12 @@
 #define DRIVERS_LIS3MDL_LIS3MDL_H_
 
 #include <lis3mdl_device.h>
+#include "lis3mdl_sample_buffer.h"
+#include "lis3mdl_bus_arbiter.h"
 #include <stdint.h>
 
+#define LIS3MDL_IDLE_UNTIL_TRANSFER_CPLT UINT32_MAX // Returned by lis3mdl_get_idle_time_us while a transfer is in flight
+
 /**
  * @brief Enumerates the possible status codes for the LIS3MDL device processing function.
  * These codes indicate the outcome or current state of the `lis3mdl_process` function.
@@ -20,14 +24,18 @@ typedef enum {
 	LIS3MDL_PROCESS_OK = 0x00,
 	LIS3MDL_PROCESS_ALL_DEVICES_IDLING = 0x01,
 	LIS3MDL_PROCESS_WAITING_FOR_SPI_CPLT = 0x02,
+	LIS3MDL_PROCESS_WAITING_FOR_REBOOT = 0x03,
 	LIS3MDL_PROCESS_ERROR
 }LIS3MDL_Process_Status_t;
 
 LIS3MDL_Process_Status_t lis3mdl_process(LIS3MDL_Device *devices, uint8_t num_of_devices, volatile uint8_t *spi_cplt_flag);
 int get_first_non_idling_device_index(LIS3MDL_Device *devices, uint8_t num_of_devices);
-LIS3MDL_Data_Retrieval_State_t lis3mdl_get_magnetic_data(LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t dev_index, LIS3MDL_Magnetic_Data_t *results);
-HAL_StatusTypeDef lis3mdl_read_reg(LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t device_index, uint8_t reg, uint8_t size);
-HAL_StatusTypeDef lis3mdl_write_reg(LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t device_index, uint8_t reg, uint8_t *data, uint8_t size);
+LIS3MDL_Data_Retrieval_State_t lis3mdl_get_magnetic_data(LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t dev_index, LIS3MDL_Sample_Buffer *samples);
+uint32_t lis3mdl_get_idle_time_us(const LIS3MDL_Device *devices, uint8_t num_of_devices, uint32_t now_us);
+void lis3mdl_decode_sample_in_place(const LIS3MDL_Device *device, LIS3MDL_Magnetic_Data_t *sample);
+HAL_StatusTypeDef lis3mdl_read_reg(LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t device_index, uint8_t reg, uint8_t size, LIS3MDL_Transaction_Class transaction_class);
+HAL_StatusTypeDef lis3mdl_read_reg_to_buffer(LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t device_index, uint8_t reg, uint8_t *destination, uint8_t size, LIS3MDL_Transaction_Class transaction_class);
+HAL_StatusTypeDef lis3mdl_write_reg(LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t device_index, uint8_t reg, uint8_t *data, uint8_t size, LIS3MDL_Transaction_Class transaction_class);
 uint8_t lis3mdl_clear_data(LIS3MDL_Device *device);
 
 #endif /* DRIVERS_LIS3MDL_LIS3MDL_H_ */
@@ -0,0 +1,33 @@
+/*
+ * lis3mdl_bus.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#include <string.h>
+#include "lis3mdl_bus.h"
+
+/**
+  * @brief Initializes a bus context with empty buffers.
+  *
+  * @param bus Pointer to the LIS3MDL_Bus to initialize.
+  * @param hspi Pointer to the SPI_HandleTypeDef of the bus.
+  *
+  * @retval 0 on success, 1 on NULL pointers.
+  */
+
+uint8_t lis3mdl_bus_init(LIS3MDL_Bus *bus, SPI_HandleTypeDef *hspi){
+	if(bus == NULL || hspi == NULL)
+		return 1;
+
+	memset(bus->tx, 0, sizeof(bus->tx));
+	memset(bus->rx, 0, sizeof(bus->rx));
+	bus->hspi = hspi;
+	bus->rx_destination = bus->rx;
+	bus->rx_frame = bus->rx;
+	bus->data_size = 0;
+	bus->cs_gpio_port = NULL;
+	bus->cs_pin = 0;
+	return 0;
+}
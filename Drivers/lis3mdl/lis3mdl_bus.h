@@ -0,0 +1,102 @@
+/*
+ * lis3mdl_bus.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef LIS3MDL_LIS3MDL_BUS_H_
+#define LIS3MDL_LIS3MDL_BUS_H_
+
+#include <stdint.h>
+#include "main.h"
+
+#define LIS3MDL_BUS_MAX_BURST 11 // STATUS_REG..INT_SRC, the longest block worth reading in one go
+#define LIS3MDL_BUS_BUFFER_SIZE (1 + LIS3MDL_BUS_MAX_BURST) // Address byte followed by the burst
+
+/*
+ * Transfer engine. By default every read and write is an address transfer followed by a
+ * data transfer, both through the HAL DMA functions, which costs several interrupt entries
+ * each. With LIS3MDL_BUS_SINGLE_IRQ set to 1 a transaction is a single full-duplex transfer
+ * of the address byte and the data from `tx` into `rx_frame`, started by `lis3mdl_bus_port_transfer`.
+ * `rx_frame` is `rx`, except for sample reads, which receive straight into their slot of the
+ * sample buffer with the address byte in the byte in front of it.
+ * The port releases CS in the one interrupt it takes, receive DMA complete, and reports
+ * the completion through HAL_SPI_RxCpltCallback like the HAL does.
+ *
+ * The next transaction is not started from that interrupt. There is none waiting: the bus
+ * buffers hold a single transaction and a read is only prepared once every device is idle.
+ * `lis3mdl_process` picks the next device and starts its transfer in the same call that
+ * completes the previous one.
+ */
+#ifndef LIS3MDL_BUS_SINGLE_IRQ
+#define LIS3MDL_BUS_SINGLE_IRQ 0
+#endif
+
+/*
+ * Hot path placement. With LIS3MDL_HOT_PATH_IN_RAM set to 1 the code between the DMA
+ * interrupt and a decoded sample, i.e. the acquisition interrupt handler, the port engine,
+ * the SPI completion callbacks, lis3mdl_process with its state change and the sample
+ * decode, goes to .RamFunc.lis3mdl. The linker script copies it to SRAM with .data and
+ * brackets it with _slis3mdl_ramfunc and _elis3mdl_ramfunc, the map file lists the moved
+ * functions and LIS3MDL_RAMFUNC_SIZE. It runs without the flash wait state and without
+ * refilling the prefetch buffer on every branch.
+ *
+ * Only that top-level code moves. Everything it calls stays in flash and is reached through
+ * linker veneers:
+ * - the bus arbiter, the init planner and the poll scheduler
+ * - `lis3mdl_get_tick_us`
+ * - the telemetry and trace hooks
+ * - HAL_DMA_IRQHandler, the HAL_SPI_*_DMA calls and libgcc
+ * Those calls still pay the wait state. Moving them too would cost several hundred bytes
+ * of the 8 KB of SRAM for code that runs once per transfer rather than once per branch.
+ */
+#ifndef LIS3MDL_HOT_PATH_IN_RAM
+#define LIS3MDL_HOT_PATH_IN_RAM 0
+#endif
+
+#if LIS3MDL_HOT_PATH_IN_RAM
+#define LIS3MDL_RAM_FUNC __attribute__((section(".RamFunc.lis3mdl")))
+#else
+#define LIS3MDL_RAM_FUNC
+#endif
+
+/*
+ * Attributes of the DMA buffers, overridable to place them in a specific RAM section.
+ * Word alignment lets the DMA and memcpy work on whole words.
+ */
+#ifndef LIS3MDL_BUS_DMA_BUFFER_ATTR
+#define LIS3MDL_BUS_DMA_BUFFER_ATTR __attribute__((aligned(4)))
+#endif
+
+/**
+ * @brief An SPI bus LIS3MDL devices are attached to and the buffers its transfers use.
+ *
+ * Only one device of a bus is in a transaction at a time, so the transmit and receive
+ * buffers and the transfer parameters belong to the bus rather than to every device.
+ * Results are handed off when a transfer completes (see `lis3mdl_process`), the buffers
+ * only hold them until the next transaction starts.
+ */
+
+typedef struct {
+	uint8_t tx[LIS3MDL_BUS_BUFFER_SIZE] LIS3MDL_BUS_DMA_BUFFER_ATTR; // tx[0] is the register address
+	uint8_t rx[LIS3MDL_BUS_BUFFER_SIZE] LIS3MDL_BUS_DMA_BUFFER_ATTR;
+	SPI_HandleTypeDef *hspi;
+	uint8_t *rx_destination; // Where the receive DMA writes, either rx or a caller provided buffer
+	uint8_t *rx_frame; // Single interrupt engine, receives the address byte followed by the data
+	uint8_t data_size; // Bytes after the address byte
+	GPIO_TypeDef *cs_gpio_port; // Chip select the port releases when the transfer completes
+	uint16_t cs_pin;
+} LIS3MDL_Bus;
+
+uint8_t lis3mdl_bus_init(LIS3MDL_Bus *bus, SPI_HandleTypeDef *hspi);
+
+/*
+ * Single interrupt engine, Core/Src/lis3mdl_bus_port.c on target and the HAL mock on the
+ * host. Only used with LIS3MDL_BUS_SINGLE_IRQ.
+ */
+void lis3mdl_bus_port_init(LIS3MDL_Bus *bus);
+HAL_StatusTypeDef lis3mdl_bus_port_transfer(LIS3MDL_Bus *bus, GPIO_TypeDef *cs_gpio_port, uint16_t cs_pin, uint8_t size);
+void lis3mdl_bus_port_irq(void);
+
+#endif /* LIS3MDL_LIS3MDL_BUS_H_ */
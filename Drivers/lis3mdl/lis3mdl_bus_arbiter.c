@@ -0,0 +1,167 @@
+/*
+ * lis3mdl_bus_arbiter.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Decides which class of transaction gets the bus next. The transmit and receive buffers
+ * belong to the bus, so only one transaction can be prepared at a time and the queue is
+ * kept as the set of devices that asked for the bus per class and did not get it yet.
+ * `lis3mdl_read_reg_to_buffer` and `lis3mdl_write_reg` ask on every attempt and only
+ * prepare the transaction that `lis3mdl_process` starts next once the arbiter agrees.
+ * A request counts for the round of `lis3mdl_process` it was made in and the next one,
+ * so a caller that stops asking, e.g. because its own sample is under way, cannot hold
+ * the other classes up.
+ *
+ * Within a class the devices take turns: a device is turned down while another one that
+ * comes before it, counting on from the device granted last, is queued as well. Otherwise
+ * the device that asks first in the main loop would win every time the bus frees up.
+ *
+ * Sample reads win over everything else, except over a control write that has been waiting
+ * for LIS3MDL_BUS_ARBITER_CONTROL_MAX_WAIT_US, which bounds its latency. Background work
+ * only gets the bus while nobody else waits and the next status read is further away than
+ * the longest transaction seen, so it fills the gaps between samples instead of delaying them.
+ */
+
+#include <string.h>
+#include "lis3mdl_bus_arbiter.h"
+
+_Static_assert(LIS3MDL_BUS_ARBITER_MAX_DEVICES <= 32, "The queues keep one bit per device in a uint32_t");
+
+static uint32_t waiting[LIS3MDL_TRANSACTION_CLASS_COUNT]; // Bit per device index, requests of this round
+static uint32_t waited[LIS3MDL_TRANSACTION_CLASS_COUNT]; // Requests of the previous round
+static uint8_t turn[LIS3MDL_TRANSACTION_CLASS_COUNT]; // Device index the round robin of a class starts at
+static uint32_t control_requested_us[LIS3MDL_BUS_ARBITER_MAX_DEVICES]; // First request of each queued control write
+static uint32_t grant_us = 0;
+static uint8_t grant_open = 0; // A granted transaction has not released CS yet
+static LIS3MDL_Bus_Arbiter_Stats stats;
+
+static uint32_t device_bit(uint8_t dev_index){
+	return 1UL << dev_index;
+}
+
+static uint32_t get_pending(LIS3MDL_Transaction_Class transaction_class){
+	return waiting[transaction_class] | waited[transaction_class];
+}
+
+/**
+  * @brief Tells whether another queued device of the class comes before `dev_index` in turn.
+  */
+
+static uint8_t is_turn_of_other(LIS3MDL_Transaction_Class transaction_class, uint8_t dev_index){
+	uint32_t from_turn = ~0UL << turn[transaction_class];
+	uint32_t below_device = device_bit(dev_index) - 1;
+	uint32_t ahead = turn[transaction_class] <= dev_index ? from_turn & below_device : from_turn | below_device;
+	return (get_pending(transaction_class) & ahead) != 0;
+}
+
+/**
+  * @brief Tells whether a queued control write has been waiting for LIS3MDL_BUS_ARBITER_CONTROL_MAX_WAIT_US.
+  */
+
+static uint8_t is_control_overdue(uint32_t now_us){
+	uint32_t pending = get_pending(LIS3MDL_TRANSACTION_CONTROL);
+	for(uint8_t i=0; pending != 0; i++, pending >>= 1){
+		if((pending & 1) && now_us - control_requested_us[i] >= LIS3MDL_BUS_ARBITER_CONTROL_MAX_WAIT_US)
+			return 1;
+	}
+	return 0;
+}
+
+void lis3mdl_bus_arbiter_reset(void){
+	memset(waiting, 0, sizeof(waiting));
+	memset(waited, 0, sizeof(waited));
+	memset(turn, 0, sizeof(turn));
+	memset(&stats, 0, sizeof(stats));
+	grant_open = 0;
+}
+
+/**
+  * @brief Registers that a device wants the bus for a transaction and tells whether it
+  * may have it. A device that is turned down has to ask again, it keeps its place meanwhile.
+  *
+  * @param transaction_class Class of the transaction.
+  * @param dev_index Index of the device the transaction is for.
+  * @param now_us Current time from `lis3mdl_get_tick_us`.
+  * @param sample_slack_us Time until the next status read is due, see `lis3mdl_get_idle_time_us`.
+  * Only used for background transactions.
+  *
+  * @retval 1 if the transaction may start as soon as the bus is free, 0 if another class or
+  * another device of the class goes first or the class or device index is out of range.
+  */
+
+uint8_t lis3mdl_bus_arbiter_request(LIS3MDL_Transaction_Class transaction_class, uint8_t dev_index, uint32_t now_us, uint32_t sample_slack_us){
+	if(transaction_class >= LIS3MDL_TRANSACTION_CLASS_COUNT || dev_index >= LIS3MDL_BUS_ARBITER_MAX_DEVICES)
+		return 0;
+
+	if(transaction_class == LIS3MDL_TRANSACTION_CONTROL && (get_pending(LIS3MDL_TRANSACTION_CONTROL) & device_bit(dev_index)) == 0)
+		control_requested_us[dev_index] = now_us;
+	waiting[transaction_class] |= device_bit(dev_index);
+
+	uint8_t control_overdue = is_control_overdue(now_us);
+	uint8_t allowed;
+	switch(transaction_class){
+	case LIS3MDL_TRANSACTION_SAMPLE:
+		allowed = !control_overdue;
+		break;
+	case LIS3MDL_TRANSACTION_CONTROL:
+		allowed = control_overdue || get_pending(LIS3MDL_TRANSACTION_SAMPLE) == 0;
+		break;
+	default:
+		allowed = get_pending(LIS3MDL_TRANSACTION_SAMPLE) == 0 && get_pending(LIS3MDL_TRANSACTION_CONTROL) == 0
+				&& sample_slack_us >= stats.longest_transaction_us + LIS3MDL_BUS_ARBITER_BACKGROUND_MARGIN_US;
+		break;
+	}
+	if(!allowed)
+		stats.deferrals[transaction_class]++;
+	return allowed && !is_turn_of_other(transaction_class, dev_index);
+}
+
+/**
+  * @brief Takes a device out of the queue of its class once its transaction is prepared.
+  */
+
+void lis3mdl_bus_arbiter_granted(LIS3MDL_Transaction_Class transaction_class, uint8_t dev_index, uint32_t now_us){
+	if(transaction_class >= LIS3MDL_TRANSACTION_CLASS_COUNT || dev_index >= LIS3MDL_BUS_ARBITER_MAX_DEVICES)
+		return;
+
+	waiting[transaction_class] &= ~device_bit(dev_index);
+	waited[transaction_class] &= ~device_bit(dev_index);
+	stats.grants[transaction_class]++;
+	turn[transaction_class] = (dev_index + 1) % LIS3MDL_BUS_ARBITER_MAX_DEVICES;
+	if(transaction_class == LIS3MDL_TRANSACTION_CONTROL && now_us - control_requested_us[dev_index] > stats.max_control_wait_us)
+		stats.max_control_wait_us = now_us - control_requested_us[dev_index];
+	grant_us = now_us;
+	grant_open = 1;
+}
+
+/**
+  * @brief Starts a new round, called by `lis3mdl_process` on every call. Requests that
+  * were not repeated since the previous round are dropped.
+  */
+
+void lis3mdl_bus_arbiter_new_round(void){
+	memcpy(waited, waiting, sizeof(waited));
+	memset(waiting, 0, sizeof(waiting));
+}
+
+/**
+  * @brief Called by `lis3mdl_process` when a transaction released CS.
+  * Transactions the arbiter did not grant, like the init sequence, are not measured.
+  */
+
+void lis3mdl_bus_arbiter_transaction_done(uint32_t now_us){
+	if(!grant_open)
+		return;
+
+	grant_open = 0;
+	uint32_t duration_us = now_us - grant_us;
+	if(duration_us > stats.longest_transaction_us)
+		stats.longest_transaction_us = duration_us;
+	else
+		stats.longest_transaction_us -= (stats.longest_transaction_us - duration_us) >> LIS3MDL_BUS_ARBITER_DECAY_SHIFT;
+}
+
+const LIS3MDL_Bus_Arbiter_Stats *lis3mdl_bus_arbiter_get_stats(void){
+	return &stats;
+}
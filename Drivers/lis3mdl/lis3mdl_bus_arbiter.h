@@ -0,0 +1,56 @@
+/*
+ * lis3mdl_bus_arbiter.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef LIS3MDL_LIS3MDL_BUS_ARBITER_H_
+#define LIS3MDL_LIS3MDL_BUS_ARBITER_H_
+
+#include <stdint.h>
+
+#ifndef LIS3MDL_BUS_ARBITER_CONTROL_MAX_WAIT_US
+#define LIS3MDL_BUS_ARBITER_CONTROL_MAX_WAIT_US 5000 // Longest sample reads may keep a control write waiting
+#endif
+
+#ifndef LIS3MDL_BUS_ARBITER_BACKGROUND_MARGIN_US
+#define LIS3MDL_BUS_ARBITER_BACKGROUND_MARGIN_US 200 // Added to the longest transaction before a status read falls due
+#endif
+
+#ifndef LIS3MDL_BUS_ARBITER_MAX_DEVICES
+#define LIS3MDL_BUS_ARBITER_MAX_DEVICES 32 // One bit per device index in the queues, so at most 32
+#endif
+
+#define LIS3MDL_BUS_ARBITER_DECAY_SHIFT 4 // A shorter transaction pulls the longest one seen 1/16 of the way down
+
+/**
+ * @brief Priority class of a bus transaction, lower values win the bus first.
+ */
+
+typedef enum {
+	LIS3MDL_TRANSACTION_SAMPLE = 0x00, // Status polls and data reads of lis3mdl_get_magnetic_data
+	LIS3MDL_TRANSACTION_CONTROL = 0x01, // Configuration writes, e.g. of the ODR controller
+	LIS3MDL_TRANSACTION_BACKGROUND = 0x02, // Self-test, diagnostics and temperature reads
+	LIS3MDL_TRANSACTION_CLASS_COUNT
+} LIS3MDL_Transaction_Class;
+
+/**
+ * @brief What the arbiter decided since `lis3mdl_bus_arbiter_reset`.
+ */
+
+typedef struct {
+	uint32_t grants[LIS3MDL_TRANSACTION_CLASS_COUNT];
+	uint32_t deferrals[LIS3MDL_TRANSACTION_CLASS_COUNT]; // Requests turned down in favour of another class
+	uint32_t max_control_wait_us; // Longest first request to grant of a control write
+	uint32_t longest_transaction_us; // Grant to CS release, decaying, what background work has to fit in
+} LIS3MDL_Bus_Arbiter_Stats;
+
+void lis3mdl_bus_arbiter_reset(void);
+uint8_t lis3mdl_bus_arbiter_request(LIS3MDL_Transaction_Class transaction_class, uint8_t dev_index, uint32_t now_us, uint32_t sample_slack_us);
+void lis3mdl_bus_arbiter_granted(LIS3MDL_Transaction_Class transaction_class, uint8_t dev_index, uint32_t now_us);
+void lis3mdl_bus_arbiter_new_round(void);
+void lis3mdl_bus_arbiter_transaction_done(uint32_t now_us);
+const LIS3MDL_Bus_Arbiter_Stats *lis3mdl_bus_arbiter_get_stats(void);
+
+#endif /* LIS3MDL_LIS3MDL_BUS_ARBITER_H_ */
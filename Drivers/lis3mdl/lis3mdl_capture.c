@@ -0,0 +1,75 @@
+/*
+ * lis3mdl_capture.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#include <string.h>
+#include "lis3mdl_capture.h"
+#include "lis3mdl_registers.h"
+#include "lis3mdl_thermal.h"
+
+/**
+  * @brief Fills the header of a capture from the devices being captured.
+  *
+  * @param header Pointer to the header to fill.
+  * @param devices Pointer to the array of LIS3MDL_Device structures.
+  * @param num_of_devices The total number of devices in the `devices` array.
+  *
+  * @retval 0 on success, 1 on NULL pointers or more than LIS3MDL_CAPTURE_MAX_DEVICES devices.
+  */
+
+uint8_t lis3mdl_capture_init_header(LIS3MDL_Capture_Header *header, const LIS3MDL_Device *devices, uint8_t num_of_devices){
+	if(header == NULL || devices == NULL || num_of_devices > LIS3MDL_CAPTURE_MAX_DEVICES)
+		return 1;
+
+	memset(header, 0, sizeof(*header));
+	header->magic = LIS3MDL_CAPTURE_MAGIC;
+	header->version = LIS3MDL_CAPTURE_VERSION;
+	header->record_size = sizeof(LIS3MDL_Capture_Record);
+	header->num_of_devices = num_of_devices;
+	for(int i=0; i<num_of_devices; i++)
+		if(devices[i].config_regs)
+			header->config[i] = *devices[i].config_regs;
+	return 0;
+}
+
+/**
+  * @brief Builds the record of a sample that was just committed, turning it back into the
+  * bytes the sensor sent.
+  *
+  * @param record Pointer to the record to fill.
+  * @param device Pointer to the LIS3MDL_Device the sample was read from. Its `status` still
+  * holds the STATUS_REG value that led to the read.
+  * @param dev_index Index of the device in the array passed to `lis3mdl_get_magnetic_data`.
+  * @param sample Pointer to the decoded sample.
+  *
+  * @retval 0 on success, 1 on NULL pointers.
+  */
+
+uint8_t lis3mdl_capture_make_record(LIS3MDL_Capture_Record *record, const LIS3MDL_Device *device, uint8_t dev_index, const LIS3MDL_Magnetic_Data_t *sample){
+	if(record == NULL || device == NULL || device->config_regs == NULL || sample == NULL)
+		return 1;
+
+	int16_t axes[3] = { sample->x, sample->y, sample->z };
+	uint8_t big_endian = device->config_regs->ctrls[3] & LIS3MDL_BLE;
+
+	record->time_us = lis3mdl_get_tick_us();
+	record->dev_index = dev_index;
+	record->status = device->status;
+	record->flags = 0;
+	record->reserved = 0;
+	for(int i=0; i<3; i++){
+		record->out[2*i] = big_endian ? (uint8_t)((uint16_t)axes[i] >> 8) : (uint8_t)axes[i];
+		record->out[2*i + 1] = big_endian ? (uint8_t)axes[i] : (uint8_t)((uint16_t)axes[i] >> 8);
+	}
+	int16_t temperature = 0;
+	if(lis3mdl_thermal_get_temperature(dev_index, &temperature) == 0)
+		record->flags |= LIS3MDL_CAPTURE_HAS_TEMPERATURE;
+	if(lis3mdl_thermal_is_compensating(dev_index))
+		record->flags |= LIS3MDL_CAPTURE_COMPENSATED;
+	record->temp[0] = (uint8_t)temperature;
+	record->temp[1] = (uint8_t)((uint16_t)temperature >> 8);
+	return 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * lis3mdl_capture.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef LIS3MDL_LIS3MDL_CAPTURE_H_
+#define LIS3MDL_LIS3MDL_CAPTURE_H_
+
+#include <stdint.h>
+#include "lis3mdl_device.h"
+
+/*
+ * Capture format for sample streams read from real sensors, replayed into the simulated
+ * LIS3MDL by Host/sim/lis3mdl_replay. A capture is one LIS3MDL_Capture_Header followed
+ * by LIS3MDL_Capture_Record entries in the order the samples were committed, all little
+ * endian as both the target and the PC store them. How the bytes leave the target (UART,
+ * SWO, a debugger dump of a RAM buffer) is up to the application.
+ */
+
+#define LIS3MDL_CAPTURE_MAGIC 0x4D43334CUL // "L3CM"
+#define LIS3MDL_CAPTURE_VERSION 1
+#define LIS3MDL_CAPTURE_MAX_DEVICES 16
+
+#define LIS3MDL_CAPTURE_HAS_TEMPERATURE 0x01 // `temp` holds TEMP_OUT_L/H of the last temperature burst
+#define LIS3MDL_CAPTURE_SELF_TEST 0x02 // Taken while the self-test field could be on, not a measurement
+#define LIS3MDL_CAPTURE_COMPENSATED 0x04 // `out` has the thermal offset of lis3mdl_thermal.h subtracted
+
+/**
+ * @brief Start of a capture, the configuration every device was running with.
+ */
+
+typedef struct __attribute__((packed)) {
+	uint32_t magic;
+	uint8_t version;
+	uint8_t record_size;
+	uint8_t num_of_devices;
+	uint8_t reserved;
+	LIS3MDL_Config_regs config[LIS3MDL_CAPTURE_MAX_DEVICES];
+} LIS3MDL_Capture_Header;
+
+/**
+ * @brief One sample burst as it was read from the sensor.
+ */
+
+typedef struct __attribute__((packed)) {
+	uint32_t time_us; // lis3mdl_get_tick_us when the sample was committed
+	uint8_t dev_index;
+	uint8_t status; // STATUS_REG read that found the sample, ZYXOR tells a sample was lost before it
+	uint8_t flags;
+	uint8_t reserved;
+	uint8_t out[6]; // OUT_X_L..OUT_Z_H in the byte order CTRL_REG4 selects
+	uint8_t temp[2];
+} LIS3MDL_Capture_Record;
+
+_Static_assert(sizeof(LIS3MDL_Capture_Record) == 16, "LIS3MDL_Capture_Record is part of the file format");
+
+uint8_t lis3mdl_capture_init_header(LIS3MDL_Capture_Header *header, const LIS3MDL_Device *devices, uint8_t num_of_devices);
+uint8_t lis3mdl_capture_make_record(LIS3MDL_Capture_Record *record, const LIS3MDL_Device *device, uint8_t dev_index, const LIS3MDL_Magnetic_Data_t *sample);
+
+#endif /* LIS3MDL_LIS3MDL_CAPTURE_H_ */
@@ -12,25 +12,24 @@
   * @brief Initializes the LIS3MDL_Device structure with default values and hardware handles.
   *
   * @param device Pointer to the LIS3MDL_Device structure to initialize.
-  * @param hspi Pointer to the SPI_HandleTypeDef structure associated with the LIS3MDL.
+  * @param bus Pointer to the LIS3MDL_Bus the LIS3MDL is attached to, see `lis3mdl_bus_init`.
   * @param cs_gpio_port_handle Pointer to the GPIO_TypeDef for the Chip Select (CS) pin's port.
   * @param cs_pin GPIO pin number for the Chip Select (CS) pin.
   *
   * @retval 0 on success, 1 on error (e.g., NULL pointer).
   */
 
-uint8_t lis3mdl_initialize_device_struct(LIS3MDL_Device *device, SPI_HandleTypeDef *hspi, GPIO_TypeDef *cs_gpio_port_handle, uint16_t cs_pin){
-	if (device == NULL || hspi == NULL || cs_gpio_port_handle == NULL)
+uint8_t lis3mdl_initialize_device_struct(LIS3MDL_Device *device, LIS3MDL_Bus *bus, GPIO_TypeDef *cs_gpio_port_handle, uint16_t cs_pin){
+	if (device == NULL || bus == NULL || cs_gpio_port_handle == NULL)
 		return 1;
 
+	device->config_regs = NULL; // Set by lis3mdl_setup_config_registers
 	device->process_state = LIS3MDL_RESETTING_REGISTERS;
 	device->data_retrieval_state = LIS3MDL_STARTING_STATUS_CHECK;
+	memset(&device->poll_schedule, 0, sizeof(device->poll_schedule)); // Polls on every call until configured
 
-	device->reg_addr = 0;
-	device->data_size = 0;
-	memset(device->rx, 0, LIS3MDL_BUFFER_SIZE);
-	memset(device->tx, 0, LIS3MDL_BUFFER_SIZE);
-	device->hspi = hspi;
+	device->status = 0;
+	device->bus = bus;
 	device->cs_gpio_port_handle = cs_gpio_port_handle;
 	device->cs_pin = cs_pin;
 
@@ -38,16 +37,40 @@ uint8_t lis3mdl_initialize_device_struct(LIS3MDL_Device *device, SPI_HandleTypeD
 }
 
 /**
-  * @brief Populates the LIS3MDL configuration registers within the device struct based on input parameters.
-  * This function typically calls an internal helper function to map initialization parameters
-  * to the specific register values for offsets, control registers, and interrupt registers.
+  * @brief Turns initialization parameters into the register image written to the sensor.
+  * Devices sharing a configuration can share one image.
   *
-  * @param device Pointer to the LIS3MDL_Device structure whose config_regs member will be updated.
+  * @param config_regs Pointer to the image to fill.
   * @param input_params A structure containing desired initialization parameters (e.g., ODR, Full Scale, etc.).
   *
-  * @retval The return value from lis3mdl_put_params_into_registers (0 on success, non-zero on error).
+  * @retval The return value from lis3mdl_put_params_into_registers (0 on success, non-zero on error),
+  * 1 if `config_regs` is NULL.
   */
 
-uint8_t lis3mdl_setup_config_registers(LIS3MDL_Device *device, LIS3MDL_Init_Params input_params){
-	return lis3mdl_put_params_into_registers(input_params, device->config_regs.offsets, device->config_regs.ctrls, device->config_regs.ints);
+uint8_t lis3mdl_build_config_image(LIS3MDL_Config_regs *config_regs, LIS3MDL_Init_Params input_params){
+	if(config_regs == NULL)
+		return 1;
+
+	return lis3mdl_put_params_into_registers(input_params, config_regs->offsets, config_regs->ctrls, config_regs->ints);
+}
+
+/**
+  * @brief Selects the register image a device is initialized with.
+  * Only a pointer is kept, the image has to outlive the device and may be a const image in
+  * flash or one built by `lis3mdl_build_config_image`. The status polling schedule is
+  * restarted for the resulting output data rate.
+  *
+  * @param device Pointer to the LIS3MDL_Device structure.
+  * @param config_regs Pointer to the register image.
+  *
+  * @retval 0 on success, 1 on NULL pointers.
+  */
+
+uint8_t lis3mdl_setup_config_registers(LIS3MDL_Device *device, const LIS3MDL_Config_regs *config_regs){
+	if(device == NULL || config_regs == NULL)
+		return 1;
+
+	device->config_regs = config_regs;
+	lis3mdl_poll_scheduler_reset(&device->poll_schedule, config_regs->ctrls);
+	return 0;
 }
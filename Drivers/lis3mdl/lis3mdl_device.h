@@ -11,48 +11,58 @@
 
 #include <lis3mdl_process_state_machine.h>
 #include <stdint.h>
+#include "lis3mdl_bus.h"
 #include "lis3mdl_init_params.h"
+#include "lis3mdl_poll_scheduler.h"
 #include "main.h"
 
-#define LIS3MDL_BUFFER_SIZE 6 // Since there are no more than 6 writable registers
+/*
+ * RAM a LIS3MDL_Device may take on the 32-bit target, checked below. With 32 sensors the
+ * devices stay under 1.5 KB of the L053's 8 KB, leaving room for the sample buffer and stack.
+ */
+#define LIS3MDL_DEVICE_RAM_BUDGET 44
 
 /**
  * @brief Enumerates the states for LIS3MDL magnetic data retrieval process.
  */
 
-typedef enum {
+typedef enum __attribute__((packed)) {
 	LIS3MDL_DATA_AVAILABLE = 0x00,
 	LIS3MDL_STARTING_STATUS_CHECK = 0x01,
 	LIS3MDL_STATUS_CHECK_IN_PROGRESS = 0x02,
 	LIS3MDL_STARTING_DATA_RETRIEVAL = 0x03,
 	LIS3MDL_DATA_RETRIEVAL_IN_PROGRESS = 0x04,
-	LIS3MDL_DATA_RETRIEVAL_ERROR = 0x05
+	LIS3MDL_DATA_RETRIEVAL_ERROR = 0x05,
+	LIS3MDL_WAITING_FOR_DATA_READY = 0x06
 }LIS3MDL_Data_Retrieval_State_t;
 
 /**
  * @brief Structure representing a single LIS3MDL device and its current state.
  * This holds all necessary information for managing communication and data with the sensor.
+ * Members are ordered by size so the struct has no padding on the target. Transfer buffers
+ * belong to the LIS3MDL_Bus the device is attached to.
  */
 
 typedef struct {
-	LIS3MDL_Config_regs config_regs;
-	LIS3MDL_Process_State_t process_state;
-	LIS3MDL_Data_Retrieval_State_t data_retrieval_state;
-
-	uint8_t reg_addr;
-	uint8_t tx[LIS3MDL_BUFFER_SIZE];
-	uint8_t rx[LIS3MDL_BUFFER_SIZE];
-	uint8_t data_size;
-
+	const LIS3MDL_Config_regs *config_regs; // Image written during initialization, may be shared and const in flash
 	GPIO_TypeDef *cs_gpio_port_handle;
+	LIS3MDL_Bus *bus;
+	LIS3MDL_Poll_Schedule poll_schedule;
+
 	uint16_t cs_pin;
-	SPI_HandleTypeDef *hspi;
+	LIS3MDL_Process_State_t process_state;
+	LIS3MDL_Data_Retrieval_State_t data_retrieval_state;
+	uint8_t status; // Last STATUS_REG value read, handed off from the bus when the read completes
 
 } LIS3MDL_Device;
 
+_Static_assert(sizeof(LIS3MDL_Data_Retrieval_State_t) == 1, "LIS3MDL_Data_Retrieval_State_t is stored in every LIS3MDL_Device");
+_Static_assert(sizeof(void *) != 4 || sizeof(LIS3MDL_Device) <= LIS3MDL_DEVICE_RAM_BUDGET, "LIS3MDL_Device exceeds LIS3MDL_DEVICE_RAM_BUDGET");
+
 /**
  * @brief Structure to hold the 3-axis magnetic field data (X, Y, Z).
  * Data is typically represented as 16-bit signed integers.
+ * The layout mirrors OUT_X_L..OUT_Z_H so a burst read can be received into it as is.
  */
 
 typedef struct{
@@ -61,7 +71,10 @@ typedef struct{
 	int16_t z;
 }LIS3MDL_Magnetic_Data_t;
 
-uint8_t lis3mdl_initialize_device_struct(LIS3MDL_Device *device, SPI_HandleTypeDef *hspi, GPIO_TypeDef *cs_gpio_port_handle, uint16_t cs_pin);
-uint8_t lis3mdl_setup_config_registers(LIS3MDL_Device *device, LIS3MDL_Init_Params input_params);
+_Static_assert(sizeof(LIS3MDL_Magnetic_Data_t) == 6, "LIS3MDL_Magnetic_Data_t has to match the OUT_X..OUT_Z register block");
+
+uint8_t lis3mdl_initialize_device_struct(LIS3MDL_Device *device, LIS3MDL_Bus *bus, GPIO_TypeDef *cs_gpio_port_handle, uint16_t cs_pin);
+uint8_t lis3mdl_build_config_image(LIS3MDL_Config_regs *config_regs, LIS3MDL_Init_Params input_params);
+uint8_t lis3mdl_setup_config_registers(LIS3MDL_Device *device, const LIS3MDL_Config_regs *config_regs);
 
 #endif /* LIS3MDL_LIS3MDL_DEVICE_H_ */
@@ -0,0 +1,422 @@
+/*
+ * lis3mdl_goertzel.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Detector for the AC field of nearby conductors. At the fast ODR rates the LIS3MDL sees
+ * the 50 or 60 Hz field of a mains cable, whose amplitude follows the load current. A bank
+ * of Goertzel filters, one per selected harmonic and axis, measures amplitude and phase of
+ * these tones over blocks of samples, so a node can report the current without sending
+ * the samples.
+ *
+ * Every sample runs s[n] = x[n] + 2 cos(w) s[n-1] - s[n-2] for every bin and axis. The
+ * coefficient is a Q16 cosine and the state is split into a high part and 15 low bits, so
+ * the product takes two 32 bit multiplications, which the M0+ executes in a cycle each, and
+ * no 64 bit arithmetic. The samples are shifted up by as many bits as the block length
+ * leaves room for, which keeps the rounding of the states below the sensor noise.
+ *
+ * At the end of a block X = e^(-jw(N-1)) (s[N-1] - e^(-jw) s[N-2]) is the DFT of the
+ * block at w, also for frequencies that do not fall on a DFT bin. Amplitude
+ * and phase are taken from it with CORDIC, which also computes the coefficients, so neither
+ * needs floating point.
+ *
+ * A bin sits exactly at the frequency its rounded coefficient stands for, a few mHz from
+ * the one asked for, and the result reports that frequency. Evaluating it at the requested
+ * frequency instead would turn the offset into errors of several LSB wherever the DC field
+ * leaks into the bin. Host/goertzel checks the results against a DFT in double precision.
+ *
+ * The sensor clock may be off by a few percent from the nominal ODR, so the bins follow the
+ * sample period the poll schedule measured for the device. `lis3mdl_goertzel_process`
+ * prepares the coefficients for the next block whenever that estimate moves, a block runs
+ * with the same coefficients from its first sample to its last.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "lis3mdl_goertzel.h"
+
+#define LIS3MDL_GOERTZEL_CORDIC_ITERATIONS 30
+#define LIS3MDL_GOERTZEL_CORDIC_GAIN_INVERSE_Q30 652032874 // Product of cos(atan(2^-i)) over the iterations
+#define LIS3MDL_GOERTZEL_AMPLITUDE_FRACTION_BITS 4
+#define LIS3MDL_GOERTZEL_VECTOR_BITS 28 // CORDIC inputs are normalized below this, the gain keeps them below 2^30
+#define LIS3MDL_GOERTZEL_STATE_BITS 29
+#define LIS3MDL_GOERTZEL_STATE_GAIN 11 // 1 / sin(w) for the bins closest to 0 and Nyquist, bounds the states
+
+/*
+ * atan(2^-i) in binary angle, 2^32 per turn.
+ */
+static const uint32_t cordic_angles[LIS3MDL_GOERTZEL_CORDIC_ITERATIONS] = {
+		536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838, 5340245,
+		2670163, 1335087, 667544, 333772, 166886, 83443, 41722, 20861,
+		10430, 5215, 2608, 1304, 652, 326, 163, 81,
+		41, 20, 10, 5, 3, 1
+};
+
+/**
+ * @brief Tuning of the bins to one sample period.
+ */
+
+typedef struct {
+	uint32_t frequency_mhz;
+	uint32_t step; // Phase advance per sample, 2^32 per turn
+	int32_t cos_q30;
+	int32_t sin_q30;
+	int32_t coefficient; // cos(w) in Q16, below 2^16 for every bin that is kept
+} LIS3MDL_Goertzel_Tuning;
+
+typedef struct {
+	uint32_t period_us;
+	uint32_t nominal_period_us; // The block restarts when the configuration changes it
+	uint8_t num_of_bins;
+	LIS3MDL_Goertzel_Tuning bins[LIS3MDL_GOERTZEL_MAX_BINS];
+} LIS3MDL_Goertzel_Setup;
+
+/**
+ * @brief Running block of one device and the last one completed.
+ */
+
+typedef struct {
+	LIS3MDL_Goertzel_Setup setup;
+	LIS3MDL_Goertzel_Setup next_setup;
+	int32_t state[LIS3MDL_GOERTZEL_MAX_BINS][3][2]; // s[n-1], s[n-2] per bin and axis
+	uint32_t start_us;
+	uint16_t samples;
+	uint8_t next_setup_ready;
+
+	LIS3MDL_Goertzel_Setup done_setup;
+	int32_t done_state[LIS3MDL_GOERTZEL_MAX_BINS][3][2];
+	uint32_t done_start_us;
+	uint8_t result_ready;
+} LIS3MDL_Goertzel_Track;
+
+static LIS3MDL_Goertzel_Params goertzel_params;
+static uint8_t input_shift = 0; // Fraction bits of the states
+static LIS3MDL_Goertzel_Track tracks[LIS3MDL_GOERTZEL_MAX_DEVICES];
+
+/**
+  * @brief Cosine and sine of a binary angle, CORDIC in rotation mode.
+  */
+
+static void cordic_rotate(uint32_t angle, int32_t *cos_q30, int32_t *sin_q30){
+	uint8_t negate = 0;
+	if((angle + 0x40000000UL) & 0x80000000UL){ // Beyond a quarter turn either way, rotate by half a turn
+		angle += 0x80000000UL;
+		negate = 1;
+	}
+
+	int32_t x = LIS3MDL_GOERTZEL_CORDIC_GAIN_INVERSE_Q30;
+	int32_t y = 0;
+	int32_t z = (int32_t)angle;
+	for(int i=0; i<LIS3MDL_GOERTZEL_CORDIC_ITERATIONS; i++){
+		int32_t x_shifted = x >> i;
+		if(z >= 0){
+			x -= y >> i;
+			y += x_shifted;
+			z -= (int32_t)cordic_angles[i];
+		}
+		else{
+			x += y >> i;
+			y -= x_shifted;
+			z += (int32_t)cordic_angles[i];
+		}
+	}
+	*cos_q30 = negate ? -x : x;
+	*sin_q30 = negate ? -y : y;
+}
+
+/**
+  * @brief Magnitude times the CORDIC gain and angle of a vector, CORDIC in vectoring mode.
+  * Both coordinates have to be below 2^LIS3MDL_GOERTZEL_VECTOR_BITS.
+  */
+
+static void cordic_vector(int32_t x, int32_t y, uint32_t *magnitude, uint32_t *angle){
+	uint32_t z = 0;
+	if(x < 0){
+		x = -x;
+		y = -y;
+		z = 0x80000000UL;
+	}
+
+	for(int i=0; i<LIS3MDL_GOERTZEL_CORDIC_ITERATIONS; i++){
+		int32_t x_shifted = x >> i;
+		if(y > 0){
+			x += y >> i;
+			y -= x_shifted;
+			z += cordic_angles[i];
+		}
+		else{
+			x -= y >> i;
+			y += x_shifted;
+			z -= cordic_angles[i];
+		}
+	}
+	*magnitude = (uint32_t)x;
+	*angle = z;
+}
+
+/**
+  * @brief Square root of a 64 bit value, rounded down.
+  */
+
+static uint32_t square_root(uint64_t value){
+	uint64_t root = 0;
+	for(uint64_t bit = 1ULL << 62; bit != 0; bit >>= 2){
+		if(value >= root + bit){
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+			root >>= 1;
+	}
+	return (uint32_t)root;
+}
+
+/**
+  * @brief 2 cos(w) times a state, the product of the recursion. The state is split at bit
+  * 15 so that both products fit 32 bits while states stay below 2^29.
+  */
+
+static inline int32_t multiply_coefficient(int32_t state, int32_t coefficient){
+	int32_t high = state >> 15;
+	int32_t low = (int32_t)((uint32_t)state & 0x7FFFU);
+	return coefficient * high + ((coefficient * low) >> 15);
+}
+
+/**
+  * @brief Sets the tones the detector looks for and drops all blocks. The bins are tuned
+  * once the sample period of a device is known.
+  *
+  * @param params Pointer to the tones, NULL or a `fundamental_mhz` of 0 disables the detector.
+  *
+  * @retval 0 on success, 1 if no harmonic is selected, more than LIS3MDL_GOERTZEL_MAX_BINS
+  * are or the block length is 0 or above LIS3MDL_GOERTZEL_MAX_BLOCK_SAMPLES.
+  */
+
+uint8_t lis3mdl_goertzel_init(const LIS3MDL_Goertzel_Params *params){
+	memset(&goertzel_params, 0, sizeof(goertzel_params));
+	memset(tracks, 0, sizeof(tracks));
+	if(params == NULL || params->fundamental_mhz == 0)
+		return 0;
+
+	uint8_t num_of_harmonics = 0;
+	for(int i=0; i<8; i++)
+		num_of_harmonics += (params->harmonics >> i) & 1;
+	if(num_of_harmonics == 0 || num_of_harmonics > LIS3MDL_GOERTZEL_MAX_BINS
+			|| params->block_samples == 0 || params->block_samples > LIS3MDL_GOERTZEL_MAX_BLOCK_SAMPLES)
+		return 1;
+
+	goertzel_params = *params;
+	// A block of full scale samples cannot drive a state beyond N * 2^15 / sin(w)
+	input_shift = 0;
+	while(((uint64_t)params->block_samples * LIS3MDL_GOERTZEL_STATE_GAIN << (15 + input_shift + 1)) < (1ULL << LIS3MDL_GOERTZEL_STATE_BITS))
+		input_shift++;
+	return 0;
+}
+
+/**
+  * @brief Tunes the bins of a device to its sample period, from the next block on.
+  *
+  * @param dev_index Index of the device.
+  * @param period_us Sample period of the device.
+  * @param restart 1 if the samples of the running block were taken at another rate and
+  * have to be dropped, 0 to let the block finish with the current tuning.
+  *
+  * @retval 0 on success, 1 if the detector is disabled or the index out of range.
+  */
+
+uint8_t lis3mdl_goertzel_set_sample_period_us(uint8_t dev_index, uint32_t period_us, uint8_t restart){
+	if(goertzel_params.fundamental_mhz == 0 || dev_index >= LIS3MDL_GOERTZEL_MAX_DEVICES)
+		return 1;
+
+	LIS3MDL_Goertzel_Track *track = &tracks[dev_index];
+	LIS3MDL_Goertzel_Setup *setup = &track->next_setup;
+	setup->period_us = period_us;
+	setup->num_of_bins = 0;
+	for(int harmonic=1; harmonic<=8 && period_us; harmonic++){
+		if(!(goertzel_params.harmonics & (1 << (harmonic - 1))))
+			continue;
+		uint64_t nano_turns = (uint64_t)goertzel_params.fundamental_mhz * harmonic * period_us; // Turns per sample times 10^9
+		if(nano_turns >= 500000000ULL) // At or above Nyquist
+			continue;
+		uint64_t step = (nano_turns << 32) / 1000000000ULL;
+		if(step < (1ULL << (32 - LIS3MDL_GOERTZEL_MIN_BIN_SHIFT)) || step > (1ULL << 31) - (1ULL << (32 - LIS3MDL_GOERTZEL_MIN_BIN_SHIFT)))
+			continue;
+
+		LIS3MDL_Goertzel_Tuning *bin = &setup->bins[setup->num_of_bins++];
+		int32_t cos_q30, sin_q30;
+		cordic_rotate((uint32_t)step, &cos_q30, &sin_q30);
+		bin->coefficient = (cos_q30 + (1L << 13)) >> 14;
+
+		// Where the rounded coefficient puts the bin
+		bin->cos_q30 = bin->coefficient * (1L << 14);
+		bin->sin_q30 = (int32_t)square_root((1ULL << 60) - (uint64_t)((int64_t)bin->cos_q30 * bin->cos_q30));
+		uint32_t magnitude;
+		cordic_vector(bin->cos_q30 >> 3, bin->sin_q30 >> 3, &magnitude, &bin->step);
+		bin->frequency_mhz = (uint32_t)(((uint64_t)bin->step * 1000000000ULL / period_us + (1ULL << 31)) >> 32);
+	}
+
+	track->next_setup_ready = 1;
+	if(restart || track->setup.period_us == 0)
+		lis3mdl_goertzel_restart_block(dev_index);
+	return 0;
+}
+
+/**
+  * @brief Follows the sample period the poll schedule of every device measures, call it
+  * on every pass of the loop. Coefficients are only computed when the estimate moved.
+  *
+  * @param devices Pointer to the array of LIS3MDL_Device structures.
+  * @param num_of_devices The total number of devices in the `devices` array.
+  */
+
+void lis3mdl_goertzel_process(const LIS3MDL_Device *devices, uint8_t num_of_devices){
+	if(goertzel_params.fundamental_mhz == 0 || devices == NULL)
+		return;
+
+	for(int i=0; i<num_of_devices && i<LIS3MDL_GOERTZEL_MAX_DEVICES; i++){
+		const LIS3MDL_Poll_Schedule *schedule = &devices[i].poll_schedule;
+		LIS3MDL_Goertzel_Track *track = &tracks[i];
+		const LIS3MDL_Goertzel_Setup *latest = track->next_setup_ready ? &track->next_setup : &track->setup;
+		if(schedule->period_us == latest->period_us && schedule->nominal_period_us == latest->nominal_period_us)
+			continue;
+
+		uint8_t rate_changed = schedule->nominal_period_us != latest->nominal_period_us;
+		lis3mdl_goertzel_set_sample_period_us(i, schedule->period_us, rate_changed);
+		track->next_setup.nominal_period_us = schedule->nominal_period_us;
+	}
+}
+
+/**
+  * @brief Drops the running block of a device, e.g. after a lost or invalid sample, the
+  * next sample starts a new one.
+  */
+
+void lis3mdl_goertzel_restart_block(uint8_t dev_index){
+	if(dev_index >= LIS3MDL_GOERTZEL_MAX_DEVICES)
+		return;
+
+	LIS3MDL_Goertzel_Track *track = &tracks[dev_index];
+	memset(track->state, 0, sizeof(track->state));
+	track->samples = 0;
+}
+
+/**
+  * @brief Runs a sample through the bins of its device, call it for every valid sample.
+  *
+  * @param dev_index Index of the device the sample came from.
+  * @param sample Pointer to the decoded sample.
+  * @param time_us Time the sample was committed.
+  *
+  * @retval 1 if the sample completed a block and a result can be taken, 0 otherwise.
+  */
+
+uint8_t lis3mdl_goertzel_add_sample(uint8_t dev_index, const LIS3MDL_Magnetic_Data_t *sample, uint32_t time_us){
+	if(goertzel_params.fundamental_mhz == 0 || dev_index >= LIS3MDL_GOERTZEL_MAX_DEVICES || sample == NULL)
+		return 0;
+
+	LIS3MDL_Goertzel_Track *track = &tracks[dev_index];
+	if(track->samples == 0){
+		if(track->next_setup_ready){
+			track->setup = track->next_setup;
+			track->next_setup_ready = 0;
+		}
+		if(track->setup.period_us == 0) // Not tuned yet
+			return 0;
+		track->start_us = time_us;
+	}
+
+	const int32_t axes[3] = { sample->x * (1L << input_shift), sample->y * (1L << input_shift), sample->z * (1L << input_shift) };
+	for(int bin=0; bin<track->setup.num_of_bins; bin++){
+		int32_t coefficient = track->setup.bins[bin].coefficient;
+		for(int i=0; i<3; i++){
+			int32_t *state = track->state[bin][i];
+			int32_t next = axes[i] + multiply_coefficient(state[0], coefficient) - state[1];
+			state[1] = state[0];
+			state[0] = next;
+		}
+	}
+	if(++track->samples < goertzel_params.block_samples)
+		return 0;
+
+	track->done_setup = track->setup;
+	memcpy(track->done_state, track->state, sizeof(track->state));
+	track->done_start_us = track->start_us;
+	track->result_ready = 1;
+	lis3mdl_goertzel_restart_block(dev_index);
+	return 1;
+}
+
+/**
+  * @brief Amplitude and phase of one bin on one axis from the final states of a block.
+  */
+
+static void evaluate(const LIS3MDL_Goertzel_Tuning *tuning, const int32_t *state, uint32_t *amplitude, int16_t *phase){
+	// s[N-1] - e^(-jw) s[N-2]
+	int64_t real = state[0] - (((int64_t)tuning->cos_q30 * state[1]) >> 30);
+	int64_t imaginary = ((int64_t)tuning->sin_q30 * state[1]) >> 30;
+
+	// Normalize for CORDIC, small vectors are scaled up to keep the phase resolution
+	int64_t largest = real < 0 ? -real : real;
+	largest |= imaginary < 0 ? -imaginary : imaginary;
+	int shift = 0;
+	while(largest >= (1LL << LIS3MDL_GOERTZEL_VECTOR_BITS)){
+		largest >>= 1;
+		shift--;
+	}
+	while(largest != 0 && largest < (1LL << (LIS3MDL_GOERTZEL_VECTOR_BITS - 1))){
+		largest <<= 1;
+		shift++;
+	}
+	if(largest == 0){
+		*amplitude = 0;
+		*phase = 0;
+		return;
+	}
+	real = shift >= 0 ? real << shift : real >> -shift;
+	imaginary = shift >= 0 ? imaginary << shift : imaginary >> -shift;
+
+	uint32_t magnitude, angle;
+	cordic_vector((int32_t)real, (int32_t)imaginary, &magnitude, &angle);
+
+	// 2 |X| / N is the peak amplitude of the tone
+	int scale_shift = 30 - 1 - LIS3MDL_GOERTZEL_AMPLITUDE_FRACTION_BITS + shift + input_shift;
+	uint64_t scaled = (uint64_t)magnitude * LIS3MDL_GOERTZEL_CORDIC_GAIN_INVERSE_Q30;
+	scaled = scale_shift >= 0 ? (scaled + (1ULL << scale_shift >> 1)) >> scale_shift : scaled << -scale_shift;
+	*amplitude = (uint32_t)((scaled + goertzel_params.block_samples / 2) / goertzel_params.block_samples);
+
+	// Back to the first sample of the block, the bin turned `step` per sample since then
+	angle -= tuning->step * (uint32_t)(goertzel_params.block_samples - 1);
+	*phase = (int16_t)((angle + 0x8000UL) >> 16);
+}
+
+/**
+  * @brief Gives amplitude and phase of every bin over the last block of a device.
+  * The CORDIC evaluations happen here, once per block, not for every sample.
+  *
+  * @param dev_index Index of the device.
+  * @param result Receives the result.
+  *
+  * @retval 0 on success, 1 if no block completed since the last result was taken.
+  */
+
+uint8_t lis3mdl_goertzel_take_result(uint8_t dev_index, LIS3MDL_Goertzel_Result *result){
+	if(dev_index >= LIS3MDL_GOERTZEL_MAX_DEVICES || !tracks[dev_index].result_ready)
+		return 1;
+
+	LIS3MDL_Goertzel_Track *track = &tracks[dev_index];
+	const LIS3MDL_Goertzel_Setup *setup = &track->done_setup;
+	memset(result, 0, sizeof(*result));
+	result->start_us = track->done_start_us;
+	result->sample_period_us = setup->period_us;
+	result->dev_index = dev_index;
+	result->num_of_bins = setup->num_of_bins;
+	result->block_samples = goertzel_params.block_samples;
+	for(int bin=0; bin<setup->num_of_bins; bin++){
+		result->bins[bin].frequency_mhz = setup->bins[bin].frequency_mhz;
+		for(int i=0; i<3; i++)
+			evaluate(&setup->bins[bin], track->done_state[bin][i], &result->bins[bin].amplitude[i], &result->bins[bin].phase[i]);
+	}
+	track->result_ready = 0;
+	return 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * lis3mdl_goertzel.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef LIS3MDL_LIS3MDL_GOERTZEL_H_
+#define LIS3MDL_LIS3MDL_GOERTZEL_H_
+
+#include <stdint.h>
+#include "lis3mdl_device.h"
+
+#ifndef LIS3MDL_GOERTZEL_MAX_DEVICES
+#define LIS3MDL_GOERTZEL_MAX_DEVICES 1 // About 480 bytes each with 4 bins, mains detection needs the sensor closest to the conductor
+#endif
+
+#ifndef LIS3MDL_GOERTZEL_MAX_BINS
+#define LIS3MDL_GOERTZEL_MAX_BINS 4
+#endif
+
+#define LIS3MDL_GOERTZEL_MAX_BLOCK_SAMPLES 1024 // Keeps the states below 2^29 whatever the samples are
+#define LIS3MDL_GOERTZEL_MIN_BIN_SHIFT 6 // Bins closer than 1/64 of the sample rate to 0 or Nyquist are left out
+
+/**
+ * @brief Tones the detector looks for. Every `block_samples` samples of a device give one
+ * LIS3MDL_Goertzel_Result. Blocks of 0.2 s put 50 and 60 Hz and their harmonics right on
+ * a bin, e.g. 200 samples at the 1 kHz fast ODR.
+ */
+
+typedef struct {
+	uint32_t fundamental_mhz; // e.g. 50000 for 50 Hz mains, 0 disables the detector
+	uint8_t harmonics; // Bit n-1 selects the nth harmonic, 0x01 the fundamental alone
+	uint16_t block_samples;
+} LIS3MDL_Goertzel_Params;
+
+/**
+ * @brief One tone in the field of one device, per axis. A field of
+ * amplitude * cos(2 * pi * f * t + phase) with t = 0 at the first sample of the block.
+ */
+
+typedef struct {
+	uint32_t frequency_mhz;
+	uint32_t amplitude[3]; // Peak, 1/16 LSB
+	int16_t phase[3]; // 65536 per turn
+} LIS3MDL_Goertzel_Bin;
+
+typedef struct {
+	uint32_t start_us; // Time the first sample of the block was committed
+	uint32_t sample_period_us; // Sample period of the device the bins were tuned to
+	uint8_t dev_index;
+	uint8_t num_of_bins; // Harmonics too close to Nyquist for the sample rate are left out
+	uint16_t block_samples;
+	LIS3MDL_Goertzel_Bin bins[LIS3MDL_GOERTZEL_MAX_BINS];
+} LIS3MDL_Goertzel_Result;
+
+uint8_t lis3mdl_goertzel_init(const LIS3MDL_Goertzel_Params *params);
+uint8_t lis3mdl_goertzel_set_sample_period_us(uint8_t dev_index, uint32_t period_us, uint8_t restart);
+void lis3mdl_goertzel_process(const LIS3MDL_Device *devices, uint8_t num_of_devices);
+uint8_t lis3mdl_goertzel_add_sample(uint8_t dev_index, const LIS3MDL_Magnetic_Data_t *sample, uint32_t time_us);
+void lis3mdl_goertzel_restart_block(uint8_t dev_index);
+uint8_t lis3mdl_goertzel_take_result(uint8_t dev_index, LIS3MDL_Goertzel_Result *result);
+
+#endif /* LIS3MDL_LIS3MDL_GOERTZEL_H_ */
@@ -41,6 +41,7 @@ uint8_t lis3mdl_set_default_params(LIS3MDL_Init_Params *init_params){
 	init_params->conversion_mode = LIS3MDL_CONTINIOUS_CONVERSION;
 
 	init_params->z_operation_mode = LIS3MDL_MEDIUM_PERFORMANCE;
+	init_params->endianness = LIS3MDL_NATIVE_ENDIANNESS;
 
 	init_params->fast_read = 0;
 	init_params->block_data_update = 1;
@@ -108,10 +109,11 @@ uint8_t lis3mdl_put_params_into_registers(LIS3MDL_Init_Params init_params, uint8
 
 	ctrl_regs[3] = 0;
 	ctrl_regs[3] |= (init_params.z_operation_mode << 2) & LIS3MDL_Z_OPERATING_MODE;
+	ctrl_regs[3] |= (init_params.endianness << 1) & LIS3MDL_BLE;
 
 	ctrl_regs[4] = 0;
 	ctrl_regs[4] |= (init_params.fast_read << 7) & LIS3MDL_FAST_READ;
-	ctrl_regs[4] |= (init_params.fast_read << 6) & LIS3MDL_BDU;
+	ctrl_regs[4] |= (init_params.block_data_update << 6) & LIS3MDL_BDU;
 
 	int_regs[0] = 0;
 	int_regs[0] |= (init_params.x_interrupt_generation << 7) & LIS3MDL_XIEN;
@@ -136,4 +138,76 @@ uint8_t lis3mdl_put_params_into_registers(LIS3MDL_Init_Params init_params, uint8
 	return 0;
 }
 
+/**
+  * @brief Returns the nominal sample period for a given output data rate.
+  *
+  * @param odr The `LIS3MDL_Output_Data_Rate` selected in CTRL_REG1.
+  *
+  * @retval The time between two consecutive samples in microseconds, 0 for an unknown ODR.
+  */
+
+uint32_t lis3mdl_get_odr_period_us(LIS3MDL_Output_Data_Rate odr){
+	switch(odr){
+	case LIS3MDL_ODR_0_625:
+		return 1600000;
+	case LIS3MDL_ODR_1_25:
+		return 800000;
+	case LIS3MDL_ODR_2_5:
+		return 400000;
+	case LIS3MDL_ODR_5:
+		return 200000;
+	case LIS3MDL_ODR_10:
+		return 100000;
+	case LIS3MDL_ODR_20:
+		return 50000;
+	case LIS3MDL_ODR_40:
+		return 25000;
+	case LIS3MDL_ODR_80:
+		return 12500;
+	default:
+		return 0;
+	}
+}
 
+/**
+  * @brief Returns the nominal sample period in fast ODR mode, where the XY operating mode
+  * selects the rate.
+  *
+  * @param operation_mode The XY `LIS3MDL_Operation_Mode` selected in CTRL_REG1.
+  *
+  * @retval The time between two consecutive samples in microseconds.
+  */
+
+uint32_t lis3mdl_get_fast_odr_period_us(LIS3MDL_Operation_Mode operation_mode){
+	switch(operation_mode){
+	case LIS3MDL_LOW_POWER:
+		return 1000; // 1000 Hz
+	case LIS3MDL_MEDIUM_PERFORMANCE:
+		return 1786; // 560 Hz
+	case LIS3MDL_HIGH_PERFORAMCE:
+		return 3333; // 300 Hz
+	default:
+		return 6452; // 155 Hz
+	}
+}
+
+/**
+  * @brief Returns the sensitivity of a full scale from the datasheet.
+  *
+  * @param full_scale The `LIS3MDL_Full_Scale` selected in CTRL_REG2.
+  *
+  * @retval LSB per gauss.
+  */
+
+uint32_t lis3mdl_get_sensitivity_lsb_per_gauss(LIS3MDL_Full_Scale full_scale){
+	switch(full_scale){
+	case LIS3MDL_FULL_SCALE_4_GAUSS:
+		return 6842;
+	case LIS3MDL_FULL_SCALE_8_GAUSS:
+		return 3421;
+	case LIS3MDL_FULL_SCALE_12_GAUSS:
+		return 2281;
+	default:
+		return 1711;
+	}
+}
@@ -60,6 +60,23 @@ typedef enum {
 	LIS3MDL_POWER_DOWN = 0x02
 } LIS3MDL_Conversion_mode;
 
+/**
+ * @brief Defines the byte order of the output registers (BLE bit of CTRL_REG4).
+ * With the order matching the MCU a burst read of OUT_X..OUT_Z lands in memory
+ * as a ready to use int16_t[3].
+ */
+
+typedef enum {
+	LIS3MDL_LITTLE_ENDIAN = 0x00, // LSb at the lower register address
+	LIS3MDL_BIG_ENDIAN = 0x01 // MSb at the lower register address
+} LIS3MDL_Endianness;
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define LIS3MDL_NATIVE_ENDIANNESS LIS3MDL_BIG_ENDIAN
+#else
+#define LIS3MDL_NATIVE_ENDIANNESS LIS3MDL_LITTLE_ENDIAN
+#endif
+
 /**
  * @brief Structure for initializing LIS3MDL device parameters.
  *
@@ -92,6 +109,7 @@ typedef struct {
 
 	//CTRL_REG4
 	LIS3MDL_Operation_Mode z_operation_mode;
+	LIS3MDL_Endianness endianness;
 
 	//CTRL_REG5
 	uint8_t fast_read;
@@ -135,5 +153,8 @@ typedef struct {
 
 uint8_t lis3mdl_set_default_params(LIS3MDL_Init_Params *init_params);
 uint8_t lis3mdl_put_params_into_registers(LIS3MDL_Init_Params init_params, uint8_t *offset_regs, uint8_t *ctrl_regs, uint8_t *int_regs);
+uint32_t lis3mdl_get_odr_period_us(LIS3MDL_Output_Data_Rate odr);
+uint32_t lis3mdl_get_fast_odr_period_us(LIS3MDL_Operation_Mode operation_mode);
+uint32_t lis3mdl_get_sensitivity_lsb_per_gauss(LIS3MDL_Full_Scale full_scale);
 
 #endif /* LIS3MDL_LIS3MDL_INIT_PARAMS_H_ */
@@ -0,0 +1,116 @@
+/*
+ * lis3mdl_init_planner.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#include <stdio.h>
+#include "lis3mdl.h"
+#include "lis3mdl_init_planner.h"
+#include "lis3mdl_trace.h"
+
+#define LIS3MDL_REBOOT_BYTES 2
+#define LIS3MDL_CONFIG_BYTES (7 + 6 + 5) // Offsets, ctrls and ints bursts including their address bytes
+#define LIS3MDL_CONFIG_TRANSACTIONS 3
+#define LIS3MDL_FIRST_SAMPLE_BYTES (2 + 7) // Status read and data read including their address bytes
+#define LIS3MDL_FIRST_SAMPLE_TRANSACTIONS 4 // Address and data DMA for both the status and the data read
+
+static uint32_t last_reboot_tick = 0;
+
+/**
+  * @brief Picks the device that should own the next SPI transaction while devices are being initialized.
+  *
+  * REBOOT commands are issued to every device back-to-back before anything else, so the
+  * settling time only has to be waited once for the whole array. Once the last REBOOT is
+  * more than `LIS3MDL_REBOOT_SETTLING_TIME_MS` old, every waiting device is released into
+  * its configuration sequence at the same time. Devices that are not initializing are
+  * scheduled in the usual lowest-index-first order.
+  *
+  * @param devices Pointer to an array of LIS3MDL_Device structures.
+  * @param num_of_devices The total number of LIS3MDL devices in the `devices` array.
+  *
+  * @retval The zero-based index of the device to serve next.
+  * @retval LIS3MDL_INIT_PLANNER_SETTLING if the only pending work is waiting for the reboot to settle.
+  * @retval -1 if all devices are idling or the `devices` pointer is NULL.
+  */
+
+int lis3mdl_init_planner_next_device_index(LIS3MDL_Device *devices, uint8_t num_of_devices){
+	if(devices == NULL)
+		return -1;
+
+	uint8_t waiting_for_reboot = 0;
+	for(int i=0; i<num_of_devices; i++){
+		if(devices[i].process_state == LIS3MDL_RESETTING_REGISTERS)
+			return i;
+		if(devices[i].process_state == LIS3MDL_WAITING_FOR_REBOOT)
+			waiting_for_reboot = 1;
+	}
+
+	// The tick may advance right after the REBOOT, one more tick makes sure the whole settling time passed
+	if(waiting_for_reboot && (HAL_GetTick() - last_reboot_tick) > LIS3MDL_REBOOT_SETTLING_TIME_MS){
+		for(int i=0; i<num_of_devices; i++){
+			if(devices[i].process_state == LIS3MDL_WAITING_FOR_REBOOT){
+				devices[i].process_state = LIS3MDL_INITIALIZING_OFFSET_REGS;
+				LIS3MDL_TRACE_PROCESS_STATE(i, LIS3MDL_INITIALIZING_OFFSET_REGS);
+			}
+		}
+		waiting_for_reboot = 0;
+	}
+
+	for(int i=0; i<num_of_devices; i++){
+		if(devices[i].process_state != LIS3MDL_IDLE && devices[i].process_state != LIS3MDL_WAITING_FOR_REBOOT)
+			return i;
+	}
+
+	if(waiting_for_reboot)
+		return LIS3MDL_INIT_PLANNER_SETTLING;
+
+	return -1;
+}
+
+/**
+  * @brief Notes the moment a REBOOT command finished shifting out.
+  * The settling time of the whole array is counted from the last REBOOT issued.
+  */
+
+void lis3mdl_init_planner_reboot_issued(void){
+	last_reboot_tick = HAL_GetTick();
+}
+
+/**
+  * @brief Estimates the time from the first REBOOT until every device has delivered its first sample.
+  *
+  * The estimate follows the plan executed by `lis3mdl_init_planner_next_device_index`:
+  * all REBOOTs back-to-back, a single settling wait, every configuration burst streamed
+  * without idle gaps, one ODR period for the last configured device to convert and
+  * finally one status read and one data read per device.
+  *
+  * @param num_of_devices Number of LIS3MDL devices sharing the bus.
+  * @param spi_bitrate_hz SPI clock frequency in Hz.
+  * @param transaction_overhead_us Time spent between two DMA transfers (CS toggle, DMA setup, ISR).
+  * @param odr Output data rate the devices are configured with.
+  *
+  * @retval Estimated time to first sample in microseconds, 0 if `spi_bitrate_hz` or `num_of_devices` is 0.
+  */
+
+uint32_t lis3mdl_init_planner_estimate_time_to_first_sample_us(uint8_t num_of_devices, uint32_t spi_bitrate_hz, uint32_t transaction_overhead_us, LIS3MDL_Output_Data_Rate odr){
+	if(spi_bitrate_hz == 0 || num_of_devices == 0)
+		return 0;
+
+	uint32_t byte_time_ns = (uint32_t)(8000000000ULL / spi_bitrate_hz);
+
+	uint64_t reboot_ns = (uint64_t)num_of_devices * (LIS3MDL_REBOOT_BYTES * byte_time_ns + transaction_overhead_us * 1000ULL);
+	uint64_t settle_ns = (LIS3MDL_REBOOT_SETTLING_TIME_MS + 1) * 1000000ULL; // Released one tick after the settling time
+	uint64_t config_ns = (uint64_t)num_of_devices * (LIS3MDL_CONFIG_BYTES * byte_time_ns + LIS3MDL_CONFIG_TRANSACTIONS * transaction_overhead_us * 1000ULL);
+
+	// The last device starts converting once its ctrl burst is done, which is one int burst before the end
+	uint64_t last_ctrl_done_ns = reboot_ns + settle_ns + config_ns - (5 * byte_time_ns + transaction_overhead_us * 1000ULL);
+	uint64_t sample_ready_ns = last_ctrl_done_ns + lis3mdl_get_odr_period_us(odr) * 1000ULL;
+	if(sample_ready_ns < reboot_ns + settle_ns + config_ns)
+		sample_ready_ns = reboot_ns + settle_ns + config_ns;
+
+	uint64_t readout_ns = (uint64_t)num_of_devices * (LIS3MDL_FIRST_SAMPLE_BYTES * byte_time_ns + LIS3MDL_FIRST_SAMPLE_TRANSACTIONS * transaction_overhead_us * 1000ULL);
+
+	return (uint32_t)((sample_ready_ns + readout_ns) / 1000);
+}
@@ -0,0 +1,21 @@
+/*
+ * lis3mdl_init_planner.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef LIS3MDL_LIS3MDL_INIT_PLANNER_H_
+#define LIS3MDL_LIS3MDL_INIT_PLANNER_H_
+
+#include <stdint.h>
+#include "lis3mdl_device.h"
+
+#define LIS3MDL_REBOOT_SETTLING_TIME_MS 5 // Time needed for the memory content to reload after REBOOT
+#define LIS3MDL_INIT_PLANNER_SETTLING -2 // Returned instead of a device index while the reboot settles
+
+int lis3mdl_init_planner_next_device_index(LIS3MDL_Device *devices, uint8_t num_of_devices);
+void lis3mdl_init_planner_reboot_issued(void);
+uint32_t lis3mdl_init_planner_estimate_time_to_first_sample_us(uint8_t num_of_devices, uint32_t spi_bitrate_hz, uint32_t transaction_overhead_us, LIS3MDL_Output_Data_Rate odr);
+
+#endif /* LIS3MDL_LIS3MDL_INIT_PLANNER_H_ */
@@ -0,0 +1,223 @@
+/*
+ * lis3mdl_odr_controller.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Adapts the output data rate to what the field does. The controller low pass filters the
+ * samples of every device and measures how fast the filtered vector moves. When the rate
+ * of change of any device exceeds the threshold, the ODR goes straight to the active level.
+ * Once the field has been still for the hold-off, it steps back down one level per hold-off
+ * until it reaches the quiet level again. Events get full time resolution, and a field
+ * that stays static for hours costs a few status reads and conversions per second.
+ *
+ * The rate is measured over windows of at least LIS3MDL_ODR_CONTROLLER_WINDOW_US, so
+ * that the sample noise does not scale with the ODR. The fast ODR levels are selected by
+ * the XY operating mode, so CTRL_REG1 and CTRL_REG4 get the matching OM and OMZ bits.
+ * Normal levels keep the operating modes of the configuration. The new rate is written to
+ * the shared register image and to one device after the other with `lis3mdl_write_reg`,
+ * in between two samples of that device.
+ */
+
+#include <stdlib.h>
+#include "lis3mdl_odr_controller.h"
+#include "lis3mdl.h"
+#include "lis3mdl_registers.h"
+#include "lis3mdl_telemetry.h"
+
+#define LIS3MDL_ODR_CONTROLLER_CTRL_WRITE_SIZE 4 // CTRL_REG1..CTRL_REG4, REG2 and REG3 are written unchanged
+#define LIS3MDL_ODR_CONTROLLER_FILTER_FRACTION_BITS 4
+
+/**
+ * @brief Filtered field of one device and the point the rate of change is measured from.
+ */
+
+typedef struct {
+	int32_t filtered[3]; // Q4 LSB
+	int32_t reference[3];
+	uint32_t reference_us;
+	uint8_t primed;
+} LIS3MDL_Odr_Controller_Track;
+
+static LIS3MDL_Config_regs *controller_config_regs = NULL;
+static LIS3MDL_Odr_Controller_Params controller_params;
+static LIS3MDL_Odr_Controller_Track tracks[LIS3MDL_ODR_CONTROLLER_MAX_DEVICES];
+static uint8_t base_xy_operation_mode = 0; // OM bits of the configuration, used by the normal levels
+static uint8_t base_z_operation_mode = 0;
+static LIS3MDL_Odr_Level level = LIS3MDL_ODR_LEVEL_10;
+static uint8_t activity_seen = 0;
+static uint32_t activity_rate = 0; // Highest rate of change seen since the last decision
+static uint32_t last_activity_us = 0;
+static uint32_t last_change_us = 0;
+static uint8_t next_device = 0; // Devices below it already run at `level`
+static uint8_t write_in_flight = 0;
+
+/**
+  * @brief Puts the ODR, FAST_ODR, OM and OMZ bits of a level into CTRL_REG1..CTRL_REG5 values.
+  */
+
+static void apply_level(uint8_t *ctrl_regs, LIS3MDL_Odr_Level new_level){
+	uint8_t xy_operation_mode = base_xy_operation_mode;
+	uint8_t z_operation_mode = base_z_operation_mode;
+	uint8_t odr_bits = (new_level << 2) & LIS3MDL_ODR;
+	uint8_t fast_odr_bit = 0;
+
+	if(new_level > LIS3MDL_ODR_LEVEL_80){
+		xy_operation_mode = LIS3MDL_ULTRA_PERFORMACE - (new_level - LIS3MDL_ODR_LEVEL_155);
+		z_operation_mode = xy_operation_mode;
+		odr_bits = 0;
+		fast_odr_bit = LIS3MDL_FAST_ODR;
+	}
+
+	ctrl_regs[0] &= ~(LIS3MDL_XY_OPERATING_MODE | LIS3MDL_ODR | LIS3MDL_FAST_ODR);
+	ctrl_regs[0] |= ((xy_operation_mode << 5) & LIS3MDL_XY_OPERATING_MODE) | odr_bits | fast_odr_bit;
+	ctrl_regs[3] &= ~LIS3MDL_Z_OPERATING_MODE;
+	ctrl_regs[3] |= (z_operation_mode << 2) & LIS3MDL_Z_OPERATING_MODE;
+}
+
+/**
+  * @brief Takes over a register image and sets it to the quiet level. Call it before the
+  * devices are initialized with the image, they then start at the quiet level.
+  *
+  * @param config_regs Image shared by every device the controller runs, has to stay writable.
+  * @param params Levels, threshold and hold-off, copied.
+  *
+  * @retval 0 on success, 1 on NULL pointers, invalid levels or a quiet level above the active one.
+  */
+
+uint8_t lis3mdl_odr_controller_init(LIS3MDL_Config_regs *config_regs, const LIS3MDL_Odr_Controller_Params *params){
+	if(config_regs == NULL || params == NULL)
+		return 1;
+	if(params->active_level >= LIS3MDL_ODR_LEVEL_COUNT || params->quiet_level > params->active_level)
+		return 1;
+
+	controller_config_regs = config_regs;
+	controller_params = *params;
+	base_xy_operation_mode = (config_regs->ctrls[0] & LIS3MDL_XY_OPERATING_MODE) >> 5;
+	base_z_operation_mode = (config_regs->ctrls[3] & LIS3MDL_Z_OPERATING_MODE) >> 2;
+
+	for(int i=0; i<LIS3MDL_ODR_CONTROLLER_MAX_DEVICES; i++)
+		tracks[i].primed = 0;
+	level = controller_params.quiet_level;
+	apply_level(config_regs->ctrls, level);
+	activity_seen = 0;
+	activity_rate = 0;
+	last_activity_us = last_change_us = lis3mdl_get_tick_us();
+	next_device = UINT8_MAX;
+	write_in_flight = 0;
+	return 0;
+}
+
+/**
+  * @brief Feeds a sample to the activity detection.
+  *
+  * @param dev_index Index of the device the sample came from.
+  * @param sample Pointer to the decoded sample.
+  */
+
+void lis3mdl_odr_controller_add_sample(uint8_t dev_index, const LIS3MDL_Magnetic_Data_t *sample){
+	if(controller_config_regs == NULL || sample == NULL || dev_index >= LIS3MDL_ODR_CONTROLLER_MAX_DEVICES)
+		return;
+
+	LIS3MDL_Odr_Controller_Track *track = &tracks[dev_index];
+	uint32_t now_us = lis3mdl_get_tick_us();
+	int32_t axes[3] = { sample->x, sample->y, sample->z };
+
+	if(!track->primed){
+		for(int i=0; i<3; i++)
+			track->filtered[i] = track->reference[i] = axes[i] << LIS3MDL_ODR_CONTROLLER_FILTER_FRACTION_BITS;
+		track->reference_us = now_us;
+		track->primed = 1;
+		return;
+	}
+
+	for(int i=0; i<3; i++)
+		track->filtered[i] += ((axes[i] << LIS3MDL_ODR_CONTROLLER_FILTER_FRACTION_BITS) - track->filtered[i]) >> LIS3MDL_ODR_CONTROLLER_FILTER_SHIFT;
+
+	uint32_t elapsed_us = now_us - track->reference_us;
+	if(elapsed_us < LIS3MDL_ODR_CONTROLLER_WINDOW_US)
+		return;
+
+	uint32_t change = 0;
+	for(int i=0; i<3; i++){
+		change += (uint32_t)abs(track->filtered[i] - track->reference[i]);
+		track->reference[i] = track->filtered[i];
+	}
+	track->reference_us = now_us;
+
+	uint32_t rate = (uint32_t)(((uint64_t)change * 1000000 / elapsed_us) >> LIS3MDL_ODR_CONTROLLER_FILTER_FRACTION_BITS);
+	if(rate > controller_params.activity_threshold){
+		activity_seen = 1;
+		last_activity_us = now_us;
+		if(rate > activity_rate)
+			activity_rate = rate;
+	}
+}
+
+/**
+  * @brief Decides on the rate and writes it to the devices. Call it on every loop
+  * iteration, the writes go through `lis3mdl_process` like any other transfer.
+  *
+  * @param devices Pointer to the array of LIS3MDL_Device structures running the image.
+  * @param num_of_devices The total number of devices in the `devices` array.
+  */
+
+void lis3mdl_odr_controller_process(LIS3MDL_Device *devices, uint8_t num_of_devices){
+	if(controller_config_regs == NULL || devices == NULL)
+		return;
+
+	if(write_in_flight){
+		if(devices[next_device].process_state != LIS3MDL_IDLE)
+			return;
+		// The device converts at the new rate from now on, the schedule has to find it again
+		lis3mdl_poll_scheduler_reset(&devices[next_device].poll_schedule, controller_config_regs->ctrls);
+		write_in_flight = 0;
+		next_device++;
+	}
+	if(next_device < num_of_devices){
+		// Only in between two samples, the write would otherwise hold up a read that is under way
+		if(devices[next_device].data_retrieval_state != LIS3MDL_WAITING_FOR_DATA_READY)
+			return;
+		if(lis3mdl_write_reg(devices, num_of_devices, next_device, LIS3MDL_CTRL_REG1_ADDR, controller_config_regs->ctrls, LIS3MDL_ODR_CONTROLLER_CTRL_WRITE_SIZE, LIS3MDL_TRANSACTION_CONTROL) == HAL_OK)
+			write_in_flight = 1;
+		return;
+	}
+
+	uint32_t now_us = lis3mdl_get_tick_us();
+	LIS3MDL_Odr_Level new_level = level;
+	if(activity_seen)
+		new_level = controller_params.active_level;
+	else if(level > controller_params.quiet_level && now_us - last_activity_us >= controller_params.hold_off_us
+			&& now_us - last_change_us >= controller_params.hold_off_us)
+		new_level = (LIS3MDL_Odr_Level)(level - 1);
+
+	if(new_level != level){
+		LIS3MDL_TELEMETRY_ODR_DECISION(level, new_level, activity_rate);
+		level = new_level;
+		apply_level(controller_config_regs->ctrls, level);
+		last_change_us = now_us;
+		next_device = 0;
+	}
+	activity_seen = 0;
+	activity_rate = 0;
+}
+
+/**
+  * @brief Rate the register image is set to, the devices follow within a sample period.
+  */
+
+LIS3MDL_Odr_Level lis3mdl_odr_controller_get_level(void){
+	return level;
+}
+
+/**
+  * @brief Returns the nominal sample period of a level.
+  *
+  * @retval The time between two consecutive samples in microseconds, 0 for an unknown level.
+  */
+
+uint32_t lis3mdl_odr_get_level_period_us(LIS3MDL_Odr_Level odr_level){
+	if(odr_level > LIS3MDL_ODR_LEVEL_80)
+		return odr_level < LIS3MDL_ODR_LEVEL_COUNT ? lis3mdl_get_fast_odr_period_us((LIS3MDL_Operation_Mode)(LIS3MDL_ULTRA_PERFORMACE - (odr_level - LIS3MDL_ODR_LEVEL_155))) : 0;
+	return lis3mdl_get_odr_period_us((LIS3MDL_Output_Data_Rate)odr_level);
+}
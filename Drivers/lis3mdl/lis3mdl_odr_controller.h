@@ -0,0 +1,64 @@
+/*
+ * lis3mdl_odr_controller.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef LIS3MDL_LIS3MDL_ODR_CONTROLLER_H_
+#define LIS3MDL_LIS3MDL_ODR_CONTROLLER_H_
+
+#include <stdint.h>
+#include "lis3mdl_device.h"
+
+#ifndef LIS3MDL_ODR_CONTROLLER_MAX_DEVICES
+#define LIS3MDL_ODR_CONTROLLER_MAX_DEVICES 4 // Samples of devices with a higher index are not watched
+#endif
+
+#ifndef LIS3MDL_ODR_CONTROLLER_WINDOW_US
+#define LIS3MDL_ODR_CONTROLLER_WINDOW_US 200000 // The rate of change is measured over at least this long
+#endif
+
+#ifndef LIS3MDL_ODR_CONTROLLER_FILTER_SHIFT
+#define LIS3MDL_ODR_CONTROLLER_FILTER_SHIFT 2 // Every sample moves the filtered field by 1/4 of its difference
+#endif
+
+/**
+ * @brief Rates the controller steps through. The first eight are the ODR codes of CTRL_REG1,
+ * the rest are the fast ODR rates that the XY operating mode selects.
+ */
+
+typedef enum {
+	LIS3MDL_ODR_LEVEL_0_625 = 0x00,
+	LIS3MDL_ODR_LEVEL_1_25 = 0x01,
+	LIS3MDL_ODR_LEVEL_2_5 = 0x02,
+	LIS3MDL_ODR_LEVEL_5 = 0x03,
+	LIS3MDL_ODR_LEVEL_10 = 0x04,
+	LIS3MDL_ODR_LEVEL_20 = 0x05,
+	LIS3MDL_ODR_LEVEL_40 = 0x06,
+	LIS3MDL_ODR_LEVEL_80 = 0x07,
+	LIS3MDL_ODR_LEVEL_155 = 0x08, // Fast ODR, ultra-high performance
+	LIS3MDL_ODR_LEVEL_300 = 0x09, // Fast ODR, high performance
+	LIS3MDL_ODR_LEVEL_560 = 0x0A, // Fast ODR, medium performance
+	LIS3MDL_ODR_LEVEL_1000 = 0x0B, // Fast ODR, low power
+	LIS3MDL_ODR_LEVEL_COUNT
+} LIS3MDL_Odr_Level;
+
+/**
+ * @brief How the controller reacts to the field.
+ */
+
+typedef struct {
+	LIS3MDL_Odr_Level quiet_level; // Rate while the field is static
+	LIS3MDL_Odr_Level active_level; // Rate as soon as activity appears
+	uint32_t activity_threshold; // Rate of change of the filtered field, sum over the axes, in LSB per second
+	uint32_t hold_off_us; // Time without activity before stepping one level down, and between steps
+} LIS3MDL_Odr_Controller_Params;
+
+uint8_t lis3mdl_odr_controller_init(LIS3MDL_Config_regs *config_regs, const LIS3MDL_Odr_Controller_Params *params);
+void lis3mdl_odr_controller_add_sample(uint8_t dev_index, const LIS3MDL_Magnetic_Data_t *sample);
+void lis3mdl_odr_controller_process(LIS3MDL_Device *devices, uint8_t num_of_devices);
+LIS3MDL_Odr_Level lis3mdl_odr_controller_get_level(void);
+uint32_t lis3mdl_odr_get_level_period_us(LIS3MDL_Odr_Level level);
+
+#endif /* LIS3MDL_LIS3MDL_ODR_CONTROLLER_H_ */
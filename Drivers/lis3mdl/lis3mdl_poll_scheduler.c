@@ -0,0 +1,183 @@
+/*
+ * lis3mdl_poll_scheduler.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#include "lis3mdl_poll_scheduler.h"
+#include "lis3mdl_init_params.h"
+#include "lis3mdl_registers.h"
+#include "main.h"
+
+#define LIS3MDL_POLL_MARGIN_SHIFT 6 // Status is read 1/64 of a period after the predicted ready moment
+#define LIS3MDL_POLL_RETRY_SHIFT 6 // A status read that found no data is retried 1/64 of a period later
+#define LIS3MDL_POLL_SYNC_RETRY_SHIFT 4 // Retry interval while waiting for the very first sample
+#define LIS3MDL_POLL_CREEP_SHIFT 12 // Predicted ready moment moves 1/4096 of a period earlier on every hit
+#define LIS3MDL_POLL_MIN_CREEP_SHIFT 4 // Creep doubles every 4 hits in a row, up to 1/16 of a period
+#define LIS3MDL_POLL_CREEP_RAMP_SHIFT 2 // A slow ramp lets the poll fall a whole period behind a fast sensor clock
+#define LIS3MDL_POLL_OVERRUN_SHIFT 4 // An overrun means the period is overestimated, shrink it by 1/16
+#define LIS3MDL_POLL_TRACKING_SHIFT 1 // Weight of a measured period in the running estimate
+#define LIS3MDL_POLL_MIN_RETRY_US 50
+
+/**
+  * @brief Computes the sample period the sensor runs at from its control registers.
+  *
+  * @param ctrl_regs Pointer to the 5 CTRL_REG1..CTRL_REG5 values written to the device.
+  *
+  * @retval The sample period in microseconds, 0 if the device is not in continuous conversion mode.
+  */
+
+uint32_t lis3mdl_get_sample_period_us(const uint8_t *ctrl_regs){
+	if((ctrl_regs[2] & LIS3MDL_MD) != LIS3MDL_CONTINIOUS_CONVERSION)
+		return 0;
+
+	if(ctrl_regs[0] & LIS3MDL_FAST_ODR)
+		return lis3mdl_get_fast_odr_period_us((LIS3MDL_Operation_Mode)((ctrl_regs[0] & LIS3MDL_XY_OPERATING_MODE) >> 5));
+
+	return lis3mdl_get_odr_period_us((LIS3MDL_Output_Data_Rate)((ctrl_regs[0] & LIS3MDL_ODR) >> 2));
+}
+
+/**
+  * @brief Restarts the schedule for a (re)configured device.
+  * Until the first sample is seen the status is polled every 1/16 of the nominal period.
+  *
+  * @param schedule Pointer to the LIS3MDL_Poll_Schedule of the device.
+  * @param ctrl_regs Pointer to the 5 CTRL_REG1..CTRL_REG5 values written to the device.
+  */
+
+void lis3mdl_poll_scheduler_reset(LIS3MDL_Poll_Schedule *schedule, const uint8_t *ctrl_regs){
+	schedule->nominal_period_us = lis3mdl_get_sample_period_us(ctrl_regs);
+	schedule->period_us = schedule->nominal_period_us;
+	schedule->last_ready_us = 0;
+	schedule->next_poll_us = 0;
+	schedule->last_fix_us = 0;
+	schedule->samples_since_fix = 0;
+	schedule->misses = 0;
+	schedule->synced = 0;
+}
+
+/**
+  * @brief Tells whether the status register should be read now.
+  *
+  * @param schedule Pointer to the LIS3MDL_Poll_Schedule of the device.
+  * @param now_us Current time from `lis3mdl_get_tick_us`.
+  *
+  * @retval 1 if the status should be read, 0 if the next sample is not expected yet.
+  */
+
+uint8_t lis3mdl_poll_scheduler_is_due(const LIS3MDL_Poll_Schedule *schedule, uint32_t now_us){
+	if(schedule->nominal_period_us == 0 || (!schedule->synced && schedule->misses == 0))
+		return 1;
+
+	return (int32_t)(now_us - schedule->next_poll_us) >= 0;
+}
+
+/**
+  * @brief Tells how long the status register does not have to be read.
+  *
+  * @param schedule Pointer to the LIS3MDL_Poll_Schedule of the device.
+  * @param now_us Current time from `lis3mdl_get_tick_us`.
+  *
+  * @retval Microseconds until `lis3mdl_poll_scheduler_is_due` turns true, 0 if it already is.
+  */
+
+uint32_t lis3mdl_poll_scheduler_time_until_due_us(const LIS3MDL_Poll_Schedule *schedule, uint32_t now_us){
+	if(lis3mdl_poll_scheduler_is_due(schedule, now_us))
+		return 0;
+
+	return schedule->next_poll_us - now_us;
+}
+
+/**
+  * @brief Updates the schedule after a status read found new data.
+  *
+  * @param schedule Pointer to the LIS3MDL_Poll_Schedule of the device.
+  * @param now_us Time the status read completed.
+  * @param overrun Non-zero if the status reported overwritten data, meaning the poll came too late.
+  */
+
+void lis3mdl_poll_scheduler_data_ready(LIS3MDL_Poll_Schedule *schedule, uint32_t now_us, uint8_t overrun){
+	if(schedule->nominal_period_us == 0)
+		return;
+
+	uint32_t retry_us = schedule->period_us >> LIS3MDL_POLL_RETRY_SHIFT;
+	if(retry_us < LIS3MDL_POLL_MIN_RETRY_US)
+		retry_us = LIS3MDL_POLL_MIN_RETRY_US;
+
+	if(!schedule->synced || overrun){
+		// No reference point yet or it got lost, start over from this sample
+		if(schedule->synced)
+			schedule->period_us -= schedule->period_us >> LIS3MDL_POLL_OVERRUN_SHIFT;
+		schedule->last_ready_us = now_us;
+		schedule->last_fix_us = now_us;
+		schedule->samples_since_fix = 0;
+		schedule->synced = 1;
+	}
+	else if(schedule->misses){
+		// The sample became ready between the last miss and now, which pins the sensor clock down
+		uint32_t ready_us = now_us - (retry_us >> 1);
+		schedule->samples_since_fix++;
+		uint32_t measured_us = (ready_us - schedule->last_fix_us) / schedule->samples_since_fix;
+		schedule->period_us += ((int32_t)measured_us - (int32_t)schedule->period_us) >> LIS3MDL_POLL_TRACKING_SHIFT;
+		schedule->last_ready_us = ready_us;
+		schedule->last_fix_us = ready_us;
+		schedule->samples_since_fix = 0;
+	}
+	else{
+		// Found on the first read, so it could have been ready earlier. Creep towards the edge
+		if(schedule->samples_since_fix < UINT16_MAX)
+			schedule->samples_since_fix++;
+		schedule->last_ready_us += schedule->period_us;
+		if((int32_t)(now_us - schedule->last_ready_us) < 0)
+			schedule->last_ready_us = now_us;
+		uint8_t creep_shift = LIS3MDL_POLL_CREEP_SHIFT - (schedule->samples_since_fix >> LIS3MDL_POLL_CREEP_RAMP_SHIFT);
+		if(schedule->samples_since_fix >= ((LIS3MDL_POLL_CREEP_SHIFT - LIS3MDL_POLL_MIN_CREEP_SHIFT) << LIS3MDL_POLL_CREEP_RAMP_SHIFT))
+			creep_shift = LIS3MDL_POLL_MIN_CREEP_SHIFT;
+		schedule->last_ready_us -= schedule->period_us >> creep_shift;
+	}
+
+	// Sensor clock is specified well within 25 %, anything outside is a tracking glitch
+	if(schedule->period_us > schedule->nominal_period_us + (schedule->nominal_period_us >> 2))
+		schedule->period_us = schedule->nominal_period_us + (schedule->nominal_period_us >> 2);
+	if(schedule->period_us < schedule->nominal_period_us - (schedule->nominal_period_us >> 2))
+		schedule->period_us = schedule->nominal_period_us - (schedule->nominal_period_us >> 2);
+
+	schedule->misses = 0;
+	schedule->next_poll_us = schedule->last_ready_us + schedule->period_us + (schedule->period_us >> LIS3MDL_POLL_MARGIN_SHIFT);
+}
+
+/**
+  * @brief Updates the schedule after a status read found no new data.
+  *
+  * @param schedule Pointer to the LIS3MDL_Poll_Schedule of the device.
+  * @param now_us Time the status read completed.
+  */
+
+void lis3mdl_poll_scheduler_data_not_ready(LIS3MDL_Poll_Schedule *schedule, uint32_t now_us){
+	if(schedule->nominal_period_us == 0)
+		return;
+
+	uint32_t retry_us = schedule->period_us >> LIS3MDL_POLL_RETRY_SHIFT;
+	if(!schedule->synced)
+		retry_us = schedule->period_us >> LIS3MDL_POLL_SYNC_RETRY_SHIFT;
+	if(retry_us < LIS3MDL_POLL_MIN_RETRY_US)
+		retry_us = LIS3MDL_POLL_MIN_RETRY_US;
+
+	if(schedule->misses < UINT8_MAX)
+		schedule->misses++;
+	schedule->next_poll_us = now_us + retry_us;
+}
+
+/**
+  * @brief Microsecond time base used for the polling schedule.
+  * The default only has the 1 ms resolution of the HAL tick, which is too coarse for the
+  * fast ODRs. The firmware provides a stronger definition in Core/Src/power_port.c that
+  * refines the HAL tick with the SysTick counter, the host build one in its HAL mock.
+  *
+  * @retval Free running time in microseconds.
+  */
+
+__weak uint32_t lis3mdl_get_tick_us(void){
+	return HAL_GetTick() * 1000;
+}
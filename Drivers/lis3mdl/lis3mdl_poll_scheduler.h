@@ -0,0 +1,44 @@
+/*
+ * lis3mdl_poll_scheduler.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef LIS3MDL_LIS3MDL_POLL_SCHEDULER_H_
+#define LIS3MDL_LIS3MDL_POLL_SCHEDULER_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Per device state of the predictive status polling.
+ *
+ * Without a DRDY line the only way to learn that a sample is ready is to read STATUS_REG.
+ * The schedule predicts when the next sample becomes ready from the configured ODR and the
+ * time the previous one was found, so the status is read right after that moment instead
+ * of continuously. Every read that finds data moves the predicted moment slightly earlier
+ * until one read comes too soon; the read that follows it pins the real ready moment down.
+ * The period estimate is refined from the time between two such pinned moments, which
+ * makes the schedule follow the drift of the sensor's own clock.
+ */
+
+typedef struct {
+	uint32_t nominal_period_us; // Period derived from CTRL_REG1, 0 when not in continuous conversion
+	uint32_t period_us; // Current estimate of the sensor sample period
+	uint32_t last_ready_us; // Estimated moment the last sample became ready
+	uint32_t next_poll_us; // Moment the status register should be read next
+	uint32_t last_fix_us; // Last ready moment pinned down by a status read that found no data
+	uint16_t samples_since_fix; // Sample periods elapsed since last_fix_us
+	uint8_t misses; // Status reads that found no data since the last sample
+	uint8_t synced; // 0 until the first sample has been seen
+} LIS3MDL_Poll_Schedule;
+
+void lis3mdl_poll_scheduler_reset(LIS3MDL_Poll_Schedule *schedule, const uint8_t *ctrl_regs);
+uint8_t lis3mdl_poll_scheduler_is_due(const LIS3MDL_Poll_Schedule *schedule, uint32_t now_us);
+uint32_t lis3mdl_poll_scheduler_time_until_due_us(const LIS3MDL_Poll_Schedule *schedule, uint32_t now_us);
+void lis3mdl_poll_scheduler_data_ready(LIS3MDL_Poll_Schedule *schedule, uint32_t now_us, uint8_t overrun);
+void lis3mdl_poll_scheduler_data_not_ready(LIS3MDL_Poll_Schedule *schedule, uint32_t now_us);
+uint32_t lis3mdl_get_sample_period_us(const uint8_t *ctrl_regs);
+uint32_t lis3mdl_get_tick_us(void); // Weak default with 1 ms resolution, see lis3mdl_poll_scheduler.c
+
+#endif /* LIS3MDL_LIS3MDL_POLL_SCHEDULER_H_ */
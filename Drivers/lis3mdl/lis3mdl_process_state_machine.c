@@ -6,6 +6,7 @@
  */
 
 #include <lis3mdl_process_state_machine.h>
+#include "lis3mdl_bus.h"
 
 /**
   * @brief Manages the state transitions of the LIS3MDL device process based on SPI completion.
@@ -21,10 +22,10 @@
   * a valid transition upon SPI completion (e.g., unexpected state).
   */
 
-LIS3MDL_State_Change_Error_t lis3mdl_change_state_due_to_spi_cplt(LIS3MDL_Process_State_t *state){
+LIS3MDL_RAM_FUNC LIS3MDL_State_Change_Error_t lis3mdl_change_state_due_to_spi_cplt(LIS3MDL_Process_State_t *state){
 	switch(*state){
 	case LIS3MDL_RESETTING_REGISTERS:
-		*state = LIS3MDL_INITIALIZING_OFFSET_REGS;
+		*state = LIS3MDL_WAITING_FOR_REBOOT; // Init planner releases the device once the reboot has settled
 		break;
 	case LIS3MDL_INITIALIZING_OFFSET_REGS:
 //		*state = LIS3MDL_INITIALIZING_CTRL_REGS;
@@ -14,7 +14,7 @@
  * like initialization, reading, and writing to the sensor.
  */
 
-typedef enum {
+typedef enum __attribute__((packed)) {
 	LIS3MDL_RESETTING_REGISTERS = 0x00,
 	LIS3MDL_INITIALIZING_OFFSET_REGS = 0x01,
 	LIS3MDL_INITIALIZING_CTRL_REGS = 0x02,
@@ -23,9 +23,12 @@ typedef enum {
 	LIS3MDL_SENDING_ADDRESS_TO_READ_FROM = 0x05,
 	LIS3MDL_SENDING_ADDRESS_TO_WRITE_TO = 0x06,
 	LIS3MDL_READING_DATA = 0x07,
-	LIS3MDL_WRITING_DATA = 0x08
+	LIS3MDL_WRITING_DATA = 0x08,
+	LIS3MDL_WAITING_FOR_REBOOT = 0x09
 } LIS3MDL_Process_State_t;
 
+_Static_assert(sizeof(LIS3MDL_Process_State_t) == 1, "LIS3MDL_Process_State_t is stored in every LIS3MDL_Device");
+
 /**
  * @brief Enumerates the possible return codes for state change operations.
  */
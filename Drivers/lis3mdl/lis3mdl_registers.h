@@ -58,7 +58,7 @@
 
 #define LIS3MDL_CTRL_REG4_ADDR 0x23
 #define LIS3MDL_Z_OPERATING_MODE 0x0C // Z UltraHigh performance
-#define LIS3MDL_BLE 0x2 // Switch up Output data MSb and LSb registers adresses
+#define LIS3MDL_BLE 0x2 // Switch up Output data MSb and LSb registers adresses (0: LSb at lower address)
 
 #define LIS3MDL_CTRL_REG5_ADDR 0x24
 #define LIS3MDL_FAST_READ 0x80 // Enables fast read
@@ -82,7 +82,7 @@
  * OUTPUT registers
  */
 
-#define LIS3MDL_OUT_X_L_ADDR 0x29
+#define LIS3MDL_OUT_X_L_ADDR 0x28
 #define LIS3MDL_OUT_X_H_ADDR 0x29
 #define LIS3MDL_OUT_Y_L_ADDR 0x2A
 #define LIS3MDL_OUT_Y_H_ADDR 0x2B
@@ -0,0 +1,195 @@
+/*
+ * lis3mdl_sample_buffer.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include "lis3mdl_sample_buffer.h"
+
+_Static_assert((LIS3MDL_SAMPLE_BUFFER_SIZE & LIS3MDL_SAMPLE_BUFFER_MASK) == 0, "LIS3MDL_SAMPLE_BUFFER_SIZE has to be a power of two");
+_Static_assert(LIS3MDL_SAMPLE_BUFFER_SIZE <= 8, "The committed slots are kept as bits of a uint8_t");
+_Static_assert(offsetof(LIS3MDL_Sample_Slot, data) == offsetof(LIS3MDL_Sample_Slot, address_byte) + 1, "The address byte has to be received right before the sample");
+_Static_assert(offsetof(LIS3MDL_Sample_Slot, temperature) == offsetof(LIS3MDL_Sample_Slot, data) + 6, "TEMP_OUT has to be received right after OUT_Z");
+
+/**
+  * @brief Empties the sample buffer.
+  *
+  * @param buffer Pointer to the LIS3MDL_Sample_Buffer to initialize.
+  *
+  * @retval 0 on success, 1 if `buffer` is NULL.
+  */
+
+uint8_t lis3mdl_sample_buffer_init(LIS3MDL_Sample_Buffer *buffer){
+	if(buffer == NULL)
+		return 1;
+
+	buffer->head = 0;
+	buffer->tail = 0;
+	buffer->claimed = 0;
+	buffer->committed = 0;
+	buffer->newest = (uint8_t)(buffer->tail - 1); // None yet
+	return 0;
+}
+
+/**
+  * @brief Returns the slot the next sample should be received into.
+  * The same slot is returned until it is claimed.
+  *
+  * @param buffer Pointer to the LIS3MDL_Sample_Buffer.
+  *
+  * @retval Pointer to the free slot, NULL if the consumer has not released any slot yet.
+  */
+
+LIS3MDL_Sample_Slot *lis3mdl_sample_buffer_acquire_slot(LIS3MDL_Sample_Buffer *buffer){
+	if((uint8_t)(buffer->claimed - buffer->tail) >= LIS3MDL_SAMPLE_BUFFER_SIZE)
+		return NULL;
+
+	return &buffer->slots[buffer->claimed & LIS3MDL_SAMPLE_BUFFER_MASK];
+}
+
+/**
+  * @brief Hands the slot returned by `lis3mdl_sample_buffer_acquire_slot` to the read of a
+  * device. Call it once the read is set up.
+  *
+  * @param buffer Pointer to the LIS3MDL_Sample_Buffer.
+  * @param dev_index Index of the device the slot is read from.
+  * @param flags LIS3MDL_SAMPLE_ flags describing the read, e.g. LIS3MDL_SAMPLE_TEMPERATURE.
+  */
+
+void lis3mdl_sample_buffer_claim(LIS3MDL_Sample_Buffer *buffer, uint8_t dev_index, uint8_t flags){
+	uint8_t slot = buffer->claimed & LIS3MDL_SAMPLE_BUFFER_MASK;
+	buffer->slots[slot].flags = flags;
+	buffer->dev_index[slot] = dev_index;
+	buffer->claimed++;
+}
+
+/**
+  * @brief Finds the slot a device claimed and did not commit yet.
+  *
+  * @param buffer Pointer to the LIS3MDL_Sample_Buffer.
+  * @param dev_index Index of the device.
+  *
+  * @retval Pointer to the slot, NULL if the device holds none.
+  */
+
+LIS3MDL_Sample_Slot *lis3mdl_sample_buffer_get_claimed_slot(LIS3MDL_Sample_Buffer *buffer, uint8_t dev_index){
+	for(uint8_t i=buffer->head; i!=buffer->claimed; i++){
+		uint8_t slot = i & LIS3MDL_SAMPLE_BUFFER_MASK;
+		if(buffer->dev_index[slot] == dev_index && !(buffer->committed & (1U << slot)))
+			return &buffer->slots[slot];
+	}
+	return NULL;
+}
+
+/**
+  * @brief Marks a claimed slot as filled. It reaches the consumer together with every
+  * slot claimed before it.
+  *
+  * @param buffer Pointer to the LIS3MDL_Sample_Buffer.
+  * @param slot Slot returned by `lis3mdl_sample_buffer_get_claimed_slot`.
+  */
+
+void lis3mdl_sample_buffer_commit(LIS3MDL_Sample_Buffer *buffer, LIS3MDL_Sample_Slot *slot){
+	uint8_t index = (uint8_t)(slot - buffer->slots);
+	buffer->committed |= (uint8_t)(1U << index);
+	for(uint8_t i=buffer->head; i!=buffer->claimed; i++){
+		if((i & LIS3MDL_SAMPLE_BUFFER_MASK) == index){
+			buffer->newest = i;
+			break;
+		}
+	}
+	while(buffer->head != buffer->claimed && (buffer->committed & (1U << (buffer->head & LIS3MDL_SAMPLE_BUFFER_MASK)))){
+		buffer->committed &= (uint8_t)~(1U << (buffer->head & LIS3MDL_SAMPLE_BUFFER_MASK));
+		buffer->head++;
+	}
+}
+
+/**
+  * @brief Returns the oldest committed sample without removing it from the buffer.
+  *
+  * @param buffer Pointer to the LIS3MDL_Sample_Buffer.
+  *
+  * @retval Pointer to the sample, NULL if the buffer is empty.
+  */
+
+const LIS3MDL_Magnetic_Data_t *lis3mdl_sample_buffer_peek(LIS3MDL_Sample_Buffer *buffer){
+	if(buffer->head == buffer->tail)
+		return NULL;
+
+	return &buffer->slots[buffer->tail & LIS3MDL_SAMPLE_BUFFER_MASK].data;
+}
+
+/**
+  * @brief Returns the most recently committed sample, e.g. to look at the sample
+  * `lis3mdl_get_magnetic_data` just reported with LIS3MDL_DATA_AVAILABLE. It may still
+  * wait for an earlier claim before the consumer sees it.
+  *
+  * @param buffer Pointer to the LIS3MDL_Sample_Buffer.
+  *
+  * @retval Pointer to the sample, NULL if it was released already or nothing was committed.
+  */
+
+const LIS3MDL_Magnetic_Data_t *lis3mdl_sample_buffer_peek_newest(LIS3MDL_Sample_Buffer *buffer){
+	if((uint8_t)(buffer->newest - buffer->tail) >= (uint8_t)(buffer->claimed - buffer->tail))
+		return NULL;
+
+	return &buffer->slots[buffer->newest & LIS3MDL_SAMPLE_BUFFER_MASK].data;
+}
+
+/**
+  * @brief Sets flags on the most recently committed sample, before the consumer sees it.
+  *
+  * @param buffer Pointer to the LIS3MDL_Sample_Buffer.
+  * @param flags LIS3MDL_SAMPLE_ flags to set.
+  */
+
+void lis3mdl_sample_buffer_flag_newest(LIS3MDL_Sample_Buffer *buffer, uint8_t flags){
+	if(lis3mdl_sample_buffer_peek_newest(buffer) != NULL)
+		buffer->slots[buffer->newest & LIS3MDL_SAMPLE_BUFFER_MASK].flags |= flags;
+}
+
+/**
+  * @brief Returns the flags of the sample `lis3mdl_sample_buffer_peek` returns.
+  *
+  * @param buffer Pointer to the LIS3MDL_Sample_Buffer.
+  *
+  * @retval LIS3MDL_SAMPLE_ flags, 0 if the buffer is empty.
+  */
+
+uint8_t lis3mdl_sample_buffer_peek_flags(LIS3MDL_Sample_Buffer *buffer){
+	if(buffer->head == buffer->tail)
+		return 0;
+
+	return buffer->slots[buffer->tail & LIS3MDL_SAMPLE_BUFFER_MASK].flags;
+}
+
+/**
+  * @brief Returns the index of the device the sample `lis3mdl_sample_buffer_peek` returns
+  * was read from.
+  *
+  * @param buffer Pointer to the LIS3MDL_Sample_Buffer.
+  *
+  * @retval Device index, 0 if the buffer is empty.
+  */
+
+uint8_t lis3mdl_sample_buffer_peek_dev_index(LIS3MDL_Sample_Buffer *buffer){
+	if(buffer->head == buffer->tail)
+		return 0;
+
+	return buffer->dev_index[buffer->tail & LIS3MDL_SAMPLE_BUFFER_MASK];
+}
+
+/**
+  * @brief Hands the oldest committed slot back to the producer.
+  * The pointer returned by `lis3mdl_sample_buffer_peek` must not be used afterwards.
+  *
+  * @param buffer Pointer to the LIS3MDL_Sample_Buffer.
+  */
+
+void lis3mdl_sample_buffer_release(LIS3MDL_Sample_Buffer *buffer){
+	if(buffer->head != buffer->tail)
+		buffer->tail++;
+}
@@ -0,0 +1,66 @@
+/*
+ * lis3mdl_sample_buffer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef LIS3MDL_LIS3MDL_SAMPLE_BUFFER_H_
+#define LIS3MDL_LIS3MDL_SAMPLE_BUFFER_H_
+
+#include <stdint.h>
+#include "lis3mdl_device.h"
+
+#define LIS3MDL_SAMPLE_BUFFER_SIZE 4 // Has to be a power of two, at most 8
+#define LIS3MDL_SAMPLE_BUFFER_MASK (LIS3MDL_SAMPLE_BUFFER_SIZE - 1)
+
+#define LIS3MDL_SAMPLE_INVALID 0x01 // E.g. taken while the self-test field was on, not to be used as a measurement
+#define LIS3MDL_SAMPLE_TEMPERATURE 0x02 // The read went on to TEMP_OUT, `temperature` of the slot holds it
+
+/**
+ * @brief A slot of the ring, laid out like the registers a read goes through. The byte in
+ * front of the sample lets the single interrupt engine of lis3mdl_bus.h receive a whole
+ * read, address byte included, into the slot. A read that continues to TEMP_OUT_H, see
+ * lis3mdl_thermal.h, lands in `temperature` right after the axes.
+ */
+
+typedef struct {
+	uint8_t flags; // LIS3MDL_SAMPLE_ flags, set on claim
+	uint8_t address_byte; // Clocked in with the register address, void
+	LIS3MDL_Magnetic_Data_t data;
+	int16_t temperature; // TEMP_OUT, only with LIS3MDL_SAMPLE_TEMPERATURE
+} LIS3MDL_Sample_Slot;
+
+/**
+ * @brief Ring of magnetic samples which the receive DMA writes into directly.
+ *
+ * The producer acquires the next free slot and claims it for the device whose read fills
+ * it, so every device can have a read under way into a slot of its own. Once filled and
+ * decoded the slot is committed. The consumer peeks at the oldest slot and releases it once
+ * done, so a sample is never copied between the SPI peripheral and its consumer. Slots reach
+ * the consumer in the order they were claimed, one committed early waits for those before it.
+ */
+
+typedef struct {
+	LIS3MDL_Sample_Slot slots[LIS3MDL_SAMPLE_BUFFER_SIZE];
+	uint8_t dev_index[LIS3MDL_SAMPLE_BUFFER_SIZE]; // Device each slot was claimed for
+	uint8_t committed; // Bit per slot, filled but waiting for an earlier claim to be committed
+	uint8_t newest; // Free running index of the slot committed last
+	uint8_t claimed; // Free running index of the next slot to be claimed
+	volatile uint8_t head; // Free running index of the next slot to reach the consumer
+	volatile uint8_t tail; // Free running index of the oldest unreleased slot
+} LIS3MDL_Sample_Buffer;
+
+uint8_t lis3mdl_sample_buffer_init(LIS3MDL_Sample_Buffer *buffer);
+LIS3MDL_Sample_Slot *lis3mdl_sample_buffer_acquire_slot(LIS3MDL_Sample_Buffer *buffer);
+void lis3mdl_sample_buffer_claim(LIS3MDL_Sample_Buffer *buffer, uint8_t dev_index, uint8_t flags);
+LIS3MDL_Sample_Slot *lis3mdl_sample_buffer_get_claimed_slot(LIS3MDL_Sample_Buffer *buffer, uint8_t dev_index);
+void lis3mdl_sample_buffer_commit(LIS3MDL_Sample_Buffer *buffer, LIS3MDL_Sample_Slot *slot);
+const LIS3MDL_Magnetic_Data_t *lis3mdl_sample_buffer_peek(LIS3MDL_Sample_Buffer *buffer);
+const LIS3MDL_Magnetic_Data_t *lis3mdl_sample_buffer_peek_newest(LIS3MDL_Sample_Buffer *buffer);
+void lis3mdl_sample_buffer_flag_newest(LIS3MDL_Sample_Buffer *buffer, uint8_t flags);
+uint8_t lis3mdl_sample_buffer_peek_flags(LIS3MDL_Sample_Buffer *buffer);
+uint8_t lis3mdl_sample_buffer_peek_dev_index(LIS3MDL_Sample_Buffer *buffer);
+void lis3mdl_sample_buffer_release(LIS3MDL_Sample_Buffer *buffer);
+
+#endif /* LIS3MDL_LIS3MDL_SAMPLE_BUFFER_H_ */
@@ -0,0 +1,225 @@
+/*
+ * lis3mdl_self_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Self-test of one device while the acquisition keeps running. The datasheet sequence
+ * averages LIS3MDL_SELF_TEST_SAMPLES outputs, switches the self-test field on with the ST
+ * bit of CTRL_REG1, averages again after it settled, switches it off and compares the
+ * change of every axis against the limits. Here the averages are taken from the samples
+ * the loop reads anyway, and ST is switched with asynchronous writes of CTRL_REG1 in
+ * between two samples, so the device never stops delivering. Switching it on is background
+ * work, switching it back off a control write, which the bus arbiter does not let wait long.
+ *
+ * The samples from the moment ST is written until it is off again and settled carry the
+ * self-test field, `lis3mdl_self_test_add_sample` reports them as invalid. The samples
+ * before are the reference and stay valid. One test runs at a time.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "lis3mdl_self_test.h"
+#include "lis3mdl.h"
+#include "lis3mdl_registers.h"
+
+typedef enum {
+	SELF_TEST_IDLE,
+	SELF_TEST_REFERENCE, // Averaging without the self-test field
+	SELF_TEST_ENABLE_PENDING, // Waiting for a gap between two samples to set ST
+	SELF_TEST_ENABLING,
+	SELF_TEST_MEASURING, // Averaging with the self-test field once it settled
+	SELF_TEST_DISABLE_PENDING,
+	SELF_TEST_DISABLING,
+	SELF_TEST_RECOVERING // Discarding samples until the field is gone
+} Self_Test_Phase;
+
+static Self_Test_Phase phase = SELF_TEST_IDLE;
+static uint8_t test_device = 0;
+static uint8_t test_ctrl1 = 0; // CTRL_REG1 of the image the test started from, without ST
+static uint32_t sensitivity_lsb_per_gauss = 0;
+static int32_t reference_sum[3];
+static int32_t measured_sum[3];
+static uint8_t sample_count = 0;
+static uint32_t switched_us = 0; // ST was written
+static uint8_t discard_next = 0;
+static LIS3MDL_Self_Test_Report report;
+
+uint8_t lis3mdl_self_test_init(void){
+	phase = SELF_TEST_IDLE;
+	memset(&report, 0, sizeof(report));
+	return 0;
+}
+
+/**
+  * @brief Starts the self-test of a device, `lis3mdl_self_test_process` and
+  * `lis3mdl_self_test_add_sample` run it from then on.
+  *
+  * @param devices Pointer to the array of LIS3MDL_Device structures.
+  * @param num_of_devices The total number of devices in the `devices` array.
+  * @param dev_index Index of the device to test, it has to be configured and sampling.
+  *
+  * @retval 0 if the test started, 1 if a test is running already or the device is invalid.
+  */
+
+uint8_t lis3mdl_self_test_start(const LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t dev_index){
+	if(phase != SELF_TEST_IDLE || devices == NULL || dev_index >= num_of_devices || devices[dev_index].config_regs == NULL)
+		return 1;
+
+	test_device = dev_index;
+	test_ctrl1 = devices[dev_index].config_regs->ctrls[0] & ~LIS3MDL_SELF_TEST;
+	sensitivity_lsb_per_gauss = lis3mdl_get_sensitivity_lsb_per_gauss((LIS3MDL_Full_Scale)((devices[dev_index].config_regs->ctrls[1] & LIS3MDL_FULL_SCALE) >> 5));
+	memset(reference_sum, 0, sizeof(reference_sum));
+	memset(measured_sum, 0, sizeof(measured_sum));
+	sample_count = 0;
+	report.result = LIS3MDL_SELF_TEST_RUNNING;
+	report.dev_index = dev_index;
+	memset(report.delta, 0, sizeof(report.delta));
+	phase = SELF_TEST_REFERENCE;
+	return 0;
+}
+
+static uint8_t is_within(int32_t delta, uint32_t min_mgauss, uint32_t max_mgauss){
+	uint32_t magnitude = (uint32_t)abs(delta);
+	return magnitude >= min_mgauss * sensitivity_lsb_per_gauss / 1000 && magnitude <= max_mgauss * sensitivity_lsb_per_gauss / 1000;
+}
+
+static void evaluate(void){
+	for(int i=0; i<3; i++)
+		report.delta[i] = (measured_sum[i] - reference_sum[i]) / LIS3MDL_SELF_TEST_SAMPLES;
+
+	if(is_within(report.delta[0], LIS3MDL_SELF_TEST_XY_MIN_MGAUSS, LIS3MDL_SELF_TEST_XY_MAX_MGAUSS)
+			&& is_within(report.delta[1], LIS3MDL_SELF_TEST_XY_MIN_MGAUSS, LIS3MDL_SELF_TEST_XY_MAX_MGAUSS)
+			&& is_within(report.delta[2], LIS3MDL_SELF_TEST_Z_MIN_MGAUSS, LIS3MDL_SELF_TEST_Z_MAX_MGAUSS)){
+		report.result = LIS3MDL_SELF_TEST_PASSED;
+		report.passed++;
+	}
+	else{
+		report.result = LIS3MDL_SELF_TEST_FAILED;
+		report.failed++;
+	}
+}
+
+static void accumulate(int32_t *sum, const LIS3MDL_Magnetic_Data_t *sample){
+	sum[0] += sample->x;
+	sum[1] += sample->y;
+	sum[2] += sample->z;
+}
+
+/**
+  * @brief Tells whether a sample read after ST was switched may still be affected by the switch.
+  */
+
+static uint8_t is_settling(uint32_t now_us){
+	if(discard_next){ // Converted before the write, or while it went out
+		discard_next = 0;
+		return 1;
+	}
+	return now_us - switched_us < LIS3MDL_SELF_TEST_SETTLE_US;
+}
+
+/**
+  * @brief Writes ST and follows the write, call it on every pass of the loop.
+  * Writes only go out in between two samples of the device under test.
+  *
+  * @param devices Pointer to the array of LIS3MDL_Device structures.
+  * @param num_of_devices The total number of devices in the `devices` array.
+  */
+
+void lis3mdl_self_test_process(LIS3MDL_Device *devices, uint8_t num_of_devices){
+	if(phase == SELF_TEST_IDLE || devices == NULL || test_device >= num_of_devices)
+		return;
+
+	LIS3MDL_Device *device = &devices[test_device];
+	uint8_t image_ctrl1 = device->config_regs->ctrls[0] & ~LIS3MDL_SELF_TEST;
+	if(image_ctrl1 != test_ctrl1){
+		test_ctrl1 = image_ctrl1;
+		// A rewrite of the configuration clears ST, the averages no longer compare
+		if(phase == SELF_TEST_ENABLING || phase == SELF_TEST_MEASURING){
+			report.result = LIS3MDL_SELF_TEST_ABORTED;
+			report.aborted++;
+			phase = SELF_TEST_DISABLE_PENDING;
+		}
+	}
+
+	uint8_t ctrl1;
+	switch(phase){
+	case SELF_TEST_ENABLE_PENDING:
+	case SELF_TEST_DISABLE_PENDING:
+		if(device->data_retrieval_state != LIS3MDL_WAITING_FOR_DATA_READY)
+			return;
+		ctrl1 = phase == SELF_TEST_ENABLE_PENDING ? test_ctrl1 | LIS3MDL_SELF_TEST : test_ctrl1;
+		if(lis3mdl_write_reg(devices, num_of_devices, test_device, LIS3MDL_CTRL_REG1_ADDR, &ctrl1, 1,
+				phase == SELF_TEST_ENABLE_PENDING ? LIS3MDL_TRANSACTION_BACKGROUND : LIS3MDL_TRANSACTION_CONTROL) == HAL_OK)
+			phase = phase == SELF_TEST_ENABLE_PENDING ? SELF_TEST_ENABLING : SELF_TEST_DISABLING;
+		return;
+
+	case SELF_TEST_ENABLING:
+	case SELF_TEST_DISABLING:
+		if(device->process_state != LIS3MDL_IDLE)
+			return;
+		switched_us = lis3mdl_get_tick_us();
+		discard_next = 1;
+		sample_count = 0;
+		phase = phase == SELF_TEST_ENABLING ? SELF_TEST_MEASURING : SELF_TEST_RECOVERING;
+		return;
+
+	default:
+		return;
+	}
+}
+
+/**
+  * @brief Feeds a sample to the test, call it for every sample the loop delivers.
+  *
+  * @param dev_index Index of the device the sample came from.
+  * @param sample Pointer to the decoded sample.
+  *
+  * @retval 1 if the sample is a regular one, 0 if it may contain the self-test field and
+  * has to be treated as invalid.
+  */
+
+uint8_t lis3mdl_self_test_add_sample(uint8_t dev_index, const LIS3MDL_Magnetic_Data_t *sample){
+	if(phase == SELF_TEST_IDLE || dev_index != test_device || sample == NULL)
+		return 1;
+
+	switch(phase){
+	case SELF_TEST_REFERENCE:
+		accumulate(reference_sum, sample);
+		if(++sample_count >= LIS3MDL_SELF_TEST_SAMPLES)
+			phase = SELF_TEST_ENABLE_PENDING;
+		return 1;
+
+	case SELF_TEST_ENABLE_PENDING: // ST has not been written yet
+		return 1;
+
+	case SELF_TEST_MEASURING:
+		if(is_settling(lis3mdl_get_tick_us()))
+			break;
+		accumulate(measured_sum, sample);
+		if(++sample_count >= LIS3MDL_SELF_TEST_SAMPLES){
+			evaluate();
+			phase = SELF_TEST_DISABLE_PENDING;
+		}
+		break;
+
+	case SELF_TEST_RECOVERING:
+		if(is_settling(lis3mdl_get_tick_us()))
+			break;
+		phase = SELF_TEST_IDLE;
+		return 1;
+
+	default:
+		break;
+	}
+	report.invalid_samples++;
+	return 0;
+}
+
+uint8_t lis3mdl_self_test_is_running(void){
+	return phase != SELF_TEST_IDLE;
+}
+
+const LIS3MDL_Self_Test_Report *lis3mdl_self_test_get_report(void){
+	return &report;
+}
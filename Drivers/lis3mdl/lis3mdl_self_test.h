@@ -0,0 +1,60 @@
+/*
+ * lis3mdl_self_test.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef LIS3MDL_LIS3MDL_SELF_TEST_H_
+#define LIS3MDL_LIS3MDL_SELF_TEST_H_
+
+#include <stdint.h>
+#include "lis3mdl_device.h"
+
+#ifndef LIS3MDL_SELF_TEST_SAMPLES
+#define LIS3MDL_SELF_TEST_SAMPLES 5 // Averaged with and without the self-test field, as in the datasheet sequence
+#endif
+
+#ifndef LIS3MDL_SELF_TEST_SETTLE_US
+#define LIS3MDL_SELF_TEST_SETTLE_US 60000 // After switching ST, samples read earlier are discarded
+#endif
+
+/*
+ * Limits of the output change the self-test field causes, from the datasheet. They are
+ * specified at the 12 gauss full scale and applied to whatever full scale the device runs.
+ */
+#define LIS3MDL_SELF_TEST_XY_MIN_MGAUSS 1000
+#define LIS3MDL_SELF_TEST_XY_MAX_MGAUSS 3000
+#define LIS3MDL_SELF_TEST_Z_MIN_MGAUSS 100
+#define LIS3MDL_SELF_TEST_Z_MAX_MGAUSS 1000
+
+typedef enum {
+	LIS3MDL_SELF_TEST_NOT_RUN = 0x00,
+	LIS3MDL_SELF_TEST_RUNNING = 0x01,
+	LIS3MDL_SELF_TEST_PASSED = 0x02,
+	LIS3MDL_SELF_TEST_FAILED = 0x03, // A delta is outside the limits
+	LIS3MDL_SELF_TEST_ABORTED = 0x04 // The configuration changed under the test, e.g. by the ODR controller
+} LIS3MDL_Self_Test_Result;
+
+/**
+ * @brief Outcome of the last self-test and counters of all of them.
+ */
+
+typedef struct {
+	LIS3MDL_Self_Test_Result result;
+	uint8_t dev_index;
+	int32_t delta[3]; // Average with ST minus average without, LSB
+	uint32_t passed;
+	uint32_t failed;
+	uint32_t aborted;
+	uint32_t invalid_samples; // Samples taken while the self-test field could be on
+} LIS3MDL_Self_Test_Report;
+
+uint8_t lis3mdl_self_test_init(void);
+uint8_t lis3mdl_self_test_start(const LIS3MDL_Device *devices, uint8_t num_of_devices, uint8_t dev_index);
+void lis3mdl_self_test_process(LIS3MDL_Device *devices, uint8_t num_of_devices);
+uint8_t lis3mdl_self_test_add_sample(uint8_t dev_index, const LIS3MDL_Magnetic_Data_t *sample);
+uint8_t lis3mdl_self_test_is_running(void);
+const LIS3MDL_Self_Test_Report *lis3mdl_self_test_get_report(void);
+
+#endif /* LIS3MDL_LIS3MDL_SELF_TEST_H_ */
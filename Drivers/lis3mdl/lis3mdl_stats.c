@@ -0,0 +1,222 @@
+/*
+ * lis3mdl_stats.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Streaming statistics of the samples of every device: mean, variance, minimum and
+ * maximum per axis over tumbling or sliding windows, handed out as compact summaries so
+ * the node can send those instead of every sample. A one second window at 80 Hz replaces
+ * 480 bytes of samples with 42, with ten second windows less than 1 % of the data leaves.
+ *
+ * Every sample updates the block of the current hop in O(1): a 32 bit sum, a 64 bit sum of
+ * squares, minimum and maximum per axis. In integers these sums are exact, so the variance
+ * computed from them does not suffer the cancellation that Welford's running mean avoids
+ * in floating point, and blocks combine by plain addition, which is the merge step of the
+ * parallel form of Welford's algorithm without its rounding. A sliding window keeps the
+ * blocks of its last hops and combines them once per hop, a tumbling one is a window of one
+ * hop. LIS3MDL_STATS_MAX_WINDOW_SAMPLES bounds a window so that n times the sum of squares
+ * and the squared sum both stay below 2^62.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "lis3mdl_stats.h"
+
+/**
+ * @brief Sums of the samples of one hop of one device.
+ */
+
+typedef struct {
+	int32_t sum[3];
+	uint64_t sum_of_squares[3];
+	int16_t min[3];
+	int16_t max[3];
+	uint16_t count; // Samples summarized
+	uint16_t offered; // Samples summarized or skipped, the hop closes at hop_samples
+	uint32_t start_us;
+	uint32_t end_us;
+	uint8_t skipped;
+} LIS3MDL_Stats_Block;
+
+/**
+ * @brief The hops of one device, the window is every block but the open one.
+ */
+
+typedef struct {
+	LIS3MDL_Stats_Block blocks[LIS3MDL_STATS_MAX_HOPS + 1];
+	uint8_t open_block;
+	uint8_t closed_hops; // Saturates at window_hops
+	uint8_t summary_ready;
+	uint8_t overrun;
+} LIS3MDL_Stats_Track;
+
+static LIS3MDL_Stats_Params stats_params;
+static LIS3MDL_Stats_Track tracks[LIS3MDL_STATS_MAX_DEVICES];
+
+/**
+  * @brief Sets the windows and drops everything summarized so far.
+  *
+  * @param params Pointer to the windows, NULL or a `hop_samples` of 0 disables the statistics.
+  *
+  * @retval 0 on success, 1 if the window has no hops, more than LIS3MDL_STATS_MAX_HOPS
+  * or more than LIS3MDL_STATS_MAX_WINDOW_SAMPLES samples.
+  */
+
+uint8_t lis3mdl_stats_init(const LIS3MDL_Stats_Params *params){
+	memset(&stats_params, 0, sizeof(stats_params));
+	memset(tracks, 0, sizeof(tracks));
+	if(params == NULL || params->hop_samples == 0)
+		return 0;
+
+	if(params->window_hops == 0 || params->window_hops > LIS3MDL_STATS_MAX_HOPS
+			|| (uint32_t)params->hop_samples * params->window_hops > LIS3MDL_STATS_MAX_WINDOW_SAMPLES)
+		return 1;
+
+	stats_params = *params;
+	return 0;
+}
+
+/**
+  * @brief Counts a sample towards the open hop and closes the hop once it is full.
+  *
+  * @retval 1 if a summary is ready, 0 otherwise.
+  */
+
+static uint8_t count_sample(LIS3MDL_Stats_Track *track){
+	if(++track->blocks[track->open_block].offered < stats_params.hop_samples)
+		return 0;
+
+	if(track->closed_hops < stats_params.window_hops)
+		track->closed_hops++;
+	track->open_block = (track->open_block + 1) % (stats_params.window_hops + 1);
+	memset(&track->blocks[track->open_block], 0, sizeof(LIS3MDL_Stats_Block));
+	if(track->closed_hops < stats_params.window_hops)
+		return 0;
+
+	if(track->summary_ready)
+		track->overrun = 1;
+	track->summary_ready = 1;
+	return 1;
+}
+
+/**
+  * @brief Adds a sample to the statistics of its device, call it for every valid sample.
+  *
+  * @param dev_index Index of the device the sample came from.
+  * @param sample Pointer to the decoded sample.
+  * @param time_us Time the sample was committed.
+  *
+  * @retval 1 if the sample completed a window and a summary can be taken, 0 otherwise.
+  */
+
+uint8_t lis3mdl_stats_add_sample(uint8_t dev_index, const LIS3MDL_Magnetic_Data_t *sample, uint32_t time_us){
+	if(stats_params.hop_samples == 0 || dev_index >= LIS3MDL_STATS_MAX_DEVICES || sample == NULL)
+		return 0;
+
+	LIS3MDL_Stats_Track *track = &tracks[dev_index];
+	LIS3MDL_Stats_Block *block = &track->blocks[track->open_block];
+	const int16_t axes[3] = { sample->x, sample->y, sample->z };
+	if(block->count == 0){
+		block->start_us = time_us;
+		for(int i=0; i<3; i++)
+			block->min[i] = block->max[i] = axes[i];
+	}
+	for(int i=0; i<3; i++){
+		block->sum[i] += axes[i];
+		block->sum_of_squares[i] += (uint32_t)((int32_t)axes[i] * axes[i]);
+		if(axes[i] < block->min[i])
+			block->min[i] = axes[i];
+		if(axes[i] > block->max[i])
+			block->max[i] = axes[i];
+	}
+	block->count++;
+	block->end_us = time_us;
+	return count_sample(track);
+}
+
+/**
+  * @brief Counts a sample that must not be summarized, e.g. one taken during a self-test,
+  * the summary of its window is flagged with LIS3MDL_STATS_SKIPPED.
+  *
+  * @retval 1 if the sample completed a window and a summary can be taken, 0 otherwise.
+  */
+
+uint8_t lis3mdl_stats_skip_sample(uint8_t dev_index){
+	if(stats_params.hop_samples == 0 || dev_index >= LIS3MDL_STATS_MAX_DEVICES)
+		return 0;
+
+	LIS3MDL_Stats_Track *track = &tracks[dev_index];
+	track->blocks[track->open_block].skipped = 1;
+	return count_sample(track);
+}
+
+/**
+  * @brief Rounds a quotient half away from zero.
+  */
+
+static int64_t divide_rounded(int64_t dividend, int64_t divisor){
+	return (dividend >= 0 ? dividend + divisor / 2 : dividend - divisor / 2) / divisor;
+}
+
+/**
+  * @brief Combines the blocks of the last window of a device into a summary.
+  * The divisions happen here, once per hop, not for every sample.
+  *
+  * @param dev_index Index of the device.
+  * @param summary Receives the summary.
+  *
+  * @retval 0 on success, 1 if no window completed since the last summary was taken.
+  */
+
+uint8_t lis3mdl_stats_take_summary(uint8_t dev_index, LIS3MDL_Stats_Summary *summary){
+	if(dev_index >= LIS3MDL_STATS_MAX_DEVICES || !tracks[dev_index].summary_ready)
+		return 1;
+
+	LIS3MDL_Stats_Track *track = &tracks[dev_index];
+	int64_t sum[3] = { 0, 0, 0 };
+	uint64_t sum_of_squares[3] = { 0, 0, 0 };
+	uint32_t count = 0;
+	memset(summary, 0, sizeof(*summary));
+	summary->dev_index = dev_index;
+	summary->flags = track->overrun ? LIS3MDL_STATS_OVERRUN : 0;
+
+	// Oldest block first, right after the open one
+	for(int hop=1; hop<=stats_params.window_hops; hop++){
+		const LIS3MDL_Stats_Block *block = &track->blocks[(track->open_block + hop) % (stats_params.window_hops + 1)];
+		if(block->skipped)
+			summary->flags |= LIS3MDL_STATS_SKIPPED;
+		if(block->count == 0)
+			continue;
+		if(count == 0){
+			summary->start_us = block->start_us;
+			memcpy(summary->min, block->min, sizeof(summary->min));
+			memcpy(summary->max, block->max, sizeof(summary->max));
+		}
+		summary->end_us = block->end_us;
+		for(int i=0; i<3; i++){
+			sum[i] += block->sum[i];
+			sum_of_squares[i] += block->sum_of_squares[i];
+			if(block->min[i] < summary->min[i])
+				summary->min[i] = block->min[i];
+			if(block->max[i] > summary->max[i])
+				summary->max[i] = block->max[i];
+		}
+		count += block->count;
+	}
+	track->summary_ready = 0;
+	track->overrun = 0;
+
+	summary->count = (uint16_t)count;
+	if(count == 0)
+		return 0;
+	uint64_t count_squared = (uint64_t)count * count;
+	for(int i=0; i<3; i++){
+		summary->mean[i] = (int16_t)divide_rounded(sum[i], count);
+		uint64_t magnitude = (uint64_t)(sum[i] < 0 ? -sum[i] : sum[i]);
+		// n * sum(x^2) - sum(x)^2 is n^2 times the variance and never negative
+		uint64_t scaled_variance = count * sum_of_squares[i] - magnitude * magnitude;
+		summary->variance[i] = (uint32_t)((scaled_variance + count_squared / 2) / count_squared);
+	}
+	return 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * lis3mdl_stats.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef LIS3MDL_LIS3MDL_STATS_H_
+#define LIS3MDL_LIS3MDL_STATS_H_
+
+#include <stdint.h>
+#include "lis3mdl_device.h"
+
+#ifndef LIS3MDL_STATS_MAX_DEVICES
+#define LIS3MDL_STATS_MAX_DEVICES 4 // Samples of devices with a higher index are not summarized
+#endif
+
+#ifndef LIS3MDL_STATS_MAX_HOPS
+#define LIS3MDL_STATS_MAX_HOPS 4 // Longest window in hops, every hop costs a block of RAM per device
+#endif
+
+#define LIS3MDL_STATS_MAX_WINDOW_SAMPLES 65535 // Keeps the sums of a window exact in 64 bits
+
+#define LIS3MDL_STATS_SKIPPED 0x01 // Samples of the window were left out, e.g. taken during a self-test
+#define LIS3MDL_STATS_OVERRUN 0x02 // The summary before this one was replaced before it was taken
+
+/**
+ * @brief Windows the samples of every device are summarized over. A summary is due every
+ * `hop_samples` samples of a device and covers the last `window_hops` hops, so one hop
+ * gives tumbling windows and more hops windows that slide by a hop. Samples are counted
+ * whether they are summarized or skipped, the windows stay aligned to the sample stream.
+ */
+
+typedef struct {
+	uint16_t hop_samples; // 0 disables the statistics
+	uint8_t window_hops;
+} LIS3MDL_Stats_Params;
+
+/**
+ * @brief Per axis statistics of one window of one device, sent instead of its samples.
+ * Little endian as both the target and the PC store it.
+ */
+
+typedef struct __attribute__((packed)) {
+	uint32_t start_us; // Time of the first sample in the window
+	uint32_t end_us; // Time of the last one
+	uint8_t dev_index;
+	uint8_t flags;
+	uint16_t count; // Samples summarized
+	int16_t mean[3]; // LSB, rounded
+	int16_t min[3];
+	int16_t max[3];
+	uint32_t variance[3]; // Population variance, LSB squared, rounded
+} LIS3MDL_Stats_Summary;
+
+_Static_assert(sizeof(LIS3MDL_Stats_Summary) == 42, "LIS3MDL_Stats_Summary leaves the node as it is");
+
+uint8_t lis3mdl_stats_init(const LIS3MDL_Stats_Params *params);
+uint8_t lis3mdl_stats_add_sample(uint8_t dev_index, const LIS3MDL_Magnetic_Data_t *sample, uint32_t time_us);
+uint8_t lis3mdl_stats_skip_sample(uint8_t dev_index);
+uint8_t lis3mdl_stats_take_summary(uint8_t dev_index, LIS3MDL_Stats_Summary *summary);
+
+#endif /* LIS3MDL_LIS3MDL_STATS_H_ */
@@ -0,0 +1,199 @@
+/*
+ * lis3mdl_telemetry.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#include <string.h>
+#include "lis3mdl_telemetry.h"
+#include "lis3mdl_poll_scheduler.h"
+
+#if LIS3MDL_TELEMETRY_ENABLED
+
+static LIS3MDL_Telemetry lis3mdl_telemetry = {
+	.version = LIS3MDL_TELEMETRY_VERSION,
+	.max_devices = LIS3MDL_TELEMETRY_MAX_DEVICES
+};
+
+/**
+ * @brief What the hooks carry from one call to the next, kept out of the exported record.
+ */
+
+static struct {
+	uint64_t latency_sum_us[LIS3MDL_TELEMETRY_MAX_DEVICES]; // latency_avg_us is this over samples
+	uint32_t poll_start_us[LIS3MDL_TELEMETRY_MAX_DEVICES]; // Start of the status read that is in progress
+	uint32_t transfer_start_us; // Start of the transfer in flight
+	uint32_t transfer_end_us; // Completion of the last transfer
+	uint8_t transfer_size; // Size of the transfer in flight
+	uint8_t retrying[LIS3MDL_TELEMETRY_MAX_DEVICES]; // The postponed read is already counted in retries
+} telemetry_state;
+
+/**
+  * @brief Clears every counter and restarts the measurement window.
+  */
+
+void lis3mdl_telemetry_reset(void){
+	memset(&lis3mdl_telemetry, 0, sizeof(lis3mdl_telemetry));
+	memset(&telemetry_state, 0, sizeof(telemetry_state));
+	lis3mdl_telemetry.version = LIS3MDL_TELEMETRY_VERSION;
+	lis3mdl_telemetry.max_devices = LIS3MDL_TELEMETRY_MAX_DEVICES;
+	lis3mdl_telemetry.since_us = lis3mdl_get_tick_us();
+}
+
+/**
+  * @brief Gives access to the recorded counters.
+  *
+  * @retval Pointer to the telemetry record, NULL if telemetry is compiled out.
+  */
+
+const LIS3MDL_Telemetry *lis3mdl_telemetry_get(void){
+	return &lis3mdl_telemetry;
+}
+
+/**
+  * @brief Accounts a DMA transfer the HAL accepted.
+  *
+  * @param size Number of bytes the transfer shifts.
+  */
+
+void lis3mdl_telemetry_transfer_started(uint8_t size){
+	LIS3MDL_Bus_Telemetry *bus = &lis3mdl_telemetry.bus;
+	uint32_t now_us = lis3mdl_get_tick_us();
+
+	if(bus->transfers){
+		uint32_t gap_us = now_us - telemetry_state.transfer_end_us;
+		bus->idle_us += gap_us;
+		if(gap_us > bus->max_idle_gap_us)
+			bus->max_idle_gap_us = gap_us;
+	}
+	bus->transfers++;
+	telemetry_state.transfer_start_us = now_us;
+	telemetry_state.transfer_size = size;
+}
+
+/**
+  * @brief Accounts the completion of the DMA transfer in flight.
+  *
+  * @param frame_done Non-zero if the transfer ended a CS frame.
+  */
+
+void lis3mdl_telemetry_transfer_completed(uint8_t frame_done){
+	LIS3MDL_Bus_Telemetry *bus = &lis3mdl_telemetry.bus;
+	uint32_t now_us = lis3mdl_get_tick_us();
+
+	bus->dma_busy_us += now_us - telemetry_state.transfer_start_us;
+	bus->bytes += telemetry_state.transfer_size;
+	telemetry_state.transfer_end_us = now_us;
+	if(frame_done)
+		bus->transactions++;
+}
+
+/**
+  * @brief Accounts a STATUS_REG read being started and marks the start of the latency measurement.
+  *
+  * @param dev_index Index of the device.
+  */
+
+void lis3mdl_telemetry_status_poll(uint8_t dev_index){
+	if(dev_index >= LIS3MDL_TELEMETRY_MAX_DEVICES)
+		return;
+	lis3mdl_telemetry.devices[dev_index].status_polls++;
+	telemetry_state.poll_start_us[dev_index] = lis3mdl_get_tick_us();
+	telemetry_state.retrying[dev_index] = 0;
+}
+
+/**
+  * @brief Accounts a STATUS_REG read that found no new data.
+  *
+  * @param dev_index Index of the device.
+  */
+
+void lis3mdl_telemetry_status_miss(uint8_t dev_index){
+	if(dev_index >= LIS3MDL_TELEMETRY_MAX_DEVICES)
+		return;
+	lis3mdl_telemetry.devices[dev_index].status_misses++;
+}
+
+/**
+  * @brief Accounts a sample the sensor overwrote before it was read.
+  *
+  * @param dev_index Index of the device.
+  */
+
+void lis3mdl_telemetry_overrun(uint8_t dev_index){
+	if(dev_index >= LIS3MDL_TELEMETRY_MAX_DEVICES)
+		return;
+	lis3mdl_telemetry.devices[dev_index].overruns++;
+}
+
+/**
+  * @brief Accounts a read postponed because the bus or the sample buffer was busy.
+  * The driver tries again on every call, only the first attempt of a read is counted,
+  * the status read or the sample that follows arms the count again.
+  *
+  * @param dev_index Index of the device.
+  */
+
+void lis3mdl_telemetry_retry(uint8_t dev_index){
+	if(dev_index >= LIS3MDL_TELEMETRY_MAX_DEVICES || telemetry_state.retrying[dev_index])
+		return;
+	lis3mdl_telemetry.devices[dev_index].retries++;
+	telemetry_state.retrying[dev_index] = 1;
+}
+
+/**
+  * @brief Accounts a committed sample and its latency since the status read that announced it.
+  *
+  * @param dev_index Index of the device the sample came from.
+  */
+
+void lis3mdl_telemetry_sample(uint8_t dev_index){
+	if(dev_index >= LIS3MDL_TELEMETRY_MAX_DEVICES)
+		return;
+
+	LIS3MDL_Device_Telemetry *device = &lis3mdl_telemetry.devices[dev_index];
+	uint32_t latency_us = lis3mdl_get_tick_us() - telemetry_state.poll_start_us[dev_index];
+
+	device->samples++;
+	telemetry_state.retrying[dev_index] = 0;
+	if(device->samples == 1 || latency_us < device->latency_min_us)
+		device->latency_min_us = latency_us;
+	if(latency_us > device->latency_max_us)
+		device->latency_max_us = latency_us;
+	telemetry_state.latency_sum_us[dev_index] += latency_us;
+	device->latency_avg_us = (uint32_t)(telemetry_state.latency_sum_us[dev_index] / device->samples);
+}
+
+/**
+  * @brief Records a rate decision of the adaptive ODR controller.
+  *
+  * @param from_level LIS3MDL_Odr_Level the devices ran at.
+  * @param to_level LIS3MDL_Odr_Level they are switched to.
+  * @param activity_rate Rate of change of the field behind a raise, 0 for a step down.
+  */
+
+void lis3mdl_telemetry_odr_decision(uint8_t from_level, uint8_t to_level, uint32_t activity_rate){
+	LIS3MDL_Odr_Telemetry *odr = &lis3mdl_telemetry.odr;
+
+	if(to_level > from_level){
+		odr->raises++;
+		odr->last_activity_rate = activity_rate;
+	}
+	else
+		odr->steps_down++;
+	odr->last_decision_us = lis3mdl_get_tick_us();
+	odr->previous_level = from_level;
+	odr->level = to_level;
+}
+
+#else
+
+void lis3mdl_telemetry_reset(void){
+}
+
+const LIS3MDL_Telemetry *lis3mdl_telemetry_get(void){
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,142 @@
+/*
+ * lis3mdl_telemetry.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef LIS3MDL_LIS3MDL_TELEMETRY_H_
+#define LIS3MDL_LIS3MDL_TELEMETRY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Telemetry is compiled in for DEBUG builds unless LIS3MDL_TELEMETRY_ENABLED is set explicitly.
+ * When disabled every hook below expands to nothing.
+ */
+
+#ifndef LIS3MDL_TELEMETRY_ENABLED
+#ifdef DEBUG
+#define LIS3MDL_TELEMETRY_ENABLED 1
+#else
+#define LIS3MDL_TELEMETRY_ENABLED 0
+#endif
+#endif
+
+#ifndef LIS3MDL_TELEMETRY_MAX_DEVICES
+#define LIS3MDL_TELEMETRY_MAX_DEVICES 4 // Devices with a higher index are not accounted
+#endif
+
+#define LIS3MDL_TELEMETRY_VERSION 4
+
+/*
+ * The records below are read by a debugger or dumped to a log stream as they are. Every
+ * field sits at its natural alignment with explicit padding, `packed` only pins that
+ * layout down, and the assertions after each record check it. Working state the hooks
+ * need between calls is kept in lis3mdl_telemetry.c.
+ */
+
+/**
+ * @brief Counters describing how busy the SPI bus shared by the LIS3MDL devices is.
+ */
+
+typedef struct __attribute__((packed)) {
+	uint32_t bytes; // Bytes shifted by DMA in either direction
+	uint32_t transfers; // DMA transfers the HAL accepted
+	uint32_t transactions; // CS low to CS high frames
+	uint32_t dma_busy_us; // Time between starting a transfer and seeing it complete
+	uint32_t idle_us; // Time between a completed transfer and the start of the next one
+	uint32_t max_idle_gap_us; // Longest single idle gap
+} LIS3MDL_Bus_Telemetry;
+
+_Static_assert(offsetof(LIS3MDL_Bus_Telemetry, max_idle_gap_us) == 20 && sizeof(LIS3MDL_Bus_Telemetry) == 24, "LIS3MDL_Bus_Telemetry layout");
+
+/**
+ * @brief Counters describing the acquisition of a single LIS3MDL device.
+ */
+
+typedef struct __attribute__((packed)) {
+	uint32_t samples; // Samples committed to the sample buffer
+	uint32_t status_polls; // STATUS_REG reads started
+	uint32_t status_misses; // STATUS_REG reads that found no new data
+	uint32_t overruns; // Samples the sensor overwrote before they were read
+	uint32_t retries; // Reads that had to be postponed because the bus or the sample buffer was busy, once per read
+	uint32_t latency_min_us; // Status read start to sample committed
+	uint32_t latency_avg_us;
+	uint32_t latency_max_us;
+} LIS3MDL_Device_Telemetry;
+
+_Static_assert(offsetof(LIS3MDL_Device_Telemetry, latency_max_us) == 28 && sizeof(LIS3MDL_Device_Telemetry) == 32, "LIS3MDL_Device_Telemetry layout");
+
+/**
+ * @brief Decisions of the adaptive ODR controller, see lis3mdl_odr_controller.h.
+ */
+
+typedef struct __attribute__((packed)) {
+	uint32_t raises; // Decisions to go to the active level
+	uint32_t steps_down; // Steps towards the quiet level after the hold-off
+	uint32_t last_decision_us; // Time of the last decision
+	uint32_t last_activity_rate; // Rate of change that led to the last raise, LSB per second
+	uint8_t level; // LIS3MDL_Odr_Level decided last
+	uint8_t previous_level; // Level before it
+	uint8_t reserved[2];
+} LIS3MDL_Odr_Telemetry;
+
+_Static_assert(offsetof(LIS3MDL_Odr_Telemetry, level) == 16 && sizeof(LIS3MDL_Odr_Telemetry) == 20, "LIS3MDL_Odr_Telemetry layout");
+
+/**
+ * @brief Everything recorded. The version and device count stay in front so a reader can
+ * tell the layout before it looks further.
+ */
+
+typedef struct __attribute__((packed)) {
+	uint8_t version;
+	uint8_t max_devices;
+	uint8_t reserved[2];
+	uint32_t since_us; // Time of the last reset
+	LIS3MDL_Bus_Telemetry bus;
+	LIS3MDL_Odr_Telemetry odr;
+	LIS3MDL_Device_Telemetry devices[LIS3MDL_TELEMETRY_MAX_DEVICES];
+} LIS3MDL_Telemetry;
+
+_Static_assert(offsetof(LIS3MDL_Telemetry, since_us) == 4 && offsetof(LIS3MDL_Telemetry, bus) == 8
+		&& offsetof(LIS3MDL_Telemetry, odr) == 32 && offsetof(LIS3MDL_Telemetry, devices) == 52, "LIS3MDL_Telemetry layout");
+
+void lis3mdl_telemetry_reset(void);
+const LIS3MDL_Telemetry *lis3mdl_telemetry_get(void);
+
+#if LIS3MDL_TELEMETRY_ENABLED
+
+void lis3mdl_telemetry_transfer_started(uint8_t size);
+void lis3mdl_telemetry_transfer_completed(uint8_t frame_done);
+void lis3mdl_telemetry_status_poll(uint8_t dev_index);
+void lis3mdl_telemetry_status_miss(uint8_t dev_index);
+void lis3mdl_telemetry_overrun(uint8_t dev_index);
+void lis3mdl_telemetry_retry(uint8_t dev_index);
+void lis3mdl_telemetry_sample(uint8_t dev_index);
+void lis3mdl_telemetry_odr_decision(uint8_t from_level, uint8_t to_level, uint32_t activity_rate);
+
+#define LIS3MDL_TELEMETRY_TRANSFER_STARTED(size) lis3mdl_telemetry_transfer_started(size)
+#define LIS3MDL_TELEMETRY_TRANSFER_COMPLETED(frame_done) lis3mdl_telemetry_transfer_completed(frame_done)
+#define LIS3MDL_TELEMETRY_STATUS_POLL(dev_index) lis3mdl_telemetry_status_poll(dev_index)
+#define LIS3MDL_TELEMETRY_STATUS_MISS(dev_index) lis3mdl_telemetry_status_miss(dev_index)
+#define LIS3MDL_TELEMETRY_OVERRUN(dev_index) lis3mdl_telemetry_overrun(dev_index)
+#define LIS3MDL_TELEMETRY_RETRY(dev_index) lis3mdl_telemetry_retry(dev_index)
+#define LIS3MDL_TELEMETRY_SAMPLE(dev_index) lis3mdl_telemetry_sample(dev_index)
+#define LIS3MDL_TELEMETRY_ODR_DECISION(from_level, to_level, activity_rate) lis3mdl_telemetry_odr_decision(from_level, to_level, activity_rate)
+
+#else
+
+#define LIS3MDL_TELEMETRY_TRANSFER_STARTED(size) do {} while(0)
+#define LIS3MDL_TELEMETRY_TRANSFER_COMPLETED(frame_done) do {} while(0)
+#define LIS3MDL_TELEMETRY_STATUS_POLL(dev_index) do {} while(0)
+#define LIS3MDL_TELEMETRY_STATUS_MISS(dev_index) do {} while(0)
+#define LIS3MDL_TELEMETRY_OVERRUN(dev_index) do {} while(0)
+#define LIS3MDL_TELEMETRY_RETRY(dev_index) do {} while(0)
+#define LIS3MDL_TELEMETRY_SAMPLE(dev_index) do {} while(0)
+#define LIS3MDL_TELEMETRY_ODR_DECISION(from_level, to_level, activity_rate) do {} while(0)
+
+#endif
+
+#endif /* LIS3MDL_LIS3MDL_TELEMETRY_H_ */
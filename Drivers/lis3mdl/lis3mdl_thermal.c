@@ -0,0 +1,158 @@
+/*
+ * lis3mdl_thermal.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Temperature of every device and compensation of its thermal offset drift. With TEMP_EN
+ * set in CTRL_REG1 the sensor converts the temperature along with the field. Every
+ * LIS3MDL_THERMAL_DECIMATION samples of a device `lis3mdl_get_magnetic_data` lets the
+ * auto-increment burst of the data read run on from OUT_Z_H to TEMP_OUT_H, so the
+ * temperature costs two more bytes instead of another transaction. Every sample is then
+ * corrected with the offsets the lookup table of its device gives for the last temperature,
+ * interpolated linearly in fixed point.
+ *
+ * STATUS_REG stays a read of its own: the poll schedule is tuned to its timing, and OUT
+ * registers read in a burst whose status found no data would clear the flags of a
+ * conversion that finishes within the burst, losing that sample.
+ */
+
+#include <stddef.h>
+#include "lis3mdl_thermal.h"
+#include "lis3mdl_registers.h"
+
+typedef struct {
+	const LIS3MDL_Thermal_Lut *lut;
+	int16_t temperature; // Last TEMP_OUT read
+	uint8_t temperature_valid;
+	uint16_t samples_until_burst;
+} LIS3MDL_Thermal_Track;
+
+static LIS3MDL_Thermal_Track tracks[LIS3MDL_THERMAL_MAX_DEVICES];
+
+/**
+  * @brief Forgets the temperatures read and schedules a burst for the next sample of every
+  * device. The tables stay set.
+  */
+
+void lis3mdl_thermal_reset(void){
+	for(int i=0; i<LIS3MDL_THERMAL_MAX_DEVICES; i++){
+		tracks[i].temperature_valid = 0;
+		tracks[i].samples_until_burst = 0;
+	}
+}
+
+/**
+  * @brief Sets the offset table of a device, the tables stay with the devices across
+  * `lis3mdl_thermal_reset`.
+  *
+  * @param dev_index Index of the device.
+  * @param lut Pointer to the table, has to stay valid, NULL to stop compensating.
+  *
+  * @retval 0 on success, 1 if the index is out of range or the steps would overflow.
+  */
+
+uint8_t lis3mdl_thermal_set_lut(uint8_t dev_index, const LIS3MDL_Thermal_Lut *lut){
+	if(dev_index >= LIS3MDL_THERMAL_MAX_DEVICES || (lut != NULL && lut->step_shift > 12))
+		return 1;
+
+	tracks[dev_index].lut = lut;
+	return 0;
+}
+
+/**
+  * @brief Tells whether the next sample of a device should be read together with the temperature.
+  *
+  * @retval 1 if the temperature sensor is enabled and LIS3MDL_THERMAL_DECIMATION samples
+  * went by since the last burst, 0 otherwise.
+  */
+
+uint8_t lis3mdl_thermal_is_burst_due(const LIS3MDL_Device *device, uint8_t dev_index){
+	if(dev_index >= LIS3MDL_THERMAL_MAX_DEVICES || device->config_regs == NULL || !(device->config_regs->ctrls[0] & LIS3MDL_TEMP_EN))
+		return 0;
+
+	return tracks[dev_index].samples_until_burst == 0;
+}
+
+/**
+  * @brief Stores the TEMP_OUT value a burst read, decoded to MCU byte order.
+  */
+
+void lis3mdl_thermal_set_temperature(uint8_t dev_index, int16_t temperature){
+	if(dev_index >= LIS3MDL_THERMAL_MAX_DEVICES)
+		return;
+
+	tracks[dev_index].temperature = temperature;
+	tracks[dev_index].temperature_valid = 1;
+	tracks[dev_index].samples_until_burst = LIS3MDL_THERMAL_DECIMATION;
+}
+
+static int32_t interpolate(const LIS3MDL_Thermal_Lut *lut, int32_t index, int32_t fraction, int axis){
+	int32_t offset = lut->offsets[index][axis];
+	if(fraction == 0)
+		return offset;
+
+	int32_t rise = lut->offsets[index + 1][axis] - offset;
+	return offset + ((rise * fraction + (1L << (lut->step_shift - 1))) >> lut->step_shift);
+}
+
+/**
+  * @brief Subtracts the thermal offset from a decoded sample and counts it towards the next burst.
+  * Samples stay as they are until the device has a table and a temperature.
+  *
+  * @param dev_index Index of the device the sample came from.
+  * @param sample Pointer to the decoded sample, corrected in place and saturated.
+  */
+
+void lis3mdl_thermal_compensate(uint8_t dev_index, LIS3MDL_Magnetic_Data_t *sample){
+	if(dev_index >= LIS3MDL_THERMAL_MAX_DEVICES)
+		return;
+
+	LIS3MDL_Thermal_Track *track = &tracks[dev_index];
+	if(track->samples_until_burst)
+		track->samples_until_burst--;
+	if(track->lut == NULL || !track->temperature_valid)
+		return;
+
+	const LIS3MDL_Thermal_Lut *lut = track->lut;
+	int32_t position = (int32_t)track->temperature - lut->first_temperature;
+	int32_t last_position = (int32_t)(LIS3MDL_THERMAL_LUT_POINTS - 1) << lut->step_shift;
+	if(position < 0)
+		position = 0;
+	if(position > last_position)
+		position = last_position;
+	int32_t index = position >> lut->step_shift;
+	int32_t fraction = position & ((1L << lut->step_shift) - 1);
+
+	int16_t *axes[3] = { &sample->x, &sample->y, &sample->z };
+	for(int i=0; i<3; i++){
+		int32_t value = *axes[i] - interpolate(lut, index, fraction, i);
+		*axes[i] = (int16_t)(value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : value);
+	}
+}
+
+/**
+  * @brief Gives the last temperature read from a device.
+  *
+  * @param temperature Receives TEMP_OUT, 8 LSB per degC and 0 around 25 degC.
+  *
+  * @retval 0 on success, 1 if no burst has read the temperature of the device yet.
+  */
+
+uint8_t lis3mdl_thermal_get_temperature(uint8_t dev_index, int16_t *temperature){
+	if(dev_index >= LIS3MDL_THERMAL_MAX_DEVICES || !tracks[dev_index].temperature_valid)
+		return 1;
+
+	*temperature = tracks[dev_index].temperature;
+	return 0;
+}
+
+/**
+  * @brief Tells whether the samples of a device are corrected.
+  *
+  * @retval 1 if the device has a table and a temperature was read, 0 otherwise.
+  */
+
+uint8_t lis3mdl_thermal_is_compensating(uint8_t dev_index){
+	return dev_index < LIS3MDL_THERMAL_MAX_DEVICES && tracks[dev_index].lut != NULL && tracks[dev_index].temperature_valid;
+}
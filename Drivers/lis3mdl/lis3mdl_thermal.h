@@ -0,0 +1,46 @@
+/*
+ * lis3mdl_thermal.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef LIS3MDL_LIS3MDL_THERMAL_H_
+#define LIS3MDL_LIS3MDL_THERMAL_H_
+
+#include <stdint.h>
+#include "lis3mdl_device.h"
+
+#ifndef LIS3MDL_THERMAL_MAX_DEVICES
+#define LIS3MDL_THERMAL_MAX_DEVICES 4 // Devices with a higher index are neither measured nor compensated
+#endif
+
+#ifndef LIS3MDL_THERMAL_DECIMATION
+#define LIS3MDL_THERMAL_DECIMATION 16 // Samples per device between two reads of the temperature
+#endif
+
+#define LIS3MDL_THERMAL_LUT_POINTS 8
+#define LIS3MDL_THERMAL_BURST_SIZE 8 // OUT_X_L..OUT_Z_H, TEMP_OUT_L/H
+
+/**
+ * @brief Offset of every axis over temperature, subtracted from the samples of a device.
+ * The points are evenly spaced by a power of two of TEMP_OUT, so looking an offset up
+ * takes shifts and one multiplication per axis. Below the first and above the last point
+ * the offset of that point applies.
+ */
+
+typedef struct {
+	int16_t first_temperature; // TEMP_OUT at the first point, 8 LSB per degC and 0 around 25 degC
+	uint8_t step_shift; // The points are 1 << step_shift LSB of TEMP_OUT apart
+	int16_t offsets[LIS3MDL_THERMAL_LUT_POINTS][3]; // X, Y, Z offset at every point, LSB of the output
+} LIS3MDL_Thermal_Lut;
+
+void lis3mdl_thermal_reset(void);
+uint8_t lis3mdl_thermal_set_lut(uint8_t dev_index, const LIS3MDL_Thermal_Lut *lut);
+uint8_t lis3mdl_thermal_is_burst_due(const LIS3MDL_Device *device, uint8_t dev_index);
+void lis3mdl_thermal_set_temperature(uint8_t dev_index, int16_t temperature);
+void lis3mdl_thermal_compensate(uint8_t dev_index, LIS3MDL_Magnetic_Data_t *sample);
+uint8_t lis3mdl_thermal_get_temperature(uint8_t dev_index, int16_t *temperature);
+uint8_t lis3mdl_thermal_is_compensating(uint8_t dev_index);
+
+#endif /* LIS3MDL_LIS3MDL_THERMAL_H_ */
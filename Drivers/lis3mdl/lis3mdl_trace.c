@@ -0,0 +1,47 @@
+/*
+ * lis3mdl_trace.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#include <string.h>
+#include "lis3mdl_trace.h"
+
+#if LIS3MDL_TRACE_ENABLED
+
+LIS3MDL_Trace lis3mdl_trace = {
+	.version = LIS3MDL_TRACE_VERSION,
+	.size_log2 = LIS3MDL_TRACE_SIZE_LOG2
+};
+
+/**
+  * @brief Empties the ring.
+  */
+
+void lis3mdl_trace_reset(void){
+	memset(&lis3mdl_trace, 0, sizeof(lis3mdl_trace));
+	lis3mdl_trace.version = LIS3MDL_TRACE_VERSION;
+	lis3mdl_trace.size_log2 = LIS3MDL_TRACE_SIZE_LOG2;
+}
+
+/**
+  * @brief Gives access to the ring, e.g. to dump it.
+  *
+  * @retval Pointer to the trace, NULL if the trace is compiled out.
+  */
+
+const LIS3MDL_Trace *lis3mdl_trace_get(void){
+	return &lis3mdl_trace;
+}
+
+#else
+
+void lis3mdl_trace_reset(void){
+}
+
+const LIS3MDL_Trace *lis3mdl_trace_get(void){
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ * lis3mdl_trace.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef LIS3MDL_LIS3MDL_TRACE_H_
+#define LIS3MDL_LIS3MDL_TRACE_H_
+
+#include <stdint.h>
+#include "lis3mdl_poll_scheduler.h"
+
+/*
+ * Event trace of the driver, a ring of 4-byte records kept in RAM. It is meant to be
+ * dumped with the debugger (the whole LIS3MDL_Trace struct as binary) and decoded on a
+ * PC by Host/trace/lis3mdl_trace_decode.
+ *
+ * The trace costs RAM, so unlike the telemetry it is only compiled in when
+ * LIS3MDL_TRACE_ENABLED is set to 1. When disabled every hook below expands to nothing.
+ */
+
+#ifndef LIS3MDL_TRACE_ENABLED
+#define LIS3MDL_TRACE_ENABLED 0
+#endif
+
+#ifndef LIS3MDL_TRACE_SIZE_LOG2
+#define LIS3MDL_TRACE_SIZE_LOG2 7 // 128 records, 512 bytes
+#endif
+
+#define LIS3MDL_TRACE_SIZE (1U << LIS3MDL_TRACE_SIZE_LOG2)
+#define LIS3MDL_TRACE_VERSION 1
+
+/*
+ * Record layout, one uint32_t:
+ *   bits 31..12  time in microseconds from lis3mdl_get_tick_us, wraps every ~1.05 s
+ *   bits 11..8   LIS3MDL_Trace_Event
+ *   bits  7..4   device index, 0 for events not tied to a device
+ *   bits  3..0   argument, the new state or the transfer size
+ * TIM2 ticks are recorded too, which keeps consecutive records well within one wrap.
+ */
+
+#define LIS3MDL_TRACE_TIME_SHIFT 12
+#define LIS3MDL_TRACE_TIME_MASK 0xFFFFFU
+#define LIS3MDL_TRACE_EVENT_SHIFT 8
+#define LIS3MDL_TRACE_DEVICE_SHIFT 4
+#define LIS3MDL_TRACE_ARG_MASK 0x0FU
+
+/**
+ * @brief Kinds of events the trace records.
+ */
+
+typedef enum {
+	LIS3MDL_TRACE_PROCESS_STATE = 0x00, // Argument is the new LIS3MDL_Process_State_t
+	LIS3MDL_TRACE_RETRIEVAL_STATE = 0x01, // Argument is the new LIS3MDL_Data_Retrieval_State_t
+	LIS3MDL_TRACE_DMA_START = 0x02, // Argument is the transfer size in bytes
+	LIS3MDL_TRACE_DMA_COMPLETE = 0x03, // Recorded from the interrupt, belongs to the last DMA_START
+	LIS3MDL_TRACE_CS_LOW = 0x04,
+	LIS3MDL_TRACE_CS_HIGH = 0x05,
+	LIS3MDL_TRACE_TIMER_TICK = 0x06,
+	LIS3MDL_TRACE_MARK = 0x07 // Free for the application, argument is up to the caller
+} LIS3MDL_Trace_Event;
+
+/**
+ * @brief The ring and its write position, laid out to be dumped as is.
+ * `head` counts every record ever written, the oldest record still present is at
+ * `head - LIS3MDL_TRACE_SIZE` once the ring has wrapped.
+ */
+
+typedef struct __attribute__((packed)) {
+	uint8_t version;
+	uint8_t size_log2;
+	uint16_t reserved;
+	volatile uint32_t head;
+	uint32_t records[LIS3MDL_TRACE_SIZE];
+} LIS3MDL_Trace;
+
+void lis3mdl_trace_reset(void);
+const LIS3MDL_Trace *lis3mdl_trace_get(void);
+
+#if LIS3MDL_TRACE_ENABLED
+
+extern LIS3MDL_Trace lis3mdl_trace;
+
+/**
+  * @brief Appends a record to the ring, overwriting the oldest one when it is full.
+  * An interrupt recording in between the read and the write of `head` can make one of
+  * the two records get lost, but records are never torn.
+  *
+  * @param event_bits Event, device and argument bits of the record.
+  */
+
+static inline void lis3mdl_trace_record(uint32_t event_bits){
+	uint32_t index = lis3mdl_trace.head;
+	lis3mdl_trace.head = index + 1;
+	lis3mdl_trace.records[index & (LIS3MDL_TRACE_SIZE - 1)] = (lis3mdl_get_tick_us() << LIS3MDL_TRACE_TIME_SHIFT) | event_bits;
+}
+
+#define LIS3MDL_TRACE(event, dev_index, arg) lis3mdl_trace_record(((uint32_t)(event) << LIS3MDL_TRACE_EVENT_SHIFT) | (((uint32_t)(dev_index) & 0x0FU) << LIS3MDL_TRACE_DEVICE_SHIFT) | ((uint32_t)(arg) & LIS3MDL_TRACE_ARG_MASK))
+
+#else
+
+#define LIS3MDL_TRACE(event, dev_index, arg) do {} while(0)
+
+#endif
+
+#define LIS3MDL_TRACE_PROCESS_STATE(dev_index, state) LIS3MDL_TRACE(LIS3MDL_TRACE_PROCESS_STATE, dev_index, state)
+#define LIS3MDL_TRACE_RETRIEVAL_STATE(dev_index, state) LIS3MDL_TRACE(LIS3MDL_TRACE_RETRIEVAL_STATE, dev_index, state)
+#define LIS3MDL_TRACE_DMA_START(dev_index, size) LIS3MDL_TRACE(LIS3MDL_TRACE_DMA_START, dev_index, size)
+#define LIS3MDL_TRACE_DMA_COMPLETE() LIS3MDL_TRACE(LIS3MDL_TRACE_DMA_COMPLETE, 0, 0)
+#define LIS3MDL_TRACE_CS_LOW(dev_index) LIS3MDL_TRACE(LIS3MDL_TRACE_CS_LOW, dev_index, 0)
+#define LIS3MDL_TRACE_CS_HIGH(dev_index) LIS3MDL_TRACE(LIS3MDL_TRACE_CS_HIGH, dev_index, 0)
+#define LIS3MDL_TRACE_TIMER_TICK() LIS3MDL_TRACE(LIS3MDL_TRACE_TIMER_TICK, 0, 0)
+#define LIS3MDL_TRACE_MARK(arg) LIS3MDL_TRACE(LIS3MDL_TRACE_MARK, 0, arg)
+
+#endif /* LIS3MDL_LIS3MDL_TRACE_H_ */
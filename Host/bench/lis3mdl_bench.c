@@ -0,0 +1,424 @@
+/*
+ * lis3mdl_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Benchmark suite for the lis3mdl acquisition pipeline, run against the HAL mock and
+ * simulated sensors in virtual time, so the numbers only change when the driver does.
+ *
+ * Cases:
+ *   odr/<hz>       one sensor at every LIS3MDL_Output_Data_Rate
+ *   fast_odr/<hz>  one sensor at every fast ODR, selected through the XY operating mode
+ *   scaling/<n>    1 to 16 sensors sharing the bus at 80 Hz
+ *   slow_bus/<n>   the same at the 7.8 kbit/s the firmware runs SPI2 at
+ *
+ * Every case reports throughput, conversion to delivery latency, SPI transactions and
+ * bytes per sample, STATUS reads per sample, overruns and the time from configuration
+ * to the first sample of the first and of the last sensor (init time). Next to the init
+ * time of the last sensor, init_estimate gives what lis3mdl_init_planner expects for it.
+ *
+ * Results are CSV: case,metric,value,unit,better where better is higher, lower or info.
+ * With --compare every metric is checked against a previous result file and the exit
+ * status is 2 if any of them got worse by more than --threshold percent.
+ *
+ * Usage: lis3mdl_bench [--filter text] [--output file] [--compare baseline.csv] [--threshold 5]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "hal_mock.h"
+#include "lis3mdl.h"
+#include "lis3mdl_init_planner.h"
+
+#define BENCH_MAX_DEVICES 16
+#define BENCH_MAX_RESULTS 512
+#define BENCH_CONVERSION_HISTORY 16 // Conversions a sample can lag behind and still be matched
+#define BENCH_PCLK_HZ 2000000 // APB1 of the firmware, 32 MHz / 16
+#define BENCH_LOOP_COST_NS 10000 // Virtual CPU time one main loop iteration takes
+#define BENCH_MIN_RUN_NS 2000000000ULL
+#define BENCH_MIN_RUN_PERIODS 20
+
+typedef struct {
+	const char *name;
+	uint8_t num_of_devices;
+	LIS3MDL_Output_Data_Rate odr;
+	uint8_t fast_odr;
+	LIS3MDL_Operation_Mode xy_operation_mode;
+	uint32_t spi_prescaler;
+} Bench_Case;
+
+typedef struct {
+	char name[48];
+	char metric[32];
+	double value;
+	char unit[12];
+	char better[8];
+} Bench_Result;
+
+typedef struct {
+	uint64_t conversion_ns[BENCH_CONVERSION_HISTORY];
+	uint16_t sequence;
+	uint32_t delivered;
+	uint64_t first_sample_ns;
+} Bench_Sensor;
+
+static const Bench_Case cases[] = {
+	{ "odr/0.625", 1, LIS3MDL_ODR_0_625, 0, LIS3MDL_ULTRA_PERFORMACE, 2 },
+	{ "odr/1.25", 1, LIS3MDL_ODR_1_25, 0, LIS3MDL_ULTRA_PERFORMACE, 2 },
+	{ "odr/2.5", 1, LIS3MDL_ODR_2_5, 0, LIS3MDL_ULTRA_PERFORMACE, 2 },
+	{ "odr/5", 1, LIS3MDL_ODR_5, 0, LIS3MDL_ULTRA_PERFORMACE, 2 },
+	{ "odr/10", 1, LIS3MDL_ODR_10, 0, LIS3MDL_ULTRA_PERFORMACE, 2 },
+	{ "odr/20", 1, LIS3MDL_ODR_20, 0, LIS3MDL_ULTRA_PERFORMACE, 2 },
+	{ "odr/40", 1, LIS3MDL_ODR_40, 0, LIS3MDL_ULTRA_PERFORMACE, 2 },
+	{ "odr/80", 1, LIS3MDL_ODR_80, 0, LIS3MDL_ULTRA_PERFORMACE, 2 },
+	{ "fast_odr/155", 1, LIS3MDL_ODR_80, 1, LIS3MDL_ULTRA_PERFORMACE, 2 },
+	{ "fast_odr/300", 1, LIS3MDL_ODR_80, 1, LIS3MDL_HIGH_PERFORAMCE, 2 },
+	{ "fast_odr/560", 1, LIS3MDL_ODR_80, 1, LIS3MDL_MEDIUM_PERFORMANCE, 2 },
+	{ "fast_odr/1000", 1, LIS3MDL_ODR_80, 1, LIS3MDL_LOW_POWER, 2 },
+	{ "scaling/1", 1, LIS3MDL_ODR_80, 0, LIS3MDL_ULTRA_PERFORMACE, 2 },
+	{ "scaling/2", 2, LIS3MDL_ODR_80, 0, LIS3MDL_ULTRA_PERFORMACE, 2 },
+	{ "scaling/4", 4, LIS3MDL_ODR_80, 0, LIS3MDL_ULTRA_PERFORMACE, 2 },
+	{ "scaling/8", 8, LIS3MDL_ODR_80, 0, LIS3MDL_ULTRA_PERFORMACE, 2 },
+	{ "scaling/16", 16, LIS3MDL_ODR_80, 0, LIS3MDL_ULTRA_PERFORMACE, 2 },
+	{ "slow_bus/1", 1, LIS3MDL_ODR_80, 0, LIS3MDL_ULTRA_PERFORMACE, 256 },
+	{ "slow_bus/4", 4, LIS3MDL_ODR_80, 0, LIS3MDL_ULTRA_PERFORMACE, 256 },
+	{ "slow_bus/16", 16, LIS3MDL_ODR_80, 0, LIS3MDL_ULTRA_PERFORMACE, 256 },
+};
+
+static volatile uint8_t spi_cplt_flag = 0;
+static Bench_Sensor sensors[BENCH_MAX_DEVICES];
+static uint64_t latency_sum_ns, latency_max_ns;
+static uint32_t matched_samples, unmatched_samples;
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi){
+	spi_cplt_flag = 1;
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi){
+	spi_cplt_flag = 1;
+}
+
+/**
+  * @brief Tags every conversion with the sensor index and a sequence number so the
+  * delivered sample can be traced back to the moment it was converted.
+  */
+
+static void tag_conversion(LIS3MDL_Sim *sim, uint64_t at_ns){
+	Bench_Sensor *sensor = (Bench_Sensor *)sim->context;
+	sensor->sequence++;
+	sensor->conversion_ns[sensor->sequence % BENCH_CONVERSION_HISTORY] = at_ns;
+	sim->field[0] = (int16_t)(sensor - sensors);
+	sim->field[1] = (int16_t)sensor->sequence;
+}
+
+static void account_sample(uint8_t dev_index, const LIS3MDL_Magnetic_Data_t *sample, uint64_t start_ns){
+	Bench_Sensor *sensor = &sensors[dev_index];
+	uint16_t sequence = (uint16_t)sample->y;
+	if(sensor->delivered++ == 0)
+		sensor->first_sample_ns = hal_mock_get_time_ns() - start_ns;
+	if(sample->x != dev_index || (uint16_t)(sensor->sequence - sequence) >= BENCH_CONVERSION_HISTORY){
+		unmatched_samples++;
+		return;
+	}
+	uint64_t latency_ns = hal_mock_get_time_ns() - sensor->conversion_ns[sequence % BENCH_CONVERSION_HISTORY];
+	latency_sum_ns += latency_ns;
+	if(latency_ns > latency_max_ns)
+		latency_max_ns = latency_ns;
+	matched_samples++;
+}
+
+static void report(FILE *out, const Bench_Case *bench_case, const char *metric, double value, const char *unit, const char *better){
+	fprintf(out, "%s,%s,%.3f,%s,%s\n", bench_case->name, metric, value, unit, better);
+}
+
+/**
+  * @brief Runs one case from reset and writes its metrics as CSV lines.
+  *
+  * @param bench_case Case to run.
+  * @param out Stream the results go to.
+  *
+  * @retval 0 on success, 1 if the driver reported an error.
+  */
+
+static uint8_t run_case(const Bench_Case *bench_case, FILE *out){
+	SPI_HandleTypeDef hspi = { .Instance = SPI2, .Init.BaudRatePrescaler = hal_mock_spi_prescaler_from_divider(bench_case->spi_prescaler) };
+	LIS3MDL_Bus bus;
+	Hal_Mock_Spi_Timing timing = { .pclk_hz = BENCH_PCLK_HZ, .dma_setup_ns = 2000, .inter_byte_ns = 0, .irq_latency_ns = 3000 };
+	LIS3MDL_Sim sims[BENCH_MAX_DEVICES];
+	LIS3MDL_Device devices[BENCH_MAX_DEVICES];
+	LIS3MDL_Sample_Buffer samples;
+	uint8_t num_of_devices = bench_case->num_of_devices;
+
+	hal_mock_reset();
+	hal_mock_spi_setup(&hspi, &timing);
+	lis3mdl_bus_init(&bus, &hspi);
+
+	LIS3MDL_Init_Params init_params;
+	lis3mdl_set_default_params(&init_params);
+	init_params.output_data_rate = bench_case->odr;
+	init_params.fast_odr = bench_case->fast_odr;
+	init_params.xy_operation_mode = bench_case->xy_operation_mode;
+	LIS3MDL_Config_regs config_image;
+	lis3mdl_build_config_image(&config_image, init_params);
+
+	for(int i=0; i<num_of_devices; i++){
+		lis3mdl_sim_init(&sims[i]);
+		sims[i].field[2] = 1000;
+		sims[i].clock_error_ppm = (i & 1) ? 20000 : -15000;
+		sims[i].conversion_callback = tag_conversion;
+		sims[i].context = &sensors[i];
+		hal_mock_spi_attach(&hspi, GPIOB, (uint16_t)(GPIO_PIN_0 << i), &sims[i]);
+
+		lis3mdl_initialize_device_struct(&devices[i], &bus, GPIOB, (uint16_t)(GPIO_PIN_0 << i));
+		lis3mdl_setup_config_registers(&devices[i], &config_image);
+	}
+	lis3mdl_sample_buffer_init(&samples);
+
+	uint64_t start_ns = hal_mock_get_time_ns();
+	uint64_t period_ns = 0;
+	for(int i=0; i<num_of_devices; i++){
+		uint64_t device_period_ns = lis3mdl_sim_get_conversion_period_ns(&sims[i]);
+		if(device_period_ns > period_ns)
+			period_ns = device_period_ns;
+	}
+	uint64_t run_ns = period_ns * BENCH_MIN_RUN_PERIODS;
+	if(run_ns < BENCH_MIN_RUN_NS)
+		run_ns = BENCH_MIN_RUN_NS;
+
+	while(hal_mock_get_time_ns() < start_ns + run_ns){
+		if(lis3mdl_process(devices, num_of_devices, &spi_cplt_flag) == LIS3MDL_PROCESS_ERROR)
+			return 1;
+		for(int i=0; i<num_of_devices; i++){
+			if(lis3mdl_get_magnetic_data(devices, num_of_devices, i, &samples) != LIS3MDL_DATA_AVAILABLE)
+				continue;
+			account_sample((uint8_t)i, lis3mdl_sample_buffer_peek(&samples), start_ns);
+			lis3mdl_sample_buffer_release(&samples);
+		}
+		hal_mock_advance_ns(BENCH_LOOP_COST_NS);
+	}
+
+	uint64_t elapsed_ns = hal_mock_get_time_ns() - start_ns;
+	const Hal_Mock_Spi_Stats *bus_stats = hal_mock_spi_get_stats(&hspi);
+	uint32_t conversions = 0, overruns = 0, status_reads = 0, frames = 0, delivered = 0;
+	uint64_t first_ns = UINT64_MAX, all_ns = 0;
+	for(int i=0; i<num_of_devices; i++){
+		conversions += sims[i].stats.conversions;
+		overruns += sims[i].stats.overruns;
+		status_reads += sims[i].stats.status_reads;
+		frames += sims[i].stats.frames;
+		delivered += sensors[i].delivered;
+		uint64_t device_first_ns = sensors[i].delivered ? sensors[i].first_sample_ns : elapsed_ns;
+		if(device_first_ns < first_ns)
+			first_ns = device_first_ns;
+		if(device_first_ns > all_ns)
+			all_ns = device_first_ns;
+	}
+	double per_sample = delivered ? 1.0 / delivered : 0.0;
+
+	report(out, bench_case, "samples_per_s", delivered * 1e9 / elapsed_ns, "1/s", "higher");
+	report(out, bench_case, "delivery_ratio", conversions ? (double)delivered / conversions : 0.0, "ratio", "higher");
+	report(out, bench_case, "latency_avg", matched_samples ? latency_sum_ns / 1e3 / matched_samples : 0.0, "us", "lower");
+	report(out, bench_case, "latency_max", latency_max_ns / 1e3, "us", "lower");
+	report(out, bench_case, "transactions_per_sample", frames * per_sample, "count", "lower");
+	report(out, bench_case, "dma_transfers_per_sample", bus_stats->transfers * per_sample, "count", "lower");
+	report(out, bench_case, "bytes_per_sample", bus_stats->bytes * per_sample, "bytes", "lower");
+	report(out, bench_case, "status_reads_per_sample", status_reads * per_sample, "count", "lower");
+	report(out, bench_case, "bus_busy", 100.0 * bus_stats->busy_ns / elapsed_ns, "%", "lower");
+	report(out, bench_case, "overruns", overruns, "count", "lower");
+	report(out, bench_case, "unmatched_samples", unmatched_samples, "count", "lower");
+	report(out, bench_case, "init_first_sample", first_ns / 1e3, "us", "lower");
+	report(out, bench_case, "init_all_sampled", all_ns / 1e3, "us", "lower");
+	report(out, bench_case, "init_estimate", lis3mdl_init_planner_estimate_time_to_first_sample_us(num_of_devices,
+			BENCH_PCLK_HZ / bench_case->spi_prescaler, (timing.dma_setup_ns + timing.irq_latency_ns) / 1000, bench_case->odr), "us", "info");
+	return 0;
+}
+
+static int parse_result(char *line, Bench_Result *result){
+	char *fields[5];
+	int count = 0;
+	for(char *token = strtok(line, ",\r\n"); token && count < 5; token = strtok(NULL, ",\r\n"))
+		fields[count++] = token;
+	if(count != 5 || strcmp(fields[0], "case") == 0)
+		return 0;
+	snprintf(result->name, sizeof(result->name), "%s", fields[0]);
+	snprintf(result->metric, sizeof(result->metric), "%s", fields[1]);
+	result->value = strtod(fields[2], NULL);
+	snprintf(result->unit, sizeof(result->unit), "%s", fields[3]);
+	snprintf(result->better, sizeof(result->better), "%s", fields[4]);
+	return 1;
+}
+
+static int read_results(FILE *in, Bench_Result *results, int count){
+	char line[160];
+	while(count < BENCH_MAX_RESULTS && fgets(line, sizeof(line), in))
+		count += parse_result(line, &results[count]);
+	return count;
+}
+
+/**
+  * @brief Absolute change a metric may show before the relative threshold applies, so
+  * a single extra overrun or a few microseconds on a tiny value are not a regression.
+  */
+
+static double get_noise_floor(const char *unit){
+	if(strcmp(unit, "us") == 0)
+		return 50.0;
+	if(strcmp(unit, "count") == 0)
+		return 0.5;
+	if(strcmp(unit, "%") == 0)
+		return 0.5;
+	if(strcmp(unit, "ratio") == 0)
+		return 0.005;
+	return 0.0;
+}
+
+/**
+  * @brief Checks the results against a baseline and prints a verdict per metric.
+  *
+  * @retval Number of metrics that regressed or disappeared.
+  */
+
+static int compare_results(const Bench_Result *results, int count, const Bench_Result *baseline, int baseline_count, double threshold_pct){
+	int regressions = 0, improvements = 0;
+	for(int b=0; b<baseline_count; b++){
+		const Bench_Result *base = &baseline[b];
+		const Bench_Result *now = NULL;
+		for(int i=0; i<count && now == NULL; i++)
+			if(strcmp(results[i].name, base->name) == 0 && strcmp(results[i].metric, base->metric) == 0)
+				now = &results[i];
+		if(now == NULL){
+			printf("MISSING    %-16s %-26s\n", base->name, base->metric);
+			regressions++;
+			continue;
+		}
+
+		double allowed = base->value * threshold_pct / 100.0;
+		if(allowed < 0)
+			allowed = -allowed;
+		allowed += get_noise_floor(base->unit);
+		double change = now->value - base->value;
+		if(strcmp(base->better, "higher") == 0)
+			change = -change;
+		else if(strcmp(base->better, "lower") != 0)
+			continue;
+
+		const char *verdict = NULL;
+		if(change > allowed){
+			verdict = "REGRESSION";
+			regressions++;
+		}
+		else if(change < -allowed){
+			verdict = "improved";
+			improvements++;
+		}
+		if(verdict)
+			printf("%-10s %-16s %-26s %12.3f -> %12.3f %s\n", verdict, base->name, base->metric, base->value, now->value, base->unit);
+	}
+	printf("%d regressions, %d improvements against %d baseline metrics (threshold %.1f %%)\n", regressions, improvements, baseline_count, threshold_pct);
+	return regressions;
+}
+
+/**
+  * @brief Runs a case in a child process, the driver keeps scheduling state in statics
+  * that must start from scratch for every case.
+  *
+  * @retval Number of results after the ones of this case were appended, -1 on failure.
+  */
+
+static int run_case_isolated(const Bench_Case *bench_case, Bench_Result *results, int count){
+	int fds[2];
+	if(pipe(fds) < 0)
+		return -1;
+	pid_t pid = fork();
+	if(pid == 0){
+		close(fds[0]);
+		FILE *out = fdopen(fds[1], "w");
+		uint8_t failed = run_case(bench_case, out);
+		fclose(out);
+		_exit(failed);
+	}
+	close(fds[1]);
+	if(pid < 0){
+		close(fds[0]);
+		return -1;
+	}
+	FILE *in = fdopen(fds[0], "r");
+	count = read_results(in, results, count);
+	fclose(in);
+	int status;
+	if(waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		return -1;
+	return count;
+}
+
+int main(int argc, char **argv){
+	static Bench_Result results[BENCH_MAX_RESULTS], baseline[BENCH_MAX_RESULTS];
+	const char *filter = NULL, *output_path = NULL, *baseline_path = NULL;
+	double threshold_pct = 5.0;
+	int count = 0, baseline_count = 0;
+
+	for(int i=1; i+1<argc; i+=2){
+		if(strcmp(argv[i], "--filter") == 0)
+			filter = argv[i+1];
+		else if(strcmp(argv[i], "--output") == 0)
+			output_path = argv[i+1];
+		else if(strcmp(argv[i], "--compare") == 0)
+			baseline_path = argv[i+1];
+		else if(strcmp(argv[i], "--threshold") == 0)
+			threshold_pct = strtod(argv[i+1], NULL);
+		else{
+			fprintf(stderr, "usage: %s [--filter text] [--output file] [--compare baseline.csv] [--threshold pct]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if(baseline_path){
+		FILE *in = fopen(baseline_path, "r");
+		if(in == NULL){
+			perror(baseline_path);
+			return 1;
+		}
+		baseline_count = read_results(in, baseline, 0);
+		fclose(in);
+	}
+
+	for(size_t c=0; c<sizeof(cases)/sizeof(cases[0]); c++){
+		if(filter && strstr(cases[c].name, filter) == NULL)
+			continue;
+		fflush(NULL);
+		count = run_case_isolated(&cases[c], results, count);
+		if(count < 0){
+			fprintf(stderr, "case %s failed\n", cases[c].name);
+			return 1;
+		}
+	}
+
+	FILE *out = stdout;
+	if(output_path && (out = fopen(output_path, "w")) == NULL){
+		perror(output_path);
+		return 1;
+	}
+	if(baseline_path == NULL || output_path){
+		fprintf(out, "case,metric,value,unit,better\n");
+		for(int i=0; i<count; i++)
+			fprintf(out, "%s,%s,%.3f,%s,%s\n", results[i].name, results[i].metric, results[i].value, results[i].unit, results[i].better);
+	}
+	if(out != stdout)
+		fclose(out);
+
+	if(baseline_path == NULL)
+		return 0;
+	if(filter){
+		// Only the cases that ran can be compared
+		int kept = 0;
+		for(int b=0; b<baseline_count; b++)
+			if(strstr(baseline[b].name, filter))
+				baseline[kept++] = baseline[b];
+		baseline_count = kept;
+	}
+	return compare_results(results, count, baseline, baseline_count, threshold_pct) ? 2 : 0;
+}
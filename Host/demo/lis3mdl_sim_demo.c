@@ -0,0 +1,123 @@
+/*
+ * lis3mdl_sim_demo.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Runs the lis3mdl driver against simulated sensors in virtual time and prints what
+ * the sensors, the bus and the driver's telemetry saw.
+ *
+ * Usage: lis3mdl_sim_demo [devices] [odr code 0..7] [spi prescaler 2..256] [seconds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "hal_mock.h"
+#include "lis3mdl.h"
+#include "lis3mdl_telemetry.h"
+
+#define DEMO_MAX_DEVICES 8
+#define DEMO_PCLK_HZ 2000000 // APB1 of the firmware, 32 MHz / 16
+#define DEMO_LOOP_COST_NS 10000 // Virtual CPU time one main loop iteration takes
+
+static volatile uint8_t spi_cplt_flag = 0;
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi){
+	spi_cplt_flag = 1;
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi){
+	spi_cplt_flag = 1;
+}
+
+int main(int argc, char **argv){
+	int num_of_devices = argc > 1 ? atoi(argv[1]) : 1;
+	LIS3MDL_Output_Data_Rate odr = argc > 2 ? (LIS3MDL_Output_Data_Rate)atoi(argv[2]) : LIS3MDL_ODR_80;
+	uint32_t prescaler = argc > 3 ? (uint32_t)atoi(argv[3]) : 256;
+	uint32_t seconds = argc > 4 ? (uint32_t)atoi(argv[4]) : 2;
+	if(num_of_devices < 1 || num_of_devices > DEMO_MAX_DEVICES || odr > LIS3MDL_ODR_80){
+		fprintf(stderr, "usage: %s [devices 1..%d] [odr code 0..7] [spi prescaler 2..256] [seconds]\n", argv[0], DEMO_MAX_DEVICES);
+		return 1;
+	}
+
+	SPI_HandleTypeDef hspi = { .Instance = SPI2, .Init.BaudRatePrescaler = hal_mock_spi_prescaler_from_divider(prescaler) };
+	LIS3MDL_Bus bus;
+	Hal_Mock_Spi_Timing timing = { .pclk_hz = DEMO_PCLK_HZ, .dma_setup_ns = 2000, .inter_byte_ns = 0, .irq_latency_ns = 3000 };
+	LIS3MDL_Sim sims[DEMO_MAX_DEVICES];
+	LIS3MDL_Device devices[DEMO_MAX_DEVICES];
+	LIS3MDL_Sample_Buffer samples;
+	uint32_t delivered[DEMO_MAX_DEVICES] = {0};
+	uint32_t mismatches = 0;
+	uint64_t first_sample_ns = 0;
+
+	hal_mock_reset();
+	hal_mock_spi_setup(&hspi, &timing);
+	lis3mdl_bus_init(&bus, &hspi);
+
+	LIS3MDL_Init_Params init_params;
+	lis3mdl_set_default_params(&init_params);
+	init_params.output_data_rate = odr;
+	LIS3MDL_Config_regs config_image;
+	lis3mdl_build_config_image(&config_image, init_params);
+
+	for(int i=0; i<num_of_devices; i++){
+		lis3mdl_sim_init(&sims[i]);
+		sims[i].field[0] = (int16_t)(1000 + i);
+		sims[i].field[1] = (int16_t)(-2000 - i);
+		sims[i].field[2] = (int16_t)(3000 + i);
+		sims[i].clock_error_ppm = (i & 1) ? 20000 : -15000;
+		hal_mock_spi_attach(&hspi, GPIOB, (uint16_t)(GPIO_PIN_0 << i), &sims[i]);
+
+		lis3mdl_initialize_device_struct(&devices[i], &bus, GPIOB, (uint16_t)(GPIO_PIN_0 << i));
+		lis3mdl_setup_config_registers(&devices[i], &config_image);
+	}
+	lis3mdl_sample_buffer_init(&samples);
+	lis3mdl_telemetry_reset();
+
+	uint64_t start_ns = hal_mock_get_time_ns();
+	uint64_t end_ns = start_ns + seconds * 1000000000ULL;
+	while(hal_mock_get_time_ns() < end_ns){
+		if(lis3mdl_process(devices, num_of_devices, &spi_cplt_flag) == LIS3MDL_PROCESS_ERROR){
+			fprintf(stderr, "lis3mdl_process failed\n");
+			return 1;
+		}
+		for(int i=0; i<num_of_devices; i++){
+			if(lis3mdl_get_magnetic_data(devices, num_of_devices, i, &samples) != LIS3MDL_DATA_AVAILABLE)
+				continue;
+			const LIS3MDL_Magnetic_Data_t *sample = lis3mdl_sample_buffer_peek(&samples);
+			if(sample->x != sims[i].field[0] || sample->y != sims[i].field[1] || sample->z != sims[i].field[2])
+				mismatches++;
+			if(first_sample_ns == 0)
+				first_sample_ns = hal_mock_get_time_ns() - start_ns;
+			delivered[i]++;
+			lis3mdl_sample_buffer_release(&samples);
+		}
+		hal_mock_advance_ns(DEMO_LOOP_COST_NS);
+	}
+
+	const Hal_Mock_Spi_Stats *bus_stats = hal_mock_spi_get_stats(&hspi);
+	printf("devices %d, odr code %d, spi %lu bit/s, %lu s of virtual time\n", num_of_devices, odr, (unsigned long)hal_mock_spi_get_bitrate_hz(&hspi), (unsigned long)seconds);
+	printf("first sample after %.3f ms, %lu mismatching samples\n", first_sample_ns / 1e6, (unsigned long)mismatches);
+	printf("bus: %lu transfers, %lu bytes, %.1f %% busy\n", (unsigned long)bus_stats->transfers, (unsigned long)bus_stats->bytes, 100.0 * bus_stats->busy_ns / (hal_mock_get_time_ns() - start_ns));
+	printf("dev  conversions  delivered  overruns  status_reads  stale_reads  avg_latency_us\n");
+	for(int i=0; i<num_of_devices; i++){
+		LIS3MDL_Sim_Stats *stats = &sims[i].stats;
+		printf("%3d  %11lu  %9lu  %8lu  %12lu  %11lu  %14.1f\n", i, (unsigned long)stats->conversions, (unsigned long)delivered[i], (unsigned long)stats->overruns,
+				(unsigned long)stats->status_reads, (unsigned long)stats->stale_reads, stats->samples_read ? stats->latency_sum_ns / 1e3 / stats->samples_read : 0.0);
+		if(stats->accesses_while_booting)
+			printf("     %lu bytes lost to a REBOOT in progress\n", (unsigned long)stats->accesses_while_booting);
+	}
+
+	const LIS3MDL_Telemetry *telemetry = lis3mdl_telemetry_get();
+	printf("driver: %lu transfers, %lu transactions, %lu us DMA busy, longest idle gap %lu us\n", (unsigned long)telemetry->bus.transfers,
+			(unsigned long)telemetry->bus.transactions, (unsigned long)telemetry->bus.dma_busy_us, (unsigned long)telemetry->bus.max_idle_gap_us);
+	printf("dev  samples  status_polls  status_misses  retries  latency_min_us  latency_avg_us  latency_max_us\n");
+	for(int i=0; i<num_of_devices && i<LIS3MDL_TELEMETRY_MAX_DEVICES; i++){
+		const LIS3MDL_Device_Telemetry *device = &telemetry->devices[i];
+		printf("%3d  %7lu  %12lu  %13lu  %7lu  %14lu  %14lu  %14lu\n", i, (unsigned long)device->samples, (unsigned long)device->status_polls,
+				(unsigned long)device->status_misses, (unsigned long)device->retries, (unsigned long)device->latency_min_us,
+				(unsigned long)device->latency_avg_us, (unsigned long)device->latency_max_us);
+	}
+
+	return 0;
+}
@@ -0,0 +1,225 @@
+/*
+ * lis3mdl_goertzel_check.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Checks the fixed point Goertzel bank of Drivers/lis3mdl/lis3mdl_goertzel.c against a
+ * DFT computed in double precision, and measures what a sample costs.
+ *
+ * For every fast ODR rate and both mains frequencies, blocks of synthetic field samples
+ * go through the bank: a DC offset like the earth field, the fundamental with random
+ * amplitude and phase on every axis, harmonics of a fraction of it, sensor noise, all
+ * quantized to LSB. The mains frequency is off its nominal value by up to
+ * CHECK_MAINS_DEVIATION, so most tones fall between DFT bins. The reference evaluates the
+ * DFT of the same samples at the frequency of every bin, which is what an FFT gives for a
+ * bin on its grid, and the difference in amplitude and phase is the error of the fixed
+ * point arithmetic alone. Phase errors are only counted for tones of at least
+ * CHECK_MIN_PHASE_LSB. A last case runs full scale tones to catch overflows.
+ *
+ * The cost is the time the host takes per sample and per bin and axis update, which only
+ * compares implementations; every update takes two 32 bit multiplications on the target.
+ *
+ * Usage: lis3mdl_goertzel_check [--trials N] [--block-s S] [--harmonics mask]
+ *        [--max-amplitude-error LSB] [--max-phase-error deg]
+ *
+ * The exit status is 2 if any error exceeds its limit.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lis3mdl_goertzel.h"
+#include "lis3mdl_odr_controller.h"
+
+#define CHECK_MAINS_DEVIATION 0.01 // Relative, mains grids stay well within 1 %
+#define CHECK_NOISE_LSB 4.0 // RMS, about the LIS3MDL noise at the 4 gauss full scale
+#define CHECK_MIN_PHASE_LSB 8.0
+#define CHECK_COST_SAMPLES 2000000
+
+typedef struct {
+	double amplitude_error_max; // LSB
+	double amplitude_error_sum_sq;
+	double relative_error_max; // Of tones above CHECK_MIN_PHASE_LSB
+	double phase_error_max; // Degrees
+	double phase_error_sum_sq;
+	uint32_t amplitudes;
+	uint32_t phases;
+} Check_Errors;
+
+static uint64_t random_state = 0x9E3779B97F4A7C15ULL;
+
+static double random_uniform(void){
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 7;
+	random_state ^= random_state << 17;
+	return (random_state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double random_gaussian(void){
+	double u = random_uniform();
+	return sqrt(-2.0 * log(u > 0.0 ? u : 1e-300)) * cos(2.0 * M_PI * random_uniform());
+}
+
+static int16_t quantize(double value){
+	value = floor(value + 0.5);
+	return (int16_t)(value > 32767.0 ? 32767.0 : value < -32768.0 ? -32768.0 : value);
+}
+
+/**
+  * @brief Runs one block through the bank and compares every bin against the DFT.
+  *
+  * @param full_scale 1 for a single tone close to full scale per bin instead of mains.
+  */
+
+static void check_block(uint32_t period_us, uint16_t block_samples, double mains_hz, uint8_t harmonics, uint8_t full_scale, Check_Errors *errors){
+	static LIS3MDL_Magnetic_Data_t samples[LIS3MDL_GOERTZEL_MAX_BLOCK_SAMPLES];
+	double period_s = period_us * 1e-6;
+	double dc[3], amplitude[3], phase[3];
+	for(int i=0; i<3; i++){
+		dc[i] = full_scale ? 0.0 : (random_uniform() * 2.0 - 1.0) * 4000.0;
+		amplitude[i] = full_scale ? 30000.0 : exp(log(4.0) + random_uniform() * log(4000.0 / 4.0));
+		phase[i] = random_uniform() * 2.0 * M_PI;
+	}
+	for(int n=0; n<block_samples; n++){
+		int16_t *axes[3] = { &samples[n].x, &samples[n].y, &samples[n].z };
+		for(int i=0; i<3; i++){
+			double value = dc[i] + (full_scale ? 0.0 : CHECK_NOISE_LSB * random_gaussian());
+			for(int harmonic=1; harmonic<=8; harmonic++){
+				if(!(harmonics & (1 << (harmonic - 1))))
+					continue;
+				double share = full_scale ? 1.0 / __builtin_popcount(harmonics) : harmonic == 1 ? 1.0 : 0.3 / harmonic;
+				value += amplitude[i] * share * cos(2.0 * M_PI * mains_hz * harmonic * n * period_s + phase[i] * harmonic);
+			}
+			*axes[i] = quantize(value);
+		}
+	}
+
+	lis3mdl_goertzel_restart_block(0);
+	uint8_t done = 0;
+	for(int n=0; n<block_samples; n++)
+		done = lis3mdl_goertzel_add_sample(0, &samples[n], n * period_us);
+	LIS3MDL_Goertzel_Result result;
+	if(!done || lis3mdl_goertzel_take_result(0, &result) != 0){
+		fprintf(stderr, "no result after %u samples\n", block_samples);
+		exit(1);
+	}
+
+	for(int bin=0; bin<result.num_of_bins; bin++){
+		double omega = 2.0 * M_PI * result.bins[bin].frequency_mhz * 1e-3 * period_s;
+		for(int i=0; i<3; i++){
+			double real = 0.0, imaginary = 0.0;
+			for(int n=0; n<block_samples; n++){
+				const int16_t *axes = &samples[n].x;
+				real += axes[i] * cos(omega * n);
+				imaginary -= axes[i] * sin(omega * n);
+			}
+			double reference_amplitude = 2.0 * hypot(real, imaginary) / block_samples;
+			double amplitude_error = fabs(result.bins[bin].amplitude[i] / 16.0 - reference_amplitude);
+			errors->amplitude_error_sum_sq += amplitude_error * amplitude_error;
+			errors->amplitudes++;
+			if(amplitude_error > errors->amplitude_error_max)
+				errors->amplitude_error_max = amplitude_error;
+			if(reference_amplitude < CHECK_MIN_PHASE_LSB)
+				continue;
+
+			if(amplitude_error / reference_amplitude > errors->relative_error_max)
+				errors->relative_error_max = amplitude_error / reference_amplitude;
+			double phase_error = fabs(remainder(result.bins[bin].phase[i] * (360.0 / 65536.0) - atan2(imaginary, real) * (180.0 / M_PI), 360.0));
+			errors->phase_error_sum_sq += phase_error * phase_error;
+			errors->phases++;
+			if(phase_error > errors->phase_error_max)
+				errors->phase_error_max = phase_error;
+		}
+	}
+}
+
+/**
+  * @brief Time the host takes per sample with all bins of the current configuration.
+  */
+
+static double measure_cost_ns(uint16_t block_samples){
+	static LIS3MDL_Magnetic_Data_t samples[256];
+	for(int n=0; n<256; n++){
+		samples[n].x = quantize(1000.0 * cos(n * 0.3));
+		samples[n].y = quantize(-500.0 * sin(n * 0.3));
+		samples[n].z = quantize(200.0 * cos(n * 0.9));
+	}
+	LIS3MDL_Goertzel_Result result;
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(uint32_t n=0; n<CHECK_COST_SAMPLES; n++){
+		if(lis3mdl_goertzel_add_sample(0, &samples[n & 255], n))
+			lis3mdl_goertzel_take_result(0, &result);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / CHECK_COST_SAMPLES;
+}
+
+int main(int argc, char **argv){
+	uint32_t trials = 200;
+	double block_s = 0.2;
+	uint8_t harmonics = 0x0F;
+	double max_amplitude_error = 0.25;
+	double max_phase_error = 0.5;
+
+	for(int i=1; i+1<argc; i+=2){
+		if(strcmp(argv[i], "--trials") == 0)
+			trials = (uint32_t)strtoul(argv[i+1], NULL, 0);
+		else if(strcmp(argv[i], "--block-s") == 0)
+			block_s = atof(argv[i+1]);
+		else if(strcmp(argv[i], "--harmonics") == 0)
+			harmonics = (uint8_t)strtoul(argv[i+1], NULL, 0);
+		else if(strcmp(argv[i], "--max-amplitude-error") == 0)
+			max_amplitude_error = atof(argv[i+1]);
+		else if(strcmp(argv[i], "--max-phase-error") == 0)
+			max_phase_error = atof(argv[i+1]);
+		else{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	int failed = 0;
+	printf("%7s %9s %6s %7s %5s %7s %11s %11s %9s %11s %11s %11s %9s\n", "odr_hz", "period_us", "block", "mains", "bins", "tones",
+			"amp_max_lsb", "amp_rms_lsb", "amp_max%", "phase_max", "phase_rms", "ns/sample", "ns/update");
+	for(LIS3MDL_Odr_Level level=LIS3MDL_ODR_LEVEL_155; level<LIS3MDL_ODR_LEVEL_COUNT; level++){
+		uint32_t period_us = lis3mdl_odr_get_level_period_us(level);
+		double block_samples_exact = floor(block_s / (period_us * 1e-6) + 0.5);
+		uint16_t block_samples = (uint16_t)(block_samples_exact > LIS3MDL_GOERTZEL_MAX_BLOCK_SAMPLES ? LIS3MDL_GOERTZEL_MAX_BLOCK_SAMPLES : block_samples_exact);
+		for(int mains=0; mains<3; mains++){
+			uint8_t full_scale = mains == 2;
+			double nominal_hz = mains == 1 ? 60.0 : 50.0;
+			LIS3MDL_Goertzel_Params params = { (uint32_t)(nominal_hz * 1000.0), harmonics, block_samples };
+			if(lis3mdl_goertzel_init(&params) != 0 || lis3mdl_goertzel_set_sample_period_us(0, period_us, 1) != 0){
+				fprintf(stderr, "cannot configure %u harmonics over %u samples\n", (unsigned)harmonics, block_samples);
+				return 1;
+			}
+
+			Check_Errors errors;
+			memset(&errors, 0, sizeof(errors));
+			uint8_t num_of_bins = 0;
+			for(uint32_t trial=0; trial<trials; trial++){
+				double mains_hz = full_scale ? nominal_hz : nominal_hz * (1.0 + (random_uniform() * 2.0 - 1.0) * CHECK_MAINS_DEVIATION);
+				check_block(period_us, block_samples, mains_hz, harmonics, full_scale, &errors);
+				num_of_bins = (uint8_t)(errors.amplitudes / 3 / (trial + 1));
+			}
+			double cost_ns = measure_cost_ns(block_samples);
+
+			printf("%7.1f %9lu %6u %7s %5u %7lu %11.3f %11.3f %9.3f %11.3f %11.3f %11.1f %9.2f\n",
+					1e6 / period_us, (unsigned long)period_us, block_samples, full_scale ? "full" : mains ? "60 Hz" : "50 Hz", num_of_bins,
+					(unsigned long)errors.amplitudes, errors.amplitude_error_max, sqrt(errors.amplitude_error_sum_sq / errors.amplitudes),
+					100.0 * errors.relative_error_max, errors.phase_error_max, errors.phases ? sqrt(errors.phase_error_sum_sq / errors.phases) : 0.0,
+					cost_ns, num_of_bins ? cost_ns / (3 * num_of_bins) : 0.0);
+			if(errors.amplitude_error_max > max_amplitude_error || errors.phase_error_max > max_phase_error)
+				failed = 1;
+		}
+	}
+	lis3mdl_goertzel_init(NULL);
+
+	if(failed)
+		printf("errors above the limits of %.3f LSB and %.3f deg\n", max_amplitude_error, max_phase_error);
+	return failed ? 2 : 0;
+}
@@ -0,0 +1,46 @@
+/*
+ * clock_port_mock.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Virtual time stand-in for Core/Src/clock_port.c. A switch takes the configured time,
+ * mostly the oscillator startup on target, and the SPI and timers of the HAL mock follow
+ * the clocks of the new profile once the governor rescales their prescalers.
+ */
+
+#include "hal_mock.h"
+#include "clock_port_mock.h"
+#include "clock_governor.h"
+
+static uint32_t switch_ns[CLOCK_PROFILE_COUNT];
+static Clock_Profile active_profile = CLOCK_PROFILE_HIGH;
+
+/**
+  * @brief Sets the time a switch into either profile takes.
+  *
+  * @param to_low_ns Switch to the MSI, which is already running.
+  * @param to_high_ns Switch to the PLL, HSI16 startup and PLL lock.
+  */
+
+void clock_port_mock_setup(uint32_t to_low_ns, uint32_t to_high_ns){
+	switch_ns[CLOCK_PROFILE_LOW] = to_low_ns;
+	switch_ns[CLOCK_PROFILE_HIGH] = to_high_ns;
+	active_profile = CLOCK_PROFILE_HIGH;
+}
+
+uint32_t clock_port_switch(Clock_Profile profile){
+	hal_mock_advance_ns(switch_ns[profile]);
+	active_profile = profile;
+	return switch_ns[profile] / 1000;
+}
+
+void clock_port_set_spi_prescaler(SPI_HandleTypeDef *hspi, uint32_t prescaler){
+	hspi->Init.BaudRatePrescaler = prescaler;
+	hal_mock_spi_set_pclk_hz(hspi, clock_governor_get_profile_info(active_profile)->pclk1_hz);
+}
+
+void clock_port_set_timer_prescaler(TIM_HandleTypeDef *htim, uint32_t prescaler){
+	htim->Init.Prescaler = prescaler;
+	hal_mock_tim_setup(htim, clock_governor_get_profile_info(active_profile)->apb1_timer_hz);
+}
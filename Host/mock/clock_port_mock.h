@@ -0,0 +1,15 @@
+/*
+ * clock_port_mock.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef MOCK_CLOCK_PORT_MOCK_H_
+#define MOCK_CLOCK_PORT_MOCK_H_
+
+#include <stdint.h>
+
+void clock_port_mock_setup(uint32_t to_low_ns, uint32_t to_high_ns);
+
+#endif /* MOCK_CLOCK_PORT_MOCK_H_ */
@@ -0,0 +1,595 @@
+/*
+ * hal_mock.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Virtual time implementation of the HAL subset declared in the host main.h.
+ *
+ * Nothing happens on its own, the program owning the simulation moves time forward with
+ * hal_mock_advance_to_ns / hal_mock_advance_ns and every event that falls into the
+ * advanced interval (DMA completions, timer updates) fires at its exact moment, callbacks
+ * included. The result only depends on the inputs, so runs are reproducible.
+ *
+ * CS is observed through BSRR. The mock looks at every port a slave is attached to each
+ * time the application can have touched it (on every HAL_SPI_*_DMA call and before time
+ * moves) and clears BSRR afterwards. Two writes in between are seen as one, so a reset
+ * bit always means a new frame: the slave is (re)selected and every other slave on the
+ * bus is released, which is what a driver that never selects two devices at once means.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "hal_mock.h"
+
+typedef struct {
+	GPIO_TypeDef *cs_gpio_port;
+	uint16_t cs_pin;
+	LIS3MDL_Sim *sim;
+} Hal_Mock_Spi_Slave;
+
+typedef struct {
+	SPI_HandleTypeDef *hspi;
+	Hal_Mock_Spi_Timing timing;
+	Hal_Mock_Spi_Slave slaves[HAL_MOCK_MAX_SLAVES];
+	uint8_t num_of_slaves;
+	int selected; // Index of the selected slave, -1 if none
+
+	uint8_t busy;
+	uint8_t receiving;
+	uint8_t *data;
+	const uint8_t *duplex_tx; // Set for a full-duplex transfer of the single interrupt engine, `data` receives
+	GPIO_TypeDef *release_cs_gpio_port; // CS the engine releases on completion, NULL for HAL transfers
+	uint16_t release_cs_pin;
+	uint8_t irq_entries; // Interrupt entries the completion of the transfer in flight takes
+	uint16_t size;
+	uint64_t start_ns;
+	uint64_t done_ns;
+
+	Hal_Mock_Spi_Stats stats;
+} Hal_Mock_Spi_Bus;
+
+typedef struct {
+	TIM_HandleTypeDef *htim;
+	uint64_t period_ns;
+	uint64_t next_ns; // 0 while stopped
+} Hal_Mock_Timer;
+
+typedef struct {
+	IWDG_HandleTypeDef *hiwdg;
+	uint32_t lsi_hz;
+	uint64_t timeout_ns;
+	uint64_t window_open_ns; // Refreshes before this much time has passed are too early
+	uint64_t last_refresh_ns;
+	Hal_Mock_Iwdg_Stats stats;
+} Hal_Mock_Iwdg;
+
+GPIO_TypeDef hal_mock_gpioa;
+GPIO_TypeDef hal_mock_gpiob;
+SPI_TypeDef hal_mock_spi1 = { .id = 1 };
+SPI_TypeDef hal_mock_spi2 = { .id = 2 };
+TIM_TypeDef hal_mock_tim2 = { .id = 2 };
+TIM_TypeDef hal_mock_tim6 = { .id = 6 };
+
+static uint64_t now_ns = 0;
+static Hal_Mock_Spi_Bus buses[HAL_MOCK_MAX_SPI_BUSES];
+static uint8_t num_of_buses = 0;
+static Hal_Mock_Timer timers[HAL_MOCK_MAX_TIMERS];
+static uint8_t num_of_timers = 0;
+static Hal_Mock_Iwdg iwdg;
+static uint32_t irq_count = 0;
+
+static Hal_Mock_Timer *find_timer(const TIM_HandleTypeDef *htim){
+	for(int i=0; i<num_of_timers; i++){
+		if(timers[i].htim == htim)
+			return &timers[i];
+	}
+	return NULL;
+}
+
+static Hal_Mock_Spi_Bus *find_bus(const SPI_HandleTypeDef *hspi){
+	for(int i=0; i<num_of_buses; i++){
+		if(buses[i].hspi == hspi)
+			return &buses[i];
+	}
+	return NULL;
+}
+
+/**
+  * @brief Consumes BSRR of every port with an attached slave and applies the CS edges.
+  */
+
+static void sync_chip_selects(void){
+	uint32_t bsrr[HAL_MOCK_MAX_SPI_BUSES][HAL_MOCK_MAX_SLAVES];
+
+	// Latching first, several slaves can share a port
+	for(int b=0; b<num_of_buses; b++){
+		for(int s=0; s<buses[b].num_of_slaves; s++)
+			bsrr[b][s] = buses[b].slaves[s].cs_gpio_port->BSRR;
+	}
+	for(int b=0; b<num_of_buses; b++){
+		for(int s=0; s<buses[b].num_of_slaves; s++){
+			GPIO_TypeDef *port = buses[b].slaves[s].cs_gpio_port;
+			port->ODR = (port->ODR | (port->BSRR & 0xFFFF)) & ~(port->BSRR >> 16);
+			port->BSRR = 0;
+		}
+	}
+
+	for(int b=0; b<num_of_buses; b++){
+		Hal_Mock_Spi_Bus *bus = &buses[b];
+		for(int s=0; s<bus->num_of_slaves; s++){
+			if((bsrr[b][s] & bus->slaves[s].cs_pin) && bus->selected == s){
+				lis3mdl_sim_deselect(bus->slaves[s].sim, now_ns);
+				bus->selected = -1;
+			}
+		}
+		for(int s=0; s<bus->num_of_slaves; s++){
+			if(bsrr[b][s] & ((uint32_t)bus->slaves[s].cs_pin << 16)){
+				if(bus->selected >= 0 && bus->selected != s)
+					lis3mdl_sim_deselect(bus->slaves[bus->selected].sim, now_ns);
+				lis3mdl_sim_select(bus->slaves[s].sim, now_ns);
+				bus->selected = s;
+			}
+		}
+	}
+}
+
+/**
+  * @brief Shifts the bytes of the finished transfer through the selected slave and signals completion.
+  *
+  * @param bus Pointer to the bus whose transfer is done.
+  */
+
+static void complete_transfer(Hal_Mock_Spi_Bus *bus){
+	uint64_t byte_ns = 8000000000ULL / hal_mock_spi_get_bitrate_hz(bus->hspi);
+	uint64_t byte_done_ns = bus->start_ns + bus->timing.dma_setup_ns;
+
+	for(int i=0; i<bus->size; i++){
+		byte_done_ns += byte_ns;
+		uint8_t mosi = bus->duplex_tx ? bus->duplex_tx[i] : bus->receiving ? 0x00 : bus->data[i];
+		uint8_t miso = 0xFF;
+		if(bus->selected >= 0)
+			miso = lis3mdl_sim_transfer_byte(bus->slaves[bus->selected].sim, byte_done_ns, mosi);
+		if(bus->receiving)
+			bus->data[i] = miso;
+		byte_done_ns += bus->timing.inter_byte_ns;
+	}
+
+	bus->busy = 0;
+	bus->stats.busy_ns += bus->done_ns - bus->start_ns;
+	bus->stats.irqs += bus->irq_entries;
+	irq_count += bus->irq_entries;
+	if(bus->release_cs_gpio_port){
+		bus->release_cs_gpio_port->BSRR = bus->release_cs_pin;
+		sync_chip_selects();
+	}
+	if(bus->receiving)
+		HAL_SPI_RxCpltCallback(bus->hspi);
+	else
+		HAL_SPI_TxCpltCallback(bus->hspi);
+}
+
+/**
+  * @brief Starts a transfer of the HAL DMA functions, or of the single interrupt engine when
+  * `duplex_tx` is given.
+  *
+  * The HAL takes several interrupt entries per transfer. HAL_SPI_Transmit_DMA enables the
+  * half and full transfer interrupts of the TX channel, HAL_SPI_Receive_DMA runs a
+  * full-duplex transfer with the half and full transfer interrupts of the RX channel and the
+  * full transfer interrupt of the TX channel. A single byte reaches half and full at once.
+  * The engine only takes the full transfer interrupt of the RX channel.
+  */
+
+static HAL_StatusTypeDef start_transfer(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint8_t receiving, const uint8_t *duplex_tx){
+	Hal_Mock_Spi_Bus *bus = find_bus(hspi);
+	if(bus == NULL || pData == NULL || Size == 0)
+		return HAL_ERROR;
+	if(bus->busy)
+		return HAL_BUSY;
+	if(bus->timing.call_ns) // The CPU gets here only after the driver code before the call ran
+		hal_mock_advance_ns(bus->timing.call_ns);
+
+	sync_chip_selects();
+
+	uint64_t byte_ns = 8000000000ULL / hal_mock_spi_get_bitrate_hz(hspi);
+	bus->busy = 1;
+	bus->receiving = receiving;
+	bus->data = pData;
+	bus->duplex_tx = duplex_tx;
+	bus->release_cs_gpio_port = NULL;
+	bus->size = Size;
+	if(duplex_tx)
+		bus->irq_entries = 1;
+	else
+		bus->irq_entries = (Size > 1 ? 2 : 1) + (receiving ? 1 : 0);
+	bus->start_ns = now_ns;
+	bus->done_ns = now_ns + bus->timing.dma_setup_ns + Size * byte_ns + (Size - 1) * (uint64_t)bus->timing.inter_byte_ns + bus->timing.irq_latency_ns;
+	bus->stats.transfers++;
+	bus->stats.bytes += Size;
+	return HAL_OK;
+}
+
+/**
+  * @brief Starts a full-duplex transfer the way the single interrupt engine of lis3mdl_bus.h
+  * does, one interrupt entry that releases CS before the completion callback.
+  *
+  * @param hspi Handle registered with `hal_mock_spi_setup`.
+  * @param tx Bytes shifted out.
+  * @param rx Receives the bytes shifted in, may be the same buffer as `tx`.
+  * @param size Bytes of the transfer.
+  * @param cs_gpio_port Port of the CS pin released on completion.
+  * @param cs_pin CS pin mask.
+  *
+  * @retval HAL_OK once started, HAL_BUSY while a transfer is in flight, HAL_ERROR on invalid input.
+  */
+
+HAL_StatusTypeDef hal_mock_spi_start_duplex(SPI_HandleTypeDef *hspi, const uint8_t *tx, uint8_t *rx, uint16_t size, GPIO_TypeDef *cs_gpio_port, uint16_t cs_pin){
+	if(tx == NULL || cs_gpio_port == NULL)
+		return HAL_ERROR;
+	HAL_StatusTypeDef status = start_transfer(hspi, rx, size, 1, tx);
+	if(status == HAL_OK){
+		Hal_Mock_Spi_Bus *bus = find_bus(hspi);
+		bus->release_cs_gpio_port = cs_gpio_port;
+		bus->release_cs_pin = cs_pin;
+	}
+	return status;
+}
+
+/**
+  * @brief Forgets every bus and slave. Time keeps running so the driver's own timestamps stay monotonic.
+  */
+
+void hal_mock_reset(void){
+	memset(buses, 0, sizeof(buses));
+	num_of_buses = 0;
+	memset(timers, 0, sizeof(timers));
+	num_of_timers = 0;
+	memset(&iwdg, 0, sizeof(iwdg));
+	irq_count = 0;
+	memset(&hal_mock_gpioa, 0, sizeof(hal_mock_gpioa));
+	memset(&hal_mock_gpiob, 0, sizeof(hal_mock_gpiob));
+}
+
+uint64_t hal_mock_get_time_ns(void){
+	return now_ns;
+}
+
+/**
+  * @brief Tells when the next event is due.
+  *
+  * @retval Time of the earliest pending event, UINT64_MAX if nothing is pending.
+  */
+
+uint64_t hal_mock_get_next_event_ns(void){
+	uint64_t next_ns = UINT64_MAX;
+	for(int i=0; i<num_of_buses; i++){
+		if(buses[i].busy && buses[i].done_ns < next_ns)
+			next_ns = buses[i].done_ns;
+	}
+	for(int i=0; i<num_of_timers; i++){
+		if(timers[i].next_ns && timers[i].next_ns < next_ns)
+			next_ns = timers[i].next_ns;
+	}
+	return next_ns;
+}
+
+/**
+  * @brief Moves virtual time forward, firing every event due up to `time_ns` in order.
+  *
+  * @param time_ns Time to move to, earlier values are ignored.
+  */
+
+void hal_mock_advance_to_ns(uint64_t time_ns){
+	sync_chip_selects();
+
+	uint64_t next_ns;
+	while((next_ns = hal_mock_get_next_event_ns()) <= time_ns){
+		if(next_ns > now_ns)
+			now_ns = next_ns;
+		for(int i=0; i<num_of_buses; i++){
+			if(buses[i].busy && buses[i].done_ns == next_ns)
+				complete_transfer(&buses[i]);
+		}
+		for(int i=0; i<num_of_timers; i++){
+			if(timers[i].next_ns && timers[i].next_ns == next_ns){
+				timers[i].next_ns += timers[i].period_ns;
+				irq_count++;
+				HAL_TIM_PeriodElapsedCallback(timers[i].htim);
+			}
+		}
+	}
+
+	if(time_ns > now_ns)
+		now_ns = time_ns;
+}
+
+void hal_mock_advance_ns(uint64_t duration_ns){
+	hal_mock_advance_to_ns(now_ns + duration_ns);
+}
+
+/**
+  * @brief Number of interrupt entries (DMA and timer updates) raised so far.
+  */
+
+uint32_t hal_mock_get_irq_count(void){
+	return irq_count;
+}
+
+/**
+  * @brief Registers an SPI handle with the mock.
+  *
+  * @param hspi Handle the application passes to HAL_SPI_*_DMA.
+  * @param timing Bus and DMA timing.
+  *
+  * @retval 0 on success, 1 if the handle is NULL or too many buses are registered.
+  */
+
+uint8_t hal_mock_spi_setup(SPI_HandleTypeDef *hspi, const Hal_Mock_Spi_Timing *timing){
+	if(hspi == NULL || timing == NULL)
+		return 1;
+
+	Hal_Mock_Spi_Bus *bus = find_bus(hspi);
+	if(bus == NULL){
+		if(num_of_buses >= HAL_MOCK_MAX_SPI_BUSES)
+			return 1;
+		bus = &buses[num_of_buses++];
+		memset(bus, 0, sizeof(*bus));
+		bus->hspi = hspi;
+		bus->selected = -1;
+	}
+	bus->timing = *timing;
+	return 0;
+}
+
+/**
+  * @brief Connects a simulated sensor to a registered bus behind the given CS pin.
+  *
+  * @param hspi Handle registered with `hal_mock_spi_setup`.
+  * @param cs_gpio_port Port of the CS pin.
+  * @param cs_pin CS pin mask.
+  * @param sim Sensor model answering while the pin is low.
+  *
+  * @retval 0 on success, 1 on invalid input or if the bus is full.
+  */
+
+uint8_t hal_mock_spi_attach(SPI_HandleTypeDef *hspi, GPIO_TypeDef *cs_gpio_port, uint16_t cs_pin, LIS3MDL_Sim *sim){
+	Hal_Mock_Spi_Bus *bus = find_bus(hspi);
+	if(bus == NULL || cs_gpio_port == NULL || sim == NULL || bus->num_of_slaves >= HAL_MOCK_MAX_SLAVES)
+		return 1;
+
+	Hal_Mock_Spi_Slave *slave = &bus->slaves[bus->num_of_slaves++];
+	slave->cs_gpio_port = cs_gpio_port;
+	slave->cs_pin = cs_pin;
+	slave->sim = sim;
+	cs_gpio_port->ODR |= cs_pin; // CS idles high
+	return 0;
+}
+
+/**
+  * @brief Changes the clock of a registered bus, e.g. after a switch of the APB clock.
+  *
+  * @retval 0 on success, 1 if the handle is unknown or the clock is 0.
+  */
+
+uint8_t hal_mock_spi_set_pclk_hz(const SPI_HandleTypeDef *hspi, uint32_t pclk_hz){
+	Hal_Mock_Spi_Bus *bus = find_bus(hspi);
+	if(bus == NULL || pclk_hz == 0)
+		return 1;
+	bus->timing.pclk_hz = pclk_hz;
+	return 0;
+}
+
+/**
+  * @brief Changes the CPU time charged to every transfer start of a registered bus, e.g.
+  * after a switch of the core clock.
+  *
+  * @retval 0 on success, 1 if the handle is unknown.
+  */
+
+uint8_t hal_mock_spi_set_call_ns(const SPI_HandleTypeDef *hspi, uint32_t call_ns){
+	Hal_Mock_Spi_Bus *bus = find_bus(hspi);
+	if(bus == NULL)
+		return 1;
+	bus->timing.call_ns = call_ns;
+	return 0;
+}
+
+/**
+  * @brief Computes the SCK frequency from the bus clock and the handle's prescaler.
+  *
+  * @param hspi Handle registered with `hal_mock_spi_setup`.
+  *
+  * @retval SCK frequency in Hz, 1 if the handle is unknown so callers never divide by zero.
+  */
+
+uint32_t hal_mock_spi_get_bitrate_hz(const SPI_HandleTypeDef *hspi){
+	Hal_Mock_Spi_Bus *bus = find_bus(hspi);
+	if(bus == NULL || bus->timing.pclk_hz == 0)
+		return 1;
+	uint32_t bitrate_hz = bus->timing.pclk_hz / (2U << (hspi->Init.BaudRatePrescaler >> 3));
+	return bitrate_hz ? bitrate_hz : 1;
+}
+
+/**
+  * @brief Converts a clock divider into the matching SPI_BAUDRATEPRESCALER_x value.
+  *
+  * @param divider 2, 4, ... 256, other values are rounded down to a power of two.
+  *
+  * @retval Value for Init.BaudRatePrescaler.
+  */
+
+uint32_t hal_mock_spi_prescaler_from_divider(uint32_t divider){
+	uint32_t value = SPI_BAUDRATEPRESCALER_2;
+	while(divider > 2 && value < SPI_BAUDRATEPRESCALER_256){
+		divider >>= 1;
+		value += SPI_BAUDRATEPRESCALER_4;
+	}
+	return value;
+}
+
+const Hal_Mock_Spi_Stats *hal_mock_spi_get_stats(const SPI_HandleTypeDef *hspi){
+	Hal_Mock_Spi_Bus *bus = find_bus(hspi);
+	return bus ? &bus->stats : NULL;
+}
+
+/**
+  * @brief Tells whether a DMA transfer is in flight on any bus.
+  */
+
+uint8_t hal_mock_spi_any_busy(void){
+	for(int i=0; i<num_of_buses; i++){
+		if(buses[i].busy)
+			return 1;
+	}
+	return 0;
+}
+
+/**
+  * @brief Registers a timer handle. The update period follows from its Init.Prescaler and Init.Period.
+  * Calling it again for a running timer applies a new clock or prescaler from the next period on.
+  *
+  * @param htim Handle the application passes to HAL_TIM_Base_Start_IT.
+  * @param clock_hz Timer kernel clock.
+  *
+  * @retval 0 on success, 1 on invalid input or if too many timers are registered.
+  */
+
+uint8_t hal_mock_tim_setup(TIM_HandleTypeDef *htim, uint32_t clock_hz){
+	if(htim == NULL || clock_hz == 0)
+		return 1;
+
+	Hal_Mock_Timer *timer = find_timer(htim);
+	if(timer == NULL){
+		if(num_of_timers >= HAL_MOCK_MAX_TIMERS)
+			return 1;
+		timer = &timers[num_of_timers++];
+		timer->htim = htim;
+		timer->next_ns = 0;
+	}
+	timer->period_ns = (uint64_t)(htim->Init.Prescaler + 1) * (htim->Init.Period + 1) * 1000000000ULL / clock_hz;
+	return 0;
+}
+
+/**
+  * @brief Derives the timeout and the window from the Init of the watchdog handle.
+  */
+
+static void configure_iwdg(void){
+	const IWDG_InitTypeDef *init = &iwdg.hiwdg->Init;
+	uint64_t tick_ns = (uint64_t)(4U << init->Prescaler) * 1000000000ULL;
+	iwdg.timeout_ns = tick_ns * (init->Reload + 1) / iwdg.lsi_hz;
+	iwdg.window_open_ns = init->Window < init->Reload ? tick_ns * (init->Reload - init->Window) / iwdg.lsi_hz : 0;
+	iwdg.last_refresh_ns = now_ns;
+}
+
+/**
+  * @brief Registers the watchdog handle. The timeout follows from its Init.Prescaler and
+  * Init.Reload, the window from Init.Window.
+  *
+  * @param hiwdg Handle the application passes to HAL_IWDG_Refresh.
+  * @param lsi_hz Clock of the watchdog counter.
+  *
+  * @retval 0 on success, 1 on invalid input.
+  */
+
+uint8_t hal_mock_iwdg_setup(IWDG_HandleTypeDef *hiwdg, uint32_t lsi_hz){
+	if(hiwdg == NULL || lsi_hz == 0)
+		return 1;
+
+	memset(&iwdg, 0, sizeof(iwdg));
+	iwdg.hiwdg = hiwdg;
+	iwdg.lsi_hz = lsi_hz;
+	configure_iwdg();
+	return 0;
+}
+
+const Hal_Mock_Iwdg_Stats *hal_mock_iwdg_get_stats(void){
+	return &iwdg.stats;
+}
+
+/*
+ * HAL
+ */
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size){
+	return start_transfer(hspi, pData, Size, 0, NULL);
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size){
+	return start_transfer(hspi, pData, Size, 1, NULL);
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim){
+	Hal_Mock_Timer *timer = find_timer(htim);
+	if(timer == NULL || timer->period_ns == 0)
+		return HAL_ERROR;
+	timer->next_ns = now_ns + timer->period_ns;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim){
+	Hal_Mock_Timer *timer = find_timer(htim);
+	if(timer == NULL)
+		return HAL_ERROR;
+	timer->next_ns = 0;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_IWDG_Init(IWDG_HandleTypeDef *hiwdg){
+	if(hiwdg != iwdg.hiwdg || hiwdg->Init.Prescaler > IWDG_PRESCALER_256 || hiwdg->Init.Reload > 0xFFF || hiwdg->Init.Window > 0xFFF)
+		return HAL_ERROR;
+
+	uint64_t gap_ns = now_ns - iwdg.last_refresh_ns; // The new setting only applies from the reload on
+	if(gap_ns > iwdg.timeout_ns)
+		iwdg.stats.expiries++;
+	configure_iwdg();
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_IWDG_Refresh(IWDG_HandleTypeDef *hiwdg){
+	if(hiwdg != iwdg.hiwdg)
+		return HAL_ERROR;
+
+	uint64_t gap_ns = now_ns - iwdg.last_refresh_ns;
+	if(gap_ns > iwdg.stats.max_gap_ns)
+		iwdg.stats.max_gap_ns = gap_ns;
+	if(gap_ns > iwdg.timeout_ns)
+		iwdg.stats.expiries++;
+	else if(gap_ns < iwdg.window_open_ns)
+		iwdg.stats.early_refreshes++;
+	iwdg.stats.refreshes++;
+	iwdg.last_refresh_ns = now_ns;
+	return HAL_OK;
+}
+
+__weak void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim){
+}
+
+__weak void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi){
+}
+
+__weak void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi){
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState){
+	if(PinState != GPIO_PIN_RESET)
+		GPIOx->ODR |= GPIO_Pin;
+	else
+		GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+}
+
+uint32_t HAL_GetTick(void){
+	return (uint32_t)(now_ns / 1000000);
+}
+
+__weak void Error_Handler(void){
+	abort();
+}
+
+/**
+  * @brief Overrides the driver's HAL tick based default with the full resolution of virtual time.
+  */
+
+uint32_t lis3mdl_get_tick_us(void){
+	return (uint32_t)(now_ns / 1000);
+}
@@ -0,0 +1,74 @@
+/*
+ * hal_mock.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef MOCK_HAL_MOCK_H_
+#define MOCK_HAL_MOCK_H_
+
+#include <stdint.h>
+#include "main.h"
+#include "lis3mdl_sim.h"
+
+#define HAL_MOCK_MAX_SPI_BUSES 2
+#define HAL_MOCK_MAX_SLAVES 16 // Per bus
+#define HAL_MOCK_MAX_TIMERS 4
+
+/**
+ * @brief Timing of an SPI bus and the DMA channels serving it.
+ */
+
+typedef struct {
+	uint32_t pclk_hz; // Clock divided by Init.BaudRatePrescaler
+	uint32_t dma_setup_ns; // From the HAL_SPI_*_DMA call to the first SCK edge
+	uint32_t inter_byte_ns; // Idle time the peripheral leaves between two bytes
+	uint32_t irq_latency_ns; // From the last SCK edge to the completion callback
+	uint32_t call_ns; // CPU time the code leading to a HAL_SPI_*_DMA call takes, virtual time advances by it within the call
+} Hal_Mock_Spi_Timing;
+
+/**
+ * @brief Counters the mock keeps per SPI bus.
+ */
+
+typedef struct {
+	uint32_t transfers;
+	uint32_t bytes;
+	uint64_t busy_ns; // Time with a DMA transfer in flight
+	uint32_t irqs; // DMA interrupt entries the transfers took
+} Hal_Mock_Spi_Stats;
+
+/**
+ * @brief Counters the mock keeps about the independent watchdog.
+ */
+
+typedef struct {
+	uint32_t refreshes;
+	uint64_t max_gap_ns; // Longest time between two refreshes
+	uint32_t expiries; // Gaps longer than the configured timeout, each one a reset on target
+	uint32_t early_refreshes; // Refreshes before the window opened, also a reset on target
+} Hal_Mock_Iwdg_Stats;
+
+void hal_mock_reset(void);
+uint64_t hal_mock_get_time_ns(void);
+uint64_t hal_mock_get_next_event_ns(void);
+void hal_mock_advance_to_ns(uint64_t time_ns);
+void hal_mock_advance_ns(uint64_t duration_ns);
+uint32_t hal_mock_get_irq_count(void);
+
+uint8_t hal_mock_spi_setup(SPI_HandleTypeDef *hspi, const Hal_Mock_Spi_Timing *timing);
+uint8_t hal_mock_spi_attach(SPI_HandleTypeDef *hspi, GPIO_TypeDef *cs_gpio_port, uint16_t cs_pin, LIS3MDL_Sim *sim);
+uint8_t hal_mock_spi_set_pclk_hz(const SPI_HandleTypeDef *hspi, uint32_t pclk_hz);
+uint8_t hal_mock_spi_set_call_ns(const SPI_HandleTypeDef *hspi, uint32_t call_ns);
+uint32_t hal_mock_spi_get_bitrate_hz(const SPI_HandleTypeDef *hspi);
+uint32_t hal_mock_spi_prescaler_from_divider(uint32_t divider);
+const Hal_Mock_Spi_Stats *hal_mock_spi_get_stats(const SPI_HandleTypeDef *hspi);
+uint8_t hal_mock_spi_any_busy(void);
+HAL_StatusTypeDef hal_mock_spi_start_duplex(SPI_HandleTypeDef *hspi, const uint8_t *tx, uint8_t *rx, uint16_t size, GPIO_TypeDef *cs_gpio_port, uint16_t cs_pin);
+
+uint8_t hal_mock_tim_setup(TIM_HandleTypeDef *htim, uint32_t clock_hz);
+uint8_t hal_mock_iwdg_setup(IWDG_HandleTypeDef *hiwdg, uint32_t lsi_hz);
+const Hal_Mock_Iwdg_Stats *hal_mock_iwdg_get_stats(void);
+
+#endif /* MOCK_HAL_MOCK_H_ */
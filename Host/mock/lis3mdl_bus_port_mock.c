@@ -0,0 +1,23 @@
+/*
+ * lis3mdl_bus_port_mock.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Single interrupt engine of lis3mdl_bus.h on the HAL mock, a full-duplex transfer that
+ * takes one interrupt entry and releases CS before the completion callback.
+ */
+
+#include "lis3mdl_bus.h"
+#include "hal_mock.h"
+
+void lis3mdl_bus_port_init(LIS3MDL_Bus *bus){
+}
+
+HAL_StatusTypeDef lis3mdl_bus_port_transfer(LIS3MDL_Bus *bus, GPIO_TypeDef *cs_gpio_port, uint16_t cs_pin, uint8_t size){
+	if(bus == NULL || size > LIS3MDL_BUS_BUFFER_SIZE)
+		return HAL_ERROR;
+	bus->cs_gpio_port = cs_gpio_port;
+	bus->cs_pin = cs_pin;
+	return hal_mock_spi_start_duplex(bus->hspi, bus->tx, bus->rx_frame, size, cs_gpio_port, cs_pin);
+}
@@ -0,0 +1,179 @@
+/*
+ * main.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Host stand-in for Core/Inc/main.h. Provides the part of the STM32L0 HAL the
+ * lis3mdl driver and the application use, backed by the virtual time mock in hal_mock.c.
+ */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef __weak
+#define __weak __attribute__((weak))
+#endif
+
+typedef enum {
+	HAL_OK = 0x00U,
+	HAL_ERROR = 0x01U,
+	HAL_BUSY = 0x02U,
+	HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+/*
+ * GPIO
+ */
+
+typedef struct {
+	volatile uint32_t ODR;
+	volatile uint32_t BSRR; // Consumed by the mock every time it looks at the bus, see hal_mock.c
+} GPIO_TypeDef;
+
+typedef enum {
+	GPIO_PIN_RESET = 0U,
+	GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_PIN_0 (0x0001U)
+#define GPIO_PIN_1 (0x0002U)
+#define GPIO_PIN_2 (0x0004U)
+#define GPIO_PIN_3 (0x0008U)
+#define GPIO_PIN_4 (0x0010U)
+#define GPIO_PIN_5 (0x0020U)
+#define GPIO_PIN_6 (0x0040U)
+#define GPIO_PIN_7 (0x0080U)
+#define GPIO_PIN_8 (0x0100U)
+#define GPIO_PIN_9 (0x0200U)
+#define GPIO_PIN_10 (0x0400U)
+#define GPIO_PIN_11 (0x0800U)
+#define GPIO_PIN_12 (0x1000U)
+#define GPIO_PIN_13 (0x2000U)
+#define GPIO_PIN_14 (0x4000U)
+#define GPIO_PIN_15 (0x8000U)
+
+extern GPIO_TypeDef hal_mock_gpioa;
+extern GPIO_TypeDef hal_mock_gpiob;
+#define GPIOA (&hal_mock_gpioa)
+#define GPIOB (&hal_mock_gpiob)
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+
+/*
+ * SPI
+ */
+
+typedef struct {
+	uint32_t id;
+} SPI_TypeDef;
+
+extern SPI_TypeDef hal_mock_spi1;
+extern SPI_TypeDef hal_mock_spi2;
+#define SPI1 (&hal_mock_spi1)
+#define SPI2 (&hal_mock_spi2)
+
+#define SPI_BAUDRATEPRESCALER_2 (0x00000000U)
+#define SPI_BAUDRATEPRESCALER_4 (0x00000008U)
+#define SPI_BAUDRATEPRESCALER_8 (0x00000010U)
+#define SPI_BAUDRATEPRESCALER_16 (0x00000018U)
+#define SPI_BAUDRATEPRESCALER_32 (0x00000020U)
+#define SPI_BAUDRATEPRESCALER_64 (0x00000028U)
+#define SPI_BAUDRATEPRESCALER_128 (0x00000030U)
+#define SPI_BAUDRATEPRESCALER_256 (0x00000038U)
+
+typedef struct {
+	uint32_t BaudRatePrescaler;
+} SPI_InitTypeDef;
+
+typedef struct __SPI_HandleTypeDef {
+	SPI_TypeDef *Instance;
+	SPI_InitTypeDef Init;
+} SPI_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size);
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi);
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi);
+
+/*
+ * TIM
+ */
+
+typedef struct {
+	uint32_t id;
+} TIM_TypeDef;
+
+extern TIM_TypeDef hal_mock_tim2;
+extern TIM_TypeDef hal_mock_tim6;
+#define TIM2 (&hal_mock_tim2)
+#define TIM6 (&hal_mock_tim6)
+
+typedef struct {
+	uint32_t Prescaler;
+	uint32_t Period;
+} TIM_Base_InitTypeDef;
+
+typedef struct {
+	TIM_TypeDef *Instance;
+	TIM_Base_InitTypeDef Init;
+} TIM_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+
+/*
+ * IWDG
+ */
+
+#define IWDG_PRESCALER_4 0x00000000U
+#define IWDG_PRESCALER_8 0x00000001U
+#define IWDG_PRESCALER_16 0x00000002U
+#define IWDG_PRESCALER_32 0x00000003U
+#define IWDG_PRESCALER_64 0x00000004U
+#define IWDG_PRESCALER_128 0x00000005U
+#define IWDG_PRESCALER_256 0x00000006U
+#define IWDG_WINDOW_DISABLE 0x00000FFFU
+
+typedef struct {
+	uint32_t Prescaler;
+	uint32_t Reload;
+	uint32_t Window;
+} IWDG_InitTypeDef;
+
+typedef struct {
+	IWDG_InitTypeDef Init;
+} IWDG_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_IWDG_Init(IWDG_HandleTypeDef *hiwdg);
+HAL_StatusTypeDef HAL_IWDG_Refresh(IWDG_HandleTypeDef *hiwdg);
+
+/*
+ * Misc
+ */
+
+#define LSI_VALUE 37000U // Nominal LSI, same as stm32l0xx_hal_conf.h
+
+uint32_t HAL_GetTick(void);
+void Error_Handler(void);
+
+/*
+ * Board pins, same as Core/Inc/main.h
+ */
+
+#define SS2_Pin GPIO_PIN_12
+#define SS2_GPIO_Port GPIOB
+#define LED1_Pin GPIO_PIN_8
+#define LED1_GPIO_Port GPIOA
+#define LED2_Pin GPIO_PIN_9
+#define LED2_GPIO_Port GPIOA
+#define LED3_Pin GPIO_PIN_10
+#define LED3_GPIO_Port GPIOA
+#define LED4_Pin GPIO_PIN_11
+#define LED4_GPIO_Port GPIOA
+
+#endif /* __MAIN_H */
@@ -0,0 +1,73 @@
+/*
+ * power_port_mock.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Virtual time stand-in for Core/Src/power_port.c.
+ *
+ * Sleep lasts until the next mock event, the requested wakeup or the next SysTick
+ * interrupt, which on target ends a Sleep every millisecond. STOP lasts as long as asked, followed by the time the
+ * target needs to bring the PLL back, during which the core is already running. Unlike
+ * on target, timer events keep firing during STOP.
+ */
+
+#include <string.h>
+#include "hal_mock.h"
+#include "power_port_mock.h"
+#include "power_manager.h"
+
+#define POWER_PORT_MOCK_SYSTICK_NS 1000000ULL
+
+static uint32_t stop_wakeup_ns = 0;
+static Power_Port_Mock_Stats stats;
+
+/**
+  * @brief Resets the counters and sets the cost of leaving STOP.
+  *
+  * @param wakeup_ns Time from the end of a STOP until the loop runs at full speed.
+  */
+
+void power_port_mock_setup(uint32_t wakeup_ns){
+	stop_wakeup_ns = wakeup_ns;
+	memset(&stats, 0, sizeof(stats));
+}
+
+const Power_Port_Mock_Stats *power_port_mock_get_stats(void){
+	return &stats;
+}
+
+void power_port_init(void){
+}
+
+uint32_t power_port_sleep(uint32_t max_us, volatile uint8_t *wake_flag){
+	if(wake_flag && *wake_flag)
+		return 0;
+
+	uint64_t start_ns = hal_mock_get_time_ns();
+	uint64_t wake_ns = (start_ns / POWER_PORT_MOCK_SYSTICK_NS + 1) * POWER_PORT_MOCK_SYSTICK_NS;
+	uint64_t event_ns = hal_mock_get_next_event_ns();
+	if(event_ns < wake_ns)
+		wake_ns = event_ns;
+	if(max_us != POWER_IDLE_UNTIL_IRQ && start_ns + (uint64_t)max_us * 1000 < wake_ns)
+		wake_ns = start_ns + (uint64_t)max_us * 1000;
+	hal_mock_advance_to_ns(wake_ns);
+	stats.sleeps++;
+	return (uint32_t)((hal_mock_get_time_ns() - start_ns) / 1000);
+}
+
+uint32_t power_port_stop(uint32_t duration_us){
+	if(hal_mock_spi_any_busy())
+		stats.stops_during_transfer++;
+	hal_mock_advance_ns((uint64_t)duration_us * 1000);
+	stats.stops++;
+	hal_mock_advance_ns(stop_wakeup_ns);
+	return duration_us;
+}
+
+void power_port_wakeup_irq(void){
+}
+
+uint32_t power_port_get_time_us(void){
+	return (uint32_t)(hal_mock_get_time_ns() / 1000);
+}
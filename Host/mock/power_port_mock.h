@@ -0,0 +1,26 @@
+/*
+ * power_port_mock.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef MOCK_POWER_PORT_MOCK_H_
+#define MOCK_POWER_PORT_MOCK_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Counters the mock keeps about the low power states.
+ */
+
+typedef struct {
+	uint32_t sleeps;
+	uint32_t stops;
+	uint32_t stops_during_transfer; // STOP entered with a DMA transfer in flight, which would stall it on target
+} Power_Port_Mock_Stats;
+
+void power_port_mock_setup(uint32_t stop_wakeup_ns);
+const Power_Port_Mock_Stats *power_port_mock_get_stats(void);
+
+#endif /* MOCK_POWER_PORT_MOCK_H_ */
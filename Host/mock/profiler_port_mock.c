@@ -0,0 +1,23 @@
+/*
+ * profiler_port_mock.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Counter of Core/Src/profiler.c on the host. Virtual time stands still while the loop
+ * runs, so the zones are timed with the monotonic clock of the PC instead, build with
+ * PROFILER_TICK_NS=1 and PROFILER_COUNTER_MASK=0xFFFFFFFF. The same zones then come out
+ * in the same statistics as on target, only for a faster core.
+ */
+
+#include <time.h>
+#include "profiler.h"
+
+void profiler_port_init(TIM_HandleTypeDef *htim){
+}
+
+uint32_t profiler_port_now(void){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)((uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec);
+}
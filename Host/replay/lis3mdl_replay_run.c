@@ -0,0 +1,159 @@
+/*
+ * lis3mdl_replay_run.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Replays a capture (see Drivers/lis3mdl/lis3mdl_capture.h) through simulated sensors and
+ * the lis3mdl driver in virtual time, so a recording of real field data can be run again
+ * and again, faster than real time and with the same result every time.
+ *
+ * Every device of the capture gets its own simulated sensor configured like the captured
+ * one. The report tells how many of the replayed samples the driver delivered unchanged,
+ * how many were lost and the conversion to delivery latency. With --output the delivered
+ * stream is written as a capture again, to diff against the input or a previous run.
+ *
+ * Virtual time already runs as fast as the PC allows, so the original timing is the one
+ * to use for regression runs. --speedup compresses the timeline, the sensor then converts
+ * faster than its configured ODR, which shows how the poll schedule copes with a sensor
+ * whose clock is far off rather than how it performs normally.
+ *
+ * Usage: lis3mdl_replay_run capture.bin [--speedup N] [--prescaler 2..256] [--output delivered.bin]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hal_mock.h"
+#include "lis3mdl.h"
+#include "lis3mdl_replay.h"
+
+#define REPLAY_PCLK_HZ 2000000 // APB1 of the firmware, 32 MHz / 16
+#define REPLAY_LOOP_COST_NS 10000 // Virtual CPU time one main loop iteration takes
+#define REPLAY_TAIL_NS 100000000ULL // Time kept running after the last record so it can be delivered
+
+static volatile uint8_t spi_cplt_flag = 0;
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi){
+	spi_cplt_flag = 1;
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi){
+	spi_cplt_flag = 1;
+}
+
+int main(int argc, char **argv){
+	const char *input_path = NULL, *output_path = NULL;
+	uint32_t speedup = 1, prescaler = 2;
+	int usage_error = 0;
+	for(int i=1; i<argc; i++){
+		if(strcmp(argv[i], "--speedup") == 0 && i + 1 < argc)
+			speedup = (uint32_t)strtoul(argv[++i], NULL, 0);
+		else if(strcmp(argv[i], "--prescaler") == 0 && i + 1 < argc)
+			prescaler = (uint32_t)strtoul(argv[++i], NULL, 0);
+		else if(strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+			output_path = argv[++i];
+		else if(input_path == NULL && argv[i][0] != '-')
+			input_path = argv[i];
+		else
+			usage_error = 1;
+	}
+	if(input_path == NULL || usage_error || speedup == 0){
+		fprintf(stderr, "usage: %s capture.bin [--speedup N] [--prescaler 2..256] [--output delivered.bin]\n", argv[0]);
+		return 1;
+	}
+
+	static LIS3MDL_Capture capture, delivered;
+	if(lis3mdl_capture_load(&capture, input_path) != 0 || capture.num_of_records == 0){
+		fprintf(stderr, "%s is not a version %d lis3mdl capture with records\n", input_path, LIS3MDL_CAPTURE_VERSION);
+		return 1;
+	}
+	uint8_t num_of_devices = capture.header.num_of_devices;
+
+	SPI_HandleTypeDef hspi = { .Instance = SPI2, .Init.BaudRatePrescaler = hal_mock_spi_prescaler_from_divider(prescaler) };
+	LIS3MDL_Bus bus;
+	Hal_Mock_Spi_Timing timing = { .pclk_hz = REPLAY_PCLK_HZ, .dma_setup_ns = 2000, .inter_byte_ns = 0, .irq_latency_ns = 3000 };
+	static LIS3MDL_Sim sims[LIS3MDL_CAPTURE_MAX_DEVICES];
+	static LIS3MDL_Replay replays[LIS3MDL_CAPTURE_MAX_DEVICES];
+	static LIS3MDL_Device devices[LIS3MDL_CAPTURE_MAX_DEVICES];
+	LIS3MDL_Sample_Buffer samples;
+	uint32_t delivered_per_device[LIS3MDL_CAPTURE_MAX_DEVICES] = {0};
+	uint32_t unmatched = 0;
+	uint64_t latency_sum_ns = 0, latency_max_ns = 0;
+
+	hal_mock_reset();
+	hal_mock_spi_setup(&hspi, &timing);
+	lis3mdl_bus_init(&bus, &hspi);
+	for(int i=0; i<num_of_devices; i++){
+		lis3mdl_sim_init(&sims[i]);
+		lis3mdl_replay_attach(&replays[i], &sims[i], &capture, (uint8_t)i, speedup);
+		hal_mock_spi_attach(&hspi, GPIOB, (uint16_t)(GPIO_PIN_0 << i), &sims[i]);
+
+		lis3mdl_initialize_device_struct(&devices[i], &bus, GPIOB, (uint16_t)(GPIO_PIN_0 << i));
+		lis3mdl_setup_config_registers(&devices[i], &capture.header.config[i]);
+	}
+	lis3mdl_sample_buffer_init(&samples);
+
+	delivered.header = capture.header;
+	delivered.records = malloc(capture.num_of_records * sizeof(LIS3MDL_Capture_Record));
+
+	uint64_t start_ns = hal_mock_get_time_ns();
+	uint64_t done_ns = 0;
+	while(done_ns == 0 || hal_mock_get_time_ns() < done_ns){
+		if(lis3mdl_process(devices, num_of_devices, &spi_cplt_flag) == LIS3MDL_PROCESS_ERROR){
+			fprintf(stderr, "lis3mdl_process failed\n");
+			return 1;
+		}
+		for(int i=0; i<num_of_devices; i++){
+			if(lis3mdl_get_magnetic_data(devices, num_of_devices, i, &samples) != LIS3MDL_DATA_AVAILABLE)
+				continue;
+			const LIS3MDL_Magnetic_Data_t *sample = lis3mdl_sample_buffer_peek(&samples);
+			int16_t axes[3] = { sample->x, sample->y, sample->z };
+			uint64_t converted_ns;
+			if(lis3mdl_replay_match(&replays[i], axes, &converted_ns) != NULL){
+				uint64_t latency_ns = hal_mock_get_time_ns() - converted_ns;
+				latency_sum_ns += latency_ns;
+				if(latency_ns > latency_max_ns)
+					latency_max_ns = latency_ns;
+			}
+			else
+				unmatched++;
+			if(delivered.records && delivered.num_of_records < capture.num_of_records)
+				lis3mdl_capture_make_record(&delivered.records[delivered.num_of_records++], &devices[i], (uint8_t)i, sample);
+			delivered_per_device[i]++;
+			lis3mdl_sample_buffer_release(&samples);
+		}
+		hal_mock_advance_ns(REPLAY_LOOP_COST_NS);
+
+		if(done_ns == 0){
+			uint8_t finished = 1;
+			for(int i=0; i<num_of_devices; i++)
+				finished &= lis3mdl_replay_finished(&replays[i]);
+			if(finished)
+				done_ns = hal_mock_get_time_ns() + REPLAY_TAIL_NS;
+		}
+	}
+
+	uint64_t elapsed_ns = hal_mock_get_time_ns() - start_ns;
+	uint32_t total_delivered = 0;
+	printf("%s: %lu records of %u devices, replayed %lux in %.3f s of virtual time\n", input_path, (unsigned long)capture.num_of_records,
+			num_of_devices, (unsigned long)speedup, elapsed_ns / 1e9);
+	printf("dev  replayed  skipped  delivered  lost  overruns  captured_overruns\n");
+	for(int i=0; i<num_of_devices; i++){
+		uint32_t lost = replays[i].replayed > delivered_per_device[i] ? replays[i].replayed - delivered_per_device[i] : 0;
+		printf("%3d  %8lu  %7lu  %9lu  %4lu  %8lu  %17lu\n", i, (unsigned long)replays[i].replayed, (unsigned long)replays[i].skipped,
+				(unsigned long)delivered_per_device[i], (unsigned long)lost, (unsigned long)sims[i].stats.overruns, (unsigned long)replays[i].captured_overruns);
+		total_delivered += delivered_per_device[i];
+	}
+	uint32_t matched = total_delivered - unmatched;
+	printf("%lu samples delivered unchanged, %lu altered, latency avg %.1f us max %.1f us\n", (unsigned long)matched, (unsigned long)unmatched,
+			matched ? latency_sum_ns / 1e3 / matched : 0.0, latency_max_ns / 1e3);
+
+	if(output_path && lis3mdl_capture_save(&delivered, output_path) != 0){
+		perror(output_path);
+		return 1;
+	}
+	lis3mdl_capture_free(&delivered);
+	lis3mdl_capture_free(&capture);
+	return unmatched ? 2 : 0;
+}
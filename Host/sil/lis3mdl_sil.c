@@ -0,0 +1,625 @@
+/*
+ * lis3mdl_sil.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Software-in-the-loop runner for the firmware super-loop (Core/Src/app.c).
+ *
+ * The loop runs unmodified against the HAL mock and simulated sensors. Every call of
+ * app_run_once costs virtual CPU time according to the cost model below and every
+ * interrupt steals `isr_ns` from the loop, so the results describe the timing of the
+ * real loop on the target, not the speed of the PC. Each point of the sweep runs in
+ * its own process because the driver keeps its scheduling state in statics.
+ *
+ * Usage: lis3mdl_sil [--prescalers 2,16,256] [--sensors 1,4] [--odrs 4,7] [--seconds 5]
+ *        [--dma-ns N] [--isr-ns N] [--dma-irq-ns N] [--engine-irq-ns N] [--loop-ns N] [--sleep 0|1] [--governor 0|1]
+ *        [--event-s S] [--self-test-s S] [--temperature 0|1] [--stats N] [--stats-hops K]
+ *        [--trace prefix] [--capture prefix] [--profile prefix]
+ *
+ * lis3mdl_sil_single_irq is the same runner built with the single interrupt SPI engine of
+ * lis3mdl_bus.h, its DMA interrupts cost `engine_irq_ns` instead of `dma_irq_ns` each.
+ *
+ * The loop calls app_idle after every iteration like main.c does, --sleep 0 keeps it
+ * spinning instead to compare against. --governor 0 keeps the core on the PLL, otherwise
+ * the clock governor may run it from the MSI, which the cost model accounts for by
+ * scaling every CPU cost with the core clock.
+ *
+ * The field is static unless --event-s is given, then something passes by the sensors
+ * every S seconds: Z rises by SIL_EVENT_LSB and falls back within SIL_EVENT_NS, which the
+ * adaptive ODR controller should answer with the active rate. --self-test-s S requests the
+ * self-test of one sensor after the other every S seconds, the simulated sensors add a
+ * self-test field within the datasheet limits while ST is set. The samples taken meanwhile
+ * carry it and would count as unmatched if they reached the consumer. --temperature 1 enables
+ * the temperature sensor, every LIS3MDL_THERMAL_DECIMATION samples of a sensor are then read
+ * in one burst together with the temperature. --stats N summarizes every N samples of a sensor
+ * over the last K hops of --stats-hops (default 1), see lis3mdl_stats.h. Every summary is
+ * checked against the tagged conversions it covers, a mismatch is reported.
+ *
+ * With --trace the driver's event trace of every point is dumped to
+ * <prefix>_<prescaler>_<sensors>_<odr code>.bin for Host/trace/lis3mdl_trace_decode.
+ * With --capture every sample the loop acquires is recorded to <prefix>_..._<odr code>.cap
+ * in the format Host/replay/lis3mdl_replay_run replays. With --profile the zone statistics
+ * of Core/Inc/profiler.h go to <prefix>_..._<odr code>.csv, one row per zone with the count,
+ * minimum, mean and maximum in ns and the histogram bins. They time the PC running the
+ * loop, not the target, the interrupt zones stay empty as the mock has no interrupt handlers.
+ *
+ * Columns: samples/s consumed by the loop, conversions/s of all sensors together,
+ * sensor overruns, CPU time spent outside idle polling, SPI busy time, conversion to
+ * consumption latency, longest gap between watchdog refreshes (us) and the number of
+ * refreshes that came too late or too early and would have reset the target, loop iterations per second, share of the time
+ * spent in Sleep and STOP and the energy per consumed sample at 3 V estimated from the
+ * power state residency (see Core/Inc/power_manager.h for the currents). Then the share
+ * of the time on the MSI, the clock switches, their average latency and the average
+ * supply current while on the MSI and on the PLL. Last the number of times the adaptive ODR
+ * controller raised the rate, the samples per second and sensor consumed during events
+ * and the deadline misses of the loop's tasks. Then the DMA interrupt entries and the CPU
+ * cycles, loop and interrupts together, per consumed sample. Then the background
+ * transactions per second the bus arbiter fitted in between the samples. Then the passed
+ * self-tests and those that failed or were aborted. Then the summaries per second and how
+ * many times fewer bytes they take than the samples consumed. Last the longest run of any
+ * task the scheduler measured, transfer starts and consumed samples advance the virtual time
+ * within the tasks for it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "hal_mock.h"
+#include "app.h"
+#include "lis3mdl_telemetry.h"
+#include "lis3mdl_trace.h"
+#include "power_manager.h"
+#include "power_port_mock.h"
+#include "clock_port_mock.h"
+#include "clock_governor.h"
+#include "watchdog.h"
+#include "task_scheduler.h"
+#include "profiler.h"
+#include "lis3mdl_self_test.h"
+
+#define SIL_MAX_POINTS 16 // Per swept parameter
+#define SIL_CONVERSION_HISTORY 16 // Conversions a sample can lag behind and still be matched
+#define SIL_SUPPLY_MV 3000
+#define SIL_EVENT_NS 1000000000ULL // Duration of a field event, rising for half of it
+#define SIL_EVENT_LSB 600 // Peak change of Z during an event
+
+/**
+ * @brief Virtual CPU cost of the loop on the 32 MHz Cortex-M0+.
+ * Estimates from the instruction count of the paths involved, tune them against a
+ * measurement on hardware.
+ */
+
+typedef struct {
+	uint32_t sysclk_hz;
+	uint32_t pclk1_hz;
+	uint32_t lsi_hz;
+	uint32_t dma_setup_ns; // HAL_SPI_*_DMA call to the first SCK edge
+	uint32_t irq_latency_ns; // Last SCK edge to the completion callback
+	uint32_t isr_ns; // Time a timer interrupt takes away from the loop
+	uint32_t dma_irq_ns; // Same for every DMA interrupt entry of the HAL path
+	uint32_t engine_irq_ns; // Same for the one interrupt of the single interrupt engine
+	uint32_t loop_ns; // An iteration with nothing to do
+	uint32_t loop_per_device_ns; // Extra per device for the data retrieval state machine
+	uint32_t transfer_start_ns; // Extra per DMA transfer started in an iteration
+	uint32_t sample_ns; // Extra per sample decoded, committed and consumed
+	uint32_t stop_wakeup_ns; // Leaving STOP until the PLL runs again
+	uint32_t clock_to_low_ns; // Switching to the MSI
+	uint32_t clock_to_high_ns; // HSI16 startup and PLL lock
+} Sil_Cost_Model;
+
+typedef struct {
+	uint32_t spi_prescaler;
+	uint8_t num_of_sensors;
+	LIS3MDL_Output_Data_Rate odr;
+	uint32_t seconds;
+	uint8_t sleep;
+	uint8_t governor;
+	uint32_t event_s; // Time between field events, 0 for a static field
+	uint32_t self_test_s; // Time between self-test requests, 0 for none
+	uint8_t temperature; // Enables the temperature sensor
+	uint16_t stats_hop; // Samples per summary, 0 for none
+	uint8_t stats_hops;
+} Sil_Point;
+
+typedef struct {
+	uint64_t conversion_ns[SIL_CONVERSION_HISTORY];
+	uint16_t sequence;
+} Sil_Sensor;
+
+IWDG_HandleTypeDef hiwdg;
+SPI_HandleTypeDef hspi2;
+TIM_HandleTypeDef htim2;
+TIM_HandleTypeDef htim6;
+
+static LIS3MDL_Sim sims[APP_MAX_LIS3MDL_DEVICES];
+static Sil_Sensor sensors[APP_MAX_LIS3MDL_DEVICES];
+static uint32_t consumed_samples = 0;
+static uint32_t unmatched_samples = 0;
+static uint64_t latency_sum_ns = 0;
+static uint64_t latency_max_ns = 0;
+static const char *trace_prefix = NULL;
+static const char *capture_prefix = NULL;
+static const char *profile_prefix = NULL;
+static FILE *capture_file = NULL;
+static uint64_t point_start_ns = 0;
+static uint64_t event_period_ns = 0;
+static uint32_t event_samples = 0;
+static uint32_t stats_summaries = 0;
+static uint32_t stats_mismatches = 0;
+static uint16_t stats_window_samples = 0;
+static const Sil_Cost_Model *point_cost = NULL;
+
+/**
+  * @brief The costs are given for the PLL, the MSI takes proportionally longer.
+  *
+  * @retval Factor to scale the CPU costs with at the current core clock.
+  */
+
+static uint32_t clock_slowdown(const Sil_Cost_Model *cost){
+	return cost->sysclk_hz / clock_governor_get_profile_info(clock_governor_get_profile())->sysclk_hz;
+}
+
+/**
+  * @brief Time into the field event under way at `at_ns`.
+  *
+  * @retval Nanoseconds since the event started, SIL_EVENT_NS when there is none.
+  */
+
+static uint64_t event_phase_ns(uint64_t at_ns){
+	if(event_period_ns == 0 || at_ns - point_start_ns < event_period_ns)
+		return SIL_EVENT_NS;
+	uint64_t phase_ns = (at_ns - point_start_ns) % event_period_ns;
+	return phase_ns < SIL_EVENT_NS ? phase_ns : SIL_EVENT_NS;
+}
+
+/**
+  * @brief Tags every conversion with the sensor index and a sequence number, so the
+  * consumed sample tells which conversion it came from.
+  */
+
+static void tag_conversion(LIS3MDL_Sim *sim, uint64_t at_ns){
+	Sil_Sensor *sensor = (Sil_Sensor *)sim->context;
+	sensor->sequence++;
+	sensor->conversion_ns[sensor->sequence % SIL_CONVERSION_HISTORY] = at_ns;
+	sim->field[0] = (int16_t)(sensor - sensors);
+	sim->field[1] = (int16_t)sensor->sequence;
+
+	uint64_t phase_ns = event_phase_ns(at_ns);
+	uint64_t from_edge_ns = phase_ns < SIL_EVENT_NS / 2 ? phase_ns : SIL_EVENT_NS - phase_ns;
+	sim->field[2] = (int16_t)(1000 + from_edge_ns * SIL_EVENT_LSB / (SIL_EVENT_NS / 2));
+}
+
+void app_magnetic_sample_callback(uint8_t dev_index, const LIS3MDL_Magnetic_Data_t *sample){
+	consumed_samples++;
+	hal_mock_advance_ns((uint64_t)point_cost->sample_ns * clock_slowdown(point_cost)); // Within the task, so the scheduler times it
+	if(event_phase_ns(hal_mock_get_time_ns()) < SIL_EVENT_NS)
+		event_samples++;
+	if(sample->x != dev_index || dev_index >= APP_MAX_LIS3MDL_DEVICES){ // X carries the index of the sensor
+		unmatched_samples++;
+		return;
+	}
+
+	Sil_Sensor *sensor = &sensors[sample->x];
+	uint16_t sequence = (uint16_t)sample->y;
+	if((uint16_t)(sensor->sequence - sequence) >= SIL_CONVERSION_HISTORY){
+		unmatched_samples++;
+		return;
+	}
+
+	uint64_t latency_ns = hal_mock_get_time_ns() - sensor->conversion_ns[sequence % SIL_CONVERSION_HISTORY];
+	latency_sum_ns += latency_ns;
+	if(latency_ns > latency_max_ns)
+		latency_max_ns = latency_ns;
+}
+
+/**
+  * @brief Checks a summary against the tagged conversions. X carries the sensor index and Y
+  * the sequence number, so a window of consecutive conversions has a constant X and a Y
+  * that covers `count` consecutive integers, with their mean and variance.
+  */
+
+void app_stats_callback(const LIS3MDL_Stats_Summary *summary){
+	stats_summaries++;
+	if(summary->mean[0] != summary->dev_index || summary->min[0] != summary->dev_index
+			|| summary->max[0] != summary->dev_index || summary->variance[0] != 0){
+		stats_mismatches++;
+		return;
+	}
+	if(summary->count != stats_window_samples || summary->max[1] - summary->min[1] + 1 != summary->count)
+		return; // Samples were skipped or lost, Y has gaps
+	int32_t ends = summary->min[1] + summary->max[1];
+	uint64_t count = summary->count;
+	if(summary->mean[1] != (ends >= 0 ? ends + 1 : ends - 1) / 2 || summary->variance[1] != (count * count - 1 + 6) / 12)
+		stats_mismatches++;
+}
+
+void app_capture_callback(const LIS3MDL_Capture_Record *record){
+	if(capture_file)
+		fwrite(record, sizeof(*record), 1, capture_file);
+}
+
+/**
+  * @brief Creates the capture file of a point and writes its header.
+  */
+
+static void open_capture(const Sil_Point *point){
+	char path[256];
+	snprintf(path, sizeof(path), "%s_%lu_%u_%u.cap", capture_prefix, (unsigned long)point->spi_prescaler, point->num_of_sensors, point->odr);
+	capture_file = fopen(path, "wb");
+	if(capture_file == NULL){
+		perror(path);
+		return;
+	}
+	uint8_t num_of_devices;
+	const LIS3MDL_Device *devices = app_get_lis3mdl_devices(&num_of_devices);
+	LIS3MDL_Capture_Header header;
+	lis3mdl_capture_init_header(&header, devices, num_of_devices);
+	fwrite(&header, sizeof(header), 1, capture_file);
+}
+
+/**
+  * @brief Writes the trace ring as is, the same layout a debugger dump of it has.
+  */
+
+static void dump_trace(const Sil_Point *point){
+	char path[256];
+	snprintf(path, sizeof(path), "%s_%lu_%u_%u.bin", trace_prefix, (unsigned long)point->spi_prescaler, point->num_of_sensors, point->odr);
+	FILE *out = fopen(path, "wb");
+	if(out == NULL){
+		perror(path);
+		return;
+	}
+	fwrite(lis3mdl_trace_get(), sizeof(LIS3MDL_Trace), 1, out);
+	fclose(out);
+}
+
+/**
+  * @brief Writes the statistics of every profiler zone as CSV.
+  */
+
+static void dump_profile(const Sil_Point *point){
+	char path[256];
+	snprintf(path, sizeof(path), "%s_%lu_%u_%u.csv", profile_prefix, (unsigned long)point->spi_prescaler, point->num_of_sensors, point->odr);
+	FILE *out = fopen(path, "w");
+	if(out == NULL){
+		perror(path);
+		return;
+	}
+	fprintf(out, "zone,count,min_ns,mean_ns,max_ns");
+	for(int i=0; i<PROFILER_HISTOGRAM_BINS - 1; i++)
+		fprintf(out, ",lt_%lu_ns", (unsigned long)PROFILER_HISTOGRAM_BASE_NS << i);
+	fprintf(out, ",ge_%lu_ns", (unsigned long)PROFILER_HISTOGRAM_BASE_NS << (PROFILER_HISTOGRAM_BINS - 2));
+	fprintf(out, "\n");
+	for(int zone=0; zone<PROFILER_ZONE_COUNT; zone++){
+		const Profiler_Zone_Stats *zone_stats = profiler_get_stats((Profiler_Zone)zone);
+		fprintf(out, "%s,%lu,%lu,%lu,%lu", profiler_get_zone_name((Profiler_Zone)zone), (unsigned long)zone_stats->count,
+				(unsigned long)(zone_stats->count ? zone_stats->min_ns : 0), (unsigned long)profiler_get_mean_ns((Profiler_Zone)zone),
+				(unsigned long)zone_stats->max_ns);
+		for(int i=0; i<PROFILER_HISTOGRAM_BINS; i++)
+			fprintf(out, ",%lu", (unsigned long)zone_stats->histogram[i]);
+		fprintf(out, "\n");
+	}
+	fclose(out);
+}
+
+/**
+  * @brief Runs one point of the sweep and prints its row.
+  */
+
+static void run_point(const Sil_Point *point, const Sil_Cost_Model *cost){
+	// Same peripheral setup as MX_*_Init in main.c
+	hiwdg.Init.Prescaler = IWDG_PRESCALER_4;
+	hiwdg.Init.Window = 20;
+	hiwdg.Init.Reload = 20;
+	hspi2.Instance = SPI2;
+	hspi2.Init.BaudRatePrescaler = hal_mock_spi_prescaler_from_divider(point->spi_prescaler);
+	htim2.Instance = TIM2;
+	htim2.Init.Prescaler = 4000-1;
+	htim2.Init.Period = 250-1;
+	htim6.Instance = TIM6;
+	htim6.Init.Prescaler = 32;
+	htim6.Init.Period = 99;
+
+	Hal_Mock_Spi_Timing timing = {
+		.pclk_hz = cost->pclk1_hz,
+		.dma_setup_ns = cost->dma_setup_ns,
+		.inter_byte_ns = 0,
+		.irq_latency_ns = cost->irq_latency_ns,
+		.call_ns = cost->transfer_start_ns
+	};
+	hal_mock_reset();
+	hal_mock_spi_setup(&hspi2, &timing);
+	hal_mock_tim_setup(&htim2, clock_governor_get_profile_info(CLOCK_PROFILE_HIGH)->apb1_timer_hz);
+	hal_mock_iwdg_setup(&hiwdg, cost->lsi_hz);
+	power_port_mock_setup(cost->stop_wakeup_ns);
+	clock_port_mock_setup(cost->clock_to_low_ns, cost->clock_to_high_ns);
+
+	point_cost = cost;
+	point_start_ns = hal_mock_get_time_ns();
+	event_period_ns = point->event_s * 1000000000ULL;
+
+	App_Chip_Select chip_selects[APP_MAX_LIS3MDL_DEVICES];
+	for(int i=0; i<point->num_of_sensors; i++){
+		lis3mdl_sim_init(&sims[i]);
+		sims[i].clock_error_ppm = (i & 1) ? 20000 : -15000; // Within the datasheet's ODR tolerance
+		sims[i].conversion_callback = tag_conversion;
+		sims[i].context = &sensors[i];
+		chip_selects[i].gpio_port = GPIOB;
+		chip_selects[i].pin = (uint16_t)(GPIO_PIN_0 << i);
+		hal_mock_spi_attach(&hspi2, chip_selects[i].gpio_port, chip_selects[i].pin, &sims[i]);
+	}
+
+	LIS3MDL_Init_Params init_params;
+	lis3mdl_set_default_params(&init_params);
+	init_params.full_scale = LIS3MDL_FULL_SCALE_16_GAUSS;
+	init_params.xy_operation_mode = LIS3MDL_ULTRA_PERFORMACE;
+	init_params.output_data_rate = point->odr;
+	init_params.temp_en = point->temperature;
+	if(app_init(chip_selects, point->num_of_sensors, init_params) != 0){
+		printf("app_init failed\n");
+		return;
+	}
+	LIS3MDL_Stats_Params stats_params = { point->stats_hop, point->stats_hops };
+	if(lis3mdl_stats_init(&stats_params) != 0){
+		printf("lis3mdl_stats_init failed\n");
+		return;
+	}
+	stats_window_samples = (uint16_t)(point->stats_hop * point->stats_hops);
+	HAL_TIM_Base_Start_IT(&htim2);
+	if(app_start() != 0){
+		printf("app_start failed\n");
+		return;
+	}
+	clock_governor_set_enabled(point->governor);
+	if(capture_prefix)
+		open_capture(point);
+
+	uint64_t start_ns = hal_mock_get_time_ns();
+	uint64_t end_ns = start_ns + point->seconds * 1000000000ULL;
+	uint64_t cpu_busy_ns = 0;
+	uint64_t cpu_busy_pll_ns = 0; // Same work at the PLL clock, for the cycle count
+	uint32_t dma_irqs = 0;
+	uint32_t iterations = 0;
+	uint64_t self_test_period_ns = point->self_test_s * 1000000000ULL;
+	uint64_t next_self_test_ns = start_ns + self_test_period_ns;
+	uint8_t self_test_device = 0;
+	while(hal_mock_get_time_ns() < end_ns){
+		if(self_test_period_ns && hal_mock_get_time_ns() >= next_self_test_ns){
+			if(app_request_self_test(self_test_device) == 0)
+				self_test_device = (uint8_t)((self_test_device + 1) % point->num_of_sensors);
+			next_self_test_ns += self_test_period_ns;
+		}
+		uint32_t transfers = hal_mock_spi_get_stats(&hspi2)->transfers;
+		uint32_t samples = consumed_samples;
+		uint32_t irqs = hal_mock_get_irq_count();
+		uint32_t spi_irqs = hal_mock_spi_get_stats(&hspi2)->irqs;
+
+		// Transfer starts and samples advance the time within the tasks, the rest of the iteration after it
+		uint32_t slowdown = clock_slowdown(cost);
+		hal_mock_spi_set_call_ns(&hspi2, cost->transfer_start_ns * slowdown);
+		app_run_once();
+		iterations++;
+
+		uint64_t work_ns = (uint64_t)(hal_mock_spi_get_stats(&hspi2)->transfers - transfers) * cost->transfer_start_ns
+				+ (uint64_t)(consumed_samples - samples) * cost->sample_ns;
+		uint64_t loop_pll_ns = cost->loop_ns + (uint64_t)point->num_of_sensors * cost->loop_per_device_ns;
+		if(work_ns){ // Iterations that found nothing to do are idle polling
+			cpu_busy_ns += (loop_pll_ns + work_ns) * slowdown;
+			cpu_busy_pll_ns += loop_pll_ns + work_ns;
+		}
+
+		hal_mock_advance_ns(loop_pll_ns * slowdown);
+		if(point->sleep)
+			app_idle();
+		else
+			power_manager_idle(0, 0, NULL); // Keeps the residency accounting going
+		spi_irqs = hal_mock_spi_get_stats(&hspi2)->irqs - spi_irqs;
+		dma_irqs += spi_irqs;
+		uint64_t isr_pll_ns = (uint64_t)(hal_mock_get_irq_count() - irqs - spi_irqs) * cost->isr_ns
+				+ (uint64_t)spi_irqs * (LIS3MDL_BUS_SINGLE_IRQ ? cost->engine_irq_ns : cost->dma_irq_ns);
+		uint64_t isr_ns = isr_pll_ns * clock_slowdown(cost);
+		cpu_busy_ns += isr_ns;
+		cpu_busy_pll_ns += isr_pll_ns;
+		hal_mock_advance_ns(isr_ns);
+	}
+
+	uint64_t elapsed_ns = hal_mock_get_time_ns() - start_ns;
+	uint32_t conversions = 0;
+	uint32_t overruns = 0;
+	for(int i=0; i<point->num_of_sensors; i++){
+		conversions += sims[i].stats.conversions;
+		overruns += sims[i].stats.overruns;
+	}
+	uint32_t matched = consumed_samples - unmatched_samples;
+	uint64_t event_ns = 0;
+	for(uint64_t at_ns = point_start_ns + event_period_ns; event_period_ns && at_ns < hal_mock_get_time_ns(); at_ns += event_period_ns)
+		event_ns += hal_mock_get_time_ns() - at_ns < SIL_EVENT_NS ? hal_mock_get_time_ns() - at_ns : SIL_EVENT_NS;
+	if(trace_prefix)
+		dump_trace(point);
+	if(capture_file)
+		fclose(capture_file);
+	if(profile_prefix)
+		dump_profile(point);
+	const Hal_Mock_Iwdg_Stats *iwdg = hal_mock_iwdg_get_stats();
+	const Power_Stats *power = power_manager_get_stats();
+	uint64_t accounted_us = power->residency_us[POWER_RUN] + power->residency_us[POWER_SLEEP] + power->residency_us[POWER_STOP];
+	double uj_per_sample = consumed_samples ? power_manager_estimate_charge_nc() * (SIL_SUPPLY_MV / 1e6) / consumed_samples : 0.0;
+	const Clock_Stats *clock = clock_governor_get_stats();
+	uint32_t clock_switches = clock->switches[CLOCK_PROFILE_LOW] + clock->switches[CLOCK_PROFILE_HIGH];
+	uint64_t clock_switch_us = clock->switch_us_sum[CLOCK_PROFILE_LOW] + clock->switch_us_sum[CLOCK_PROFILE_HIGH];
+	if(watchdog_get_stats()->late_tasks)
+		printf("watchdog refresh withheld, late tasks 0x%02x\n", watchdog_get_stats()->late_tasks);
+	if(power_port_mock_get_stats()->stops_during_transfer)
+		printf("%lu STOPs with a transfer in flight\n", (unsigned long)power_port_mock_get_stats()->stops_during_transfer);
+	if(app_get_identity_failures())
+		printf("%lu WHO_AM_I checks failed\n", (unsigned long)app_get_identity_failures());
+	const LIS3MDL_Self_Test_Report *self_test = lis3mdl_self_test_get_report();
+	if(self_test->result == LIS3MDL_SELF_TEST_FAILED || self_test->result == LIS3MDL_SELF_TEST_ABORTED)
+		printf("self-test of sensor %u %s, delta %ld %ld %ld LSB\n", self_test->dev_index, self_test->result == LIS3MDL_SELF_TEST_FAILED ? "failed" : "aborted",
+				(long)self_test->delta[0], (long)self_test->delta[1], (long)self_test->delta[2]);
+	if(unmatched_samples)
+		printf("%lu samples matched no recent conversion of the sensor they were tagged with\n", (unsigned long)unmatched_samples);
+	if(stats_mismatches)
+		printf("%lu of %lu summaries disagree with their samples\n", (unsigned long)stats_mismatches, (unsigned long)stats_summaries);
+
+	uint32_t max_execution_us = 0;
+	for(uint8_t task=0; task_scheduler_get_stats(task) != NULL; task++)
+		if(task_scheduler_get_stats(task)->max_execution_us > max_execution_us)
+			max_execution_us = task_scheduler_get_stats(task)->max_execution_us;
+
+	printf("%9lu %9lu %7u %8.3f %10.1f %9.1f %8lu %9.1f %9.1f %10.0f %10.0f %9.0f %8lu %10.0f %7.1f %7.1f %9.2f %7.1f %8lu %8.0f %7lu %8lu %6lu %7.1f %7lu %7.2f %8.0f %7.1f %7lu %7lu %7.2f %7.1f %7lu\n",
+			(unsigned long)point->spi_prescaler,
+			(unsigned long)hal_mock_spi_get_bitrate_hz(&hspi2),
+			point->num_of_sensors,
+			1e6 / lis3mdl_get_odr_period_us(point->odr),
+			consumed_samples * 1e9 / elapsed_ns,
+			conversions * 1e9 / elapsed_ns,
+			(unsigned long)overruns,
+			100.0 * cpu_busy_ns / elapsed_ns,
+			100.0 * hal_mock_spi_get_stats(&hspi2)->busy_ns / elapsed_ns,
+			matched ? latency_sum_ns / 1e3 / matched : 0.0,
+			latency_max_ns / 1e3,
+			iwdg->max_gap_ns / 1e3,
+			(unsigned long)(iwdg->expiries + iwdg->early_refreshes),
+			iterations * 1e9 / elapsed_ns,
+			accounted_us ? 100.0 * power->residency_us[POWER_SLEEP] / accounted_us : 0.0,
+			accounted_us ? 100.0 * power->residency_us[POWER_STOP] / accounted_us : 0.0,
+			uj_per_sample,
+			100.0 * clock->residency_us[CLOCK_PROFILE_LOW] / (clock->residency_us[CLOCK_PROFILE_LOW] + clock->residency_us[CLOCK_PROFILE_HIGH]),
+			(unsigned long)clock_switches,
+			clock_switches ? (double)clock_switch_us / clock_switches : 0.0,
+			(unsigned long)clock_governor_get_average_current_ua(CLOCK_PROFILE_LOW),
+			(unsigned long)clock_governor_get_average_current_ua(CLOCK_PROFILE_HIGH),
+			(unsigned long)lis3mdl_telemetry_get()->odr.raises,
+			event_ns ? event_samples * 1e9 / event_ns / point->num_of_sensors : 0.0,
+			(unsigned long)task_scheduler_get_deadline_misses(),
+			consumed_samples ? (double)dma_irqs / consumed_samples : 0.0,
+			consumed_samples ? cpu_busy_pll_ns * (cost->sysclk_hz / 1e9) / consumed_samples : 0.0,
+			lis3mdl_bus_arbiter_get_stats()->grants[LIS3MDL_TRANSACTION_BACKGROUND] * 1e9 / elapsed_ns,
+			(unsigned long)self_test->passed,
+			(unsigned long)(self_test->failed + self_test->aborted),
+			stats_summaries * 1e9 / elapsed_ns,
+			stats_summaries ? (double)consumed_samples * sizeof(LIS3MDL_Magnetic_Data_t) / (stats_summaries * sizeof(LIS3MDL_Stats_Summary)) : 0.0,
+			(unsigned long)max_execution_us);
+}
+
+static int parse_list(const char *text, uint32_t *values, int max_values){
+	int count = 0;
+	char *end;
+	while(*text && count < max_values){
+		values[count++] = (uint32_t)strtoul(text, &end, 0);
+		if(*end != ',')
+			break;
+		text = end + 1;
+	}
+	return count;
+}
+
+int main(int argc, char **argv){
+	uint32_t prescalers[SIL_MAX_POINTS] = { 2, 16, 256 };
+	uint32_t sensor_counts[SIL_MAX_POINTS] = { 1, 4 };
+	uint32_t odrs[SIL_MAX_POINTS] = { LIS3MDL_ODR_10, LIS3MDL_ODR_80 };
+	int num_of_prescalers = 3, num_of_sensor_counts = 2, num_of_odrs = 2;
+	uint32_t seconds = 5;
+	uint8_t sleep = 1;
+	uint8_t governor = 1;
+	uint32_t event_s = 0;
+	uint32_t self_test_s = 0;
+	uint8_t temperature = 0;
+	uint16_t stats_hop = 0;
+	uint8_t stats_hops = 1;
+	Sil_Cost_Model cost = {
+		.sysclk_hz = 32000000,
+		.pclk1_hz = 2000000, // APB1 divided by 16 in SystemClock_Config
+		.lsi_hz = 37000,
+		.dma_setup_ns = 3000,
+		.irq_latency_ns = 2000,
+		.isr_ns = 9000,
+		.dma_irq_ns = 5000, // HAL_DMA_IRQHandler for both channels, the last entry also waits for the SPI
+		.engine_irq_ns = 2000,
+		.loop_ns = 4000,
+		.loop_per_device_ns = 1500,
+		.transfer_start_ns = 12000,
+		.sample_ns = 6000,
+		.stop_wakeup_ns = 60000,
+		.clock_to_low_ns = 10000,
+		.clock_to_high_ns = 130000
+	};
+
+	for(int i=1; i+1<argc; i+=2){
+		if(strcmp(argv[i], "--prescalers") == 0)
+			num_of_prescalers = parse_list(argv[i+1], prescalers, SIL_MAX_POINTS);
+		else if(strcmp(argv[i], "--sensors") == 0)
+			num_of_sensor_counts = parse_list(argv[i+1], sensor_counts, SIL_MAX_POINTS);
+		else if(strcmp(argv[i], "--odrs") == 0)
+			num_of_odrs = parse_list(argv[i+1], odrs, SIL_MAX_POINTS);
+		else if(strcmp(argv[i], "--seconds") == 0)
+			seconds = (uint32_t)strtoul(argv[i+1], NULL, 0);
+		else if(strcmp(argv[i], "--dma-ns") == 0)
+			cost.dma_setup_ns = (uint32_t)strtoul(argv[i+1], NULL, 0);
+		else if(strcmp(argv[i], "--isr-ns") == 0)
+			cost.isr_ns = (uint32_t)strtoul(argv[i+1], NULL, 0);
+		else if(strcmp(argv[i], "--dma-irq-ns") == 0)
+			cost.dma_irq_ns = (uint32_t)strtoul(argv[i+1], NULL, 0);
+		else if(strcmp(argv[i], "--engine-irq-ns") == 0)
+			cost.engine_irq_ns = (uint32_t)strtoul(argv[i+1], NULL, 0);
+		else if(strcmp(argv[i], "--loop-ns") == 0)
+			cost.loop_ns = (uint32_t)strtoul(argv[i+1], NULL, 0);
+		else if(strcmp(argv[i], "--sleep") == 0)
+			sleep = (uint8_t)strtoul(argv[i+1], NULL, 0);
+		else if(strcmp(argv[i], "--governor") == 0)
+			governor = (uint8_t)strtoul(argv[i+1], NULL, 0);
+		else if(strcmp(argv[i], "--event-s") == 0)
+			event_s = (uint32_t)strtoul(argv[i+1], NULL, 0);
+		else if(strcmp(argv[i], "--self-test-s") == 0)
+			self_test_s = (uint32_t)strtoul(argv[i+1], NULL, 0);
+		else if(strcmp(argv[i], "--temperature") == 0)
+			temperature = (uint8_t)strtoul(argv[i+1], NULL, 0);
+		else if(strcmp(argv[i], "--stats") == 0)
+			stats_hop = (uint16_t)strtoul(argv[i+1], NULL, 0);
+		else if(strcmp(argv[i], "--stats-hops") == 0)
+			stats_hops = (uint8_t)strtoul(argv[i+1], NULL, 0);
+		else if(strcmp(argv[i], "--trace") == 0)
+			trace_prefix = argv[i+1];
+		else if(strcmp(argv[i], "--capture") == 0)
+			capture_prefix = argv[i+1];
+		else if(strcmp(argv[i], "--profile") == 0)
+			profile_prefix = argv[i+1];
+		else{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	printf("%9s %9s %7s %8s %10s %9s %8s %9s %9s %10s %10s %9s %8s %10s %7s %7s %9s %7s %8s %8s %7s %8s %6s %7s %7s %7s %8s %7s %7s %7s %7s %7s %7s\n", "prescaler", "bit/s", "sensors", "odr_hz", "samples/s", "conv/s",
+			"overruns", "cpu_busy%", "bus_busy%", "lat_avg_us", "lat_max_us", "iwdg_gap", "iwdg_rst", "loops/s", "sleep%", "stop%", "uJ/sample",
+			"msi%", "switches", "sw_us", "msi_uA", "pll_uA", "raises", "evt_hz", "dl_miss", "irq/smp", "cyc/smp", "bg/s", "st_pass", "st_fail", "summ/s", "x_less", "exec_us");
+	for(int p=0; p<num_of_prescalers; p++){
+		for(int s=0; s<num_of_sensor_counts; s++){
+			for(int o=0; o<num_of_odrs; o++){
+				Sil_Point point = { prescalers[p], (uint8_t)sensor_counts[s], (LIS3MDL_Output_Data_Rate)odrs[o], seconds, sleep, governor, event_s, self_test_s, temperature, stats_hop, stats_hops };
+				if(point.num_of_sensors < 1 || point.num_of_sensors > APP_MAX_LIS3MDL_DEVICES || point.odr > LIS3MDL_ODR_80){
+					fprintf(stderr, "skipping %u sensors at odr code %u\n", (unsigned)sensor_counts[s], (unsigned)odrs[o]);
+					continue;
+				}
+
+				fflush(stdout);
+				pid_t pid = fork();
+				if(pid == 0){
+					run_point(&point, &cost);
+					fflush(stdout);
+					_exit(0);
+				}
+				if(pid < 0 || waitpid(pid, NULL, 0) < 0){
+					perror("fork");
+					return 1;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
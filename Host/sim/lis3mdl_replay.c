@@ -0,0 +1,224 @@
+/*
+ * lis3mdl_replay.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lis3mdl_replay.h"
+#include "lis3mdl_registers.h"
+
+#define LIS3MDL_REPLAY_EMPTY UINT32_MAX
+
+/**
+  * @brief Reads a capture file.
+  *
+  * @param capture Pointer to the LIS3MDL_Capture to fill, free it with `lis3mdl_capture_free`.
+  * @param path File to read.
+  *
+  * @retval 0 on success, 1 if the file cannot be read or is not a capture of this version.
+  */
+
+uint8_t lis3mdl_capture_load(LIS3MDL_Capture *capture, const char *path){
+	memset(capture, 0, sizeof(*capture));
+	FILE *in = fopen(path, "rb");
+	if(in == NULL)
+		return 1;
+
+	if(fread(&capture->header, sizeof(capture->header), 1, in) != 1 || capture->header.magic != LIS3MDL_CAPTURE_MAGIC
+			|| capture->header.version != LIS3MDL_CAPTURE_VERSION || capture->header.record_size != sizeof(LIS3MDL_Capture_Record)
+			|| capture->header.num_of_devices > LIS3MDL_CAPTURE_MAX_DEVICES){
+		fclose(in);
+		return 1;
+	}
+
+	uint32_t capacity = 1024;
+	capture->records = malloc(capacity * sizeof(LIS3MDL_Capture_Record));
+	while(capture->records && fread(&capture->records[capture->num_of_records], sizeof(LIS3MDL_Capture_Record), 1, in) == 1){
+		if(++capture->num_of_records == capacity){
+			capacity *= 2;
+			LIS3MDL_Capture_Record *records = realloc(capture->records, capacity * sizeof(LIS3MDL_Capture_Record));
+			if(records == NULL)
+				free(capture->records);
+			capture->records = records;
+		}
+	}
+	fclose(in);
+	return capture->records == NULL;
+}
+
+/**
+  * @brief Writes a capture file.
+  *
+  * @param capture Pointer to the LIS3MDL_Capture to write.
+  * @param path File to create.
+  *
+  * @retval 0 on success, 1 if the file cannot be written.
+  */
+
+uint8_t lis3mdl_capture_save(const LIS3MDL_Capture *capture, const char *path){
+	FILE *out = fopen(path, "wb");
+	if(out == NULL)
+		return 1;
+
+	uint8_t failed = fwrite(&capture->header, sizeof(capture->header), 1, out) != 1;
+	if(!failed && capture->num_of_records)
+		failed = fwrite(capture->records, sizeof(LIS3MDL_Capture_Record), capture->num_of_records, out) != capture->num_of_records;
+	return fclose(out) != 0 || failed;
+}
+
+void lis3mdl_capture_free(LIS3MDL_Capture *capture){
+	free(capture->records);
+	capture->records = NULL;
+	capture->num_of_records = 0;
+}
+
+/**
+  * @brief Turns the raw bytes of a record into axis values, honoring the BLE setting the
+  * device was captured with.
+  *
+  * @param capture Pointer to the LIS3MDL_Capture the record belongs to.
+  * @param record Pointer to the record.
+  * @param axes Receives X, Y and Z.
+  */
+
+void lis3mdl_capture_decode_record(const LIS3MDL_Capture *capture, const LIS3MDL_Capture_Record *record, int16_t *axes){
+	uint8_t big_endian = capture->header.config[record->dev_index % LIS3MDL_CAPTURE_MAX_DEVICES].ctrls[3] & LIS3MDL_BLE;
+	for(int i=0; i<3; i++){
+		uint8_t low = big_endian ? record->out[2*i + 1] : record->out[2*i];
+		uint8_t high = big_endian ? record->out[2*i] : record->out[2*i + 1];
+		axes[i] = (int16_t)(low | (high << 8));
+	}
+}
+
+/**
+  * @brief Maps a record to the virtual time it is replayed at.
+  */
+
+static uint64_t get_replay_time_ns(const LIS3MDL_Replay *replay, const LIS3MDL_Capture_Record *record){
+	uint32_t since_first_us = record->time_us - replay->capture->records[0].time_us;
+	return replay->start_ns + (uint64_t)since_first_us * 1000 / replay->speedup;
+}
+
+static uint32_t find_device_record(const LIS3MDL_Replay *replay, uint32_t index){
+	while(index < replay->capture->num_of_records && replay->capture->records[index].dev_index != replay->dev_index)
+		index++;
+	return index;
+}
+
+/**
+  * @brief next_conversion_callback of the simulated sensor, schedules the next record.
+  */
+
+static uint64_t schedule_record(LIS3MDL_Sim *sim, uint64_t after_ns){
+	LIS3MDL_Replay *replay = (LIS3MDL_Replay *)sim->context;
+	if(replay->start_ns == 0)
+		replay->start_ns = after_ns + lis3mdl_sim_get_conversion_period_ns(sim); // Like the first conversion of a real sensor
+
+	replay->next = find_device_record(replay, replay->next);
+	while(replay->next < replay->capture->num_of_records && get_replay_time_ns(replay, &replay->capture->records[replay->next]) <= after_ns){
+		replay->skipped++;
+		replay->next = find_device_record(replay, replay->next + 1);
+	}
+	if(replay->next >= replay->capture->num_of_records)
+		return UINT64_MAX; // Nothing left, the sensor goes quiet
+	return get_replay_time_ns(replay, &replay->capture->records[replay->next]);
+}
+
+/**
+  * @brief conversion_callback of the simulated sensor, loads the scheduled record so the
+  * output registers end up holding the captured bytes.
+  */
+
+static void load_record(LIS3MDL_Sim *sim, uint64_t at_ns){
+	LIS3MDL_Replay *replay = (LIS3MDL_Replay *)sim->context;
+	replay->next = find_device_record(replay, replay->next);
+	if(replay->next >= replay->capture->num_of_records)
+		return;
+
+	const LIS3MDL_Capture_Record *record = &replay->capture->records[replay->next];
+	int16_t axes[3];
+	lis3mdl_capture_decode_record(replay->capture, record, axes);
+	for(int i=0; i<3; i++){
+		// The sensor subtracts the offset registers, add them so the captured value comes out
+		int16_t offset = (int16_t)(sim->regs[LIS3MDL_OFFSET_X_REG_L_M_ADDR + 2*i] | (sim->regs[LIS3MDL_OFFSET_X_REG_H_M_ADDR + 2*i] << 8));
+		int32_t field = (int32_t)axes[i] + offset;
+		sim->field[i] = (int16_t)(field > INT16_MAX ? INT16_MAX : field < INT16_MIN ? INT16_MIN : field);
+	}
+	if(record->flags & LIS3MDL_CAPTURE_HAS_TEMPERATURE)
+		sim->temperature_lsb = (int16_t)(record->temp[0] | (record->temp[1] << 8));
+	if(record->status & LIS3MDL_ZYXOR)
+		replay->captured_overruns++;
+
+	memmove(replay->history, replay->history + 1, sizeof(replay->history) - sizeof(replay->history[0]));
+	memmove(replay->history_ns, replay->history_ns + 1, sizeof(replay->history_ns) - sizeof(replay->history_ns[0]));
+	replay->history[LIS3MDL_REPLAY_HISTORY - 1] = replay->next;
+	replay->history_ns[LIS3MDL_REPLAY_HISTORY - 1] = at_ns;
+	replay->replayed++;
+	replay->next++;
+}
+
+/**
+  * @brief Makes a simulated sensor replay the records of one device of a capture.
+  * Takes over the sensor's conversion callbacks and `context`.
+  *
+  * @param replay Pointer to the LIS3MDL_Replay to set up.
+  * @param sim Pointer to the simulated sensor.
+  * @param capture Pointer to the capture, has to outlive the replay.
+  * @param dev_index Device of the capture whose records are replayed.
+  * @param speedup 1 for the original timing, N to replay N times faster.
+  *
+  * @retval 0 on success, 1 on invalid input.
+  */
+
+uint8_t lis3mdl_replay_attach(LIS3MDL_Replay *replay, LIS3MDL_Sim *sim, const LIS3MDL_Capture *capture, uint8_t dev_index, uint32_t speedup){
+	if(replay == NULL || sim == NULL || capture == NULL || capture->num_of_records == 0 || dev_index >= capture->header.num_of_devices || speedup == 0)
+		return 1;
+
+	memset(replay, 0, sizeof(*replay));
+	replay->capture = capture;
+	replay->dev_index = dev_index;
+	replay->speedup = speedup;
+	for(int i=0; i<LIS3MDL_REPLAY_HISTORY; i++)
+		replay->history[i] = LIS3MDL_REPLAY_EMPTY;
+
+	sim->conversion_callback = load_record;
+	sim->next_conversion_callback = schedule_record;
+	sim->context = replay;
+	return 0;
+}
+
+/**
+  * @brief Tells whether every record of the device has been replayed or skipped.
+  */
+
+uint8_t lis3mdl_replay_finished(const LIS3MDL_Replay *replay){
+	return find_device_record(replay, replay->next) >= replay->capture->num_of_records;
+}
+
+/**
+  * @brief Finds the recently replayed record a delivered sample came from.
+  *
+  * @param replay Pointer to the LIS3MDL_Replay.
+  * @param axes Delivered X, Y and Z.
+  * @param converted_ns Receives the moment the record was converted, may be NULL.
+  *
+  * @retval Pointer to the newest matching record, NULL if none of the recent ones matches.
+  */
+
+const LIS3MDL_Capture_Record *lis3mdl_replay_match(const LIS3MDL_Replay *replay, const int16_t *axes, uint64_t *converted_ns){
+	for(int i=LIS3MDL_REPLAY_HISTORY - 1; i>=0 && replay->history[i] != LIS3MDL_REPLAY_EMPTY; i--){
+		const LIS3MDL_Capture_Record *record = &replay->capture->records[replay->history[i]];
+		int16_t replayed[3];
+		lis3mdl_capture_decode_record(replay->capture, record, replayed);
+		if(memcmp(replayed, axes, sizeof(replayed)) == 0){
+			if(converted_ns)
+				*converted_ns = replay->history_ns[i];
+			return record;
+		}
+	}
+	return NULL;
+}
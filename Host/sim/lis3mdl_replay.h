@@ -0,0 +1,60 @@
+/*
+ * lis3mdl_replay.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef SIM_LIS3MDL_REPLAY_H_
+#define SIM_LIS3MDL_REPLAY_H_
+
+#include <stdint.h>
+#include "lis3mdl_capture.h"
+#include "lis3mdl_sim.h"
+
+#define LIS3MDL_REPLAY_HISTORY 16 // Replayed records kept to match delivered samples against
+
+/**
+ * @brief A capture loaded into memory, see Drivers/lis3mdl/lis3mdl_capture.h.
+ */
+
+typedef struct {
+	LIS3MDL_Capture_Header header;
+	LIS3MDL_Capture_Record *records;
+	uint32_t num_of_records;
+} LIS3MDL_Capture;
+
+/**
+ * @brief Feeds the records of one device of a capture to a simulated LIS3MDL.
+ *
+ * Every record becomes one conversion of the sensor, at the time it was captured relative
+ * to the first record, divided by `speedup`. Time zero of the capture is the moment the
+ * sensor is put into continuous conversion. Once the records run out the sensor stops
+ * converting.
+ */
+
+typedef struct {
+	const LIS3MDL_Capture *capture;
+	uint8_t dev_index;
+	uint32_t speedup;
+	uint64_t start_ns; // Moment the first record of the capture maps to, 0 until conversions start
+	uint32_t next; // Index of the next record to replay, any device
+	uint32_t replayed;
+	uint32_t skipped; // Records that mapped to the same moment as the previous one
+	uint32_t captured_overruns; // Replayed records whose capture had ZYXOR set
+
+	// Replayed records, most recent last, to match delivered samples against
+	uint32_t history[LIS3MDL_REPLAY_HISTORY];
+	uint64_t history_ns[LIS3MDL_REPLAY_HISTORY];
+} LIS3MDL_Replay;
+
+uint8_t lis3mdl_capture_load(LIS3MDL_Capture *capture, const char *path);
+uint8_t lis3mdl_capture_save(const LIS3MDL_Capture *capture, const char *path);
+void lis3mdl_capture_free(LIS3MDL_Capture *capture);
+void lis3mdl_capture_decode_record(const LIS3MDL_Capture *capture, const LIS3MDL_Capture_Record *record, int16_t *axes);
+
+uint8_t lis3mdl_replay_attach(LIS3MDL_Replay *replay, LIS3MDL_Sim *sim, const LIS3MDL_Capture *capture, uint8_t dev_index, uint32_t speedup);
+uint8_t lis3mdl_replay_finished(const LIS3MDL_Replay *replay);
+const LIS3MDL_Capture_Record *lis3mdl_replay_match(const LIS3MDL_Replay *replay, const int16_t *axes, uint64_t *converted_ns);
+
+#endif /* SIM_LIS3MDL_REPLAY_H_ */
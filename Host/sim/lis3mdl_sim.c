@@ -0,0 +1,367 @@
+/*
+ * lis3mdl_sim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#include <string.h>
+#include "lis3mdl_sim.h"
+#include "lis3mdl_registers.h"
+
+#define LIS3MDL_SIM_DEFAULT_REBOOT_TIME_NS 2000000U
+#define LIS3MDL_SIM_DA_BITS (LIS3MDL_ZYXDA | LIS3MDL_ZDA | LIS3MDL_YDA | LIS3MDL_XDA)
+#define LIS3MDL_SIM_OR_BITS (LIS3MDL_ZYXOR | LIS3MDL_ZOR | LIS3MDL_YOR | LIS3MDL_XOR)
+
+static const uint64_t odr_period_ns[8] = {
+	1600000000, 800000000, 400000000, 200000000, 100000000, 50000000, 25000000, 12500000
+};
+
+static const int32_t sensitivity_lsb_per_gauss[4] = { 6842, 3421, 2281, 1711 }; // 4, 8, 12, 16 gauss
+
+static const uint64_t fast_odr_period_ns[4] = {
+	1000000, // Low power, 1000 Hz
+	1785714, // Medium performance, 560 Hz
+	3333333, // High performance, 300 Hz
+	6451613 // Ultra high performance, 155 Hz
+};
+
+/**
+  * @brief Puts every register to its power-on value.
+  *
+  * @param sim Pointer to the LIS3MDL_Sim.
+  */
+
+static void load_default_registers(LIS3MDL_Sim *sim){
+	memset(sim->regs, 0, sizeof(sim->regs));
+	sim->regs[LIS3MDL_WHO_AM_I_REG_ADDR] = LIS3MDL_WHO_AM_I_REG_VALUE;
+	sim->regs[LIS3MDL_CTRL_REG1_ADDR] = 0x10;
+	sim->regs[LIS3MDL_CTRL_REG3_ADDR] = 0x03;
+	sim->regs[LIS3MDL_INT_CFG_REG_ADDR] = 0xE8;
+	sim->next_conversion_ns = 0;
+	sim->pending_valid = 0;
+}
+
+/**
+  * @brief Initializes the model to a powered up sensor in power-down mode with a self-test
+  * field within the datasheet limits. Field, self-test field, temperature, clock error and
+  * reboot time can be adjusted afterwards.
+  *
+  * @param sim Pointer to the LIS3MDL_Sim to initialize.
+  */
+
+void lis3mdl_sim_init(LIS3MDL_Sim *sim){
+	memset(sim, 0, sizeof(*sim));
+	load_default_registers(sim);
+	sim->reboot_time_ns = LIS3MDL_SIM_DEFAULT_REBOOT_TIME_NS;
+	sim->self_test_mgauss[0] = 2000;
+	sim->self_test_mgauss[1] = 2000;
+	sim->self_test_mgauss[2] = 500;
+}
+
+/**
+  * @brief Computes the time between two conversions from the current configuration.
+  *
+  * @param sim Pointer to the LIS3MDL_Sim.
+  *
+  * @retval Conversion period in nanoseconds including the clock error.
+  */
+
+uint64_t lis3mdl_sim_get_conversion_period_ns(const LIS3MDL_Sim *sim){
+	uint8_t ctrl1 = sim->regs[LIS3MDL_CTRL_REG1_ADDR];
+	uint64_t period_ns;
+
+	if(sim->regs[LIS3MDL_CTRL_REG3_ADDR] & LIS3MDL_LP)
+		period_ns = odr_period_ns[0]; // Low power forces 0.625 Hz
+	else if(ctrl1 & LIS3MDL_FAST_ODR)
+		period_ns = fast_odr_period_ns[(ctrl1 & LIS3MDL_XY_OPERATING_MODE) >> 5];
+	else
+		period_ns = odr_period_ns[(ctrl1 & LIS3MDL_ODR) >> 2];
+
+	return period_ns * (uint64_t)(1000000 + sim->clock_error_ppm) / 1000000;
+}
+
+/**
+  * @brief Moment of the next continuous conversion after `after_ns`.
+  *
+  * @param sim Pointer to the LIS3MDL_Sim.
+  * @param after_ns Moment of the previous conversion or of the start of conversions.
+  *
+  * @retval Time in nanoseconds.
+  */
+
+static uint64_t get_next_conversion_ns(LIS3MDL_Sim *sim, uint64_t after_ns){
+	if(sim->next_conversion_callback != NULL){
+		uint64_t next_ns = sim->next_conversion_callback(sim, after_ns);
+		if(next_ns)
+			return next_ns;
+	}
+	return after_ns + lis3mdl_sim_get_conversion_period_ns(sim);
+}
+
+/**
+  * @brief Starts or stops conversions after CTRL_REG1 or CTRL_REG3 changed.
+  *
+  * @param sim Pointer to the LIS3MDL_Sim.
+  */
+
+static void update_conversion_schedule(LIS3MDL_Sim *sim){
+	switch(sim->regs[LIS3MDL_CTRL_REG3_ADDR] & LIS3MDL_MD){
+	case 0x00: // Continuous conversion, keeps the phase if already running
+		if(sim->next_conversion_ns == 0)
+			sim->next_conversion_ns = get_next_conversion_ns(sim, sim->now_ns);
+		break;
+	case 0x01: // Single conversion
+		sim->next_conversion_ns = sim->now_ns + lis3mdl_sim_get_conversion_period_ns(sim);
+		break;
+	default:
+		sim->next_conversion_ns = 0;
+		break;
+	}
+}
+
+/**
+  * @brief Produces one sample, flagging an overrun if the previous one was never read.
+  *
+  * @param sim Pointer to the LIS3MDL_Sim.
+  * @param at_ns Moment the conversion finishes.
+  */
+
+static void convert(LIS3MDL_Sim *sim, uint64_t at_ns){
+	if(sim->conversion_callback != NULL)
+		sim->conversion_callback(sim, at_ns);
+
+	uint8_t *status = &sim->regs[LIS3MDL_STATUS_REG_ADDR];
+	if(*status & LIS3MDL_ZYXDA){
+		*status |= LIS3MDL_SIM_OR_BITS;
+		sim->stats.overruns++;
+	}
+	*status |= LIS3MDL_SIM_DA_BITS;
+
+	uint8_t out[6];
+	uint8_t big_endian = sim->regs[LIS3MDL_CTRL_REG4_ADDR] & LIS3MDL_BLE;
+	uint8_t self_test = sim->regs[LIS3MDL_CTRL_REG1_ADDR] & LIS3MDL_SELF_TEST;
+	int32_t sensitivity = sensitivity_lsb_per_gauss[(sim->regs[LIS3MDL_CTRL_REG2_ADDR] & LIS3MDL_FULL_SCALE) >> 5];
+	for(int i=0; i<3; i++){
+		int16_t offset = (int16_t)(sim->regs[LIS3MDL_OFFSET_X_REG_L_M_ADDR + 2*i] | (sim->regs[LIS3MDL_OFFSET_X_REG_H_M_ADDR + 2*i] << 8));
+		int32_t value = (int32_t)sim->field[i] - offset;
+		if(self_test)
+			value += sim->self_test_mgauss[i] * sensitivity / 1000;
+		if(value > INT16_MAX)
+			value = INT16_MAX;
+		if(value < INT16_MIN)
+			value = INT16_MIN;
+		out[2*i] = big_endian ? (uint8_t)((uint16_t)value >> 8) : (uint8_t)value;
+		out[2*i + 1] = big_endian ? (uint8_t)value : (uint8_t)((uint16_t)value >> 8);
+	}
+
+	if((sim->regs[LIS3MDL_CTRL_REG5_ADDR] & LIS3MDL_BDU) && sim->selected && sim->outputs_touched){
+		memcpy(sim->pending, out, 6);
+		sim->pending_valid = 1;
+	}
+	else
+		memcpy(&sim->regs[LIS3MDL_OUT_X_L_ADDR], out, 6);
+
+	if(sim->regs[LIS3MDL_CTRL_REG1_ADDR] & LIS3MDL_TEMP_EN){
+		uint16_t temperature = (uint16_t)sim->temperature_lsb;
+		sim->regs[LIS3MDL_TEMP_OUT_L_ADDR] = big_endian ? (uint8_t)(temperature >> 8) : (uint8_t)temperature;
+		sim->regs[LIS3MDL_TEMP_OUT_H_ADDR] = big_endian ? (uint8_t)temperature : (uint8_t)(temperature >> 8);
+	}
+
+	sim->last_conversion_ns = at_ns;
+	sim->stats.conversions++;
+}
+
+/**
+  * @brief Runs every conversion that finishes up to `now_ns`.
+  *
+  * @param sim Pointer to the LIS3MDL_Sim.
+  * @param now_ns Current time, never earlier than the one of the previous call.
+  */
+
+void lis3mdl_sim_advance(LIS3MDL_Sim *sim, uint64_t now_ns){
+	while(sim->next_conversion_ns && sim->next_conversion_ns <= now_ns){
+		convert(sim, sim->next_conversion_ns);
+		if((sim->regs[LIS3MDL_CTRL_REG3_ADDR] & LIS3MDL_MD) == 0x01){
+			sim->regs[LIS3MDL_CTRL_REG3_ADDR] |= LIS3MDL_MD; // Single conversion ends in power-down
+			sim->next_conversion_ns = 0;
+		}
+		else
+			sim->next_conversion_ns = get_next_conversion_ns(sim, sim->next_conversion_ns);
+	}
+	if(now_ns > sim->now_ns)
+		sim->now_ns = now_ns;
+}
+
+/**
+  * @brief CS falling edge. A falling edge while already selected ends the previous frame first.
+  *
+  * @param sim Pointer to the LIS3MDL_Sim.
+  * @param now_ns Moment of the edge.
+  */
+
+void lis3mdl_sim_select(LIS3MDL_Sim *sim, uint64_t now_ns){
+	if(sim->selected)
+		lis3mdl_sim_deselect(sim, now_ns);
+	lis3mdl_sim_advance(sim, now_ns);
+	sim->selected = 1;
+	sim->frame_pos = 0;
+	sim->outputs_touched = 0;
+	sim->stats.frames++;
+}
+
+/**
+  * @brief CS rising edge. Output registers held back by BDU are updated here.
+  *
+  * @param sim Pointer to the LIS3MDL_Sim.
+  * @param now_ns Moment of the edge.
+  */
+
+void lis3mdl_sim_deselect(LIS3MDL_Sim *sim, uint64_t now_ns){
+	lis3mdl_sim_advance(sim, now_ns);
+	if(sim->pending_valid){
+		memcpy(&sim->regs[LIS3MDL_OUT_X_L_ADDR], sim->pending, 6);
+		sim->pending_valid = 0;
+	}
+	sim->selected = 0;
+	sim->frame_pos = 0;
+	sim->outputs_touched = 0;
+}
+
+/**
+  * @brief Returns a register value the way an SPI read sees it, including read side effects.
+  *
+  * @param sim Pointer to the LIS3MDL_Sim.
+  * @param reg Register address.
+  *
+  * @retval The register value.
+  */
+
+static uint8_t read_register(LIS3MDL_Sim *sim, uint8_t reg){
+	uint8_t value = sim->regs[reg];
+	uint8_t *status = &sim->regs[LIS3MDL_STATUS_REG_ADDR];
+
+	if(reg == LIS3MDL_STATUS_REG_ADDR)
+		sim->stats.status_reads++;
+
+	if(reg >= LIS3MDL_OUT_X_L_ADDR && reg <= LIS3MDL_OUT_Z_H_ADDR){
+		sim->outputs_touched = 1;
+		if(reg & 1){ // Second register of an axis clears its flags
+			uint8_t axis = (reg - LIS3MDL_OUT_X_L_ADDR) >> 1;
+			if(reg == LIS3MDL_OUT_Z_H_ADDR){
+				if(*status & LIS3MDL_ZDA){
+					uint64_t latency_ns = sim->now_ns - sim->last_conversion_ns;
+					sim->stats.samples_read++;
+					sim->stats.latency_sum_ns += latency_ns;
+					if(latency_ns > sim->stats.latency_max_ns)
+						sim->stats.latency_max_ns = latency_ns;
+				}
+				else
+					sim->stats.stale_reads++;
+			}
+			*status &= ~((LIS3MDL_XDA | LIS3MDL_XOR) << axis);
+			if(!(*status & (LIS3MDL_ZDA | LIS3MDL_YDA | LIS3MDL_XDA)))
+				*status &= ~LIS3MDL_ZYXDA;
+			if(!(*status & (LIS3MDL_ZOR | LIS3MDL_YOR | LIS3MDL_XOR)))
+				*status &= ~LIS3MDL_ZYXOR;
+		}
+	}
+
+	return value;
+}
+
+/**
+  * @brief Applies an SPI write to a register. Read-only registers ignore writes.
+  *
+  * @param sim Pointer to the LIS3MDL_Sim.
+  * @param reg Register address.
+  * @param value Value written.
+  */
+
+static void write_register(LIS3MDL_Sim *sim, uint8_t reg, uint8_t value){
+	switch(reg){
+	case LIS3MDL_OFFSET_X_REG_L_M_ADDR ... LIS3MDL_OFFSET_Z_REG_H_M_ADDR:
+	case LIS3MDL_CTRL_REG4_ADDR:
+	case LIS3MDL_CTRL_REG5_ADDR:
+	case LIS3MDL_INT_CFG_REG_ADDR:
+	case LIS3MDL_INT_THS_L:
+	case LIS3MDL_INT_THS_H:
+		sim->regs[reg] = value;
+		return;
+	case LIS3MDL_CTRL_REG1_ADDR:
+	case LIS3MDL_CTRL_REG3_ADDR:
+		sim->regs[reg] = value;
+		update_conversion_schedule(sim);
+		return;
+	case LIS3MDL_CTRL_REG2_ADDR:
+		if(value & LIS3MDL_SOFT_RST)
+			load_default_registers(sim);
+		if(value & LIS3MDL_REBOOT)
+			sim->busy_until_ns = sim->now_ns + sim->reboot_time_ns;
+		sim->regs[reg] = value & ~(LIS3MDL_REBOOT | LIS3MDL_SOFT_RST); // Both bits clear themselves
+		return;
+	default:
+		return;
+	}
+}
+
+/**
+  * @brief Shifts one byte through the sensor. The first byte of a frame is the address
+  * with the read and auto-increment bits, every following one reads or writes a register.
+  *
+  * @param sim Pointer to the LIS3MDL_Sim.
+  * @param now_ns Moment the last bit of the byte is clocked.
+  * @param mosi Byte the master sends.
+  *
+  * @retval Byte the sensor drives on SDO, 0xFF while SDO is not driven.
+  */
+
+uint8_t lis3mdl_sim_transfer_byte(LIS3MDL_Sim *sim, uint64_t now_ns, uint8_t mosi){
+	lis3mdl_sim_advance(sim, now_ns);
+	sim->stats.bytes++;
+
+	if(!sim->selected)
+		return 0xFF;
+
+	if(sim->now_ns < sim->busy_until_ns){
+		sim->stats.accesses_while_booting++;
+		if(sim->frame_pos < UINT8_MAX)
+			sim->frame_pos++;
+		return 0xFF;
+	}
+
+	if(sim->frame_pos == 0){
+		sim->address = mosi & (LIS3MDL_SIM_REG_COUNT - 1);
+		sim->reading = (mosi & LIS3MDL_READ_BIT) != 0;
+		sim->auto_increment = (mosi & LIS3MDL_MD_BIT) != 0;
+		sim->frame_pos++;
+		return 0xFF;
+	}
+
+	uint8_t miso = 0xFF;
+	if(sim->reading)
+		miso = read_register(sim, sim->address);
+	else
+		write_register(sim, sim->address, mosi);
+
+	if(sim->auto_increment)
+		sim->address = (sim->address + 1) & (LIS3MDL_SIM_REG_COUNT - 1);
+	if(sim->frame_pos < UINT8_MAX)
+		sim->frame_pos++;
+
+	return miso;
+}
+
+/**
+  * @brief Level of the DRDY pin, high while a new sample has not been read.
+  *
+  * @param sim Pointer to the LIS3MDL_Sim.
+  * @param now_ns Current time.
+  *
+  * @retval 1 if DRDY is high, 0 otherwise.
+  */
+
+uint8_t lis3mdl_sim_drdy(LIS3MDL_Sim *sim, uint64_t now_ns){
+	lis3mdl_sim_advance(sim, now_ns);
+	return (sim->regs[LIS3MDL_STATUS_REG_ADDR] & LIS3MDL_ZYXDA) != 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * lis3mdl_sim.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ */
+
+#ifndef SIM_LIS3MDL_SIM_H_
+#define SIM_LIS3MDL_SIM_H_
+
+#include <stdint.h>
+
+#define LIS3MDL_SIM_REG_COUNT 0x40
+
+/**
+ * @brief Counters the simulated sensor keeps about how it was used.
+ */
+
+typedef struct {
+	uint32_t conversions; // Samples the sensor produced
+	uint32_t overruns; // Samples that replaced one which was never read
+	uint32_t samples_read; // Reads that reached OUT_Z_H while new data was flagged
+	uint32_t stale_reads; // Reads that reached OUT_Z_H with nothing new to report
+	uint32_t status_reads; // Reads of STATUS_REG
+	uint32_t frames; // CS low periods
+	uint32_t bytes; // Bytes shifted in either direction
+	uint32_t accesses_while_booting; // Bytes that arrived while a REBOOT was still in progress
+	uint64_t latency_sum_ns; // Conversion to read of OUT_Z_H, summed over samples_read
+	uint64_t latency_max_ns;
+} LIS3MDL_Sim_Stats;
+
+/**
+ * @brief Register level model of one LIS3MDL on a 4-wire SPI bus.
+ *
+ * The model keeps its own notion of time, every call passes the moment it happens at
+ * and conversions up to that moment are produced first. Conversions follow the ODR
+ * configured in CTRL_REG1/CTRL_REG3, skewed by `clock_error_ppm` to mimic the sensor's
+ * own oscillator. STATUS_REG, the DRDY line, overrun, BLE, BDU, auto-increment and the
+ * REBOOT busy time behave like the datasheet describes them.
+ */
+
+typedef struct LIS3MDL_Sim {
+	uint8_t regs[LIS3MDL_SIM_REG_COUNT];
+
+	int16_t field[3]; // Raw X, Y, Z value the next conversions report, before offsets
+	int16_t self_test_mgauss[3]; // Added to `field` while ST is set in CTRL_REG1, at the configured full scale
+	int16_t temperature_lsb; // Raw TEMP_OUT value, 8 LSB/degC around 25 degC
+	int32_t clock_error_ppm; // Positive values make the sensor run slow
+	uint32_t reboot_time_ns; // Accesses within this time after a REBOOT are lost
+
+	uint64_t now_ns;
+	uint64_t next_conversion_ns; // 0 while not converting
+	uint64_t last_conversion_ns;
+	uint64_t busy_until_ns;
+
+	uint8_t selected;
+	uint8_t frame_pos; // Bytes seen in the current frame, the first one is the address
+	uint8_t address;
+	uint8_t reading;
+	uint8_t auto_increment;
+
+	uint8_t pending[6]; // Conversion held back by BDU until the frame reading the outputs ends
+	uint8_t pending_valid;
+	uint8_t outputs_touched; // OUT registers read in the current frame
+
+	LIS3MDL_Sim_Stats stats;
+
+	// Optional, runs right before a conversion latches `field`, e.g. to vary or tag it
+	void (*conversion_callback)(struct LIS3MDL_Sim *sim, uint64_t at_ns);
+	// Optional, moment of the first continuous conversion after `after_ns`, 0 to follow the ODR
+	uint64_t (*next_conversion_callback)(struct LIS3MDL_Sim *sim, uint64_t after_ns);
+	void *context;
+} LIS3MDL_Sim;
+
+void lis3mdl_sim_init(LIS3MDL_Sim *sim);
+void lis3mdl_sim_advance(LIS3MDL_Sim *sim, uint64_t now_ns);
+void lis3mdl_sim_select(LIS3MDL_Sim *sim, uint64_t now_ns);
+void lis3mdl_sim_deselect(LIS3MDL_Sim *sim, uint64_t now_ns);
+uint8_t lis3mdl_sim_transfer_byte(LIS3MDL_Sim *sim, uint64_t now_ns, uint8_t mosi);
+uint8_t lis3mdl_sim_drdy(LIS3MDL_Sim *sim, uint64_t now_ns);
+uint64_t lis3mdl_sim_get_conversion_period_ns(const LIS3MDL_Sim *sim);
+
+#endif /* SIM_LIS3MDL_SIM_H_ */
@@ -0,0 +1,166 @@
+/*
+ * lis3mdl_endianness_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Checks the decoding of the OUT_X..OUT_Z burst for both settings of the BLE bit.
+ *
+ * First `lis3mdl_decode_sample_in_place` gets raw bursts built by hand in the byte order
+ * of each setting, so the swap of the non-native order runs on known bytes. Then the
+ * driver reads simulated sensors configured with each setting, and every delivered sample
+ * has to match the field of its sensor.
+ *
+ * Usage: lis3mdl_endianness_test
+ *
+ * The exit status is 1 if any sample decodes to a wrong value.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "hal_mock.h"
+#include "lis3mdl.h"
+
+#define TEST_NUM_OF_DEVICES 2
+#define TEST_PCLK_HZ 2000000
+#define TEST_LOOP_COST_NS 10000
+#define TEST_RUN_NS 500000000ULL
+#define TEST_MIN_SAMPLES 20
+
+static const int16_t test_values[][3] = {
+	{ 0x1234, -0x1234, 0x00FF },
+	{ 1, -1, 0 },
+	{ INT16_MAX, INT16_MIN, -256 },
+	{ 0x7F80, 0x0080, -0x7F80 },
+};
+
+static volatile uint8_t spi_cplt_flag = 0;
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi){
+	spi_cplt_flag = 1;
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi){
+	spi_cplt_flag = 1;
+}
+
+/**
+  * @brief Decodes bursts laid out the way the sensor sends them with the given BLE setting.
+  *
+  * @retval Number of axes that decoded to a wrong value.
+  */
+
+static uint32_t check_decode(LIS3MDL_Endianness endianness){
+	LIS3MDL_Bus bus;
+	SPI_HandleTypeDef hspi = { .Instance = SPI2 };
+	LIS3MDL_Device device;
+	LIS3MDL_Init_Params init_params;
+	LIS3MDL_Config_regs config_image;
+	uint32_t failures = 0;
+
+	lis3mdl_bus_init(&bus, &hspi);
+	lis3mdl_set_default_params(&init_params);
+	init_params.endianness = endianness;
+	lis3mdl_build_config_image(&config_image, init_params);
+	lis3mdl_initialize_device_struct(&device, &bus, GPIOB, GPIO_PIN_0);
+	lis3mdl_setup_config_registers(&device, &config_image);
+
+	for(size_t v=0; v<sizeof(test_values) / sizeof(test_values[0]); v++){
+		uint8_t burst[6];
+		for(int i=0; i<3; i++){
+			uint16_t value = (uint16_t)test_values[v][i];
+			burst[2*i] = endianness == LIS3MDL_BIG_ENDIAN ? (uint8_t)(value >> 8) : (uint8_t)value;
+			burst[2*i + 1] = endianness == LIS3MDL_BIG_ENDIAN ? (uint8_t)value : (uint8_t)(value >> 8);
+		}
+		LIS3MDL_Magnetic_Data_t sample;
+		memcpy(&sample, burst, sizeof(sample));
+		lis3mdl_decode_sample_in_place(&device, &sample);
+		const int16_t decoded[3] = { sample.x, sample.y, sample.z };
+		for(int i=0; i<3; i++){
+			if(decoded[i] == test_values[v][i])
+				continue;
+			printf("BLE=%d value %zu axis %d: %d instead of %d\n", endianness, v, i, decoded[i], test_values[v][i]);
+			failures++;
+		}
+	}
+	return failures;
+}
+
+/**
+  * @brief Runs the driver against simulated sensors that send in the given byte order.
+  *
+  * @retval Number of samples that did not match the field, or did not arrive.
+  */
+
+static uint32_t check_acquisition(LIS3MDL_Endianness endianness){
+	SPI_HandleTypeDef hspi = { .Instance = SPI2, .Init.BaudRatePrescaler = hal_mock_spi_prescaler_from_divider(2) };
+	LIS3MDL_Bus bus;
+	Hal_Mock_Spi_Timing timing = { .pclk_hz = TEST_PCLK_HZ, .dma_setup_ns = 2000, .inter_byte_ns = 0, .irq_latency_ns = 3000 };
+	LIS3MDL_Sim sims[TEST_NUM_OF_DEVICES];
+	LIS3MDL_Device devices[TEST_NUM_OF_DEVICES];
+	LIS3MDL_Sample_Buffer samples;
+	uint32_t delivered[TEST_NUM_OF_DEVICES] = { 0 };
+	uint32_t failures = 0;
+
+	hal_mock_reset();
+	hal_mock_spi_setup(&hspi, &timing);
+	lis3mdl_bus_init(&bus, &hspi);
+
+	LIS3MDL_Init_Params init_params;
+	lis3mdl_set_default_params(&init_params);
+	init_params.endianness = endianness;
+	init_params.output_data_rate = LIS3MDL_ODR_80;
+	LIS3MDL_Config_regs config_image;
+	lis3mdl_build_config_image(&config_image, init_params);
+
+	for(int i=0; i<TEST_NUM_OF_DEVICES; i++){
+		lis3mdl_sim_init(&sims[i]);
+		memcpy(sims[i].field, test_values[i], sizeof(sims[i].field));
+		hal_mock_spi_attach(&hspi, GPIOB, (uint16_t)(GPIO_PIN_0 << i), &sims[i]);
+		lis3mdl_initialize_device_struct(&devices[i], &bus, GPIOB, (uint16_t)(GPIO_PIN_0 << i));
+		lis3mdl_setup_config_registers(&devices[i], &config_image);
+	}
+	lis3mdl_sample_buffer_init(&samples);
+
+	uint64_t end_ns = hal_mock_get_time_ns() + TEST_RUN_NS;
+	while(hal_mock_get_time_ns() < end_ns){
+		if(lis3mdl_process(devices, TEST_NUM_OF_DEVICES, &spi_cplt_flag) == LIS3MDL_PROCESS_ERROR){
+			printf("BLE=%d: lis3mdl_process failed\n", endianness);
+			return 1;
+		}
+		for(int i=0; i<TEST_NUM_OF_DEVICES; i++){
+			if(lis3mdl_get_magnetic_data(devices, TEST_NUM_OF_DEVICES, i, &samples) != LIS3MDL_DATA_AVAILABLE)
+				continue;
+			const LIS3MDL_Magnetic_Data_t *sample = lis3mdl_sample_buffer_peek(&samples);
+			if(sample->x != sims[i].field[0] || sample->y != sims[i].field[1] || sample->z != sims[i].field[2]){
+				if(failures++ == 0)
+					printf("BLE=%d device %d: %d %d %d instead of %d %d %d\n", endianness, i, sample->x, sample->y, sample->z,
+							sims[i].field[0], sims[i].field[1], sims[i].field[2]);
+			}
+			delivered[i]++;
+			lis3mdl_sample_buffer_release(&samples);
+		}
+		hal_mock_advance_ns(TEST_LOOP_COST_NS);
+	}
+
+	for(int i=0; i<TEST_NUM_OF_DEVICES; i++){
+		if(delivered[i] >= TEST_MIN_SAMPLES)
+			continue;
+		printf("BLE=%d device %d: only %lu samples\n", endianness, i, (unsigned long)delivered[i]);
+		failures++;
+	}
+	return failures;
+}
+
+int main(void){
+	uint32_t failures = 0;
+	const LIS3MDL_Endianness endiannesses[] = { LIS3MDL_LITTLE_ENDIAN, LIS3MDL_BIG_ENDIAN };
+	for(int e=0; e<2; e++){
+		uint32_t decode_failures = check_decode(endiannesses[e]);
+		uint32_t acquisition_failures = check_acquisition(endiannesses[e]);
+		printf("BLE=%d%s: %lu decode and %lu acquisition failures\n", endiannesses[e], endiannesses[e] == LIS3MDL_NATIVE_ENDIANNESS ? " (native)" : "",
+				(unsigned long)decode_failures, (unsigned long)acquisition_failures);
+		failures += decode_failures + acquisition_failures;
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,178 @@
+/*
+ * lis3mdl_thermal_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Checks the thermal offset compensation of lis3mdl_thermal.h end to end.
+ *
+ * A simulated sensor with the temperature sensor enabled sits at a fixed field while its
+ * TEMP_OUT steps below, onto, between and beyond the points of a lookup table. Once the
+ * driver has read a temperature, every sample has to be the field minus the offset the
+ * table gives there, interpolated here in floating point. Both settings of the BLE bit
+ * run, so TEMP_OUT has to decode like the axes.
+ *
+ * Usage: lis3mdl_thermal_test
+ *
+ * The exit status is 1 if any sample carries a wrong offset.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include "hal_mock.h"
+#include "lis3mdl.h"
+#include "lis3mdl_thermal.h"
+
+#define TEST_PCLK_HZ 2000000
+#define TEST_LOOP_COST_NS 10000
+#define TEST_STEP_NS 500000000ULL // Per temperature, a few bursts at 80 Hz
+#define TEST_MIN_SAMPLES 10 // Per temperature, after the first burst read it
+
+static const int16_t test_field[3] = { 1000, -2000, 300 };
+
+static const LIS3MDL_Thermal_Lut test_lut = {
+	.first_temperature = -200,
+	.step_shift = 6, // 8 degC between the points
+	.offsets = {
+		{ -40, 25, 0 },
+		{ -22, 17, -3 },
+		{ -9, 10, -5 },
+		{ 0, 0, 0 },
+		{ 7, -13, 8 },
+		{ 19, -29, 21 },
+		{ 36, -48, 40 },
+		{ 58, -70, 66 },
+	},
+};
+
+static const int16_t test_temperatures[] = {
+	-300, // Below the first point
+	-200, // First point
+	-180,
+	-137,
+	0,
+	64,
+	101,
+	248, // Last point
+	1000, // Above the last point
+	-1, // One below a point, the largest fraction
+};
+
+static volatile uint8_t spi_cplt_flag = 0;
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi){
+	spi_cplt_flag = 1;
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi){
+	spi_cplt_flag = 1;
+}
+
+/**
+  * @brief Offset the table gives at a temperature, computed independently of the driver.
+  */
+
+static int32_t expected_offset(int16_t temperature, int axis){
+	double step = (double)(1 << test_lut.step_shift);
+	double position = (temperature - test_lut.first_temperature) / step;
+	if(position < 0)
+		position = 0;
+	if(position > LIS3MDL_THERMAL_LUT_POINTS - 1)
+		position = LIS3MDL_THERMAL_LUT_POINTS - 1;
+	int index = (int)position;
+	if(index == LIS3MDL_THERMAL_LUT_POINTS - 1)
+		return test_lut.offsets[index][axis];
+	double rise = test_lut.offsets[index + 1][axis] - test_lut.offsets[index][axis];
+	return test_lut.offsets[index][axis] + (int32_t)floor(rise * (position - index) + 0.5);
+}
+
+/**
+  * @brief Steps the temperature of a simulated sensor through `test_temperatures` and
+  * checks the compensated samples at every step.
+  *
+  * @retval Number of samples with a wrong offset plus the steps with too few samples.
+  */
+
+static uint32_t check_compensation(LIS3MDL_Endianness endianness){
+	SPI_HandleTypeDef hspi = { .Instance = SPI2, .Init.BaudRatePrescaler = hal_mock_spi_prescaler_from_divider(2) };
+	LIS3MDL_Bus bus;
+	Hal_Mock_Spi_Timing timing = { .pclk_hz = TEST_PCLK_HZ, .dma_setup_ns = 2000, .inter_byte_ns = 0, .irq_latency_ns = 3000 };
+	LIS3MDL_Sim sim;
+	LIS3MDL_Device device;
+	LIS3MDL_Sample_Buffer samples;
+	uint32_t failures = 0;
+
+	hal_mock_reset();
+	hal_mock_spi_setup(&hspi, &timing);
+	lis3mdl_bus_init(&bus, &hspi);
+
+	LIS3MDL_Init_Params init_params;
+	lis3mdl_set_default_params(&init_params);
+	init_params.endianness = endianness;
+	init_params.output_data_rate = LIS3MDL_ODR_80;
+	init_params.temp_en = 1;
+	LIS3MDL_Config_regs config_image;
+	lis3mdl_build_config_image(&config_image, init_params);
+
+	lis3mdl_sim_init(&sim);
+	for(int i=0; i<3; i++)
+		sim.field[i] = test_field[i];
+	hal_mock_spi_attach(&hspi, GPIOB, GPIO_PIN_0, &sim);
+	lis3mdl_initialize_device_struct(&device, &bus, GPIOB, GPIO_PIN_0);
+	lis3mdl_setup_config_registers(&device, &config_image);
+	lis3mdl_sample_buffer_init(&samples);
+	lis3mdl_thermal_reset();
+	lis3mdl_thermal_set_lut(0, &test_lut);
+
+	for(size_t t=0; t<sizeof(test_temperatures) / sizeof(test_temperatures[0]); t++){
+		int16_t temperature = test_temperatures[t];
+		uint32_t checked = 0;
+		sim.temperature_lsb = temperature;
+
+		uint64_t end_ns = hal_mock_get_time_ns() + TEST_STEP_NS;
+		while(hal_mock_get_time_ns() < end_ns){
+			if(lis3mdl_process(&device, 1, &spi_cplt_flag) == LIS3MDL_PROCESS_ERROR){
+				printf("BLE=%d: lis3mdl_process failed\n", endianness);
+				return 1;
+			}
+			if(lis3mdl_get_magnetic_data(&device, 1, 0, &samples) == LIS3MDL_DATA_AVAILABLE){
+				int16_t read_temperature;
+				const LIS3MDL_Magnetic_Data_t *sample = lis3mdl_sample_buffer_peek(&samples);
+				if(lis3mdl_thermal_get_temperature(0, &read_temperature) == 0 && read_temperature == temperature){
+					const int16_t values[3] = { sample->x, sample->y, sample->z };
+					for(int i=0; i<3; i++){
+						int32_t expected = test_field[i] - expected_offset(temperature, i);
+						if(values[i] == expected)
+							continue;
+						if(failures++ == 0)
+							printf("BLE=%d TEMP_OUT %d axis %d: %d instead of %ld\n", endianness, temperature, i, values[i], (long)expected);
+					}
+					checked++;
+				}
+				lis3mdl_sample_buffer_release(&samples);
+			}
+			hal_mock_advance_ns(TEST_LOOP_COST_NS);
+		}
+		if(checked < TEST_MIN_SAMPLES){
+			printf("BLE=%d TEMP_OUT %d: only %lu compensated samples\n", endianness, temperature, (unsigned long)checked);
+			failures++;
+		}
+	}
+	if(!lis3mdl_thermal_is_compensating(0)){
+		printf("BLE=%d: not compensating\n", endianness);
+		failures++;
+	}
+	lis3mdl_thermal_set_lut(0, NULL);
+	return failures;
+}
+
+int main(void){
+	uint32_t failures = 0;
+	const LIS3MDL_Endianness endiannesses[] = { LIS3MDL_LITTLE_ENDIAN, LIS3MDL_BIG_ENDIAN };
+	for(int e=0; e<2; e++){
+		uint32_t endianness_failures = check_compensation(endiannesses[e]);
+		printf("BLE=%d: %lu failures\n", endiannesses[e], (unsigned long)endianness_failures);
+		failures += endianness_failures;
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,379 @@
+/*
+ * lis3mdl_trace_decode.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: arvyd
+ *
+ * Decodes a dump of the LIS3MDL_Trace ring (see Drivers/lis3mdl/lis3mdl_trace.h).
+ * On target the dump is taken with the debugger, e.g. in GDB:
+ *   dump binary memory trace.bin &lis3mdl_trace ((char *)&lis3mdl_trace + sizeof(lis3mdl_trace))
+ * The host runners write the same layout with --trace.
+ *
+ * Prints a latency breakdown of every kind of SPI transaction (CS low to first DMA,
+ * time in DMA, turnaround from a completion to the next start, last completion to CS
+ * high) and of the status-to-sample pipeline per device. With --json the trace is also
+ * written as a Chrome trace / Perfetto timeline.
+ *
+ * Usage: lis3mdl_trace_decode trace.bin [--json timeline.json]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lis3mdl_trace.h"
+#include "lis3mdl_device.h"
+
+#define DECODE_MAX_DEVICES 16
+#define DECODE_MAX_KINDS 32
+
+typedef struct {
+	uint64_t time_us;
+	LIS3MDL_Trace_Event event;
+	uint8_t dev_index;
+	uint8_t arg;
+} Decoded_Record;
+
+typedef struct {
+	uint32_t count;
+	uint64_t sum_us;
+	uint64_t max_us;
+} Decode_Stat;
+
+typedef struct {
+	char name[32];
+	Decode_Stat setup; // CS low to the first DMA start
+	Decode_Stat dma; // DMA start to completion, summed over the transaction
+	Decode_Stat turnaround; // Completion to the next DMA start, summed over the transaction
+	Decode_Stat release; // Last completion to CS high
+	Decode_Stat total; // CS low to CS high
+} Transaction_Kind;
+
+static const char *process_state_names[16] = {
+	"RESETTING_REGISTERS", "INITIALIZING_OFFSET_REGS", "INITIALIZING_CTRL_REGS", "INITIALIZING_INT_REGS",
+	"IDLE", "SENDING_ADDRESS_TO_READ_FROM", "SENDING_ADDRESS_TO_WRITE_TO", "READING_DATA",
+	"WRITING_DATA", "WAITING_FOR_REBOOT"
+};
+
+static const char *retrieval_state_names[16] = {
+	"DATA_AVAILABLE", "STARTING_STATUS_CHECK", "STATUS_CHECK_IN_PROGRESS", "STARTING_DATA_RETRIEVAL",
+	"DATA_RETRIEVAL_IN_PROGRESS", "DATA_RETRIEVAL_ERROR", "WAITING_FOR_DATA_READY"
+};
+
+static const char *get_name(const char *const *names, uint8_t value){
+	return names[value & 0x0F] ? names[value & 0x0F] : "UNKNOWN";
+}
+
+static void add_stat(Decode_Stat *stat, uint64_t value_us){
+	stat->count++;
+	stat->sum_us += value_us;
+	if(value_us > stat->max_us)
+		stat->max_us = value_us;
+}
+
+static void print_stat(const char *name, const Decode_Stat *stat){
+	if(stat->count == 0)
+		return;
+	printf("  %-16s avg %9.1f us  max %7llu us\n", name, (double)stat->sum_us / stat->count, (unsigned long long)stat->max_us);
+}
+
+/**
+  * @brief Puts the records of the ring in order and unwraps their 20-bit timestamps.
+  *
+  * @retval Number of records decoded, -1 if the dump is not a trace.
+  */
+
+static int decode_records(const uint8_t *dump, size_t dump_size, Decoded_Record **decoded, uint32_t *lost){
+	const size_t header_size = 8;
+	if(dump_size < header_size || dump[0] != LIS3MDL_TRACE_VERSION || dump[1] > 16)
+		return -1;
+	uint32_t size = 1U << dump[1];
+	if(dump_size < header_size + size * 4)
+		return -1;
+	uint32_t head;
+	memcpy(&head, dump + 4, 4);
+
+	uint32_t count = head < size ? head : size;
+	*lost = head - count;
+	*decoded = calloc(count ? count : 1, sizeof(Decoded_Record));
+
+	uint64_t time_us = 0;
+	uint32_t previous_raw = 0;
+	for(uint32_t i=0; i<count; i++){
+		uint32_t record;
+		memcpy(&record, dump + header_size + ((head - count + i) & (size - 1)) * 4, 4);
+		uint32_t raw = record >> LIS3MDL_TRACE_TIME_SHIFT;
+		if(i > 0)
+			time_us += (raw - previous_raw) & LIS3MDL_TRACE_TIME_MASK;
+		previous_raw = raw;
+
+		(*decoded)[i].time_us = time_us;
+		(*decoded)[i].event = (LIS3MDL_Trace_Event)((record >> LIS3MDL_TRACE_EVENT_SHIFT) & 0x0F);
+		(*decoded)[i].dev_index = (record >> LIS3MDL_TRACE_DEVICE_SHIFT) & 0x0F;
+		(*decoded)[i].arg = record & LIS3MDL_TRACE_ARG_MASK;
+	}
+	return (int)count;
+}
+
+static Transaction_Kind *get_kind(Transaction_Kind *kinds, int *num_of_kinds, const char *name){
+	for(int i=0; i<*num_of_kinds; i++)
+		if(strcmp(kinds[i].name, name) == 0)
+			return &kinds[i];
+	if(*num_of_kinds == DECODE_MAX_KINDS)
+		return NULL;
+	Transaction_Kind *kind = &kinds[(*num_of_kinds)++];
+	memset(kind, 0, sizeof(*kind));
+	snprintf(kind->name, sizeof(kind->name), "%s", name);
+	return kind;
+}
+
+static void print_breakdown(const Decoded_Record *records, int count){
+	Transaction_Kind kinds[DECODE_MAX_KINDS];
+	int num_of_kinds = 0;
+	uint8_t process_state[DECODE_MAX_DEVICES];
+	uint8_t retrieval_state[DECODE_MAX_DEVICES];
+	uint64_t status_check_start_us[DECODE_MAX_DEVICES] = {0};
+	uint64_t data_ready_us[DECODE_MAX_DEVICES] = {0};
+	Decode_Stat status_to_sample[DECODE_MAX_DEVICES], ready_to_sample[DECODE_MAX_DEVICES], status_misses[DECODE_MAX_DEVICES];
+	memset(process_state, LIS3MDL_RESETTING_REGISTERS, sizeof(process_state)); // Where lis3mdl_initialize_device_struct leaves them
+	memset(retrieval_state, LIS3MDL_WAITING_FOR_DATA_READY, sizeof(retrieval_state));
+	memset(status_to_sample, 0, sizeof(status_to_sample));
+	memset(ready_to_sample, 0, sizeof(ready_to_sample));
+	memset(status_misses, 0, sizeof(status_misses));
+
+	// Transaction in progress
+	int in_frame = 0;
+	char frame_name[32] = "";
+	uint8_t frame_state = LIS3MDL_IDLE;
+	uint64_t cs_low_us = 0, dma_start_us = 0, dma_end_us = 0, dma_sum_us = 0, turnaround_sum_us = 0, setup_us = 0;
+	uint32_t dma_count = 0, ticks = 0;
+
+	for(int i=0; i<count; i++){
+		const Decoded_Record *record = &records[i];
+		uint8_t dev = record->dev_index;
+		switch(record->event){
+		case LIS3MDL_TRACE_PROCESS_STATE:
+			process_state[dev] = record->arg;
+			break;
+		case LIS3MDL_TRACE_RETRIEVAL_STATE:
+			if(record->arg == LIS3MDL_STATUS_CHECK_IN_PROGRESS)
+				status_check_start_us[dev] = record->time_us;
+			else if(record->arg == LIS3MDL_STARTING_DATA_RETRIEVAL)
+				data_ready_us[dev] = record->time_us;
+			else if(record->arg == LIS3MDL_WAITING_FOR_DATA_READY && status_check_start_us[dev]){
+				if(retrieval_state[dev] == LIS3MDL_DATA_RETRIEVAL_IN_PROGRESS){
+					add_stat(&status_to_sample[dev], record->time_us - status_check_start_us[dev]);
+					add_stat(&ready_to_sample[dev], record->time_us - data_ready_us[dev]);
+				}
+				else if(retrieval_state[dev] == LIS3MDL_STATUS_CHECK_IN_PROGRESS)
+					add_stat(&status_misses[dev], record->time_us - status_check_start_us[dev]);
+			}
+			retrieval_state[dev] = record->arg;
+			break;
+		case LIS3MDL_TRACE_CS_LOW:
+			in_frame = 1;
+			cs_low_us = record->time_us;
+			dma_count = 0;
+			dma_sum_us = turnaround_sum_us = 0;
+			frame_state = process_state[dev];
+			snprintf(frame_name, sizeof(frame_name), "%s", get_name(process_state_names, frame_state));
+			break;
+		case LIS3MDL_TRACE_DMA_START:
+			if(!in_frame)
+				break;
+			if(dma_count == 0)
+				setup_us = record->time_us - cs_low_us;
+			else
+				turnaround_sum_us += record->time_us - dma_end_us;
+			if(dma_count == 1 && frame_state == LIS3MDL_SENDING_ADDRESS_TO_READ_FROM)
+				snprintf(frame_name, sizeof(frame_name), "read %u bytes", record->arg);
+			else if(dma_count == 1 && frame_state == LIS3MDL_SENDING_ADDRESS_TO_WRITE_TO)
+				snprintf(frame_name, sizeof(frame_name), "write %u bytes", record->arg);
+			dma_start_us = record->time_us;
+			dma_count++;
+			break;
+		case LIS3MDL_TRACE_DMA_COMPLETE:
+			if(!in_frame)
+				break;
+			dma_end_us = record->time_us;
+			dma_sum_us += dma_end_us - dma_start_us;
+			break;
+		case LIS3MDL_TRACE_CS_HIGH:{
+			if(!in_frame || dma_count == 0)
+				break;
+			in_frame = 0;
+			Transaction_Kind *kind = get_kind(kinds, &num_of_kinds, frame_name);
+			if(kind == NULL)
+				break;
+			add_stat(&kind->setup, setup_us);
+			add_stat(&kind->dma, dma_sum_us);
+			add_stat(&kind->turnaround, turnaround_sum_us);
+			add_stat(&kind->release, record->time_us - dma_end_us);
+			add_stat(&kind->total, record->time_us - cs_low_us);
+			break;
+		}
+		case LIS3MDL_TRACE_TIMER_TICK:
+			ticks++;
+			break;
+		default:
+			break;
+		}
+	}
+
+	for(int k=0; k<num_of_kinds; k++){
+		printf("%s: %lu transactions\n", kinds[k].name, (unsigned long)kinds[k].total.count);
+		print_stat("cs_to_dma", &kinds[k].setup);
+		print_stat("dma", &kinds[k].dma);
+		print_stat("turnaround", &kinds[k].turnaround);
+		print_stat("dma_to_cs", &kinds[k].release);
+		print_stat("total", &kinds[k].total);
+	}
+	for(int dev=0; dev<DECODE_MAX_DEVICES; dev++){
+		if(status_to_sample[dev].count == 0 && status_misses[dev].count == 0)
+			continue;
+		printf("device %d: %lu samples, %lu status reads without data\n", dev, (unsigned long)status_to_sample[dev].count, (unsigned long)status_misses[dev].count);
+		print_stat("status_read", &status_misses[dev]);
+		print_stat("status_to_sample", &status_to_sample[dev]);
+		print_stat("ready_to_sample", &ready_to_sample[dev]);
+	}
+	printf("%lu timer ticks\n", (unsigned long)ticks);
+}
+
+static void write_span(FILE *out, int *first, const char *name, int pid, int tid, uint64_t start_us, uint64_t end_us){
+	fprintf(out, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%llu,\"dur\":%llu}", *first ? "" : ",",
+			name, pid, tid, (unsigned long long)start_us, (unsigned long long)(end_us - start_us));
+	*first = 0;
+}
+
+static void write_metadata(FILE *out, int *first, const char *what, int pid, int tid, const char *name){
+	fprintf(out, "%s\n{\"name\":\"%s\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", *first ? "" : ",", what, pid, tid, name);
+	*first = 0;
+}
+
+/**
+  * @brief Writes the trace in the Chrome trace event format, which Perfetto and
+  * chrome://tracing open. The bus, the process state and the retrieval state of every
+  * device are separate tracks, timer ticks and marks are instant events.
+  */
+
+static void write_json(FILE *out, const Decoded_Record *records, int count){
+	enum { PID_BUS = 0, PID_PROCESS = 1, PID_RETRIEVAL = 2 };
+	uint64_t process_since[DECODE_MAX_DEVICES], retrieval_since[DECODE_MAX_DEVICES];
+	int process_state[DECODE_MAX_DEVICES], retrieval_state[DECODE_MAX_DEVICES];
+	uint64_t cs_low_us = 0, dma_start_us = 0;
+	int dma_dev = -1, dma_size = 0, cs_dev = -1;
+	int first = 1;
+	char name[40];
+	for(int i=0; i<DECODE_MAX_DEVICES; i++)
+		process_state[i] = retrieval_state[i] = -1;
+
+	fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	write_metadata(out, &first, "process_name", PID_BUS, 0, "SPI bus");
+	write_metadata(out, &first, "process_name", PID_PROCESS, 0, "lis3mdl_process state");
+	write_metadata(out, &first, "process_name", PID_RETRIEVAL, 0, "data retrieval state");
+	write_metadata(out, &first, "thread_name", PID_BUS, 0, "DMA");
+	for(int i=0; i<count; i++){
+		const Decoded_Record *record = &records[i];
+		int dev = record->dev_index;
+		switch(record->event){
+		case LIS3MDL_TRACE_PROCESS_STATE:
+			if(process_state[dev] < 0){
+				snprintf(name, sizeof(name), "device %d", dev);
+				write_metadata(out, &first, "thread_name", PID_PROCESS, dev, name);
+			}
+			else
+				write_span(out, &first, get_name(process_state_names, process_state[dev]), PID_PROCESS, dev, process_since[dev], record->time_us);
+			process_state[dev] = record->arg;
+			process_since[dev] = record->time_us;
+			break;
+		case LIS3MDL_TRACE_RETRIEVAL_STATE:
+			if(retrieval_state[dev] < 0){
+				snprintf(name, sizeof(name), "device %d", dev);
+				write_metadata(out, &first, "thread_name", PID_RETRIEVAL, dev, name);
+			}
+			else
+				write_span(out, &first, get_name(retrieval_state_names, retrieval_state[dev]), PID_RETRIEVAL, dev, retrieval_since[dev], record->time_us);
+			retrieval_state[dev] = record->arg;
+			retrieval_since[dev] = record->time_us;
+			break;
+		case LIS3MDL_TRACE_CS_LOW:
+			cs_dev = dev;
+			cs_low_us = record->time_us;
+			break;
+		case LIS3MDL_TRACE_CS_HIGH:
+			if(cs_dev == dev){
+				snprintf(name, sizeof(name), "CS device %d", dev);
+				write_span(out, &first, name, PID_BUS, dev + 1, cs_low_us, record->time_us);
+			}
+			cs_dev = -1;
+			break;
+		case LIS3MDL_TRACE_DMA_START:
+			dma_dev = dev;
+			dma_size = record->arg;
+			dma_start_us = record->time_us;
+			break;
+		case LIS3MDL_TRACE_DMA_COMPLETE:
+			if(dma_dev >= 0){
+				snprintf(name, sizeof(name), "device %d, %d bytes", dma_dev, dma_size);
+				write_span(out, &first, name, PID_BUS, 0, dma_start_us, record->time_us);
+			}
+			dma_dev = -1;
+			break;
+		case LIS3MDL_TRACE_TIMER_TICK:
+		case LIS3MDL_TRACE_MARK:
+			fprintf(out, ",\n{\"name\":\"%s %u\",\"ph\":\"i\",\"s\":\"g\",\"pid\":%d,\"tid\":0,\"ts\":%llu}",
+					record->event == LIS3MDL_TRACE_TIMER_TICK ? "TIM2" : "mark", record->arg, PID_BUS, (unsigned long long)record->time_us);
+			break;
+		default:
+			break;
+		}
+	}
+	fprintf(out, "\n]}\n");
+}
+
+int main(int argc, char **argv){
+	const char *input_path = NULL, *json_path = NULL;
+	int usage_error = 0;
+	for(int i=1; i<argc; i++){
+		if(strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			json_path = argv[++i];
+		else if(input_path == NULL && argv[i][0] != '-')
+			input_path = argv[i];
+		else
+			usage_error = 1;
+	}
+	if(input_path == NULL || usage_error){
+		fprintf(stderr, "usage: %s trace.bin [--json timeline.json]\n", argv[0]);
+		return 1;
+	}
+
+	FILE *in = fopen(input_path, "rb");
+	if(in == NULL){
+		perror(input_path);
+		return 1;
+	}
+	static uint8_t dump[8 + (4U << 16)];
+	size_t dump_size = fread(dump, 1, sizeof(dump), in);
+	fclose(in);
+
+	Decoded_Record *records;
+	uint32_t lost;
+	int count = decode_records(dump, dump_size, &records, &lost);
+	if(count < 0){
+		fprintf(stderr, "%s is not a version %d lis3mdl trace\n", input_path, LIS3MDL_TRACE_VERSION);
+		return 1;
+	}
+	printf("%d records over %.3f ms, %lu older records overwritten\n", count, count ? records[count - 1].time_us / 1e3 : 0.0, (unsigned long)lost);
+	print_breakdown(records, count);
+
+	if(json_path){
+		FILE *out = fopen(json_path, "w");
+		if(out == NULL){
+			perror(json_path);
+			return 1;
+		}
+		write_json(out, records, count);
+		fclose(out);
+	}
+	free(records);
+	return 0;
+}